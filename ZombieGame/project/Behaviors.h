@@ -11,6 +11,39 @@
 #include "EliteMath/EMath.h"
 #include "EBehaviorTree.h"
 #include "Inventory.h"
+#include "KnownHouses.h"
+#include "KnownItems.h"
+#include "EnemyThreats.h"
+#include "PathCache.h"
+#include "DangerField.h"
+#include "BlackboardKeys.h"
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+//The inventory is changed in place, this marks it changed in the blackboard when a slot changed while the guard lived
+class InventoryChangeGuard final
+{
+public:
+	InventoryChangeGuard(Blackboard* pBlackboard, const Inventory* pInventory)
+		: m_pBlackboard{ pBlackboard }, m_pInventory{ pInventory }, m_SlotVersion{ pInventory->GetSlotVersion() } {}
+	~InventoryChangeGuard()
+	{
+		if (m_pInventory->GetSlotVersion() != m_SlotVersion) {
+			m_pBlackboard->MarkChanged(BB_Keys::Inventory);
+		}
+	}
+
+	InventoryChangeGuard(const InventoryChangeGuard& other) = delete;
+	InventoryChangeGuard(InventoryChangeGuard&& other) = delete;
+	InventoryChangeGuard& operator=(const InventoryChangeGuard& other) = delete;
+	InventoryChangeGuard& operator=(InventoryChangeGuard&& other) = delete;
+
+private:
+	Blackboard* m_pBlackboard;
+	const Inventory* m_pInventory;
+	const unsigned int m_SlotVersion;
+};
 
 //-----------------------------------------------------------------
 // Behaviors
@@ -21,31 +54,33 @@ namespace BT_Actions
 		Elite::Vector2 target{};
 		AgentInfo playerInfo{};
 		IExamInterface* pInterface{};
+		PathCache* pPathCache{};
 		SteeringPlugin_Output steering{};
 		bool canRun{};
 		bool isFleeing{};
 
 		float acceptanceRadius{ 0.01f };
 
-		bool dataFound = pBlackboard->GetData("Target", target) &&
-			pBlackboard->GetData("PlayerInfo", playerInfo) &&
-			pBlackboard->GetData("Interface", pInterface) &&
-			pBlackboard->GetData("CanRun", canRun) &&
-			pBlackboard->GetData("IsFleeing", isFleeing);
+		bool dataFound = pBlackboard->GetData(BB_Keys::Target, target) &&
+			pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo) &&
+			pBlackboard->GetData(BB_Keys::Interface, pInterface) &&
+			pBlackboard->GetData(BB_Keys::PathCache, pPathCache) &&
+			pBlackboard->GetData(BB_Keys::CanRun, canRun) &&
+			pBlackboard->GetData(BB_Keys::IsFleeing, isFleeing);
 
-		if (!dataFound || pInterface == nullptr) {
+		if (!dataFound || pInterface == nullptr || pPathCache == nullptr) {
 			return BehaviorState::Failure;
 		}
 
-		target = pInterface->NavMesh_GetClosestPathPoint(target);
+		target = pPathCache->GetClosestPathPoint(pInterface, playerInfo.Position, target);
 
 		//If it is close to the target, let him stop
 		if (Elite::DistanceSquared(target, playerInfo.Position) < acceptanceRadius * acceptanceRadius) {
 			//Set fleeing data
 			if (isFleeing) {
-				pBlackboard->ChangeData("IsFleeing", false);
-				pBlackboard->ChangeData("WasFleeing", true);
-				pBlackboard->ChangeData("CanRun", false);
+				pBlackboard->ChangeData(BB_Keys::IsFleeing, false);
+				pBlackboard->ChangeData(BB_Keys::WasFleeing, true);
+				pBlackboard->ChangeData(BB_Keys::CanRun, false);
 			}
 			steering.LinearVelocity = { 0, 0 };
 		}
@@ -56,7 +91,7 @@ namespace BT_Actions
 			steering.LinearVelocity *= playerInfo.MaxLinearSpeed;
 		}
 		
-		pBlackboard->ChangeData("SteeringOutput", steering);
+		pBlackboard->ChangeData(BB_Keys::SteeringOutput, steering);
 		return BehaviorState::Success;
 	}
 
@@ -68,27 +103,37 @@ namespace BT_Actions
 		SteeringPlugin_Output steering{};
 		bool canRun{};
 		float fleeRadius{};
+		DangerField* pDangerField{};
 
-		bool dataFound = pBlackboard->GetData("FleeTarget", fleeTarget) &&
-			pBlackboard->GetData("PlayerInfo", playerInfo) &&
-			pBlackboard->GetData("Interface", pInterface) &&
-			pBlackboard->GetData("CanRun", canRun) &&
-			pBlackboard->GetData("FleeRadius", fleeRadius);
+		bool dataFound = pBlackboard->GetData(BB_Keys::FleeTarget, fleeTarget) &&
+			pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo) &&
+			pBlackboard->GetData(BB_Keys::Interface, pInterface) &&
+			pBlackboard->GetData(BB_Keys::CanRun, canRun) &&
+			pBlackboard->GetData(BB_Keys::FleeRadius, fleeRadius) &&
+			pBlackboard->GetData(BB_Keys::DangerField, pDangerField);
 
-		if (!dataFound || pInterface == nullptr) {
+		if (!dataFound || pInterface == nullptr || pDangerField == nullptr) {
 			return BehaviorState::Failure;
 		}
 
-		//Calculate the spot to run to
+		//Calculate the spot to run to, towards the safest cell of the danger field so all enemies and purge zones in view are avoided
 		Elite::Vector2 playerPosition{ playerInfo.Position };
+		Elite::Vector2 safestCell{};
 
-		Elite::Vector2 targetToPlayer = playerPosition - fleeTarget;
-		targetToPlayer.Normalize();
+		Elite::Vector2 fleeDirection{};
+		if (pDangerField->GetFleeTarget(playerPosition, safestCell)) {
+			fleeDirection = safestCell - playerPosition;
+		}
+		else {
+			//Staying is the safest, or nothing dangerous is in view, run straight away from the flee target
+			fleeDirection = playerPosition - fleeTarget;
+		}
+		fleeDirection.Normalize();
 
-		Elite::Vector2 newTarget = playerPosition + targetToPlayer * fleeRadius;
+		Elite::Vector2 newTarget = playerPosition + fleeDirection * fleeRadius;
 
-		pBlackboard->ChangeData("Target", newTarget);
-		pBlackboard->ChangeData("IsFleeing", true);
+		pBlackboard->ChangeData(BB_Keys::Target, newTarget);
+		pBlackboard->ChangeData(BB_Keys::IsFleeing, true);
 
 		return Seek(pBlackboard);
 	}
@@ -100,9 +145,9 @@ namespace BT_Actions
 		//Get the steering so you will keep moving while facing the target
 		SteeringPlugin_Output steering{};
 
-		bool dataFound = pBlackboard->GetData("Target", target) &&
-			pBlackboard->GetData("PlayerInfo", playerInfo) &&
-			pBlackboard->GetData("SteeringOutput", steering);
+		bool dataFound = pBlackboard->GetData(BB_Keys::Target, target) &&
+			pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo) &&
+			pBlackboard->GetData(BB_Keys::SteeringOutput, steering);
 
 		if (dataFound == false) {
 			return BehaviorState::Failure;
@@ -110,16 +155,16 @@ namespace BT_Actions
 
 		const Elite::Vector2 toTarget{ target - playerInfo.Position };
 
-		//angle between -pi and +pi
-		const float angleTo{ atan2f(toTarget.y, toTarget.x) };
+		//angle between -pi and +pi, turn the short way round
+		const float angleTo{ Elite::VectorToOrientation(toTarget) };
 		float angleFrom{ playerInfo.Orientation };
 
-		float deltaAngle = angleTo - angleFrom;
+		float deltaAngle = Elite::DeltaOrientation(angleFrom, angleTo);
 
 		steering.AutoOrient = false;
 		steering.AngularVelocity = deltaAngle * playerInfo.MaxAngularSpeed;
 		
-		pBlackboard->ChangeData("SteeringOutput", steering);
+		pBlackboard->ChangeData(BB_Keys::SteeringOutput, steering);
 		return BehaviorState::Success;
 	}
 
@@ -130,9 +175,9 @@ namespace BT_Actions
 		//Get the steering so you will keep moving while facing the target
 		SteeringPlugin_Output steering{};
 
-		bool dataFound = pBlackboard->GetData("Target", target) &&
-			pBlackboard->GetData("PlayerInfo", playerInfo) &&
-			pBlackboard->GetData("SteeringOutput", steering);
+		bool dataFound = pBlackboard->GetData(BB_Keys::Target, target) &&
+			pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo) &&
+			pBlackboard->GetData(BB_Keys::SteeringOutput, steering);
 
 		if (dataFound == false) {
 			return BehaviorState::Failure;
@@ -140,16 +185,16 @@ namespace BT_Actions
 		//To look behind you, flip the vector
 		const Elite::Vector2 toPlayer{ playerInfo.Position - target};
 
-		//angle between -pi and +pi
-		const float angleTo{ atan2f(toPlayer.y, toPlayer.x) };
+		//angle between -pi and +pi, turn the short way round
+		const float angleTo{ Elite::VectorToOrientation(toPlayer) };
 		float angleFrom{ playerInfo.Orientation };
 
-		float deltaAngle = angleTo - angleFrom;
+		float deltaAngle = Elite::DeltaOrientation(angleFrom, angleTo);
 
 		steering.AutoOrient = false;
 		steering.AngularVelocity = deltaAngle * playerInfo.MaxAngularSpeed;
 
-		pBlackboard->ChangeData("SteeringOutput", steering);
+		pBlackboard->ChangeData(BB_Keys::SteeringOutput, steering);
 		return BehaviorState::Success;
 	}
 
@@ -157,15 +202,15 @@ namespace BT_Actions
 		AgentInfo playerInfo{};
 		PurgeZoneInfo currentPurgeZone{};
 
-		bool dataFound = pBlackboard->GetData("CurrentPurgeZone", currentPurgeZone) &&
-			pBlackboard->GetData("PlayerInfo", playerInfo);
+		bool dataFound = pBlackboard->GetData(BB_Keys::CurrentPurgeZone, currentPurgeZone) &&
+			pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo);
 
 		if (dataFound == false) {
 			return BehaviorState::Failure;
 		}
 
-		pBlackboard->ChangeData("FleeTarget", currentPurgeZone.Center);
-		pBlackboard->ChangeData("CanRun", true);
+		pBlackboard->ChangeData(BB_Keys::FleeTarget, currentPurgeZone.Center);
+		pBlackboard->ChangeData(BB_Keys::CanRun, true);
 		
 		return BehaviorState::Success;
 	}
@@ -173,7 +218,7 @@ namespace BT_Actions
 	BehaviorState GetReadyToFlee(Blackboard* pBlackboard) {
 		AgentInfo playerInfo{};
 
-		bool dataFound = pBlackboard->GetData("PlayerInfo", playerInfo);
+		bool dataFound = pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo);
 
 		if (dataFound == false) {
 			return BehaviorState::Failure;
@@ -181,44 +226,39 @@ namespace BT_Actions
 
 		float stamina = playerInfo.Stamina;
 
-		pBlackboard->ChangeData("IsFleeing", true);
-		pBlackboard->ChangeData("WasFleeing", false);
+		pBlackboard->ChangeData(BB_Keys::IsFleeing, true);
+		pBlackboard->ChangeData(BB_Keys::WasFleeing, false);
 		//only sprint if stamina is high enough!
 		if (stamina > 3.0f) {
-			pBlackboard->ChangeData("CanRun", true);
+			pBlackboard->ChangeData(BB_Keys::CanRun, true);
 		}
 
 		return BehaviorState::Success;
 	}
 
-	BehaviorState SetClosestEnemyAsTarget(Blackboard* pBlackboard) {
+	BehaviorState SetBiggestThreatAsTarget(Blackboard* pBlackboard) {
 		AgentInfo playerInfo{};
 		std::vector<EnemyInfo>* pEnemiesInFOV{};
+		EnemyThreats* pEnemyThreats{};
 
-		bool dataFound = pBlackboard->GetData("EnemiesInFOV", pEnemiesInFOV) &&
-			pBlackboard->GetData("PlayerInfo", playerInfo);
+		bool dataFound = pBlackboard->GetData(BB_Keys::EnemiesInFOV, pEnemiesInFOV) &&
+			pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo) &&
+			pBlackboard->GetData(BB_Keys::EnemyThreats, pEnemyThreats);
 
-		if (dataFound == false || pEnemiesInFOV == nullptr) {
+		if (dataFound == false || pEnemiesInFOV == nullptr || pEnemyThreats == nullptr) {
 			return BehaviorState::Failure;
 		}
 
+		//Score every enemy in the FOV on distance, speed towards you, health and type
 		//If there are no enemies in the FOV, this cant work
-		if (pEnemiesInFOV->size() <= 0) {
+		UINT biggestThreat{};
+		if (!pEnemyThreats->Evaluate(*pEnemiesInFOV, playerInfo.Position, playerInfo.LinearVelocity, biggestThreat)) {
 			return BehaviorState::Failure;
 		}
 
-		EnemyInfo closestEnemy{ pEnemiesInFOV->at(0) };
-		float minDistanceSquared{Elite::DistanceSquared(playerInfo.Position, closestEnemy.Location)};
-		for (const EnemyInfo& enemy : *pEnemiesInFOV) {
-			float distanceSquared{ Elite::DistanceSquared(playerInfo.Position, enemy.Location )};
-			if (distanceSquared < minDistanceSquared) {
-				closestEnemy = enemy;
-				minDistanceSquared = distanceSquared;
-			}
-		}
-
-		pBlackboard->ChangeData("Target", closestEnemy.Location);
-		pBlackboard->ChangeData("FleeTarget", closestEnemy.Location);
+		const EnemyInfo& enemy = pEnemiesInFOV->at(biggestThreat);
+		pBlackboard->ChangeData(BB_Keys::Target, enemy.Location);
+		pBlackboard->ChangeData(BB_Keys::FleeTarget, enemy.Location);
 		return BehaviorState::Success;
 	}
 
@@ -226,8 +266,8 @@ namespace BT_Actions
 		Inventory* pInventory{};
 		std::vector<EnemyInfo>* pEnemiesInFov{};
 
-		bool dataFound = pBlackboard->GetData("Inventory", pInventory) &&
-			pBlackboard->GetData("EnemiesInFOV", pEnemiesInFov);
+		bool dataFound = pBlackboard->GetData(BB_Keys::Inventory, pInventory) &&
+			pBlackboard->GetData(BB_Keys::EnemiesInFOV, pEnemiesInFov);
 
 		if (dataFound == false || pInventory == nullptr || pEnemiesInFov == nullptr) {
 			return BehaviorState::Failure;
@@ -244,6 +284,7 @@ namespace BT_Actions
 		}
 
 		//	Inventory keeps track of the ammo and will throw away an empty gun automatically
+		const InventoryChangeGuard inventoryChange{ pBlackboard, pInventory };
 		if (pInventory->ContainsItemOfType(preferredGunType)) {
 			bool hasFired = pInventory->UseItemOfType(preferredGunType);
 			if (hasFired) {
@@ -265,13 +306,14 @@ namespace BT_Actions
 	BehaviorState UseMedkit(Blackboard* pBlackboard) {
 		Inventory* pInventory{};
 
-		bool dataFound = pBlackboard->GetData("Inventory", pInventory);
+		bool dataFound = pBlackboard->GetData(BB_Keys::Inventory, pInventory);
 
 		if (dataFound == false || pInventory == nullptr) {
 			return BehaviorState::Failure;
 		}
 
 		//Inventory will automatically delete the medkit once it is used up
+		const InventoryChangeGuard inventoryChange{ pBlackboard, pInventory };
 		if (pInventory->ContainsItemOfType(eItemType::MEDKIT)) {
 			bool hasUsed = pInventory->UseItemOfType(eItemType::MEDKIT);
 			if (hasUsed) {
@@ -285,13 +327,14 @@ namespace BT_Actions
 	BehaviorState EatFood(Blackboard* pBlackboard) {
 		Inventory* pInventory{};
 
-		bool dataFound = pBlackboard->GetData("Inventory", pInventory);
+		bool dataFound = pBlackboard->GetData(BB_Keys::Inventory, pInventory);
 
 		if (dataFound == false || pInventory == nullptr) {
 			return BehaviorState::Failure;
 		}
 
 		//Inventory will automatically delete the food once it is used up
+		const InventoryChangeGuard inventoryChange{ pBlackboard, pInventory };
 		if (pInventory->ContainsItemOfType(eItemType::FOOD)) {
 			bool hasUsed = pInventory->UseItemOfType(eItemType::FOOD);
 			if (hasUsed) {
@@ -307,17 +350,16 @@ namespace BT_Actions
 		Elite::Vector2 target{};
 		const float distanceFactor{ 2.0f };
 
-		bool dataFound = pBlackboard->GetData("PlayerInfo", playerInfo) &&
-			pBlackboard->GetData("Target", target);
+		bool dataFound = pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo) &&
+			pBlackboard->GetData(BB_Keys::Target, target);
 
 		if (dataFound == false) {
 			return BehaviorState::Failure;
 		}
 
-		Elite::Vector2 pointBehind = Elite::Vector2(playerInfo.Position.x - distanceFactor * cosf(playerInfo.Orientation),
-			playerInfo.Position.y - distanceFactor * sinf(playerInfo.Orientation));
+		Elite::Vector2 pointBehind = playerInfo.Position - Elite::OrientationToVector(playerInfo.Orientation) * distanceFactor;
 
-		pBlackboard->ChangeData("FleeTarget", pointBehind);
+		pBlackboard->ChangeData(BB_Keys::FleeTarget, pointBehind);
 		return BehaviorState::Success;
 	}
 
@@ -325,8 +367,8 @@ namespace BT_Actions
 		AgentInfo playerInfo{};
 		std::vector<EntityInfo>* pItemsInFOV{};
 
-		bool dataFound = pBlackboard->GetData("ItemsInFOV", pItemsInFOV) &&
-			pBlackboard->GetData("PlayerInfo", playerInfo);
+		bool dataFound = pBlackboard->GetData(BB_Keys::ItemsInFOV, pItemsInFOV) &&
+			pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo);
 
 		if (dataFound == false || pItemsInFOV == nullptr) {
 			return BehaviorState::Failure;
@@ -346,8 +388,8 @@ namespace BT_Actions
 				minDistanceSquared = distanceSquared;
 			}
 		}
-		pBlackboard->ChangeData("ClosestItem", closestItem);
-		pBlackboard->ChangeData("Target", closestItem.Location);
+		pBlackboard->ChangeData(BB_Keys::ClosestItem, closestItem);
+		pBlackboard->ChangeData(BB_Keys::Target, closestItem.Location);
 		return BehaviorState::Success;
 	}
 
@@ -355,12 +397,12 @@ namespace BT_Actions
 		EntityInfo closestItem{};
 		Inventory* pInventory{};
 		IExamInterface* pInterface{};
-		std::vector<ItemInfo>* pKnownItems{};
+		KnownItems* pKnownItems{};
 
-		auto dataFound = pBlackboard->GetData("ClosestItem", closestItem) &&
-			pBlackboard->GetData("Inventory", pInventory) &&
-			pBlackboard->GetData("Interface", pInterface) &&
-			pBlackboard->GetData("KnownItems", pKnownItems);
+		auto dataFound = pBlackboard->GetData(BB_Keys::ClosestItem, closestItem) &&
+			pBlackboard->GetData(BB_Keys::Inventory, pInventory) &&
+			pBlackboard->GetData(BB_Keys::Interface, pInterface) &&
+			pBlackboard->GetData(BB_Keys::KnownItems, pKnownItems);
 
 		if (dataFound == false || pInventory == nullptr || pInterface == nullptr || pKnownItems == nullptr) {
 			return BehaviorState::Failure;
@@ -370,22 +412,14 @@ namespace BT_Actions
 		if (closestItem.EntityHash == 0) {
 			return BehaviorState::Failure;
 		}
+		const InventoryChangeGuard inventoryChange{ pBlackboard, pInventory };
 		bool hasPickedup = pInventory->PickupItem(closestItem);
 		if (hasPickedup) {
 			//Debug render the inventory (TODO: remove)
 			pInventory->DebugRender();
 
-			//Check if this item was a known item
-			int indexOfKnowItem{ invalid_index };
-			for (int index{}; index < int(pKnownItems->size()); ++index) {
-				if (closestItem.Location.Distance(pKnownItems->at(index).Location) < 0.1f) {
-					indexOfKnowItem = index;
-				}
-			}
-			//It is a known item, delete it from the known item list
-			if (indexOfKnowItem != invalid_index) {
-				pKnownItems->erase(pKnownItems->begin() + indexOfKnowItem);
-			}
+			//If it was a known item, delete it from the known items
+			pKnownItems->RemoveItemAt(closestItem.Location);
 
 			return BehaviorState::Success;
 		}
@@ -398,8 +432,8 @@ namespace BT_Actions
 		HouseSearch* pCurrentHouse{};
 		AgentInfo playerInfo{};
 
-		bool dataFound = pBlackboard->GetData("CurrentHouse", pCurrentHouse) &&
-			pBlackboard->GetData("PlayerInfo", playerInfo);
+		bool dataFound = pBlackboard->GetData(BB_Keys::CurrentHouse, pCurrentHouse) &&
+			pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo);
 
 		if (dataFound == false || pCurrentHouse == nullptr) {
 			return BehaviorState::Failure;
@@ -407,7 +441,7 @@ namespace BT_Actions
 
 		//Check if you are close to the current location, and then update it to the next one
 		bool hasChecked = pCurrentHouse->UpdateCurrentLocation(playerInfo.Position);
-		pBlackboard->ChangeData("Target", pCurrentHouse->GetCurrentLocation());
+		pBlackboard->ChangeData(BB_Keys::Target, pCurrentHouse->GetCurrentLocation());
 
 		//Go towards the new spot
 		return Seek(pBlackboard);
@@ -417,8 +451,8 @@ namespace BT_Actions
 		WorldSearch* pWorldSearch{};
 		AgentInfo playerInfo{};
 
-		bool dataFound = pBlackboard->GetData("WorldSearch", pWorldSearch) &&
-			pBlackboard->GetData("PlayerInfo", playerInfo);
+		bool dataFound = pBlackboard->GetData(BB_Keys::WorldSearch, pWorldSearch) &&
+			pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo);
 
 		if (dataFound == false || pWorldSearch == nullptr) {
 			return BehaviorState::Failure;
@@ -426,20 +460,20 @@ namespace BT_Actions
 
 		//Check if you are close to the current location, and then update it to the next one
 		bool hasChecked = pWorldSearch->UpdateCurrentLocation(playerInfo.Position);
-		pBlackboard->ChangeData("Target", pWorldSearch->GetCurrentLocation());
+		pBlackboard->ChangeData(BB_Keys::Target, pWorldSearch->GetCurrentLocation());
 
 		//Go towards the new spot
 		return Seek(pBlackboard);
 	}
 
 	BehaviorState RememberItem(Blackboard* pBlackboard) {
-		std::vector<ItemInfo>* pKnownItems{};
+		KnownItems* pKnownItems{};
 		IExamInterface* pInterface{};
 		EntityInfo closestItem{};
 
-		bool dataFound = pBlackboard->GetData("KnownItems", pKnownItems) &&
-			pBlackboard->GetData("Interface", pInterface) &&
-			pBlackboard->GetData("ClosestItem", closestItem);
+		bool dataFound = pBlackboard->GetData(BB_Keys::KnownItems, pKnownItems) &&
+			pBlackboard->GetData(BB_Keys::Interface, pInterface) &&
+			pBlackboard->GetData(BB_Keys::ClosestItem, closestItem);
 
 		if (dataFound == false || pKnownItems == nullptr || pInterface == nullptr) {
 			return BehaviorState::Failure;
@@ -453,16 +487,8 @@ namespace BT_Actions
 		ItemInfo knownItem{};
 		pInterface->Item_GetInfo(closestItem, knownItem);
 
-		//Check to see if it is already in there, by location
-		bool isNewItem{ true };
-		for (const ItemInfo& item : *pKnownItems) {
-			if (item.Location.Distance(closestItem.Location) < 0.1f) {
-				isNewItem = false;
-			}
-		}
-
-		if (isNewItem) {
-			pKnownItems->push_back(knownItem);
+		//Only added if it is not in there yet, by location
+		if (pKnownItems->AddItem(knownItem)) {
 			return BehaviorState::Success;
 		}
 		
@@ -472,7 +498,7 @@ namespace BT_Actions
 	BehaviorState MarkHouseAsUnsafe(Blackboard* pBlackboard) {
 		HouseSearch* pCurrentHouse{};
 
-		bool dataFound = pBlackboard->GetData("CurrentHouse", pCurrentHouse);
+		bool dataFound = pBlackboard->GetData(BB_Keys::CurrentHouse, pCurrentHouse);
 
 		if (dataFound == false || pCurrentHouse == nullptr) {
 			return BehaviorState::Failure;
@@ -492,11 +518,11 @@ namespace BT_Conditions
 {
 	bool IsInPurgeZone(Blackboard* pBlackboard) {
 		std::vector<PurgeZoneInfo>* pPurgeZonesInFOV{};
-		AgentInfo playerInfo{};
+		Elite::Vector2 playerPosition{};
 		const float bufferZoneSquared{ 100.0f};
 		
-		bool dataFound = pBlackboard->GetData("PurgeZonesInFOV", pPurgeZonesInFOV)&&
-			pBlackboard->GetData("PlayerInfo", playerInfo);
+		bool dataFound = pBlackboard->GetData(BB_Keys::PurgeZonesInFOV, pPurgeZonesInFOV)&&
+			pBlackboard->GetData(BB_Keys::PlayerPosition, playerPosition);
 
 		//If its not found or the vector is empty
 		if (dataFound == false || pPurgeZonesInFOV == nullptr) {
@@ -509,9 +535,9 @@ namespace BT_Conditions
 		}
 
 		for (const PurgeZoneInfo& purgeZone : *pPurgeZonesInFOV) {
-			if (Elite::DistanceSquared(purgeZone.Center, playerInfo.Position) < (purgeZone.Radius * purgeZone.Radius + bufferZoneSquared)) {
+			if (Elite::DistanceSquared(purgeZone.Center, playerPosition) < (purgeZone.Radius * purgeZone.Radius + bufferZoneSquared)) {
 				//You are inside or close to a purge zone right now
-				pBlackboard->ChangeData("CurrentPurgeZone", purgeZone);
+				pBlackboard->ChangeData(BB_Keys::CurrentPurgeZone, purgeZone);
 				return true;
 			}
 		}
@@ -519,35 +545,39 @@ namespace BT_Conditions
 	}
 
 	bool IsEnemyInFOV(Blackboard* pBlackboard) {
-		std::vector<EnemyInfo>* pEnemiesInFOV{};
+		return pBlackboard->Memoize(BB_Memos::IsEnemyInFOV, [](Blackboard* pBlackboard) {
+			std::vector<EnemyInfo>* pEnemiesInFOV{};
 
-		bool dataFound = pBlackboard->GetData("EnemiesInFOV", pEnemiesInFOV);
-		if (dataFound == false || pEnemiesInFOV == nullptr) {
-			return false;
-		}
+			bool dataFound = pBlackboard->GetData(BB_Keys::EnemiesInFOV, pEnemiesInFOV);
+			if (dataFound == false || pEnemiesInFOV == nullptr) {
+				return false;
+			}
 
-		//If this vectors size is bigger than 0 it means there is one or more enemies in the FOV
-		return pEnemiesInFOV->size() > 0;
+			//If this vectors size is bigger than 0 it means there is one or more enemies in the FOV
+			return pEnemiesInFOV->size() > 0;
+		});
 	}
 
 	bool HasGun(Blackboard* pBlackboard) {
-		Inventory* pInventory{};
+		return pBlackboard->Memoize(BB_Memos::HasGun, [](Blackboard* pBlackboard) {
+			Inventory* pInventory{};
 
-		bool dataFound = pBlackboard->GetData("Inventory", pInventory);
+			bool dataFound = pBlackboard->GetData(BB_Keys::Inventory, pInventory);
 
-		if (dataFound == false || pInventory == nullptr) {
-			return false;
-		}
+			if (dataFound == false || pInventory == nullptr) {
+				return false;
+			}
 
-		//If you have a pistol, or a shotgun, you are armed
-		bool hasGun = (pInventory->ContainsItemOfType(eItemType::PISTOL) || pInventory->ContainsItemOfType(eItemType::SHOTGUN));
-		return hasGun;
+			//If you have a pistol, or a shotgun, you are armed
+			bool hasGun = (pInventory->ContainsItemOfType(eItemType::PISTOL) || pInventory->ContainsItemOfType(eItemType::SHOTGUN));
+			return hasGun;
+		});
 	}
 
 	bool WasFleeing(Blackboard* pBlackboard) {
 		bool wasFleeing{};
 
-		bool dataFound = pBlackboard->GetData("WasFleeing", wasFleeing);
+		bool dataFound = pBlackboard->GetData(BB_Keys::WasFleeing, wasFleeing);
 
 		if (dataFound == false) {
 			return false;
@@ -559,7 +589,7 @@ namespace BT_Conditions
 	bool IsFleeing(Blackboard* pBlackboard) {
 		bool IsFleeing{};
 
-		bool dataFound = pBlackboard->GetData("IsFleeing", IsFleeing);
+		bool dataFound = pBlackboard->GetData(BB_Keys::IsFleeing, IsFleeing);
 
 		if (dataFound == false) {
 			return false;
@@ -569,32 +599,32 @@ namespace BT_Conditions
 	}
 
 	bool IsHurt(Blackboard* pBlackboard) {
-		AgentInfo playerInfo{};
-		float maxHealth{};
+		return pBlackboard->Memoize(BB_Memos::IsHurt, [](Blackboard* pBlackboard) {
+			float health{};
+			float maxHealth{};
 
-		bool dataFound = pBlackboard->GetData("PlayerInfo", playerInfo) &&
-			pBlackboard->GetData("MaxPlayerHealth", maxHealth);
+			bool dataFound = pBlackboard->GetData(BB_Keys::PlayerHealth, health) &&
+				pBlackboard->GetData(BB_Keys::MaxPlayerHealth, maxHealth);
 
-		if (dataFound == false) {
-			return false;
-		}
+			if (dataFound == false) {
+				return false;
+			}
 
-		//If you have less health than max health you are hurt
-		return playerInfo.Health < maxHealth;
+			//If you have less health than max health you are hurt
+			return health < maxHealth;
+		});
 	}
 
 	bool ShouldHeal(Blackboard* pBlackboard) {
-		AgentInfo playerInfo{};
+		float health{};
 		Inventory* pInventory{};
 		float maxHealth{};
-		IExamInterface* pInterface{};
 
-		bool dataFound = pBlackboard->GetData("PlayerInfo", playerInfo) && 
-			pBlackboard->GetData("Inventory", pInventory) &&
-			pBlackboard->GetData("MaxPlayerHealth", maxHealth) &&
-			pBlackboard->GetData("Interface", pInterface);
+		bool dataFound = pBlackboard->GetData(BB_Keys::PlayerHealth, health) && 
+			pBlackboard->GetData(BB_Keys::Inventory, pInventory) &&
+			pBlackboard->GetData(BB_Keys::MaxPlayerHealth, maxHealth);
 
-		if (dataFound == false || pInventory == nullptr || pInterface == nullptr) {
+		if (dataFound == false || pInventory == nullptr) {
 			return false;
 		}
 		//If you dont have a medkit, you shouldnt try to heal
@@ -606,12 +636,10 @@ namespace BT_Conditions
 			return false;
 		}
 		//Check the medkit charges
-		ItemInfo item{};
-		pInterface->Inventory_GetItem(medkitIndex, item);
-		int medkitCharges = pInterface->Medkit_GetHealth(item);
+		int medkitCharges = pInventory->GetItemValue(medkitIndex);
 
 		//Check so you dont waste any medkit charges
-		if (maxHealth - playerInfo.Health > medkitCharges) {
+		if (maxHealth - health > medkitCharges) {
 			return true;
 		}
 
@@ -619,32 +647,32 @@ namespace BT_Conditions
 	}
 
 	bool IsHungry(Blackboard* pBlackboard) {
-		AgentInfo playerInfo{};
-		float maxEnergy{};
+		return pBlackboard->Memoize(BB_Memos::IsHungry, [](Blackboard* pBlackboard) {
+			float energy{};
+			float maxEnergy{};
 
-		bool dataFound = pBlackboard->GetData("PlayerInfo", playerInfo) &&
-			pBlackboard->GetData("MaxPlayerEnergy", maxEnergy);
+			bool dataFound = pBlackboard->GetData(BB_Keys::PlayerEnergy, energy) &&
+				pBlackboard->GetData(BB_Keys::MaxPlayerEnergy, maxEnergy);
 
-		if (dataFound == false) {
-			return false;
-		}
+			if (dataFound == false) {
+				return false;
+			}
 
-		//If you have less energy than the max energy, you are hungry
-		return playerInfo.Energy < maxEnergy;
+			//If you have less energy than the max energy, you are hungry
+			return energy < maxEnergy;
+		});
 	}
 
 	bool ShouldEat(Blackboard* pBlackboard) {
-		AgentInfo playerInfo{};
+		float energy{};
 		Inventory* pInventory{};
 		float maxEnergy{};
-		IExamInterface* pInterface{};
 
-		bool dataFound = pBlackboard->GetData("PlayerInfo", playerInfo) &&
-			pBlackboard->GetData("Inventory", pInventory) &&
-			pBlackboard->GetData("MaxPlayerEnergy", maxEnergy) &&
-			pBlackboard->GetData("Interface", pInterface);
+		bool dataFound = pBlackboard->GetData(BB_Keys::PlayerEnergy, energy) &&
+			pBlackboard->GetData(BB_Keys::Inventory, pInventory) &&
+			pBlackboard->GetData(BB_Keys::MaxPlayerEnergy, maxEnergy);
 
-		if (dataFound == false || pInventory == nullptr || pInterface == nullptr) {
+		if (dataFound == false || pInventory == nullptr) {
 			return false;
 		}
 		//If you dont have food you shouldnt eat
@@ -656,12 +684,10 @@ namespace BT_Conditions
 			return false;
 		}
 		//Check the food energy
-		ItemInfo item{};
-		pInterface->Inventory_GetItem(foodIndex, item);
-		int foodEnergy = pInterface->Food_GetEnergy(item);
+		int foodEnergy = pInventory->GetItemValue(foodIndex);
 
 		//Check so you dont waste any food energy
-		if (maxEnergy - playerInfo.Energy > foodEnergy) {
+		if (maxEnergy - energy > foodEnergy) {
 			return true;
 		}
 
@@ -670,17 +696,17 @@ namespace BT_Conditions
 
 	bool WasBitten(Blackboard* pBlackboard) {
 		bool isInDanger{};
-		AgentInfo playerInfo{};
+		bool wasBitten{};
 
-		bool dataFound = pBlackboard->GetData("IsInDanger", isInDanger) &&
-			pBlackboard->GetData("PlayerInfo", playerInfo);
+		bool dataFound = pBlackboard->GetData(BB_Keys::IsInDanger, isInDanger) &&
+			pBlackboard->GetData(BB_Keys::PlayerWasBitten, wasBitten);
 
 		if (dataFound == false) {
 			return false;
 		}
 
-		if (playerInfo.WasBitten) {
-			pBlackboard->ChangeData("IsInDanger", true);
+		if (wasBitten) {
+			pBlackboard->ChangeData(BB_Keys::IsInDanger, true);
 			return true;
 		}
 
@@ -690,7 +716,7 @@ namespace BT_Conditions
 	bool IsItemInFOV(Blackboard* pBlackboard) {
 		std::vector<EntityInfo>* pItemsInFOV{};
 
-		bool dataFound = pBlackboard->GetData("ItemsInFOV", pItemsInFOV);
+		bool dataFound = pBlackboard->GetData(BB_Keys::ItemsInFOV, pItemsInFOV);
 		if (dataFound == false) {
 			return false;
 		}
@@ -700,28 +726,28 @@ namespace BT_Conditions
 	}
 
 	bool IsBitten(Blackboard* pBlackboard) {
-		AgentInfo playerInfo{};
+		bool isBitten{};
 
-		bool dataFound = pBlackboard->GetData("PlayerInfo", playerInfo);
+		bool dataFound = pBlackboard->GetData(BB_Keys::PlayerBitten, isBitten);
 
 		if (dataFound == false) {
 			return false;
 		}
 
 		//Set that you are in danger once bitten
-		if (playerInfo.Bitten) {
-			pBlackboard->ChangeData("IsInDanger", true);
+		if (isBitten) {
+			pBlackboard->ChangeData(BB_Keys::IsInDanger, true);
 		}
 		
-		return playerInfo.Bitten;
+		return isBitten;
 	}
 
 	bool IsItemInPickupRange(Blackboard* pBlackboard) {
 		AgentInfo playerInfo{};
 		EntityInfo itemInfo{};
 
-		bool dataFound = pBlackboard->GetData("PlayerInfo", playerInfo) &&
-			pBlackboard->GetData("ClosestItem", itemInfo);
+		bool dataFound = pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo) &&
+			pBlackboard->GetData(BB_Keys::ClosestItem, itemInfo);
 
 		if (dataFound == false) {
 			return false;
@@ -744,8 +770,8 @@ namespace BT_Conditions
 		Elite::Vector2 target{};
 		const float acceptanceAngle{ 0.08f };
 
-		bool dataFound = pBlackboard->GetData("PlayerInfo", playerInfo) &&
-			pBlackboard->GetData("Target", target);
+		bool dataFound = pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo) &&
+			pBlackboard->GetData(BB_Keys::Target, target);
 
 		if (dataFound == false) {
 			return false;
@@ -753,11 +779,11 @@ namespace BT_Conditions
 
 		const Elite::Vector2 toTarget{ target - playerInfo.Position };
 
-		//angle between -pi and +pi
-		const float angleTo{ atan2f(toTarget.y, toTarget.x) };
+		//angle between -pi and +pi, turn the short way round
+		const float angleTo{ Elite::VectorToOrientation(toTarget) };
 		float angleFrom{ playerInfo.Orientation };
 
-		float deltaAngle = angleTo - angleFrom;
+		float deltaAngle = Elite::DeltaOrientation(angleFrom, angleTo);
 
 		if (abs(deltaAngle) < acceptanceAngle) {
 			return true;
@@ -768,23 +794,22 @@ namespace BT_Conditions
 	}
 
 	bool IsInsideHouse(Blackboard* pBlackboard) {
-		std::vector<HouseSearch>* pKnownHouses{};
-		AgentInfo playerInfo{};
+		KnownHouses* pKnownHouses{};
+		Elite::Vector2 playerPosition{};
 
-		bool dataFound = pBlackboard->GetData("KnownHouses", pKnownHouses) &&
-			pBlackboard->GetData("PlayerInfo", playerInfo);
+		bool dataFound = pBlackboard->GetData(BB_Keys::KnownHouses, pKnownHouses) &&
+			pBlackboard->GetData(BB_Keys::PlayerPosition, playerPosition);
 
 		if (dataFound == false || pKnownHouses == nullptr) {
 			return false;
 		}
 	
 		//Check if you are insideof the house
-		for (HouseSearch& houseSearch : *pKnownHouses) {
-			if (houseSearch.IsPointInsideHouse(playerInfo.Position)) {
-				//Set the current house as the house you are in
-				pBlackboard->ChangeData("CurrentHouse", &houseSearch);
-				return true;
-			}
+		HouseSearch* pHouseSearch = pKnownHouses->FindHouseContaining(playerPosition);
+		if (pHouseSearch != nullptr) {
+			//Set the current house as the house you are in
+			pBlackboard->ChangeData(BB_Keys::CurrentHouse, pHouseSearch);
+			return true;
 		}
 		//You are not inside a known house
 		return false;
@@ -793,7 +818,7 @@ namespace BT_Conditions
 	bool ShouldSearchHouse(Blackboard* pBlackboard) {
 		HouseSearch* pCurrentHouse{};
 
-		bool dataFound = pBlackboard->GetData("CurrentHouse", pCurrentHouse);
+		bool dataFound = pBlackboard->GetData(BB_Keys::CurrentHouse, pCurrentHouse);
 
 		if (dataFound == false || pCurrentHouse == nullptr) {
 			return false;
@@ -804,9 +829,9 @@ namespace BT_Conditions
 	}
 
 	bool ShouldSearchKnownHouse(Blackboard* pBlackboard) {
-		std::vector<HouseSearch>* pKnownHouses{};
+		KnownHouses* pKnownHouses{};
 
-		bool dataFound = pBlackboard->GetData("KnownHouses", pKnownHouses);
+		bool dataFound = pBlackboard->GetData(BB_Keys::KnownHouses, pKnownHouses);
 
 		if (dataFound == false || pKnownHouses == nullptr) {
 			return false;
@@ -815,7 +840,7 @@ namespace BT_Conditions
 		//If any of the houses you know should be looted, check them out
 		for (HouseSearch& houseSearch : *pKnownHouses) {
 			if (houseSearch.shouldCheck) {
-				pBlackboard->ChangeData("CurrentHouse", &houseSearch);
+				pBlackboard->ChangeData(BB_Keys::CurrentHouse, &houseSearch);
 				return true;
 			}
 		}
@@ -828,9 +853,9 @@ namespace BT_Conditions
 		Inventory* pInventory{};
 		IExamInterface* pInterface{};
 
-		auto dataFound = pBlackboard->GetData("ClosestItem", closestItem) &&
-			pBlackboard->GetData("Inventory", pInventory) &&
-			pBlackboard->GetData("Interface", pInterface);
+		auto dataFound = pBlackboard->GetData(BB_Keys::ClosestItem, closestItem) &&
+			pBlackboard->GetData(BB_Keys::Inventory, pInventory) &&
+			pBlackboard->GetData(BB_Keys::Interface, pInterface);
 
 		if (dataFound == false || pInventory == nullptr || pInterface == nullptr) {
 			return false;
@@ -841,19 +866,25 @@ namespace BT_Conditions
 			return false;
 		}
 		
+		//Can throw away an almost empty item to make room
+		const InventoryChangeGuard inventoryChange{ pBlackboard, pInventory };
 		return pInventory->ShouldPickupItem(closestItem);
 	}
 
 	bool IsInNeedOfItem(Blackboard* pBlackboard) {
 		Inventory* pInventory{};
+		std::vector<eItemType>* pNeededItemTypes{};
 
-		bool dataFound = pBlackboard->GetData("Inventory", pInventory);
+		bool dataFound = pBlackboard->GetData(BB_Keys::Inventory, pInventory) &&
+			pBlackboard->GetData(BB_Keys::NeededItemTypes, pNeededItemTypes);
 
-		if (dataFound == false || pInventory == nullptr) {
+		if (dataFound == false || pInventory == nullptr || pNeededItemTypes == nullptr) {
 			return false;
 		}
 
-		std::vector<eItemType> neededItemTypes{};
+		//Filled in place, the list keeps its capacity between frames
+		std::vector<eItemType>& neededItemTypes{ *pNeededItemTypes };
+		neededItemTypes.clear();
 
 		if (!HasGun(pBlackboard)) {
 			//set type of item you need to pistol and shotgun
@@ -876,7 +907,7 @@ namespace BT_Conditions
 			}
 		}
 
-		pBlackboard->ChangeData("NeededItemTypes", neededItemTypes);
+		pBlackboard->MarkChanged(BB_Keys::NeededItemTypes);
 
 		if (neededItemTypes.size() > 0) {
 			return true;
@@ -886,47 +917,28 @@ namespace BT_Conditions
 	}
 
 	bool ShouldPickupKnownItem(Blackboard* pBlackboard) {
-		std::vector<ItemInfo>* pKnownItems{};
-		std::vector<eItemType> neededItemTypes{};
+		KnownItems* pKnownItems{};
+		std::vector<eItemType>* pNeededItemTypes{};
 		AgentInfo playerInfo{};
 		float maxItemWalkRange{};
 
-		bool dataFound = pBlackboard->GetData("KnownItems", pKnownItems) &&
-			pBlackboard->GetData("NeededItemTypes", neededItemTypes) &&
-			pBlackboard->GetData("PlayerInfo", playerInfo) &&
-			pBlackboard->GetData("MaxItemWalkRange", maxItemWalkRange);
+		bool dataFound = pBlackboard->GetData(BB_Keys::KnownItems, pKnownItems) &&
+			pBlackboard->GetData(BB_Keys::NeededItemTypes, pNeededItemTypes) &&
+			pBlackboard->GetData(BB_Keys::PlayerInfo, playerInfo) &&
+			pBlackboard->GetData(BB_Keys::MaxItemWalkRange, maxItemWalkRange);
 
-		if (dataFound == false || pKnownItems == nullptr || neededItemTypes.size() <= 0) {
+		if (dataFound == false || pKnownItems == nullptr || pNeededItemTypes == nullptr || pNeededItemTypes->size() <= 0) {
 			return false;
 		}
 
-		//get the closest known item of the type you need
-		float closestDistance = FLT_MAX;
+		//get the closest known item of the type you need, if its further than the max walkrange, ignore it
 		ItemInfo knownItem{};
-		for (eItemType type : neededItemTypes) {
-			for (const ItemInfo& item : *pKnownItems) {
-				if (item.Type == type) {
-					float distance = playerInfo.Position.Distance(item.Location);
-					if (distance < closestDistance) {
-						closestDistance = distance;
-						knownItem = item;
-					}
-				}
-			}
-		}
-		
-		//if the closestdistance is still max, you dont known any items of those types, return false
-		if (abs(closestDistance - FLT_MAX) <= 0.001f) {
-			return false;
-		}
-
-		//if its further than the max walkrange, ignore it
-		if (closestDistance > maxItemWalkRange) {
+		if (!pKnownItems->FindClosestItem(*pNeededItemTypes, playerInfo.Position, maxItemWalkRange, knownItem)) {
 			return false;
 		}
 
 		//If you get to here, you should go and pick it up, so set the item location as target
-		pBlackboard->ChangeData("Target", knownItem.Location);
+		pBlackboard->ChangeData(BB_Keys::Target, knownItem.Location);
 		return true;
 	}
 
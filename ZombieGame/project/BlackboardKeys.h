@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Exam_HelperStructs.h"
+#include "EBlackboard.h"
+
+class IExamInterface;
+class Inventory;
+struct HouseSearch;
+class KnownHouses;
+class KnownItems;
+class EnemyThreats;
+class PathCache;
+class DangerField;
+class NavigationGrid;
+struct WorldSearch;
+
+//Typed keys for all the data the plugin stores in its blackboard
+//The slot of every key is resolved once, when the key is constructed
+namespace BB_Keys
+{
+	//General
+	const BlackboardKey<IExamInterface*> Interface{ "Interface" };
+	const BlackboardKey<AgentInfo> PlayerInfo{ "PlayerInfo" };
+	//	Parts of the player info the conditionals read, only written when they change
+	const BlackboardKey<float> PlayerHealth{ "PlayerHealth" };
+	const BlackboardKey<float> PlayerEnergy{ "PlayerEnergy" };
+	const BlackboardKey<Elite::Vector2> PlayerPosition{ "PlayerPosition" };
+	const BlackboardKey<bool> PlayerBitten{ "PlayerBitten" };
+	const BlackboardKey<bool> PlayerWasBitten{ "PlayerWasBitten" };
+	const BlackboardKey<WorldInfo> WorldInfo{ "WorldInfo" };
+	const BlackboardKey<SteeringPlugin_Output> SteeringOutput{ "SteeringOutput" };
+	const BlackboardKey<Inventory*> Inventory{ "Inventory" };
+	const BlackboardKey<float> FleeRadius{ "FleeRadius" };
+	const BlackboardKey<std::vector<EnemyInfo>*> EnemiesInFOV{ "EnemiesInFOV" };
+	const BlackboardKey<EnemyThreats*> EnemyThreats{ "EnemyThreats" };
+
+	//Items
+	const BlackboardKey<std::vector<EntityInfo>*> ItemsInFOV{ "ItemsInFOV" };
+	const BlackboardKey<KnownItems*> KnownItems{ "KnownItems" };
+	const BlackboardKey<EntityInfo> ClosestItem{ "ClosestItem" };
+	const BlackboardKey<std::vector<eItemType>*> NeededItemTypes{ "NeededItemTypes" };
+	const BlackboardKey<float> MaxItemWalkRange{ "MaxItemWalkRange" };
+
+	//Purge zone
+	const BlackboardKey<std::vector<PurgeZoneInfo>*> PurgeZonesInFOV{ "PurgeZonesInFOV" };
+	const BlackboardKey<PurgeZoneInfo> CurrentPurgeZone{ "CurrentPurgeZone" };
+
+	//Movement
+	const BlackboardKey<bool> CanRun{ "CanRun" };
+	const BlackboardKey<bool> WasFleeing{ "WasFleeing" };
+	const BlackboardKey<bool> IsFleeing{ "IsFleeing" };
+	const BlackboardKey<Elite::Vector2> Target{ "Target" };
+	const BlackboardKey<Elite::Vector2> FleeTarget{ "FleeTarget" };
+	const BlackboardKey<PathCache*> PathCache{ "PathCache" };
+	const BlackboardKey<DangerField*> DangerField{ "DangerField" };
+
+	//Health
+	const BlackboardKey<float> MaxPlayerHealth{ "MaxPlayerHealth" };
+	const BlackboardKey<bool> IsInDanger{ "IsInDanger" };
+
+	//Food
+	const BlackboardKey<float> MaxPlayerEnergy{ "MaxPlayerEnergy" };
+
+	//Houses
+	const BlackboardKey<std::vector<HouseInfo>*> HousesInFOV{ "HousesInFOV" };
+	const BlackboardKey<KnownHouses*> KnownHouses{ "KnownHouses" };
+	const BlackboardKey<HouseSearch*> CurrentHouse{ "CurrentHouse" };
+	const BlackboardKey<HouseInfo> ClosestHouse{ "ClosestHouse" };
+
+	//World
+	const BlackboardKey<WorldSearch*> WorldSearch{ "WorldSearch" };
+	const BlackboardKey<NavigationGrid*> NavigationGrid{ "NavigationGrid" };
+}
+
+//Pure conditionals that are evaluated at most once per tick, with the keys they read
+//Inventory is changed in place, whatever changes its slots marks it changed with an InventoryChangeGuard,
+//so HasGun is kept until a slot changes, IsHurt and IsHungry until the health or energy changes
+namespace BB_Memos
+{
+	const BlackboardMemoKey HasGun{ "HasGun", { BB_Keys::Inventory.GetSlot() }, true };
+	const BlackboardMemoKey IsHurt{ "IsHurt", { BB_Keys::PlayerHealth.GetSlot(), BB_Keys::MaxPlayerHealth.GetSlot() }, true };
+	const BlackboardMemoKey IsHungry{ "IsHungry", { BB_Keys::PlayerEnergy.GetSlot(), BB_Keys::MaxPlayerEnergy.GetSlot() }, true };
+	const BlackboardMemoKey IsEnemyInFOV{ "IsEnemyInFOV", { BB_Keys::EnemiesInFOV.GetSlot() } };
+}
@@ -0,0 +1,503 @@
+#include "stdafx.h"
+#include "DangerField.h"
+#include "NavigationGrid.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#if !defined(_MSC_VER)
+#include <time.h>
+#endif
+
+namespace {
+	//Enemies are dangerous up to this distance, the most in their center
+	const float EnemyRadius{ 20.f };
+	const float EnemyDanger{ 1.f };
+	//Purge zones are fully dangerous inside, and up to a margin around them
+	const float PurgeZoneMargin{ 5.f };
+	const float PurgeZoneDanger{ 4.f };
+	//Danger of a cell that is all wall
+	const float WallDanger{ 2.f };
+
+	//Distance the agent walks to get rid of one danger
+	const float StayCost{ 100.f };
+	//How much slower walking through one danger is
+	const float TravelWeight{ 1.f };
+
+	const int NeighborCount{ 8 };
+	const int NeighborX[NeighborCount]{ 1, -1, 0, 0, 1, 1, -1, -1 };
+	const int NeighborY[NeighborCount]{ 0, 0, 1, -1, 1, -1, 1, -1 };
+	const float Sqrt2{ 1.41421356f };
+	const size_t StampCapacity{ 32 };
+
+	//Rough cost of the work on one cell, in work units of about 10 ns, a wall sample and a heap step cost the most
+	const int ScanWork{ 1 };
+	const int WallWork{ 16 };
+	const int OpenWork{ 10 };
+	//An update should never take longer than this
+	const double SlowUpdateMicroseconds{ 100.0 };
+
+	double GetMicroseconds(const std::chrono::high_resolution_clock::time_point& start)
+	{
+		return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	//Time the thread ran, so the time it was not scheduled is left out, Windows has no fine thread clock and uses the wall clock
+	double GetThreadMicroseconds()
+	{
+#if defined(_MSC_VER)
+		return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+#else
+		timespec time{};
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+		return time.tv_sec * 1e6 + time.tv_nsec / 1e3;
+#endif
+	}
+}
+
+bool DangerField::Stamp::operator==(const Stamp& stamp) const
+{
+	return cellX == stamp.cellX && cellY == stamp.cellY && radius == stamp.radius && ramp == stamp.ramp && danger == stamp.danger;
+}
+
+DangerField::DangerField(float cellSize, int size, int workBudget)
+	:m_CellSize{ cellSize }
+	, m_Size{ size }
+	, m_WorkBudget{ workBudget }
+{
+	const size_t cellCount{ size_t(m_Size) * m_Size };
+	for (Field* pField : { &m_Field, &m_NextField }) {
+		pField->wallDangers.resize(cellCount);
+		pField->dangers.resize(cellCount);
+		pField->costs.resize(cellCount);
+		pField->parents.resize(cellCount);
+	}
+	m_NewGenerations.resize(cellCount);
+	m_DirtyGenerations.resize(cellCount);
+	m_InvalidGenerations.resize(cellCount);
+	m_ValidGenerations.resize(cellCount);
+	m_Open.reserve(cellCount * 2);
+	m_Chain.reserve(cellCount);
+	//The stamps are copied every update, with room for a crowded FOV they do not grow
+	for (std::vector<Stamp>* pStamps : { &m_Stamps, &m_Field.stamps, &m_NextField.stamps }) {
+		pStamps->reserve(StampCapacity);
+	}
+}
+
+void DangerField::Update(const Elite::Vector2& agentPosition, const std::vector<EnemyInfo>& enemies, const std::vector<PurgeZoneInfo>& purgeZones, const NavigationGrid* pNavigationGrid)
+{
+	const double threadStart{ GetThreadMicroseconds() };
+	const std::chrono::high_resolution_clock::time_point start{ std::chrono::high_resolution_clock::now() };
+
+	AddStamps(enemies, purgeZones);
+	m_pNavigationGrid = pNavigationGrid;
+
+	//The field only moves a whole cell at a time, the cells it moves onto are new
+	const int originX{ int(floorf(agentPosition.x / m_CellSize)) - m_Size / 2 };
+	const int originY{ int(floorf(agentPosition.y / m_CellSize)) - m_Size / 2 };
+	const UINT navigationVersion{ pNavigationGrid != nullptr ? pNavigationGrid->GetVersion() : 0 };
+
+	//A repair that is still going on finishes first, changes since it started are repaired after it
+	const int workBudget{ m_WorkBudget > 0 ? m_WorkBudget : (std::numeric_limits<int>::max)() };
+	int budget{ workBudget };
+	while (budget > 0) {
+		if (m_Phase == Phase::Idle) {
+			if (!HasChanges(originX, originY, navigationVersion)) {
+				break;
+			}
+			//Starting a repair moves every cell, it waits for the next update when that does not fit in what is left
+			if (budget < workBudget && budget < m_Size * m_Size) {
+				break;
+			}
+			BeginRepair(originX, originY, navigationVersion, budget);
+		}
+		if (!Repair(budget)) {
+			break;
+		}
+	}
+	m_IsUpToDate = m_Phase == Phase::Idle && !HasChanges(originX, originY, navigationVersion);
+	m_MaxWork = (std::max)(m_MaxWork, workBudget - budget);
+
+	const double microseconds{ GetMicroseconds(start) };
+	m_TotalMicroseconds += microseconds;
+	m_MaxMicroseconds = (std::max)(m_MaxMicroseconds, microseconds);
+	m_SlowUpdateCount += microseconds > SlowUpdateMicroseconds;
+	//Both clocks can only show more than the work took, the wall clock goes on while the thread is not scheduled and the thread clock is coarse
+	const double threadMicroseconds{ (std::min)(GetThreadMicroseconds() - threadStart, microseconds) };
+	m_MaxThreadMicroseconds = (std::max)(m_MaxThreadMicroseconds, threadMicroseconds);
+	m_SlowThreadUpdateCount += threadMicroseconds > SlowUpdateMicroseconds;
+	++m_UpdateCount;
+}
+
+bool DangerField::GetFleeTarget(const Elite::Vector2& position, Elite::Vector2& target) const
+{
+	//Walls alone are no reason to flee
+	const int index{ GetIndex(position) };
+	if (index == -1 || m_Field.dangers[index] <= m_Field.wallDangers[index]) {
+		return false;
+	}
+
+	int cell{ index };
+	while (m_Field.parents[cell] != -1) {
+		cell = m_Field.parents[cell];
+	}
+	if (cell == index) {
+		return false;
+	}
+	target = Elite::Vector2{ (m_Field.originX + cell % m_Size + 0.5f) * m_CellSize, (m_Field.originY + cell / m_Size + 0.5f) * m_CellSize };
+	return true;
+}
+
+float DangerField::GetDanger(const Elite::Vector2& position) const
+{
+	const int index{ GetIndex(position) };
+	return index == -1 ? 0.f : m_Field.dangers[index];
+}
+
+float DangerField::GetCost(const Elite::Vector2& position) const
+{
+	const int index{ GetIndex(position) };
+	return index == -1 ? 0.f : m_Field.costs[index];
+}
+
+void DangerField::PrintStats() const
+{
+	const UINT repairCount{ m_FullRepairCount + m_PartialRepairCount };
+	printf("DangerField: %u updates, %u full and %u partial repairs of %.1f cells on average taking up to %u updates, %d work units per update max, %.2f us per update on average, %.2f us max, %u over %.0f us, thread time %.2f us max, %u over %.0f us\n",
+		m_UpdateCount, m_FullRepairCount, m_PartialRepairCount, repairCount > 0 ? double(m_RepairedCells) / repairCount : 0.0, m_MaxRepairUpdates,
+		m_MaxWork, m_UpdateCount > 0 ? m_TotalMicroseconds / m_UpdateCount : 0.0, m_MaxMicroseconds, m_SlowUpdateCount, SlowUpdateMicroseconds,
+		m_MaxThreadMicroseconds, m_SlowThreadUpdateCount, SlowUpdateMicroseconds);
+}
+
+bool DangerField::HasChanges(int originX, int originY, UINT navigationVersion) const
+{
+	return m_IsFullUpdateNeeded || !m_Field.isValid || originX != m_Field.originX || originY != m_Field.originY
+		|| navigationVersion != m_Field.navigationVersion || !(m_Stamps == m_Field.stamps);
+}
+
+void DangerField::AddStamps(const std::vector<EnemyInfo>& enemies, const std::vector<PurgeZoneInfo>& purgeZones)
+{
+	m_Stamps.clear();
+	for (const EnemyInfo& enemy : enemies) {
+		m_Stamps.push_back(Stamp{ int(floorf(enemy.Location.x / m_CellSize)), int(floorf(enemy.Location.y / m_CellSize)), EnemyRadius, EnemyRadius, EnemyDanger });
+	}
+	for (const PurgeZoneInfo& purgeZone : purgeZones) {
+		m_Stamps.push_back(Stamp{ int(floorf(purgeZone.Center.x / m_CellSize)), int(floorf(purgeZone.Center.y / m_CellSize)), purgeZone.Radius + PurgeZoneMargin, PurgeZoneMargin, PurgeZoneDanger });
+	}
+}
+
+void DangerField::BeginRepair(int originX, int originY, UINT navigationVersion, int& budget)
+{
+	++m_Generation;
+	m_RepairStartUpdate = m_UpdateCount;
+	const int cellCount{ m_Size * m_Size };
+	budget -= cellCount;
+
+	//Everything is recomputed when the agent got too far since the last field
+	m_IsFullRepair = m_IsFullUpdateNeeded || !m_Field.isValid || abs(originX - m_Field.originX) >= m_Size || abs(originY - m_Field.originY) >= m_Size;
+	m_IsFullUpdateNeeded = false;
+	m_NextField.stamps = m_Stamps;
+	if (m_IsFullRepair) {
+		m_NextField.originX = originX;
+		m_NextField.originY = originY;
+		for (int index{}; index < cellCount; ++index) {
+			m_NewGenerations[index] = m_Generation;
+			m_DirtyGenerations[index] = m_Generation;
+		}
+		m_AreWallsChanged = true;
+		++m_FullRepairCount;
+	}
+	else {
+		MoveCells(originX - m_Field.originX, originY - m_Field.originY);
+		MarkChangedStamps(budget);
+		m_AreWallsChanged = navigationVersion != m_Field.navigationVersion;
+		++m_PartialRepairCount;
+	}
+	m_NextField.navigationVersion = navigationVersion;
+	m_NextField.isValid = true;
+	m_Phase = Phase::Walls;
+	m_Cursor = 0;
+}
+
+bool DangerField::Repair(int& budget)
+{
+	const int cellCount{ m_Size * m_Size };
+	switch (m_Phase) {
+	case Phase::Walls:
+		for (; m_Cursor < cellCount && budget > 0; ++m_Cursor) {
+			const int index{ m_Cursor };
+			budget -= ScanWork;
+			const bool isNew{ m_NewGenerations[index] == m_Generation };
+			if (!isNew && !m_AreWallsChanged) {
+				continue;
+			}
+			budget -= WallWork;
+			const float wallDanger{ GetWallDanger(m_NextField.originX + index % m_Size, m_NextField.originY + index / m_Size) };
+			if (isNew || wallDanger != m_NextField.wallDangers[index]) {
+				m_NextField.wallDangers[index] = wallDanger;
+				m_DirtyGenerations[index] = m_Generation;
+			}
+		}
+		if (m_Cursor < cellCount) {
+			return false;
+		}
+		m_Phase = Phase::Dangers;
+		m_Cursor = 0;
+		//Fall through
+	case Phase::Dangers:
+		for (; m_Cursor < cellCount && budget > 0; ++m_Cursor) {
+			const int index{ m_Cursor };
+			budget -= ScanWork;
+			if (m_DirtyGenerations[index] == m_Generation) {
+				budget -= int(m_NextField.stamps.size());
+				m_NextField.dangers[index] = m_NextField.wallDangers[index] + GetStampDanger(m_NextField.originX + index % m_Size, m_NextField.originY + index / m_Size);
+			}
+		}
+		if (m_Cursor < cellCount) {
+			return false;
+		}
+		m_Phase = Phase::Reset;
+		m_Cursor = 0;
+		m_Open.clear();
+		//Fall through
+	case Phase::Reset:
+		//Every cell whose way to safety goes through a changed cell starts over
+		for (; m_Cursor < cellCount && budget > 0; ++m_Cursor) {
+			const int index{ m_Cursor };
+			const bool isInvalid{ IsInvalid(index) };
+			//Every cell on the way to safety that was followed counts
+			budget -= ScanWork * (1 + int(m_Chain.size()));
+			if (isInvalid) {
+				budget -= ScanWork;
+				m_NextField.costs[index] = GetBaseCost(index);
+				m_NextField.parents[index] = -1;
+				m_Open.push_back(OpenNode{ m_NextField.costs[index], index });
+				++m_RepairedCells;
+			}
+		}
+		if (m_Cursor < cellCount) {
+			return false;
+		}
+		m_Phase = Phase::Seed;
+		m_Cursor = m_IsFullRepair ? cellCount : 0;
+		//Fall through
+	case Phase::Seed:
+		//They can still get to safety through the cells around them that were not changed
+		for (; m_Cursor < cellCount && budget > 0; ++m_Cursor) {
+			const int index{ m_Cursor };
+			budget -= ScanWork;
+			if (IsNextToRepairedCell(index)) {
+				m_Open.push_back(OpenNode{ m_NextField.costs[index], index });
+			}
+		}
+		if (m_Cursor < cellCount) {
+			return false;
+		}
+		m_Phase = Phase::Propagate;
+		budget -= int(m_Open.size());
+		std::make_heap(m_Open.begin(), m_Open.end());
+		//Fall through
+	case Phase::Propagate:
+		while (!m_Open.empty() && budget > 0) {
+			budget -= OpenWork;
+			Propagate(budget);
+		}
+		if (!m_Open.empty()) {
+			return false;
+		}
+		break;
+	case Phase::Idle:
+	default:
+		return false;
+	}
+
+	//Done, the next field is read from now on and the old one is where the next repair starts
+	std::swap(m_Field, m_NextField);
+	m_Phase = Phase::Idle;
+	m_MaxRepairUpdates = (std::max)(m_MaxRepairUpdates, m_UpdateCount - m_RepairStartUpdate + 1);
+	return true;
+}
+
+void DangerField::MoveCells(int moveX, int moveY)
+{
+	m_NextField.originX = m_Field.originX + moveX;
+	m_NextField.originY = m_Field.originY + moveY;
+	for (int y{}; y < m_Size; ++y) {
+		for (int x{}; x < m_Size; ++x) {
+			const int index{ y * m_Size + x };
+			const int oldX{ x + moveX };
+			const int oldY{ y + moveY };
+			if (oldX < 0 || oldY < 0 || oldX >= m_Size || oldY >= m_Size) {
+				//New cell, its walls and danger are computed with the other dirty ones
+				m_NewGenerations[index] = m_Generation;
+				m_DirtyGenerations[index] = m_Generation;
+				continue;
+			}
+			const int oldIndex{ oldY * m_Size + oldX };
+			m_NextField.wallDangers[index] = m_Field.wallDangers[oldIndex];
+			m_NextField.dangers[index] = m_Field.dangers[oldIndex];
+			m_NextField.costs[index] = m_Field.costs[oldIndex];
+			const int oldParent{ m_Field.parents[oldIndex] };
+			m_NextField.parents[index] = -1;
+			if (oldParent != -1) {
+				const int parentX{ oldParent % m_Size - moveX };
+				const int parentY{ oldParent / m_Size - moveY };
+				if (parentX < 0 || parentY < 0 || parentX >= m_Size || parentY >= m_Size) {
+					//Its way to safety left the field
+					m_DirtyGenerations[index] = m_Generation;
+				}
+				else {
+					m_NextField.parents[index] = parentY * m_Size + parentX;
+				}
+			}
+		}
+	}
+}
+
+void DangerField::MarkChangedStamps(int& budget)
+{
+	//Only the stamps that were added or removed change the danger, enemies in the same cell give the same stamp
+	if (m_NextField.stamps == m_Field.stamps) {
+		return;
+	}
+	for (int pass{}; pass < 2; ++pass) {
+		const std::vector<Stamp>& stamps{ pass == 0 ? m_NextField.stamps : m_Field.stamps };
+		for (const Stamp& stamp : stamps) {
+			budget -= int(m_NextField.stamps.size() + m_Field.stamps.size());
+			const auto count{ std::count(m_NextField.stamps.begin(), m_NextField.stamps.end(), stamp) };
+			const auto previousCount{ std::count(m_Field.stamps.begin(), m_Field.stamps.end(), stamp) };
+			if (count != previousCount) {
+				MarkDirty(stamp, budget);
+			}
+		}
+	}
+}
+
+void DangerField::MarkDirty(const Stamp& stamp, int& budget)
+{
+	const int reach{ int(ceilf(stamp.radius / m_CellSize)) };
+	const int minX{ (std::max)(0, stamp.cellX - reach - m_NextField.originX) };
+	const int minY{ (std::max)(0, stamp.cellY - reach - m_NextField.originY) };
+	const int maxX{ (std::min)(m_Size - 1, stamp.cellX + reach - m_NextField.originX) };
+	const int maxY{ (std::min)(m_Size - 1, stamp.cellY + reach - m_NextField.originY) };
+	for (int y{ minY }; y <= maxY; ++y) {
+		budget -= ScanWork;
+		for (int x{ minX }; x <= maxX; ++x) {
+			m_DirtyGenerations[y * m_Size + x] = m_Generation;
+		}
+	}
+}
+
+bool DangerField::IsInvalid(int index)
+{
+	//Follows the way to safety until a cell with a known state, all cells on the way get the same one
+	m_Chain.clear();
+	bool isInvalid{};
+	for (int cell{ index }; cell != -1; cell = m_NextField.parents[cell]) {
+		if (m_DirtyGenerations[cell] == m_Generation || m_InvalidGenerations[cell] == m_Generation) {
+			isInvalid = true;
+			break;
+		}
+		if (m_ValidGenerations[cell] == m_Generation) {
+			break;
+		}
+		m_Chain.push_back(cell);
+	}
+	std::vector<UINT>& generations{ isInvalid ? m_InvalidGenerations : m_ValidGenerations };
+	for (int cell : m_Chain) {
+		generations[cell] = m_Generation;
+	}
+	return isInvalid;
+}
+
+bool DangerField::IsNextToRepairedCell(int index) const
+{
+	if (m_InvalidGenerations[index] == m_Generation || m_DirtyGenerations[index] == m_Generation) {
+		return false;
+	}
+	const int x{ index % m_Size };
+	const int y{ index / m_Size };
+	for (int neighbor{}; neighbor < NeighborCount; ++neighbor) {
+		const int neighborX{ x + NeighborX[neighbor] };
+		const int neighborY{ y + NeighborY[neighbor] };
+		if (neighborX < 0 || neighborY < 0 || neighborX >= m_Size || neighborY >= m_Size) {
+			continue;
+		}
+		const int neighborIndex{ neighborY * m_Size + neighborX };
+		if (m_InvalidGenerations[neighborIndex] == m_Generation || m_DirtyGenerations[neighborIndex] == m_Generation) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void DangerField::Propagate(int& budget)
+{
+	//One step of Dijkstra from every cell in the open heap at once
+	std::pop_heap(m_Open.begin(), m_Open.end());
+	const OpenNode node{ m_Open.back() };
+	m_Open.pop_back();
+	if (node.cost > m_NextField.costs[node.index]) {
+		return;
+	}
+
+	const int x{ node.index % m_Size };
+	const int y{ node.index / m_Size };
+	for (int neighbor{}; neighbor < NeighborCount; ++neighbor) {
+		const int neighborX{ x + NeighborX[neighbor] };
+		const int neighborY{ y + NeighborY[neighbor] };
+		if (neighborX < 0 || neighborY < 0 || neighborX >= m_Size || neighborY >= m_Size) {
+			continue;
+		}
+		const int neighborIndex{ neighborY * m_Size + neighborX };
+		const float cost{ node.cost + GetStepCost(neighborIndex, node.index, neighbor >= 4) };
+		if (cost < m_NextField.costs[neighborIndex]) {
+			m_NextField.costs[neighborIndex] = cost;
+			m_NextField.parents[neighborIndex] = node.index;
+			m_Open.push_back(OpenNode{ cost, neighborIndex });
+			std::push_heap(m_Open.begin(), m_Open.end());
+			budget -= 1;
+		}
+	}
+}
+
+float DangerField::GetStampDanger(int cellX, int cellY) const
+{
+	float danger{};
+	for (const Stamp& stamp : m_NextField.stamps) {
+		const float distance{ Elite::Vector2{ float(cellX - stamp.cellX), float(cellY - stamp.cellY) }.Magnitude() * m_CellSize };
+		danger += stamp.danger * Elite::Clamp((stamp.radius - distance) / stamp.ramp, 0.f, 1.f);
+	}
+	return danger;
+}
+
+float DangerField::GetWallDanger(int cellX, int cellY) const
+{
+	if (m_pNavigationGrid == nullptr) {
+		return 0.f;
+	}
+	const Elite::Vector2 min{ cellX * m_CellSize, cellY * m_CellSize };
+	return WallDanger * m_pNavigationGrid->GetBlockedFraction(min, min + Elite::Vector2{ m_CellSize, m_CellSize });
+}
+
+float DangerField::GetBaseCost(int index) const
+{
+	return m_NextField.dangers[index] * StayCost;
+}
+
+float DangerField::GetStepCost(int from, int to, bool isDiagonal) const
+{
+	return (isDiagonal ? Sqrt2 : 1.f) * m_CellSize * (1.f + TravelWeight * (m_NextField.dangers[from] + m_NextField.dangers[to]) / 2.f);
+}
+
+int DangerField::GetIndex(const Elite::Vector2& position) const
+{
+	if (!m_Field.isValid) {
+		return -1;
+	}
+	const int x{ int(floorf(position.x / m_CellSize)) - m_Field.originX };
+	const int y{ int(floorf(position.y / m_CellSize)) - m_Field.originY };
+	if (x < 0 || y < 0 || x >= m_Size || y >= m_Size) {
+		return -1;
+	}
+	return y * m_Size + x;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Exam_HelperStructs.h"
+
+class NavigationGrid;
+
+//Coarse grid around the agent with the danger of every enemy and purge zone in view, and of the known walls
+//Every cell gets the cost to reach safety from it: staying costs its danger, walking costs the distance, more through danger
+//Following the cheapest neighbors from the agent leads to the safest cell that is worth walking to
+//The cells stay at the same place in the world, when the danger of some cells changed or the field moved onto new cells,
+//only those cells and the ones whose way to safety goes through them are recomputed
+//
+//Every update does at most a fixed amount of work, counted in work units and not in time so runs stay deterministic.
+//Changes are worked in on a second field that replaces the one that is read once it is done,
+//a big change (the first field, or the agent moving far) is spread over as many updates as it needs and the old field is read until then.
+class DangerField final {
+public:
+	//About 5 us of work, an update that finds the field out of the caches takes up to 50 us to read it back in
+	static const int DefaultWorkBudget{ 700 };
+
+	//A work budget of 0 does all the work in the update that saw the change
+	explicit DangerField(float cellSize = 4.f, int size = 25, int workBudget = DefaultWorkBudget);
+	~DangerField() = default;
+
+	//Delete copy and move constructors and operators
+	DangerField(const DangerField& dangerField) = delete;
+	DangerField(DangerField&& dangerField) = delete;
+	DangerField& operator=(const DangerField& dangerField) = delete;
+	DangerField& operator=(DangerField&& dangerField) = delete;
+
+	//Centers the field on the agent and updates the danger, the navigation grid can be nullptr
+	void Update(const Elite::Vector2& agentPosition, const std::vector<EnemyInfo>& enemies, const std::vector<PurgeZoneInfo>& purgeZones, const NavigationGrid* pNavigationGrid);
+	//Recomputes the whole field, starting on the next update
+	void Invalidate() { m_IsFullUpdateNeeded = true; }
+	//False while the field that is read is still behind on what the last update saw
+	bool IsUpToDate() const { return m_IsUpToDate; }
+
+	//Center of the cell the way to safety ends in, returns false if there is no danger at the position or staying is the safest
+	bool GetFleeTarget(const Elite::Vector2& position, Elite::Vector2& target) const;
+	//Danger and cost to reach safety of the cell at the position, 0 outside the field
+	float GetDanger(const Elite::Vector2& position) const;
+	float GetCost(const Elite::Vector2& position) const;
+
+	int GetSize() const { return m_Size; }
+	float GetCellSize() const { return m_CellSize; }
+	void PrintStats() const;
+
+private:
+	//Danger around a point that only changes when the point moves to another cell
+	struct Stamp {
+		int cellX{};
+		int cellY{};
+		float radius{}; //No danger from here on
+		float ramp{}; //Full danger this far inside the radius
+		float danger{};
+		bool operator==(const Stamp& stamp) const;
+	};
+
+	struct OpenNode {
+		float cost{};
+		int index{};
+		bool operator<(const OpenNode& node) const { return cost > node.cost; } //Min heap
+	};
+
+	//Everything that is read, and what it was computed from
+	struct Field {
+		int originX{}; //Cell of the bottom left corner, in world cells
+		int originY{};
+		bool isValid{};
+		UINT navigationVersion{};
+		std::vector<Stamp> stamps{};
+		std::vector<float> wallDangers{};
+		std::vector<float> dangers{};
+		std::vector<float> costs{};
+		std::vector<int> parents{};
+	};
+
+	//Steps of working in the changes, each one can stop when the budget is used and go on in the next update
+	enum class Phase {
+		Idle,
+		Walls, //Samples the new cells, or all cells when the walls changed
+		Dangers, //Recomputes the danger of the dirty cells
+		Reset, //Resets the cells whose way to safety goes through a dirty cell
+		Seed, //Opens the cells around the reset ones
+		Propagate //Dijkstra from the open cells
+	};
+
+	const float m_CellSize;
+	const int m_Size;
+	const int m_WorkBudget;
+	bool m_IsFullUpdateNeeded{ true };
+	bool m_IsUpToDate{};
+	const NavigationGrid* m_pNavigationGrid{ nullptr };
+	std::vector<Stamp> m_Stamps{};
+
+	Field m_Field{};
+	Field m_NextField{};
+
+	//Repair state of the next field, a cell is only marked for the repair whose generation it has
+	Phase m_Phase{ Phase::Idle };
+	int m_Cursor{};
+	bool m_IsFullRepair{};
+	bool m_AreWallsChanged{};
+	std::vector<UINT> m_NewGenerations{};
+	std::vector<UINT> m_DirtyGenerations{};
+	std::vector<UINT> m_InvalidGenerations{};
+	std::vector<UINT> m_ValidGenerations{};
+	UINT m_Generation{};
+	std::vector<int> m_Chain{};
+	std::vector<OpenNode> m_Open{};
+
+	UINT m_UpdateCount{};
+	UINT m_FullRepairCount{};
+	UINT m_PartialRepairCount{};
+	UINT m_RepairStartUpdate{};
+	UINT m_MaxRepairUpdates{};
+	unsigned long long m_RepairedCells{};
+	int m_MaxWork{};
+	double m_TotalMicroseconds{};
+	double m_MaxMicroseconds{};
+	UINT m_SlowUpdateCount{};
+	double m_MaxThreadMicroseconds{};
+	UINT m_SlowThreadUpdateCount{};
+
+	bool HasChanges(int originX, int originY, UINT navigationVersion) const;
+	void AddStamps(const std::vector<EnemyInfo>& enemies, const std::vector<PurgeZoneInfo>& purgeZones);
+	//Starts the next field from the one that is read, moved to the new origin
+	void BeginRepair(int originX, int originY, UINT navigationVersion, int& budget);
+	//Returns true when the next field is done and replaced the one that is read
+	bool Repair(int& budget);
+	void MoveCells(int moveX, int moveY);
+	//Marks the cells of the stamps that were added or removed dirty
+	void MarkChangedStamps(int& budget);
+	void MarkDirty(const Stamp& stamp, int& budget);
+	bool IsInvalid(int index);
+	bool IsNextToRepairedCell(int index) const;
+	void Propagate(int& budget);
+
+	float GetStampDanger(int cellX, int cellY) const;
+	float GetWallDanger(int cellX, int cellY) const;
+	float GetBaseCost(int index) const;
+	float GetStepCost(int from, int to, bool isDiagonal) const;
+	int GetIndex(const Elite::Vector2& position) const;
+};
@@ -0,0 +1,172 @@
+/*=============================================================================*/
+// Copyright 2021-2022 Elite Engine
+/*=============================================================================*/
+// EBehaviorNodePool.h: Allocator that keeps all nodes of one behavior tree together in memory
+/*=============================================================================*/
+#ifndef ELITE_BEHAVIOR_NODE_POOL
+#define ELITE_BEHAVIOR_NODE_POOL
+
+//--- Includes ---
+#include <cstddef>
+#include <cstdio>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//-----------------------------------------------------------------
+// BEHAVIOR NODE POOL
+//-----------------------------------------------------------------
+//Same idea as the b2BlockAllocator of Box2D, but nodes of a tree are never freed one by one,
+//so there are no free lists: creating a node only moves a pointer forward in the block.
+//When the size of the whole tree is passed to the constructor, the tree is one contiguous block
+//and the nodes are in the order they were created. Destroying the pool destroys every node it created
+//and gives the memory back at once, a node created in the pool must never be deleted.
+class BehaviorNodePool final
+{
+public:
+	explicit BehaviorNodePool(size_t blockSize = 4 * 1024, size_t nodeCount = 0)
+		: m_BlockSize(GetAllocationSize(blockSize > 0 ? blockSize : 1))
+	{
+		m_Nodes.reserve(nodeCount);
+		AddBlock(m_BlockSize);
+	}
+	~BehaviorNodePool()
+	{
+		//Children can still be used by the destructor of their parent, destroy in the reverse order of creation
+		for (auto it = m_Nodes.rbegin(); it != m_Nodes.rend(); ++it)
+			it->fpDestroy(it->pNode);
+		for (const Block& block : m_Blocks)
+			::operator delete(block.pData);
+	}
+
+	BehaviorNodePool(const BehaviorNodePool& other) = delete;
+	BehaviorNodePool& operator=(const BehaviorNodePool& other) = delete;
+	BehaviorNodePool(BehaviorNodePool&& other) = delete;
+	BehaviorNodePool& operator=(BehaviorNodePool&& other) = delete;
+
+	template<typename T, typename... Args>
+	T* Create(Args&&... args)
+	{
+		T* pNode = new (Allocate(sizeof(T))) T(std::forward<Args>(args)...);
+		if (!std::is_trivially_destructible<T>::value)
+			m_Nodes.push_back(NodeRecord{ pNode, &DestroyNode<T> });
+		return pNode;
+	}
+	//For the child lists of composites, the elements are value initialized
+	template<typename T>
+	T* CreateArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "Arrays in the node pool are never destroyed");
+		T* pArray = static_cast<T*>(Allocate(count * sizeof(T)));
+		for (size_t index = 0; index < count; ++index)
+			new (pArray + index) T();
+		return pArray;
+	}
+
+	//Every allocation starts at this alignment, use this to compute the size of a tree up front
+	static constexpr size_t GetAllocationSize(size_t size)
+	{
+		return (size + Alignment - 1) / Alignment * Alignment;
+	}
+
+	size_t GetUsedSize() const { return m_UsedSize; }
+	size_t GetCapacity() const
+	{
+		size_t capacity = 0;
+		for (const Block& block : m_Blocks)
+			capacity += block.Size;
+		return capacity;
+	}
+	//One block means the whole tree is contiguous
+	size_t GetBlockCount() const { return m_Blocks.size(); }
+
+	void PrintStats() const
+	{
+		printf("BehaviorNodePool: %zu nodes with a destructor, %zu bytes used, %zu bytes capacity, %zu blocks \n",
+			m_Nodes.size(), m_UsedSize, GetCapacity(), m_Blocks.size());
+	}
+
+private:
+	static constexpr size_t Alignment = alignof(std::max_align_t);
+
+	struct Block
+	{
+		char* pData = nullptr;
+		size_t Size = 0;
+		size_t Used = 0;
+	};
+	struct NodeRecord
+	{
+		void* pNode = nullptr;
+		void(*fpDestroy)(void*) = nullptr;
+	};
+
+	std::vector<Block> m_Blocks = {};
+	std::vector<NodeRecord> m_Nodes = {};
+	size_t m_BlockSize = 0;
+	size_t m_UsedSize = 0;
+
+	template<typename T>
+	static void DestroyNode(void* pNode)
+	{
+		static_cast<T*>(pNode)->~T();
+	}
+
+	void* Allocate(size_t size)
+	{
+		size = GetAllocationSize(size);
+		if (m_Blocks.back().Used + size > m_Blocks.back().Size)
+			AddBlock(size > m_BlockSize ? size : m_BlockSize);
+
+		Block& block = m_Blocks.back();
+		void* pData = block.pData + block.Used;
+		block.Used += size;
+		m_UsedSize += size;
+		return pData;
+	}
+
+	void AddBlock(size_t size)
+	{
+		Block block{};
+		block.pData = static_cast<char*>(::operator new(size));
+		block.Size = size;
+		m_Blocks.push_back(block);
+	}
+};
+
+//-----------------------------------------------------------------
+// CACHE LINE ALLOCATOR
+//-----------------------------------------------------------------
+//Before C++17 the default allocator ignores alignas above the alignment of new,
+//so the elements of a vector with this allocator start on the alignment of T.
+//Over allocates like the blackboard arena, the start of the raw allocation is kept in front of the elements.
+template<typename T>
+class CacheLineAllocator
+{
+public:
+	using value_type = T;
+
+	CacheLineAllocator() = default;
+	template<typename U> CacheLineAllocator(const CacheLineAllocator<U>&) {}
+
+	T* allocate(size_t count)
+	{
+		char* pRaw = static_cast<char*>(::operator new(count * sizeof(T) + alignof(T) + sizeof(void*)));
+		const size_t start = reinterpret_cast<size_t>(pRaw) + sizeof(void*);
+		char* pAligned = pRaw + sizeof(void*) + (alignof(T) - start % alignof(T)) % alignof(T);
+		reinterpret_cast<void**>(pAligned)[-1] = pRaw;
+		return reinterpret_cast<T*>(pAligned);
+	}
+	void deallocate(T* p, size_t)
+	{
+		::operator delete(reinterpret_cast<void**>(p)[-1]);
+	}
+};
+
+template<typename T, typename U>
+bool operator==(const CacheLineAllocator<T>&, const CacheLineAllocator<U>&) { return true; }
+template<typename T, typename U>
+bool operator!=(const CacheLineAllocator<T>&, const CacheLineAllocator<U>&) { return false; }
+
+#endif
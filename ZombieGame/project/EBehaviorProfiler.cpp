@@ -0,0 +1,292 @@
+//=== General Includes ===
+#include "stdafx.h"
+#include "EBehaviorProfiler.h"
+#include "EBehaviorTree.h"
+#include <iomanip>
+
+namespace
+{
+	const unsigned int InvalidNodeIndex = 0xFFFFFFFFU;
+
+	const void* GetLeafFunction(const IBehavior* pBehavior, bool& isInverted)
+	{
+		isInverted = false;
+		if (const BehaviorConditional* pConditional = dynamic_cast<const BehaviorConditional*>(pBehavior))
+			return reinterpret_cast<const void*>(pConditional->GetFunction());
+		if (const InvertedBehaviorConditional* pInverted = dynamic_cast<const InvertedBehaviorConditional*>(pBehavior))
+		{
+			isInverted = true;
+			return reinterpret_cast<const void*>(pInverted->GetFunction());
+		}
+		if (const BehaviorAction* pAction = dynamic_cast<const BehaviorAction*>(pBehavior))
+			return reinterpret_cast<const void*>(pAction->GetFunction());
+		return nullptr;
+	}
+
+	std::string GetBehaviorName(const IBehavior* pBehavior, unsigned int childIndex)
+	{
+		//Composites get their index in the parent, so sibling composites are not merged in a flame graph
+		const char* pCompositeName = nullptr;
+		if (dynamic_cast<const BehaviorPartialSequence*>(pBehavior))
+			pCompositeName = "PartialSequence";
+		else if (dynamic_cast<const BehaviorSequence*>(pBehavior))
+			pCompositeName = "Sequence";
+		else if (dynamic_cast<const BehaviorSelector*>(pBehavior))
+			pCompositeName = "Selector";
+		if (pCompositeName != nullptr)
+			return std::string(pCompositeName) + "[" + std::to_string(childIndex) + "]";
+
+		bool isInverted = false;
+		const void* pFunction = GetLeafFunction(pBehavior, isInverted);
+		if (const char* pName = BehaviorProfiler::GetFunctionName(pFunction))
+			return std::string(isInverted ? "!" : "") + pName;
+
+		if (dynamic_cast<const BehaviorAction*>(pBehavior))
+			return "Action[" + std::to_string(childIndex) + "]";
+		if (dynamic_cast<const BehaviorConditional*>(pBehavior) || isInverted)
+			return std::string(isInverted ? "!" : "") + "Conditional[" + std::to_string(childIndex) + "]";
+		return "Behavior[" + std::to_string(childIndex) + "]";
+	}
+}
+
+//-----------------------------------------------------------------
+// FUNCTION NAMES
+//-----------------------------------------------------------------
+std::vector<std::pair<const void*, std::string>>& BehaviorProfiler::GetFunctionNames()
+{
+	static std::vector<std::pair<const void*, std::string>> functionNames{};
+	return functionNames;
+}
+
+void BehaviorProfiler::SetFunctionName(const void* pFunction, const char* name)
+{
+	for (auto& functionName : GetFunctionNames())
+	{
+		if (functionName.first == pFunction)
+		{
+			functionName.second = name;
+			return;
+		}
+	}
+	GetFunctionNames().push_back(std::make_pair(pFunction, std::string(name)));
+}
+
+const char* BehaviorProfiler::GetFunctionName(const void* pFunction)
+{
+	if (pFunction == nullptr)
+		return nullptr;
+	for (const auto& functionName : GetFunctionNames())
+	{
+		if (functionName.first == pFunction)
+			return functionName.second.c_str();
+	}
+	return nullptr;
+}
+
+//-----------------------------------------------------------------
+// ATTACH
+//-----------------------------------------------------------------
+void BehaviorProfiler::Attach(IBehavior* pRootBehavior)
+{
+	Detach();
+	if (pRootBehavior != nullptr)
+		AttachBehavior(pRootBehavior, InvalidNodeIndex, 0);
+
+#ifdef ELITE_BEHAVIOR_PROFILER
+	//Only hand out pointers once the array is complete
+	for (size_t index = 0; index < m_Behaviors.size(); ++index)
+		m_Behaviors[index]->SetProfile(&m_Nodes[index]);
+#endif
+	Reset();
+}
+
+void BehaviorProfiler::AttachBehavior(IBehavior* pBehavior, unsigned int parentIndex, unsigned int childIndex)
+{
+	const unsigned int nodeIndex = static_cast<unsigned int>(m_Nodes.size());
+	BehaviorNodeProfile node{};
+	node.Name = GetBehaviorName(pBehavior, childIndex);
+	node.ParentIndex = parentIndex;
+	node.Depth = parentIndex == InvalidNodeIndex ? 0 : m_Nodes[parentIndex].Depth + 1;
+	m_Nodes.push_back(node);
+	m_Behaviors.push_back(pBehavior);
+
+	if (const BehaviorComposite* pComposite = dynamic_cast<const BehaviorComposite*>(pBehavior))
+	{
+		const BehaviorChildren& children = pComposite->GetChildBehaviors();
+		for (unsigned int child = 0; child < children.size(); ++child)
+			AttachBehavior(children[child], nodeIndex, child);
+	}
+}
+
+void BehaviorProfiler::Detach()
+{
+#ifdef ELITE_BEHAVIOR_PROFILER
+	for (IBehavior* pBehavior : m_Behaviors)
+		pBehavior->SetProfile(nullptr);
+#endif
+	m_Behaviors.clear();
+	m_Nodes.clear();
+}
+
+void BehaviorProfiler::Reset()
+{
+	for (BehaviorNodeProfile& node : m_Nodes)
+	{
+		for (unsigned long long& stateCount : node.StateCounts)
+			stateCount = 0;
+		node.TimedCount = 0;
+		node.TotalCycles = 0;
+		node.MaxCycles = 0;
+	}
+	m_StartCycles = GetCycles();
+	m_StartTime = std::chrono::high_resolution_clock::now();
+}
+
+//-----------------------------------------------------------------
+// QUERIES
+//-----------------------------------------------------------------
+double BehaviorProfiler::GetNanosecondsPerCycle() const
+{
+	const unsigned long long cycles = GetCycles() - m_StartCycles;
+	if (cycles == 0)
+		return 0.0;
+	const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - m_StartTime).count();
+	return nanoseconds / static_cast<double>(cycles);
+}
+
+double BehaviorProfiler::GetTotalCycles(unsigned int nodeIndex) const
+{
+	//Only the executions in timed ticks were timed, the others are taken to cost the same on average
+	const BehaviorNodeProfile& node = m_Nodes[nodeIndex];
+	if (node.TimedCount == 0)
+		return 0.0;
+	return double(node.TotalCycles) * double(node.GetExecutionCount()) / double(node.TimedCount);
+}
+
+double BehaviorProfiler::GetSelfCycles(unsigned int nodeIndex) const
+{
+	//Children follow their parent in pre-order, the subtree ends at the first node that is not deeper
+	double childCycles = 0.0;
+	for (unsigned int index = nodeIndex + 1; index < m_Nodes.size() && m_Nodes[index].Depth > m_Nodes[nodeIndex].Depth; ++index)
+	{
+		if (m_Nodes[index].ParentIndex == nodeIndex)
+			childCycles += GetTotalCycles(index);
+	}
+	const double totalCycles = GetTotalCycles(nodeIndex);
+	return totalCycles > childCycles ? totalCycles - childCycles : 0.0;
+}
+
+std::string BehaviorProfiler::GetStack(unsigned int nodeIndex) const
+{
+	std::string stack = m_Nodes[nodeIndex].Name;
+	for (unsigned int index = m_Nodes[nodeIndex].ParentIndex; index != InvalidNodeIndex; index = m_Nodes[index].ParentIndex)
+		stack = m_Nodes[index].Name + ";" + stack;
+	return stack;
+}
+
+//-----------------------------------------------------------------
+// OUTPUTS
+//-----------------------------------------------------------------
+bool BehaviorProfiler::WriteCSV(const std::string& filePath) const
+{
+	std::ofstream file(filePath);
+	if (!file)
+	{
+		printf("WARNING: could not write behavior profile to %s\n", filePath.c_str());
+		return false;
+	}
+
+	const double nsPerCycle = GetNanosecondsPerCycle();
+	file << std::fixed << std::setprecision(1);
+	file << "index,parent,depth,name,executions,success,failure,running,total_ns,self_ns,average_ns,max_ns\n";
+	for (unsigned int index = 0; index < m_Nodes.size(); ++index)
+	{
+		const BehaviorNodeProfile& node = m_Nodes[index];
+		const unsigned long long executionCount = node.GetExecutionCount();
+		const double averageCycles = node.TimedCount > 0 ? double(node.TotalCycles) / double(node.TimedCount) : 0.0;
+		file << index << ',' << (node.ParentIndex == InvalidNodeIndex ? -1 : int(node.ParentIndex)) << ',' << node.Depth << ','
+			<< node.Name << ',' << executionCount << ',' << node.StateCounts[static_cast<int>(BehaviorState::Success)] << ','
+			<< node.StateCounts[static_cast<int>(BehaviorState::Failure)] << ',' << node.StateCounts[static_cast<int>(BehaviorState::Running)] << ','
+			<< GetTotalCycles(index) * nsPerCycle << ',' << GetSelfCycles(index) * nsPerCycle << ','
+			<< averageCycles * nsPerCycle << ',' << node.MaxCycles * nsPerCycle << '\n';
+	}
+	return true;
+}
+
+bool BehaviorProfiler::WriteJSON(const std::string& filePath) const
+{
+	std::ofstream file(filePath);
+	if (!file)
+	{
+		printf("WARNING: could not write behavior profile to %s\n", filePath.c_str());
+		return false;
+	}
+
+	//Nested like the tree, every node closes once the next node is not deeper
+	const double nsPerCycle = GetNanosecondsPerCycle();
+	file << std::fixed << std::setprecision(1);
+	for (unsigned int index = 0; index < m_Nodes.size(); ++index)
+	{
+		const BehaviorNodeProfile& node = m_Nodes[index];
+		const std::string indent(node.Depth * 2, ' ');
+		if (index > 0 && node.ParentIndex == index - 1)
+			file << ",\n" << indent << "\"children\": [\n";
+		else if (index > 0)
+			file << ",\n";
+
+		file << indent << "{ \"name\": \"" << node.Name << "\", \"executions\": " << node.GetExecutionCount()
+			<< ", \"success\": " << node.StateCounts[static_cast<int>(BehaviorState::Success)]
+			<< ", \"failure\": " << node.StateCounts[static_cast<int>(BehaviorState::Failure)]
+			<< ", \"running\": " << node.StateCounts[static_cast<int>(BehaviorState::Running)]
+			<< ", \"total_ns\": " << GetTotalCycles(index) * nsPerCycle << ", \"self_ns\": " << GetSelfCycles(index) * nsPerCycle
+			<< ", \"max_ns\": " << node.MaxCycles * nsPerCycle;
+
+		const unsigned int nextDepth = index + 1 < m_Nodes.size() ? m_Nodes[index + 1].Depth : 0;
+		if (nextDepth > node.Depth)
+			continue;
+		file << " }";
+		for (unsigned int depth = node.Depth; depth > nextDepth; --depth)
+			file << "\n" << std::string((depth - 1) * 2, ' ') << "] }";
+	}
+	file << "\n";
+	return true;
+}
+
+bool BehaviorProfiler::WriteFoldedStacks(const std::string& filePath) const
+{
+	std::ofstream file(filePath);
+	if (!file)
+	{
+		printf("WARNING: could not write behavior profile to %s\n", filePath.c_str());
+		return false;
+	}
+
+	const double nsPerCycle = GetNanosecondsPerCycle();
+	for (unsigned int index = 0; index < m_Nodes.size(); ++index)
+	{
+		const unsigned long long selfNanoseconds = static_cast<unsigned long long>(GetSelfCycles(index) * nsPerCycle);
+		if (selfNanoseconds > 0)
+			file << GetStack(index) << ' ' << selfNanoseconds << '\n';
+	}
+	return true;
+}
+
+void BehaviorProfiler::PrintBreakdown() const
+{
+	if (m_Nodes.empty())
+		return;
+
+	const double nsPerCycle = GetNanosecondsPerCycle();
+	const double rootCycles = m_Nodes[0].TotalCycles > 0 ? GetTotalCycles(0) : 1.0;
+	printf("%-48s %10s %10s %10s %7s %7s\n", "node", "calls", "avg ns", "max ns", "total%", "self%");
+	for (unsigned int index = 0; index < m_Nodes.size(); ++index)
+	{
+		const BehaviorNodeProfile& node = m_Nodes[index];
+		const std::string name = std::string(node.Depth * 2, ' ') + node.Name;
+		const unsigned long long executionCount = node.GetExecutionCount();
+		const double averageCycles = node.TimedCount > 0 ? double(node.TotalCycles) / double(node.TimedCount) : 0.0;
+		printf("%-48s %10llu %10.1f %10.1f %6.1f%% %6.1f%%\n", name.c_str(), executionCount,
+			averageCycles * nsPerCycle, node.MaxCycles * nsPerCycle,
+			100.0 * GetTotalCycles(index) / rootCycles, 100.0 * GetSelfCycles(index) / rootCycles);
+	}
+}
@@ -0,0 +1,122 @@
+/*=============================================================================*/
+// Copyright 2021-2022 Elite Engine
+/*=============================================================================*/
+// EBehaviorProfiler.h: Per node statistics of a BehaviorTree
+/*=============================================================================*/
+#ifndef ELITE_BEHAVIOR_PROFILER_H
+#define ELITE_BEHAVIOR_PROFILER_H
+
+//--- Includes ---
+#include "EBehaviorNodePool.h"
+#include <chrono>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+//The profiler hooks are only compiled in when ELITE_BEHAVIOR_PROFILER is defined,
+//without it a BehaviorTree executes exactly like before and none of this is used.
+class IBehavior;
+
+//-----------------------------------------------------------------
+// BEHAVIOR NODE PROFILE
+//-----------------------------------------------------------------
+//The counters written on every execution come first and share one cache line, no two nodes share one
+struct alignas(64) BehaviorNodeProfile
+{
+	unsigned long long StateCounts[3] = {}; //Executions that returned each BehaviorState
+	unsigned long long TimedCount = 0; //Executions in a timed tick
+	unsigned long long TotalCycles = 0; //Of the timed executions, including the children
+	unsigned long long MaxCycles = 0;
+
+	std::string Name = {};
+	unsigned int ParentIndex = 0xFFFFFFFFU; //Index of the parent node, invalid for the root
+	unsigned int Depth = 0;
+
+	unsigned long long GetExecutionCount() const { return StateCounts[0] + StateCounts[1] + StateCounts[2]; }
+};
+
+//-----------------------------------------------------------------
+// BEHAVIOR PROFILER
+//-----------------------------------------------------------------
+//Owns the profile of every node of one tree, nodes point into it so the array never grows after Attach.
+//Times are measured with the cycle counter and converted to nanoseconds when the profile is written.
+//Every execution is counted, but only one tick in TimedTickInterval is timed: reading the counter can cost
+//as much as a whole node (about 25 ns in a virtual machine). In a timed tick the counter is read once per node,
+//when it returns, a node starts where the node before it returned or where the tick started.
+//Totals are scaled from the timed executions to all of them, self times are a total minus the totals of the children.
+class BehaviorProfiler final
+{
+public:
+	BehaviorProfiler() = default;
+	~BehaviorProfiler() = default; //Does not touch the nodes, they may already be deleted
+
+	BehaviorProfiler(const BehaviorProfiler& other) = delete;
+	BehaviorProfiler& operator=(const BehaviorProfiler& other) = delete;
+
+	static unsigned long long GetCycles()
+	{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return static_cast<unsigned long long>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+#endif
+	}
+
+	static const unsigned int TimedTickInterval = 4;
+
+	//Timing state of the tick that is executing on this thread
+	struct TickClock
+	{
+		unsigned long long LastCycles = 0; //Counter read when the last node returned, or the tick started
+		unsigned int TickCount = 0;
+		bool IsTimed = false;
+	};
+	static TickClock& GetTickClock()
+	{
+		static thread_local TickClock tickClock{};
+		return tickClock;
+	}
+	//The tree calls it before it executes the root
+	static void BeginTick()
+	{
+		TickClock& tickClock = GetTickClock();
+		tickClock.IsTimed = ++tickClock.TickCount % TimedTickInterval == 0;
+		if (tickClock.IsTimed)
+			tickClock.LastCycles = GetCycles();
+	}
+
+	//Leaves are named after the function they call, when it was given a name
+	static void SetFunctionName(const void* pFunction, const char* name);
+	static const char* GetFunctionName(const void* pFunction);
+
+	void Attach(IBehavior* pRootBehavior);
+	void Detach();
+	void Reset();
+
+	const std::vector<BehaviorNodeProfile, CacheLineAllocator<BehaviorNodeProfile>>& GetNodes() const { return m_Nodes; }
+	double GetNanosecondsPerCycle() const;
+
+	//Outputs
+	bool WriteCSV(const std::string& filePath) const;
+	bool WriteJSON(const std::string& filePath) const;
+	bool WriteFoldedStacks(const std::string& filePath) const; //Input for flame graph tools, in nanoseconds of self time
+	void PrintBreakdown() const;
+
+private:
+	std::vector<BehaviorNodeProfile, CacheLineAllocator<BehaviorNodeProfile>> m_Nodes = {};
+	std::vector<IBehavior*> m_Behaviors = {};
+
+	//Cycle counter calibration, taken at Attach/Reset
+	unsigned long long m_StartCycles = 0;
+	std::chrono::high_resolution_clock::time_point m_StartTime = {};
+
+	static std::vector<std::pair<const void*, std::string>>& GetFunctionNames();
+	void AttachBehavior(IBehavior* pBehavior, unsigned int parentIndex, unsigned int childIndex);
+	double GetTotalCycles(unsigned int nodeIndex) const;
+	double GetSelfCycles(unsigned int nodeIndex) const;
+	std::string GetStack(unsigned int nodeIndex) const;
+};
+
+#endif
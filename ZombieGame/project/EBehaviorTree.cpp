@@ -11,139 +11,90 @@ BehaviorState BehaviorSelector::Execute(Blackboard* pBlackBoard)
 {
 	// Loop over all children in m_ChildBehaviors
 	for (auto& child : m_ChildBehaviors) {
-		//Every Child: Execute and store the result in m_CurrentState
-		m_CurrentState = child->Execute(pBlackBoard);
+		//Every Child: Execute and store the result in currentState
+		const BehaviorState currentState = ExecuteBehavior(child, pBlackBoard);
 		//Check the currentstate and apply the selector Logic:
-		//if (m_CurrentState == BehaviorState::Success) {
+		//if (currentState == BehaviorState::Success) {
 		//	//if a child returns Success:
 		//	//stop looping over all children and return Success
-		//	return m_CurrentState;
+		//	return currentState;
 		//}
-		//if (m_CurrentState == BehaviorState::Running) {
+		//if (currentState == BehaviorState::Running) {
 		//	//if a child returns Running:
 		//	//Running: stop looping and return Running
-		//	return m_CurrentState;
+		//	return currentState;
 		//}
 
 		////option 2
-		//if (m_CurrentState != BehaviorState::Failure) {
-		//	return m_CurrentState;
+		//if (currentState != BehaviorState::Failure) {
+		//	return currentState;
 		//}
 		//option 3
-		switch (m_CurrentState) {
+		switch (currentState) {
 		default:
 		case BehaviorState::Failure:
 			continue;
 		case BehaviorState::Success:
 		case BehaviorState::Running:
-			return m_CurrentState;
+			return currentState;
 		}
 	}
 	//The selector fails if all children failed.
 	//All children failed
-	m_CurrentState = BehaviorState::Failure;
-	return m_CurrentState;
+	return BehaviorState::Failure;
 }
 //SEQUENCE
 BehaviorState BehaviorSequence::Execute(Blackboard* pBlackBoard)
 {
 	//Loop over all children in m_ChildBehaviors
 	for (auto& child : m_ChildBehaviors) {
-		//Every Child: Execute and store the result in m_CurrentState
-		m_CurrentState = child->Execute(pBlackBoard);
+		//Every Child: Execute and store the result in currentState
+		const BehaviorState currentState = ExecuteBehavior(child, pBlackBoard);
 		//Check the currentstate and apply the sequence Logic:
 		//if a child returns Failed:
 			//stop looping over all children and return Failed
 		//if a child returns Running:
 			//Running: stop looping and return Running
-		switch (m_CurrentState) {
+		switch (currentState) {
 		default:
 		case BehaviorState::Success:
 			continue;
 		case BehaviorState::Failure:
 		case BehaviorState::Running:
-			return m_CurrentState;
+			return currentState;
 		}
 		//The selector succeeds if all children succeeded.
 	}
 	//All children succeeded 
-	m_CurrentState = BehaviorState::Success;
-	return m_CurrentState;
+	return BehaviorState::Success;
 }
 //PARTIAL SEQUENCE
+unsigned int BehaviorPartialSequence::GetNextStateIndex()
+{
+	//Trees are built on one thread, only executing them can happen in parallel
+	static unsigned int nextStateIndex = 0;
+	return nextStateIndex++;
+}
+
 BehaviorState BehaviorPartialSequence::Execute(Blackboard* pBlackBoard)
 {
-	while (m_CurrentBehaviorIndex < m_ChildBehaviors.size())
+	unsigned int& currentBehaviorIndex = pBlackBoard->GetBehaviorState(m_StateIndex);
+	while (currentBehaviorIndex < m_ChildBehaviors.size())
 	{
-		m_CurrentState = m_ChildBehaviors[m_CurrentBehaviorIndex]->Execute(pBlackBoard);
-		switch (m_CurrentState)
+		switch (ExecuteBehavior(m_ChildBehaviors[currentBehaviorIndex], pBlackBoard))
 		{
 		case BehaviorState::Failure:
-			m_CurrentBehaviorIndex = 0;
-			return m_CurrentState;
+			currentBehaviorIndex = 0;
+			return BehaviorState::Failure;
 		case BehaviorState::Success:
-			++m_CurrentBehaviorIndex;
-			m_CurrentState = BehaviorState::Running;
-			return m_CurrentState;
+			++currentBehaviorIndex;
+			return BehaviorState::Running;
 		case BehaviorState::Running:
-			return m_CurrentState;
+			return BehaviorState::Running;
 		}
 	}
 
-	m_CurrentBehaviorIndex = 0;
-	m_CurrentState = BehaviorState::Success;
-	return m_CurrentState;
-}
-#pragma endregion
-//-----------------------------------------------------------------
-// BEHAVIOR TREE CONDITIONAL (IBehavior)
-//-----------------------------------------------------------------
-BehaviorState BehaviorConditional::Execute(Blackboard* pBlackBoard)
-{
-	if (m_fpConditional == nullptr)
-		return BehaviorState::Failure;
-
-	switch (m_fpConditional(pBlackBoard))
-	{
-	case true:
-		m_CurrentState = BehaviorState::Success;
-		return m_CurrentState;
-	case false:
-		m_CurrentState = m_CurrentState = BehaviorState::Failure;
-		return m_CurrentState;
-	}
-
-	return BehaviorState::Failure;
-}
-//-----------------------------------------------------------------
-// BEHAVIOR TREE ACTION (IBehavior)
-//-----------------------------------------------------------------
-BehaviorState BehaviorAction::Execute(Blackboard* pBlackBoard)
-{
-	if (m_fpAction == nullptr)
-		return BehaviorState::Failure;
-
-	m_CurrentState = m_fpAction(pBlackBoard);
-	return m_CurrentState;
-}
-
-//-----------------------------------------------------------------
-// BEHAVIOR TREE INVERYED CONDITIONAL (IBehavior)
-//-----------------------------------------------------------------
-BehaviorState InvertedBehaviorConditional::Execute(Blackboard* pBlackBoard)
-{
-	if (m_fpConditional == nullptr)
-		return BehaviorState::Failure;
-
-	switch (m_fpConditional(pBlackBoard))
-	{
-	case true:
-		m_CurrentState = BehaviorState::Failure;
-		return m_CurrentState;
-	case false:
-		m_CurrentState = m_CurrentState = BehaviorState::Success;
-		return m_CurrentState;
-	}
-
+	currentBehaviorIndex = 0;
 	return BehaviorState::Success;
 }
+#pragma endregion
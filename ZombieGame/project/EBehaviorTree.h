@@ -10,6 +10,8 @@
 //--- Includes ---
 #include "EBlackboard.h"
 #include "EDecisionMaking.h"
+#include "EBehaviorProfiler.h"
+#include "EBehaviorNodePool.h"
 
 
 //-----------------------------------------------------------------
@@ -22,9 +24,14 @@ enum class BehaviorState
 	Running
 };
 
+typedef bool(*BehaviorConditionalFn)(Blackboard*);
+typedef BehaviorState(*BehaviorActionFn)(Blackboard*);
+
 //-----------------------------------------------------------------
 // BEHAVIOR INTERFACES (BASE)
 //-----------------------------------------------------------------
+//The built-in behaviors keep no state of their own, whatever has to be remembered between updates is stored
+//in the blackboard. That way one tree can be executed for many agents, each with its own blackboard.
 class IBehavior
 {
 public:
@@ -32,41 +39,93 @@ public:
 	virtual ~IBehavior() = default;
 	virtual BehaviorState Execute(Blackboard* pBlackBoard) = 0;
 
-protected:
-	BehaviorState m_CurrentState = BehaviorState::Failure;
+#ifdef ELITE_BEHAVIOR_PROFILER
+	BehaviorNodeProfile* GetProfile() const { return m_pProfile; }
+	void SetProfile(BehaviorNodeProfile* pProfile) { m_pProfile = pProfile; }
+
+private:
+	BehaviorNodeProfile* m_pProfile = nullptr;
+#endif
 };
 
+//Executes a child behavior, records its profile when the profiler is compiled in
+inline BehaviorState ExecuteBehavior(IBehavior* pBehavior, Blackboard* pBlackBoard)
+{
+#ifdef ELITE_BEHAVIOR_PROFILER
+	BehaviorNodeProfile* pProfile = pBehavior->GetProfile();
+	if (pProfile == nullptr)
+		return pBehavior->Execute(pBlackBoard);
+
+	BehaviorProfiler::TickClock& tickClock = BehaviorProfiler::GetTickClock();
+	if (!tickClock.IsTimed)
+	{
+		const BehaviorState state = pBehavior->Execute(pBlackBoard);
+		++pProfile->StateCounts[static_cast<int>(state)];
+		return state;
+	}
+
+	//One counter read per node, it starts where the node before it returned
+	const unsigned long long startCycles = tickClock.LastCycles;
+	const BehaviorState state = pBehavior->Execute(pBlackBoard);
+	const unsigned long long endCycles = BehaviorProfiler::GetCycles();
+	tickClock.LastCycles = endCycles;
+	const unsigned long long cycles = endCycles - startCycles;
+
+	++pProfile->StateCounts[static_cast<int>(state)];
+	++pProfile->TimedCount;
+	pProfile->TotalCycles += cycles;
+	if (cycles > pProfile->MaxCycles)
+		pProfile->MaxCycles = cycles;
+	return state;
+#else
+	return pBehavior->Execute(pBlackBoard);
+#endif
+}
+
 //-----------------------------------------------------------------
 // BEHAVIOR TREE COMPOSITES (IBehavior)
 //-----------------------------------------------------------------
 #pragma region COMPOSITES
 	//--- COMPOSITE BASE ---
+//The children of a composite are next to each other in the node pool of the tree
+class BehaviorChildren final
+{
+public:
+	BehaviorChildren() = default;
+	BehaviorChildren(IBehavior* const* pBehaviors, unsigned int count)
+		: m_pBehaviors(pBehaviors), m_Count(count) {}
+
+	IBehavior* const* begin() const { return m_pBehaviors; }
+	IBehavior* const* end() const { return m_pBehaviors + m_Count; }
+	unsigned int size() const { return m_Count; }
+	IBehavior* operator[](unsigned int index) const { return m_pBehaviors[index]; }
+
+private:
+	IBehavior* const* m_pBehaviors = nullptr;
+	unsigned int m_Count = 0;
+};
+
+//Composites do not own their children, every node of a tree is owned by the node pool it was created in
 class BehaviorComposite : public IBehavior
 {
 public:
-	explicit BehaviorComposite(std::vector<IBehavior*> childBehaviors)
-	{
-		m_ChildBehaviors = childBehaviors;
-	}
-	virtual ~BehaviorComposite()
-	{
-		for (auto pb : m_ChildBehaviors)
-			SAFE_DELETE(pb);
-		m_ChildBehaviors.clear();
-	}
+	BehaviorComposite() = default;
+	virtual ~BehaviorComposite() = default;
 
 	virtual BehaviorState Execute(Blackboard* pBlackBoard) override = 0;
+	const BehaviorChildren& GetChildBehaviors() const { return m_ChildBehaviors; }
+	//Children are set once, while the tree is built
+	void SetChildBehaviors(const BehaviorChildren& childBehaviors) { m_ChildBehaviors = childBehaviors; }
 
 protected:
-	std::vector<IBehavior*> m_ChildBehaviors = {};
+	BehaviorChildren m_ChildBehaviors = {};
 };
 
 //--- SELECTOR ---
 class BehaviorSelector : public BehaviorComposite
 {
 public:
-	explicit BehaviorSelector(std::vector<IBehavior*> childBehaviors) :
-		BehaviorComposite(childBehaviors) {}
+	BehaviorSelector() = default;
 	virtual ~BehaviorSelector() = default;
 
 	virtual BehaviorState Execute(Blackboard* pBlackBoard) override;
@@ -76,8 +135,7 @@ public:
 class BehaviorSequence : public BehaviorComposite
 {
 public:
-	explicit BehaviorSequence(std::vector<IBehavior*> childBehaviors) :
-		BehaviorComposite(childBehaviors) {}
+	BehaviorSequence() = default;
 	virtual ~BehaviorSequence() = default;
 
 	virtual BehaviorState Execute(Blackboard* pBlackBoard) override;
@@ -87,28 +145,109 @@ public:
 class BehaviorPartialSequence : public BehaviorSequence
 {
 public:
-	explicit BehaviorPartialSequence(std::vector<IBehavior*> childBehaviors)
-		: BehaviorSequence(childBehaviors) {}
+	BehaviorPartialSequence()
+		: m_StateIndex(GetNextStateIndex()) {}
 	virtual ~BehaviorPartialSequence() = default;
 
 	virtual BehaviorState Execute(Blackboard* pBlackBoard) override;
 
 private:
-	unsigned int m_CurrentBehaviorIndex = 0;
+	//The index of the current child is kept in the blackboard, at this index
+	const unsigned int m_StateIndex;
+
+	static unsigned int GetNextStateIndex();
 };
 #pragma endregion
 
+//-----------------------------------------------------------------
+// BEHAVIOR TREE LEAF CALLABLES
+//-----------------------------------------------------------------
+//Leaves are templated on the callable they hold, so the call is inlined in Execute when the compiler can see it:
+//	- ConditionalFunction<&IsHurt> / ActionFunction<&Flee>: function known at compile time, inlined
+//	- BehaviorConditionalFn / BehaviorActionFn: plain function pointer, one indirect call
+//	- a lambda: stored by value, captures included
+//A std::function is only made when something has to store a callable with state without knowing its type, e.g. the flat tree.
+template<bool(*fpConditional)(Blackboard*)>
+struct ConditionalFunction
+{
+	bool operator()(Blackboard* pBlackBoard) const { return fpConditional(pBlackBoard); }
+	operator BehaviorConditionalFn() const { return fpConditional; }
+};
+
+template<BehaviorState(*fpAction)(Blackboard*)>
+struct ActionFunction
+{
+	BehaviorState operator()(Blackboard* pBlackBoard) const { return fpAction(pBlackBoard); }
+	operator BehaviorActionFn() const { return fpAction; }
+};
+
+//The plain function behind a callable, nullptr for callables with state
+template<typename Function, typename Callable>
+typename std::enable_if<std::is_convertible<Callable, Function>::value, Function>::type ToLeafFunction(const Callable& callable)
+{
+	return callable;
+}
+template<typename Function, typename Callable>
+typename std::enable_if<!std::is_convertible<Callable, Function>::value, Function>::type ToLeafFunction(const Callable&)
+{
+	return nullptr;
+}
+
+//A leaf made with a null function pointer gets one of these instead, so it always fails without checking every tick
+inline bool FailingConditional(Blackboard*) { return false; }
+inline bool FailingInvertedConditional(Blackboard*) { return true; }
+inline BehaviorState FailingAction(Blackboard*) { return BehaviorState::Failure; }
+
+template<typename Callable, typename Function>
+typename std::enable_if<std::is_pointer<Callable>::value, Callable>::type ToValidLeafCallable(Callable callable, Function fpFailing)
+{
+	if (callable != nullptr)
+		return callable;
+	printf("WARNING: Behavior tree leaf without a function, it always fails \n");
+	return fpFailing;
+}
+template<typename Callable, typename Function>
+typename std::enable_if<!std::is_pointer<Callable>::value, Callable>::type ToValidLeafCallable(Callable callable, Function)
+{
+	return callable;
+}
+
 //-----------------------------------------------------------------
 // BEHAVIOR TREE CONDITIONAL (IBehavior)
 //-----------------------------------------------------------------
 class BehaviorConditional : public IBehavior
 {
 public:
-	explicit BehaviorConditional(std::function<bool(Blackboard*)> fp) : m_fpConditional(fp) {}
-	virtual BehaviorState Execute(Blackboard* pBlackBoard) override;
+	virtual BehaviorState Execute(Blackboard* pBlackBoard) override = 0;
+	//The plain function that is called, nullptr when the callable has state
+	BehaviorConditionalFn GetFunction() const { return m_fpConditional; }
+	virtual std::function<bool(Blackboard*)> GetConditional() const = 0;
+
+protected:
+	explicit BehaviorConditional(BehaviorConditionalFn fpConditional) : m_fpConditional(fpConditional) {}
+
+private:
+	BehaviorConditionalFn m_fpConditional = nullptr;
+};
+
+//A null function pointer is replaced once here, the callable is not checked when the leaf is executed
+template<typename Conditional>
+class CallableBehaviorConditional final : public BehaviorConditional
+{
+public:
+	explicit CallableBehaviorConditional(Conditional conditional)
+		: CallableBehaviorConditional(ToValidLeafCallable(std::move(conditional), &FailingConditional), 0) {}
+	virtual BehaviorState Execute(Blackboard* pBlackBoard) override
+	{
+		return m_Conditional(pBlackBoard) ? BehaviorState::Success : BehaviorState::Failure;
+	}
+	virtual std::function<bool(Blackboard*)> GetConditional() const override { return m_Conditional; }
 
 private:
-	std::function<bool(Blackboard*)> m_fpConditional = nullptr;
+	Conditional m_Conditional;
+
+	CallableBehaviorConditional(Conditional conditional, int)
+		: BehaviorConditional(ToLeafFunction<BehaviorConditionalFn>(conditional)), m_Conditional(std::move(conditional)) {}
 };
 
 //-----------------------------------------------------------------
@@ -117,11 +256,35 @@ private:
 class InvertedBehaviorConditional : public IBehavior
 {
 public:
-	explicit InvertedBehaviorConditional(std::function<bool(Blackboard*)> fp) : m_fpConditional(fp) {}
-	virtual BehaviorState Execute(Blackboard* pBlackBoard) override;
+	virtual BehaviorState Execute(Blackboard* pBlackBoard) override = 0;
+	//The plain function that is called, nullptr when the callable has state
+	BehaviorConditionalFn GetFunction() const { return m_fpConditional; }
+	virtual std::function<bool(Blackboard*)> GetConditional() const = 0;
+
+protected:
+	explicit InvertedBehaviorConditional(BehaviorConditionalFn fpConditional) : m_fpConditional(fpConditional) {}
 
 private:
-	std::function<bool(Blackboard*)> m_fpConditional = nullptr;
+	BehaviorConditionalFn m_fpConditional = nullptr;
+};
+
+template<typename Conditional>
+class CallableInvertedBehaviorConditional final : public InvertedBehaviorConditional
+{
+public:
+	explicit CallableInvertedBehaviorConditional(Conditional conditional)
+		: CallableInvertedBehaviorConditional(ToValidLeafCallable(std::move(conditional), &FailingInvertedConditional), 0) {}
+	virtual BehaviorState Execute(Blackboard* pBlackBoard) override
+	{
+		return m_Conditional(pBlackBoard) ? BehaviorState::Failure : BehaviorState::Success;
+	}
+	virtual std::function<bool(Blackboard*)> GetConditional() const override { return m_Conditional; }
+
+private:
+	Conditional m_Conditional;
+
+	CallableInvertedBehaviorConditional(Conditional conditional, int)
+		: InvertedBehaviorConditional(ToLeafFunction<BehaviorConditionalFn>(conditional)), m_Conditional(std::move(conditional)) {}
 };
 
 //-----------------------------------------------------------------
@@ -130,24 +293,70 @@ private:
 class BehaviorAction : public IBehavior
 {
 public:
-	explicit BehaviorAction(std::function<BehaviorState(Blackboard*)> fp) : m_fpAction(fp) {}
-	virtual BehaviorState Execute(Blackboard* pBlackBoard) override;
+	virtual BehaviorState Execute(Blackboard* pBlackBoard) override = 0;
+	//The plain function that is called, nullptr when the callable has state
+	BehaviorActionFn GetFunction() const { return m_fpAction; }
+	virtual std::function<BehaviorState(Blackboard*)> GetAction() const = 0;
+
+protected:
+	explicit BehaviorAction(BehaviorActionFn fpAction) : m_fpAction(fpAction) {}
 
 private:
-	std::function<BehaviorState(Blackboard*)> m_fpAction = nullptr;
+	BehaviorActionFn m_fpAction = nullptr;
 };
 
+template<typename Action>
+class CallableBehaviorAction final : public BehaviorAction
+{
+public:
+	explicit CallableBehaviorAction(Action action)
+		: CallableBehaviorAction(ToValidLeafCallable(std::move(action), &FailingAction), 0) {}
+	virtual BehaviorState Execute(Blackboard* pBlackBoard) override { return m_Action(pBlackBoard); }
+	virtual std::function<BehaviorState(Blackboard*)> GetAction() const override { return m_Action; }
+
+private:
+	Action m_Action;
+
+	CallableBehaviorAction(Action action, int)
+		: BehaviorAction(ToLeafFunction<BehaviorActionFn>(action)), m_Action(std::move(action)) {}
+};
+
+//--- LEAF CREATION ---
+//The type of the leaf follows from the callable, e.g. CreateAction(nodePool, ActionFunction<&Flee>{})
+template<typename Conditional>
+BehaviorConditional* CreateConditional(BehaviorNodePool& nodePool, Conditional conditional)
+{
+	return nodePool.Create<CallableBehaviorConditional<Conditional>>(std::move(conditional));
+}
+template<typename Conditional>
+InvertedBehaviorConditional* CreateInvertedConditional(BehaviorNodePool& nodePool, Conditional conditional)
+{
+	return nodePool.Create<CallableInvertedBehaviorConditional<Conditional>>(std::move(conditional));
+}
+template<typename Action>
+BehaviorAction* CreateAction(BehaviorNodePool& nodePool, Action action)
+{
+	return nodePool.Create<CallableBehaviorAction<Action>>(std::move(action));
+}
+
 //-----------------------------------------------------------------
 // BEHAVIOR TREE (BASE)
 //-----------------------------------------------------------------
+//Takes ownership of the node pool the root and all of its descendants were created in
 class BehaviorTree final : public IDecisionMaking
 {
 public:
-	explicit BehaviorTree(Blackboard* pBlackBoard, IBehavior* pRootBehavior)
-		: m_pBlackBoard(pBlackBoard), m_pRootBehavior(pRootBehavior) {};
+	explicit BehaviorTree(Blackboard* pBlackBoard, IBehavior* pRootBehavior, BehaviorNodePool* pNodePool)
+		: m_pBlackBoard(pBlackBoard), m_pRootBehavior(pRootBehavior), m_pNodePool(pNodePool)
+	{
+#ifdef ELITE_BEHAVIOR_PROFILER
+		m_Profiler.Attach(m_pRootBehavior);
+#endif
+	};
 	~BehaviorTree()
 	{
-		SAFE_DELETE(m_pRootBehavior);
+		m_pRootBehavior = nullptr;
+		SAFE_DELETE(m_pNodePool); //Destroys every node of the tree at once
 		SAFE_DELETE(m_pBlackBoard); //Takes ownership of passed blackboard!
 	};
 
@@ -159,17 +368,43 @@ public:
 			return;
 		}
 
-		m_CurrentState = m_pRootBehavior->Execute(m_pBlackBoard);
+		m_pBlackBoard->BeginTick();
+#ifdef ELITE_BEHAVIOR_PROFILER
+		BehaviorProfiler::BeginTick();
+#endif
+		m_CurrentState = ExecuteBehavior(m_pRootBehavior, m_pBlackBoard);
 	}
 	Blackboard* GetBlackboard() const
 	{
 		return m_pBlackBoard;
 	}
+	IBehavior* GetRootBehavior() const
+	{
+		return m_pRootBehavior;
+	}
+	BehaviorState GetCurrentState() const
+	{
+		return m_CurrentState;
+	}
+	const BehaviorNodePool* GetNodePool() const
+	{
+		return m_pNodePool;
+	}
+#ifdef ELITE_BEHAVIOR_PROFILER
+	BehaviorProfiler& GetProfiler()
+	{
+		return m_Profiler;
+	}
+#endif
 
 private:
 	BehaviorState m_CurrentState = BehaviorState::Failure;
 	Blackboard* m_pBlackBoard = nullptr;
 	IBehavior* m_pRootBehavior = nullptr;
+	BehaviorNodePool* m_pNodePool = nullptr;
+#ifdef ELITE_BEHAVIOR_PROFILER
+	BehaviorProfiler m_Profiler;
+#endif
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+//=== General Includes ===
+#include "stdafx.h"
+#include "EBehaviorTreeBatch.h"
+
+//-----------------------------------------------------------------
+// BEHAVIOR TREE BATCH
+//-----------------------------------------------------------------
+BehaviorTreeBatch::BehaviorTreeBatch(IBehavior* pRootBehavior, unsigned int threadCount)
+	: m_pRootBehavior(pRootBehavior)
+	, m_ThreadPool(threadCount)
+{
+}
+
+unsigned int BehaviorTreeBatch::AddAgent(Blackboard* pBlackBoard)
+{
+	Agent agent{};
+	agent.pBlackBoard = pBlackBoard;
+	m_Agents.push_back(agent);
+	m_ActiveAgents.push_back(static_cast<unsigned int>(m_Agents.size()) - 1);
+	return m_ActiveAgents.back();
+}
+
+void BehaviorTreeBatch::SetAgentActive(unsigned int agentIndex, bool isActive)
+{
+	Agent& agent = m_Agents[agentIndex];
+	if (agent.IsActive == isActive)
+		return;
+	agent.IsActive = isActive;
+
+	//Kept in agent order, so the threads still get neighbouring agents
+	m_ActiveAgents.clear();
+	for (unsigned int index = 0; index < GetAgentCount(); ++index)
+	{
+		if (m_Agents[index].IsActive)
+			m_ActiveAgents.push_back(index);
+	}
+}
+
+void BehaviorTreeBatch::Update(float deltaTime)
+{
+	if (m_pRootBehavior == nullptr)
+	{
+		for (unsigned int agentIndex : m_ActiveAgents)
+			m_Agents[agentIndex].CurrentState = BehaviorState::Failure;
+		return;
+	}
+
+	m_ThreadPool.ParallelFor(GetActiveAgentCount(), [this](unsigned int activeIndex)
+	{
+		Agent& agent = m_Agents[m_ActiveAgents[activeIndex]];
+		agent.pBlackBoard->BeginTick();
+#ifdef ELITE_BEHAVIOR_PROFILER
+		BehaviorProfiler::BeginTick();
+#endif
+		agent.CurrentState = ExecuteBehavior(m_pRootBehavior, agent.pBlackBoard);
+	});
+}
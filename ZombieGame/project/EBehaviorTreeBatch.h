@@ -0,0 +1,62 @@
+/*=============================================================================*/
+// Copyright 2021-2022 Elite Engine
+/*=============================================================================*/
+// EBehaviorTreeBatch.h: One behavior tree updated for many agents in parallel
+/*=============================================================================*/
+#ifndef ELITE_BEHAVIOR_TREE_BATCH
+#define ELITE_BEHAVIOR_TREE_BATCH
+
+//--- Includes ---
+#include "EBehaviorTree.h"
+#include "EThreadPool.h"
+#include <vector>
+
+//-----------------------------------------------------------------
+// BEHAVIOR TREE BATCH
+//-----------------------------------------------------------------
+//Executes one tree for every agent, every agent has its own blackboard and the agents are split over a thread pool.
+//The built-in behaviors keep their state in the blackboard, so the tree is shared without copies.
+//Takes no ownership of the tree or the blackboards. The leaves of one agent may only touch data of that agent,
+//custom IBehavior types that keep state (e.g. StaticBehavior) and an attached profiler are not thread safe.
+class BehaviorTreeBatch final : public IDecisionMaking
+{
+public:
+	explicit BehaviorTreeBatch(IBehavior* pRootBehavior, unsigned int threadCount = 0); //0 uses one thread per hardware thread
+	~BehaviorTreeBatch() = default;
+
+	BehaviorTreeBatch(const BehaviorTreeBatch& other) = delete;
+	BehaviorTreeBatch& operator=(const BehaviorTreeBatch& other) = delete;
+	BehaviorTreeBatch(BehaviorTreeBatch&& other) = delete;
+	BehaviorTreeBatch& operator=(BehaviorTreeBatch&& other) = delete;
+
+	//Returns the index of the agent
+	unsigned int AddAgent(Blackboard* pBlackBoard);
+
+	//Updates every active agent once, returns when all of them are done
+	virtual void Update(float deltaTime) override;
+
+	//An inactive agent is skipped by Update and keeps its last state, agents start active
+	void SetAgentActive(unsigned int agentIndex, bool isActive);
+
+	unsigned int GetAgentCount() const { return static_cast<unsigned int>(m_Agents.size()); }
+	unsigned int GetActiveAgentCount() const { return static_cast<unsigned int>(m_ActiveAgents.size()); }
+	unsigned int GetThreadCount() const { return m_ThreadPool.GetThreadCount(); }
+	Blackboard* GetBlackboard(unsigned int agentIndex) const { return m_Agents[agentIndex].pBlackBoard; }
+	BehaviorState GetCurrentState(unsigned int agentIndex) const { return m_Agents[agentIndex].CurrentState; }
+
+private:
+	//One cache line each, agents next to each other are often updated by different threads
+	struct alignas(64) Agent
+	{
+		Blackboard* pBlackBoard = nullptr;
+		BehaviorState CurrentState = BehaviorState::Failure;
+		bool IsActive = true;
+	};
+
+	IBehavior* m_pRootBehavior = nullptr;
+	std::vector<Agent, CacheLineAllocator<Agent>> m_Agents = {};
+	std::vector<unsigned int> m_ActiveAgents = {};
+	ThreadPool m_ThreadPool;
+};
+
+#endif
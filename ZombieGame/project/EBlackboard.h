@@ -9,44 +9,173 @@
 
 //Includes
 #include <unordered_map>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <typeinfo>
+#include <new>
+#include <initializer_list>
 
+//-1 in unsigned int, used for keys that are not registered
+#define INVALID_BLACKBOARD_SLOT 0xFFFFFFFFU
 
 //-----------------------------------------------------------------
 // BLACKBOARD TYPES (BASE)
 //-----------------------------------------------------------------
-class IBlackBoardField
+//Bookkeeping for one field that lives in the arena of a blackboard
+//Fields do not take ownership of pointers whatsoever!
+struct BlackboardFieldRecord
+{
+	unsigned int Slot = INVALID_BLACKBOARD_SLOT;
+	unsigned int Chunk = 0;
+	unsigned int Offset = 0;
+	unsigned int Size = 0;
+	void(*pDestroy)(void* pData) = nullptr;
+};
+
+template<typename T>
+void DestroyBlackboardField(void* pData)
+{
+	static_cast<T*>(pData)->~T();
+}
+
+//-----------------------------------------------------------------
+// BLACKBOARD KEYS
+//-----------------------------------------------------------------
+//Hands out a dense slot index for every key name, shared by all blackboards.
+//Slots are resolved once, so typed lookups never hash a string at runtime.
+class BlackboardKeyRegistry final
 {
 public:
-	IBlackBoardField() = default;
-	virtual ~IBlackBoardField() = default;
+	//Returns the slot of the name, registering it if it is not known yet
+	static unsigned int GetSlot(const std::string& name, const char* typeName)
+	{
+		BlackboardKeyRegistry& registry = GetInstance();
+		auto it = registry.m_Slots.find(name);
+		if (it != registry.m_Slots.end())
+		{
+			if (strcmp(registry.m_TypeNames[it->second], typeName) != 0)
+				printf("WARNING: Key '%s' of type '%s' already registered with type '%s' \n", name.c_str(), typeName, registry.m_TypeNames[it->second]);
+			return it->second;
+		}
+
+		const unsigned int slot = static_cast<unsigned int>(registry.m_Names.size());
+		registry.m_Slots[name] = slot;
+		registry.m_Names.push_back(name);
+		registry.m_TypeNames.push_back(typeName);
+		return slot;
+	}
+
+	//Returns the slot of the name, or INVALID_BLACKBOARD_SLOT if it was never registered
+	static unsigned int FindSlot(const std::string& name)
+	{
+		BlackboardKeyRegistry& registry = GetInstance();
+		auto it = registry.m_Slots.find(name);
+		if (it == registry.m_Slots.end())
+			return INVALID_BLACKBOARD_SLOT;
+		return it->second;
+	}
+
+	static const std::string& GetName(unsigned int slot) { return GetInstance().m_Names[slot]; }
+	static const char* GetTypeName(unsigned int slot) { return GetInstance().m_TypeNames[slot]; }
+	static unsigned int GetSlotCount() { return static_cast<unsigned int>(GetInstance().m_Names.size()); }
+
+private:
+	BlackboardKeyRegistry() = default;
+	static BlackboardKeyRegistry& GetInstance()
+	{
+		static BlackboardKeyRegistry registry{};
+		return registry;
+	}
+
+	std::unordered_map<std::string, unsigned int> m_Slots;
+	std::vector<std::string> m_Names;
+	std::vector<const char*> m_TypeNames;
 };
 
-//BlackboardField does not take ownership of pointers whatsoever!
+//Typed handle to a blackboard entry, e.g. BlackboardKey<AgentInfo> PlayerInfo{ "PlayerInfo" };
+//Keys with the same name share a slot, so they can be declared in any translation unit.
 template<typename T>
-class BlackboardField : public IBlackBoardField
+class BlackboardKey final
+{
+public:
+	using ValueType = T;
+
+	explicit BlackboardKey(const std::string& name)
+		: m_Slot(BlackboardKeyRegistry::GetSlot(name, typeid(T).name()))
+	{}
+
+	unsigned int GetSlot() const { return m_Slot; }
+	const std::string& GetName() const { return BlackboardKeyRegistry::GetName(m_Slot); }
+
+private:
+	unsigned int m_Slot;
+};
+
+//Identifies a pure conditional and the blackboard keys it reads, see Blackboard::Memoize, e.g.
+//	BlackboardMemoKey IsHurt{ "IsHurt", { BB_Keys::PlayerHealth.GetSlot(), BB_Keys::MaxPlayerHealth.GetSlot() } };
+class BlackboardMemoKey final
 {
 public:
-	explicit BlackboardField(T data) : m_Data(data)
+	//A result is only kept between ticks when every change to the inputs marks them changed, also changes made in place
+	BlackboardMemoKey(const std::string& name, std::initializer_list<unsigned int> inputSlots, bool isKeptBetweenTicks = false)
+		: m_Id(GetNextId()), m_Name(name), m_InputSlots(inputSlots), m_IsKeptBetweenTicks(isKeptBetweenTicks)
 	{}
-	T GetData() { return m_Data; };
-	void SetData(T data) { m_Data = data; }
+
+	unsigned int GetId() const { return m_Id; }
+	const std::string& GetName() const { return m_Name; }
+	const std::vector<unsigned int>& GetInputSlots() const { return m_InputSlots; }
+	bool IsKeptBetweenTicks() const { return m_IsKeptBetweenTicks; }
 
 private:
-	T m_Data;
+	unsigned int m_Id;
+	std::string m_Name;
+	std::vector<unsigned int> m_InputSlots;
+	bool m_IsKeptBetweenTicks;
+
+	static unsigned int GetNextId()
+	{
+		static unsigned int nextId = 0;
+		return nextId++;
+	}
+};
+
+//Cached result of a memoized conditional in one blackboard
+struct BlackboardMemoEntry
+{
+	const BlackboardMemoKey* pKey = nullptr;
+	unsigned int Tick = 0;
+	unsigned int InputVersion = 0;
+	bool Result = false;
+
+	unsigned long long EvaluationCount = 0;
+	unsigned long long SavedCount = 0; //Calls answered from the cache
 };
 
 //-----------------------------------------------------------------
 // BLACKBOARD (BASE)
 //-----------------------------------------------------------------
+//All fields are constructed in place in one cache line aligned arena, in the order they are added.
+//Add the data that is used every tick first, so it ends up in the same few cache lines.
 class Blackboard final
 {
 public:
-	Blackboard() = default;
+	explicit Blackboard(unsigned int arenaSize = 1024)
+		: m_ChunkSize(arenaSize)
+	{
+		AddChunk(arenaSize);
+	}
 	~Blackboard()
 	{
-		for (auto el : m_BlackboardData)
-			SAFE_DELETE(el.second);
-		m_BlackboardData.clear();
+		//Destroy in reverse order of construction
+		for (auto it = m_Records.rbegin(); it != m_Records.rend(); ++it)
+			it->pDestroy(m_Chunks[it->Chunk] + it->Offset);
+		m_Records.clear();
+
+		for (char* pRawChunk : m_RawChunks)
+			::operator delete(pRawChunk);
+		m_RawChunks.clear();
+		m_Chunks.clear();
 	}
 
 	Blackboard(const Blackboard& other) = delete;
@@ -54,31 +183,58 @@ public:
 	Blackboard(Blackboard&& other) = delete;
 	Blackboard& operator=(Blackboard&& other) = delete;
 
+	//--- Typed keys (fast path) ---
 	//Add data to the blackboard
-	template<typename T> bool AddData(const std::string& name, T data)
+	template<typename T> bool AddData(const BlackboardKey<T>& key, typename BlackboardKey<T>::ValueType data)
 	{
-		auto it = m_BlackboardData.find(name);
-		if (it == m_BlackboardData.end())
+		return AddDataToSlot(key.GetSlot(), data);
+	}
+
+	//Change the data of the blackboard
+	template<typename T> bool ChangeData(const BlackboardKey<T>& key, typename BlackboardKey<T>::ValueType data)
+	{
+		//The registry guarantees a slot only ever holds one type
+		T* p = static_cast<T*>(GetField(key.GetSlot()));
+		if (p)
+		{
+			*p = data;
+			++m_Versions[key.GetSlot()];
+			return true;
+		}
+		printf("WARNING: Data '%s' of type '%s' not found in Blackboard \n", key.GetName().c_str(), typeid(T).name());
+		return false;
+	}
+
+	//Get the data from the blackboard
+	template<typename T> bool GetData(const BlackboardKey<T>& key, T& data)
+	{
+		const T* p = static_cast<const T*>(GetField(key.GetSlot()));
+		if (p)
 		{
-			m_BlackboardData[name] = new BlackboardField<T>(data);
+			data = *p;
 			return true;
 		}
-		printf("WARNING: Data '%s' of type '%s' already in Blackboard \n", name.c_str(), typeid(T).name());
+		printf("WARNING: Data '%s' of type '%s' not found in Blackboard \n", key.GetName().c_str(), typeid(T).name());
 		return false;
 	}
 
+	//--- String names (slow path, for tooling and debugging) ---
+	//Add data to the blackboard
+	template<typename T> bool AddData(const std::string& name, T data)
+	{
+		return AddDataToSlot(BlackboardKeyRegistry::GetSlot(name, typeid(T).name()), data);
+	}
+
 	//Change the data of the blackboard
 	template<typename T> bool ChangeData(const std::string& name, T data)
 	{
-		auto it = m_BlackboardData.find(name);
-		if (it != m_BlackboardData.end())
+		const unsigned int slot = BlackboardKeyRegistry::FindSlot(name);
+		T* p = static_cast<T*>(GetCheckedField<T>(slot));
+		if (p)
 		{
-			BlackboardField<T>* p = dynamic_cast<BlackboardField<T>*>(m_BlackboardData[name]);
-			if (p)
-			{
-				p->SetData(data);
-				return true;
-			}
+			*p = data;
+			++m_Versions[slot];
+			return true;
 		}
 		printf("WARNING: Data '%s' of type '%s' not found in Blackboard \n", name.c_str(), typeid(T).name());
 		return false;
@@ -87,18 +243,190 @@ public:
 	//Get the data from the blackboard
 	template<typename T> bool GetData(const std::string& name, T& data)
 	{
-		BlackboardField<T>* p = dynamic_cast<BlackboardField<T>*>(m_BlackboardData[name]);
+		const T* p = static_cast<const T*>(GetCheckedField<T>(BlackboardKeyRegistry::FindSlot(name)));
 		if (p != nullptr)
 		{
-			data = p->GetData();
+			data = *p;
 			return true;
 		}
 		printf("WARNING: Data '%s' of type '%s' not found in Blackboard \n", name.c_str(), typeid(T).name());
 		return false;
 	}
 
+	//--- Change tracking ---
+	//Every write to a key bumps its version, data that is changed through a stored pointer has to be marked by hand
+	template<typename T> void MarkChanged(const BlackboardKey<T>& key)
+	{
+		if (key.GetSlot() < m_Versions.size())
+			++m_Versions[key.GetSlot()];
+	}
+	template<typename T> unsigned int GetVersion(const BlackboardKey<T>& key) const
+	{
+		return GetSlotVersion(key.GetSlot());
+	}
+	unsigned int GetSlotVersion(unsigned int slot) const
+	{
+		return slot < m_Versions.size() ? m_Versions[slot] : 0;
+	}
+
+	//--- Memoization ---
+	//Called by the behavior trees at the start of every update, invalidates the memoized results not kept between ticks
+	void BeginTick() { ++m_Tick; }
+	unsigned int GetTick() const { return m_Tick; }
+
+	//Returns the cached result of a pure conditional when it was already evaluated this tick (or before, for keys kept between ticks)
+	//and none of its input keys were written since, otherwise evaluates it
+	template<typename Function> bool Memoize(const BlackboardMemoKey& key, Function evaluate)
+	{
+		if (key.GetId() >= m_Memos.size())
+			m_Memos.resize(key.GetId() + 1);
+		BlackboardMemoEntry& entry = m_Memos[key.GetId()];
+
+		//Versions only go up, so the sum only stays the same when none of them changed
+		unsigned int inputVersion = 0;
+		for (unsigned int slot : key.GetInputSlots())
+			inputVersion += GetSlotVersion(slot);
+
+		if (entry.pKey != nullptr && (entry.Tick == m_Tick || key.IsKeptBetweenTicks()) && entry.InputVersion == inputVersion)
+		{
+			++entry.SavedCount;
+			return entry.Result;
+		}
+
+		entry.pKey = &key;
+		entry.Result = evaluate(this);
+		entry.Tick = m_Tick;
+		entry.InputVersion = inputVersion;
+		++entry.EvaluationCount;
+		return entry.Result;
+	}
+	const std::vector<BlackboardMemoEntry>& GetMemoEntries() const { return m_Memos; }
+	void PrintMemoStats() const
+	{
+		printf("Blackboard memoization: \n");
+		for (const BlackboardMemoEntry& entry : m_Memos)
+		{
+			if (entry.pKey == nullptr)
+				continue;
+			const unsigned long long calls = entry.EvaluationCount + entry.SavedCount;
+			printf("  %-24s %10llu calls %10llu evaluated %10llu saved (%.1f%%) \n", entry.pKey->GetName().c_str(),
+				calls, entry.EvaluationCount, entry.SavedCount, calls > 0 ? 100.0 * entry.SavedCount / calls : 0.0);
+		}
+	}
+
+	//--- Behavior state ---
+	//State behaviors keep between updates (e.g. the current child of a partial sequence), so the tree itself
+	//holds no state of the agent it is executed for. Every behavior that needs one gets its own index.
+	unsigned int& GetBehaviorState(unsigned int index)
+	{
+		if (index >= m_BehaviorStates.size())
+			m_BehaviorStates.resize(index + 1, 0);
+		return m_BehaviorStates[index];
+	}
+
+	//--- Debugging ---
+	//Walks the arena and prints every field with its offset, size and type
+	void DebugPrint() const
+	{
+		printf("Blackboard: %u fields, %u bytes used in %u chunk(s) \n", unsigned(m_Records.size()), GetUsedSize(), unsigned(m_Chunks.size()));
+		for (const BlackboardFieldRecord& record : m_Records)
+		{
+			printf("  [%u] +%4u %4u bytes  %-20s %s \n", record.Chunk, record.Offset, record.Size,
+				BlackboardKeyRegistry::GetName(record.Slot).c_str(), BlackboardKeyRegistry::GetTypeName(record.Slot));
+		}
+		PrintMemoStats();
+	}
+	const std::vector<BlackboardFieldRecord>& GetFieldRecords() const { return m_Records; }
+	unsigned int GetUsedSize() const { return m_UsedSize; }
+
 private:
-	std::unordered_map<std::string, IBlackBoardField*> m_BlackboardData;
+	static const unsigned int m_ArenaAlignment = 64;
+
+	//Indexed by the slot of the key, nullptr for keys that were not added to this blackboard
+	std::vector<void*> m_BlackboardData;
+	//Write count of every slot, same indexing as m_BlackboardData
+	std::vector<unsigned int> m_Versions;
+	//Fields in the order they were placed in the arena
+	std::vector<BlackboardFieldRecord> m_Records;
+
+	unsigned int m_Tick = 0;
+	std::vector<BlackboardMemoEntry> m_Memos;
+	std::vector<unsigned int> m_BehaviorStates;
+
+	//The arena, normally one chunk, extra chunks are only added when it overflows so fields never move
+	std::vector<char*> m_Chunks;
+	std::vector<char*> m_RawChunks;
+	unsigned int m_ChunkSize = 0;
+	unsigned int m_LastChunkSize = 0;
+	unsigned int m_UsedInLastChunk = 0;
+	unsigned int m_UsedSize = 0;
+
+	void* GetField(unsigned int slot) const
+	{
+		if (slot >= m_BlackboardData.size())
+			return nullptr;
+		return m_BlackboardData[slot];
+	}
+
+	template<typename T> void* GetCheckedField(unsigned int slot) const
+	{
+		if (slot == INVALID_BLACKBOARD_SLOT || strcmp(BlackboardKeyRegistry::GetTypeName(slot), typeid(T).name()) != 0)
+			return nullptr;
+		return GetField(slot);
+	}
+
+	void AddChunk(unsigned int size)
+	{
+		//Over allocate so the start of the chunk can be aligned to a cache line
+		char* pRawChunk = static_cast<char*>(::operator new(size + m_ArenaAlignment));
+		const size_t misalignment = reinterpret_cast<size_t>(pRawChunk) % m_ArenaAlignment;
+		m_RawChunks.push_back(pRawChunk);
+		m_Chunks.push_back(pRawChunk + (m_ArenaAlignment - misalignment) % m_ArenaAlignment);
+		m_LastChunkSize = size;
+		m_UsedInLastChunk = 0;
+	}
+
+	template<typename T> bool AddDataToSlot(unsigned int slot, T data)
+	{
+		const std::string& name = BlackboardKeyRegistry::GetName(slot);
+		if (strcmp(BlackboardKeyRegistry::GetTypeName(slot), typeid(T).name()) != 0)
+		{
+			printf("WARNING: Data '%s' of type '%s' does not match the registered type '%s' \n", name.c_str(), typeid(T).name(), BlackboardKeyRegistry::GetTypeName(slot));
+			return false;
+		}
+		if (GetField(slot) != nullptr)
+		{
+			printf("WARNING: Data '%s' of type '%s' already in Blackboard \n", name.c_str(), typeid(T).name());
+			return false;
+		}
+
+		static_assert(alignof(T) <= m_ArenaAlignment, "Blackboard data can not be aligned to more than a cache line");
+		unsigned int offset = (m_UsedInLastChunk + alignof(T) - 1) & ~unsigned(alignof(T) - 1);
+		if (offset + sizeof(T) > m_LastChunkSize)
+		{
+			AddChunk(sizeof(T) > m_ChunkSize ? unsigned(sizeof(T)) : m_ChunkSize);
+			offset = 0;
+		}
+
+		BlackboardFieldRecord record{};
+		record.Slot = slot;
+		record.Chunk = unsigned(m_Chunks.size() - 1);
+		record.Offset = offset;
+		record.Size = unsigned(sizeof(T));
+		record.pDestroy = &DestroyBlackboardField<T>;
+		m_Records.push_back(record);
+		m_UsedSize += offset + unsigned(sizeof(T)) - m_UsedInLastChunk;
+		m_UsedInLastChunk = offset + unsigned(sizeof(T));
+
+		if (slot >= m_BlackboardData.size())
+		{
+			m_BlackboardData.resize(BlackboardKeyRegistry::GetSlotCount(), nullptr);
+			m_Versions.resize(BlackboardKeyRegistry::GetSlotCount(), 0);
+		}
+		m_BlackboardData[slot] = new (m_Chunks.back() + offset) T(data);
+		++m_Versions[slot];
+		return true;
+	}
 };
 
-#endif
\ No newline at end of file
+#endif
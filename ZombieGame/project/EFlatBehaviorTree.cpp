@@ -0,0 +1,461 @@
+//=== General Includes ===
+#include "stdafx.h"
+#include "EFlatBehaviorTree.h"
+#include <algorithm>
+
+//-----------------------------------------------------------------
+// FLAT BEHAVIOR TREE COMPILER
+//-----------------------------------------------------------------
+FlatBehaviorTree::FlatBehaviorTree(Blackboard* pBlackBoard, const IBehavior* pRootBehavior, bool isReactive)
+	: m_pBlackBoard(pBlackBoard)
+	, m_IsReactive(isReactive)
+{
+	if (pRootBehavior != nullptr)
+		CompileBehavior(pRootBehavior);
+
+	//One frame for every composite on the deepest path, the subtree of a composite ends at its index + SubtreeSize
+	std::vector<unsigned int> subtreeEnds{};
+	size_t maxDepth = 0;
+	for (unsigned int nodeIndex = 0; nodeIndex < m_Nodes.size(); ++nodeIndex)
+	{
+		while (!subtreeEnds.empty() && subtreeEnds.back() <= nodeIndex)
+			subtreeEnds.pop_back();
+		if (m_Nodes[nodeIndex].ChildCount > 0)
+			subtreeEnds.push_back(nodeIndex + m_Nodes[nodeIndex].SubtreeSize);
+		maxDepth = (std::max)(maxDepth, subtreeEnds.size());
+	}
+	m_Stack.resize(maxDepth);
+
+	if (m_IsReactive)
+		CompileReactiveNodes();
+}
+
+void FlatBehaviorTree::CompileBehavior(const IBehavior* pBehavior)
+{
+	//Nodes are stored in pre-order, reserve the spot of this node before compiling its children
+	const unsigned int nodeIndex = static_cast<unsigned int>(m_Nodes.size());
+	m_Nodes.push_back(FlatBehaviorNode{});
+	FlatBehaviorNode node{};
+
+	if (const BehaviorComposite* pComposite = dynamic_cast<const BehaviorComposite*>(pBehavior))
+	{
+		//Check the partial sequence first, it derives from the sequence
+		if (dynamic_cast<const BehaviorPartialSequence*>(pComposite))
+		{
+			node.Type = FlatBehaviorType::PartialSequence;
+			node.DataIndex = static_cast<unsigned int>(m_PartialSequenceIndices.size());
+			m_PartialSequenceIndices.push_back(0);
+		}
+		else if (dynamic_cast<const BehaviorSequence*>(pComposite))
+			node.Type = FlatBehaviorType::Sequence;
+		else
+			node.Type = FlatBehaviorType::Selector;
+
+		node.ChildCount = pComposite->GetChildBehaviors().size();
+		for (const IBehavior* pChild : pComposite->GetChildBehaviors())
+			CompileBehavior(pChild);
+
+		//Leaves are one node each, so the children follow the composite without a gap
+		node.HasOnlyLeaves = node.Type != FlatBehaviorType::PartialSequence && std::all_of(m_Nodes.begin() + nodeIndex + 1, m_Nodes.end(),
+			[](const FlatBehaviorNode& child)
+			{
+				return child.Type == FlatBehaviorType::Conditional || child.Type == FlatBehaviorType::InvertedConditional || child.Type == FlatBehaviorType::Action;
+			});
+	}
+	else if (const BehaviorConditional* pConditional = dynamic_cast<const BehaviorConditional*>(pBehavior))
+	{
+		CompileConditional(pConditional, false, node);
+	}
+	else if (const InvertedBehaviorConditional* pInverted = dynamic_cast<const InvertedBehaviorConditional*>(pBehavior))
+	{
+		CompileConditional(pInverted, true, node);
+	}
+	else if (const BehaviorAction* pAction = dynamic_cast<const BehaviorAction*>(pBehavior))
+	{
+		//Only a callable with state is wrapped in a std::function
+		if (const BehaviorActionFn fpAction = pAction->GetFunction())
+		{
+			node.Type = fpAction == &FailingAction ? FlatBehaviorType::Failure : FlatBehaviorType::Action;
+			node.pAction = fpAction;
+		}
+		else
+		{
+			node.Type = FlatBehaviorType::BoundAction;
+			node.DataIndex = static_cast<unsigned int>(m_BoundActions.size());
+			m_BoundActions.push_back(pAction->GetAction());
+		}
+	}
+	else if (pBehavior != nullptr)
+	{
+		node.Type = FlatBehaviorType::Behavior;
+		node.DataIndex = static_cast<unsigned int>(m_ExternalBehaviors.size());
+		m_ExternalBehaviors.push_back(const_cast<IBehavior*>(pBehavior));
+	}
+
+	node.SubtreeSize = static_cast<unsigned int>(m_Nodes.size()) - nodeIndex;
+	m_Nodes[nodeIndex] = node;
+}
+
+//For BehaviorConditional and InvertedBehaviorConditional
+template<typename Conditional>
+void FlatBehaviorTree::CompileConditional(const Conditional* pConditional, bool isInverted, FlatBehaviorNode& node)
+{
+	//Only a callable with state is wrapped in a std::function
+	if (const BehaviorConditionalFn fpConditional = pConditional->GetFunction())
+	{
+		node.Type = isInverted ? FlatBehaviorType::InvertedConditional : FlatBehaviorType::Conditional;
+		node.pConditional = fpConditional;
+		if (fpConditional == (isInverted ? &FailingInvertedConditional : &FailingConditional))
+			node.Type = FlatBehaviorType::Failure;
+	}
+	else
+	{
+		node.Type = isInverted ? FlatBehaviorType::BoundInvertedConditional : FlatBehaviorType::BoundConditional;
+		node.DataIndex = static_cast<unsigned int>(m_BoundConditionals.size());
+		m_BoundConditionals.push_back(pConditional->GetConditional());
+	}
+}
+
+//-----------------------------------------------------------------
+// REACTIVE MODE
+//-----------------------------------------------------------------
+std::vector<FlatBehaviorTree::ConditionalInputs>& FlatBehaviorTree::GetConditionalInputs()
+{
+	static std::vector<ConditionalInputs> conditionalInputs{};
+	return conditionalInputs;
+}
+
+void FlatBehaviorTree::SetConditionalInputs(BehaviorConditionalFn pConditional, const std::vector<unsigned int>& inputSlots, bool isPure)
+{
+	for (ConditionalInputs& conditionalInputs : GetConditionalInputs())
+	{
+		if (conditionalInputs.pConditional == pConditional)
+		{
+			conditionalInputs.InputSlots = inputSlots;
+			conditionalInputs.IsPure = isPure;
+			return;
+		}
+	}
+	GetConditionalInputs().push_back(ConditionalInputs{ pConditional, inputSlots, isPure });
+}
+
+void FlatBehaviorTree::CompileReactiveNodes()
+{
+	m_ReactiveNodes.resize(m_Nodes.size());
+
+	//Parents always come before their children, so the depth of the parent is known
+	for (unsigned int nodeIndex = 0; nodeIndex < m_Nodes.size(); ++nodeIndex)
+	{
+		const FlatBehaviorNode& node = m_Nodes[nodeIndex];
+		FlatReactiveNode& reactiveNode = m_ReactiveNodes[nodeIndex];
+
+		unsigned int childIndex = nodeIndex + 1;
+		for (unsigned int child = 0; child < node.ChildCount; ++child)
+		{
+			FlatReactiveNode& reactiveChild = m_ReactiveNodes[childIndex];
+			reactiveChild.Parent = nodeIndex;
+			reactiveChild.Depth = reactiveNode.Depth + 1;
+			//A partial sequence stops after the child it executes
+			reactiveChild.ChildrenLeft = node.Type == FlatBehaviorType::PartialSequence ? 0 : node.ChildCount - child - 1;
+			childIndex += m_Nodes[childIndex].SubtreeSize;
+		}
+
+		//Only conditionals that call a plain function can be guards
+		if (node.Type != FlatBehaviorType::Conditional && node.Type != FlatBehaviorType::InvertedConditional)
+			continue;
+		for (const ConditionalInputs& conditionalInputs : GetConditionalInputs())
+		{
+			if (conditionalInputs.pConditional == node.pConditional)
+			{
+				reactiveNode.IsGuard = true;
+				reactiveNode.IsPure = conditionalInputs.IsPure;
+				reactiveNode.InputBegin = static_cast<unsigned int>(m_InputSlots.size());
+				reactiveNode.InputCount = static_cast<unsigned int>(conditionalInputs.InputSlots.size());
+				m_InputSlots.insert(m_InputSlots.end(), conditionalInputs.InputSlots.begin(), conditionalInputs.InputSlots.end());
+				break;
+			}
+		}
+	}
+
+	//Every guard is executed at most once per update, so tracing does not allocate
+	m_Guards.reserve(std::count_if(m_ReactiveNodes.begin(), m_ReactiveNodes.end(), [](const FlatReactiveNode& reactiveNode) { return reactiveNode.IsGuard; }));
+}
+
+void FlatBehaviorTree::PrintReactiveStats() const
+{
+	const double updateCount = m_UpdateCount > 0 ? static_cast<double>(m_UpdateCount) : 1.0;
+	printf("Reactive behavior tree: %.1f nodes executed and %.1f guards skipped per update \n",
+		m_ExecutedCount / updateCount, m_SkippedCount / updateCount);
+}
+
+bool FlatBehaviorTree::Resume(unsigned int& nodeIndex, unsigned int& stackSize, BehaviorState& state)
+{
+	++m_UpdateCount;
+	for (unsigned int guardIndex = 0; guardIndex < m_Guards.size(); ++guardIndex)
+	{
+		FlatReactiveGuard& guard = m_Guards[guardIndex];
+		const FlatReactiveNode& reactiveNode = m_ReactiveNodes[guard.NodeIndex];
+		const unsigned int inputVersion = GetInputVersion(reactiveNode);
+		//A guard that wrote something is executed again to write it again
+		if (inputVersion == guard.InputVersion && (reactiveNode.IsPure || !guard.Result))
+		{
+			++m_SkippedCount;
+			continue;
+		}
+
+		//With the same result the way to the next guard stays the same
+		const FlatBehaviorNode& node = m_Nodes[guard.NodeIndex];
+		const bool result = node.pConditional(m_pBlackBoard);
+		++m_ExecutedCount;
+		if (result == guard.Result)
+		{
+			guard.InputVersion = inputVersion;
+			continue;
+		}
+
+		//The update goes on from this guard with its new result, and traces the guards after it again
+		guard.InputVersion = inputVersion;
+		guard.Result = result;
+		nodeIndex = guard.NodeIndex;
+		m_Guards.resize(guardIndex + 1);
+		m_IsTracing = true;
+
+		stackSize = BuildStack(nodeIndex);
+		state = result != (node.Type == FlatBehaviorType::InvertedConditional) ? BehaviorState::Success : BehaviorState::Failure;
+		return true;
+	}
+
+	//Every guard gave the same result, the update goes on where the last one stopped tracing.
+	//Before the first update that is the root, which traces the guards from the start
+	m_IsTracing = m_ResumeIndex == 0;
+	if (m_ResumeIndex >= m_Nodes.size())
+	{
+		stackSize = 0;
+		state = m_ResumeState;
+		return true;
+	}
+	nodeIndex = m_ResumeIndex;
+	stackSize = BuildStack(nodeIndex);
+	return false;
+}
+
+bool FlatBehaviorTree::ExecuteTracedConditional(unsigned int nodeIndex)
+{
+	const FlatReactiveNode& reactiveNode = m_ReactiveNodes[nodeIndex];
+	if (!reactiveNode.IsGuard)
+	{
+		StopTracing(nodeIndex);
+		return m_Nodes[nodeIndex].pConditional(m_pBlackBoard);
+	}
+
+	//Versions from before executing, so a guard that writes its own inputs is checked again next update
+	const unsigned int inputVersion = GetInputVersion(reactiveNode);
+	const bool result = m_Nodes[nodeIndex].pConditional(m_pBlackBoard);
+	m_Guards.push_back(FlatReactiveGuard{ nodeIndex, inputVersion, result });
+	return result;
+}
+
+void FlatBehaviorTree::StopTracing(unsigned int nodeIndex)
+{
+	if (!m_IsTracing)
+		return;
+	m_IsTracing = false;
+	m_ResumeIndex = nodeIndex;
+}
+
+unsigned int FlatBehaviorTree::GetInputVersion(const FlatReactiveNode& reactiveNode) const
+{
+	//Versions only go up, so the sum only stays the same when none of the inputs was written
+	unsigned int inputVersion = 0;
+	for (unsigned int input = 0; input < reactiveNode.InputCount; ++input)
+		inputVersion += m_pBlackBoard->GetSlotVersion(m_InputSlots[reactiveNode.InputBegin + input]);
+	return inputVersion;
+}
+
+unsigned int FlatBehaviorTree::BuildStack(unsigned int nodeIndex)
+{
+	const unsigned int stackSize = m_ReactiveNodes[nodeIndex].Depth;
+	unsigned int childIndex = nodeIndex;
+	for (unsigned int frameIndex = stackSize; frameIndex-- > 0;)
+	{
+		const FlatReactiveNode& reactiveChild = m_ReactiveNodes[childIndex];
+		FlatBehaviorFrame& frame = m_Stack[frameIndex];
+		frame.NodeIndex = reactiveChild.Parent;
+		frame.ChildrenLeft = reactiveChild.ChildrenLeft;
+		childIndex = reactiveChild.Parent;
+	}
+	return stackSize;
+}
+
+//-----------------------------------------------------------------
+// FLAT BEHAVIOR TREE INTERPRETER
+//-----------------------------------------------------------------
+template<bool isReactive>
+BehaviorState FlatBehaviorTree::ExecuteNodes()
+{
+	FlatBehaviorFrame* const pStack = m_Stack.data();
+	unsigned int stackSize = 0;
+	unsigned int nodeIndex = 0;
+	BehaviorState state = BehaviorState::Failure;
+	//Reactive mode starts where the guards of the last update lead, with the state of that node when a guard gave it
+	bool isStateKnown = isReactive && Resume(nodeIndex, stackSize, state);
+	for (;;)
+	{
+		//Down: a composite pushes a frame and goes on with its first child, a leaf gives a state
+		if (!isStateKnown)
+		{
+			const FlatBehaviorNode& node = m_Nodes[nodeIndex];
+			if (isReactive)
+				++m_ExecutedCount;
+			switch (node.Type)
+			{
+			case FlatBehaviorType::Selector:
+			case FlatBehaviorType::Sequence:
+			{
+				//Reactive mode traces the conditionals one by one
+				if (!isReactive && node.HasOnlyLeaves)
+				{
+					state = ExecuteLeaves(node);
+					break;
+				}
+				if (node.ChildCount == 0)
+				{
+					state = node.Type == FlatBehaviorType::Selector ? BehaviorState::Failure : BehaviorState::Success;
+					break;
+				}
+				FlatBehaviorFrame& frame = pStack[stackSize++];
+				frame.NodeIndex = nodeIndex;
+				frame.ChildrenLeft = node.ChildCount - 1;
+				nodeIndex = nodeIndex + 1;
+				continue;
+			}
+			case FlatBehaviorType::PartialSequence:
+			{
+				//Keeps state between updates, the guards after it are not traced
+				if (isReactive)
+					StopTracing(nodeIndex);
+				//Execute one child per update, starting from where the previous update stopped
+				const unsigned int currentChild = m_PartialSequenceIndices[node.DataIndex];
+				if (currentChild >= node.ChildCount)
+				{
+					m_PartialSequenceIndices[node.DataIndex] = 0;
+					state = BehaviorState::Success;
+					break;
+				}
+				unsigned int childIndex = nodeIndex + 1;
+				for (unsigned int child = 0; child < currentChild; ++child)
+					childIndex += m_Nodes[childIndex].SubtreeSize;
+				FlatBehaviorFrame& frame = pStack[stackSize++];
+				frame.NodeIndex = nodeIndex;
+				frame.ChildrenLeft = 0;
+				nodeIndex = childIndex;
+				continue;
+			}
+			case FlatBehaviorType::Conditional:
+			{
+				const bool result = isReactive && m_IsTracing ? ExecuteTracedConditional(nodeIndex) : node.pConditional(m_pBlackBoard);
+				state = result ? BehaviorState::Success : BehaviorState::Failure;
+				break;
+			}
+			case FlatBehaviorType::InvertedConditional:
+			{
+				const bool result = isReactive && m_IsTracing ? ExecuteTracedConditional(nodeIndex) : node.pConditional(m_pBlackBoard);
+				state = result ? BehaviorState::Failure : BehaviorState::Success;
+				break;
+			}
+			case FlatBehaviorType::Action:
+				if (isReactive)
+					StopTracing(nodeIndex);
+				state = node.pAction(m_pBlackBoard);
+				break;
+			case FlatBehaviorType::BoundConditional:
+				if (isReactive)
+					StopTracing(nodeIndex);
+				state = m_BoundConditionals[node.DataIndex](m_pBlackBoard) ? BehaviorState::Success : BehaviorState::Failure;
+				break;
+			case FlatBehaviorType::BoundInvertedConditional:
+				if (isReactive)
+					StopTracing(nodeIndex);
+				state = m_BoundConditionals[node.DataIndex](m_pBlackBoard) ? BehaviorState::Failure : BehaviorState::Success;
+				break;
+			case FlatBehaviorType::BoundAction:
+				if (isReactive)
+					StopTracing(nodeIndex);
+				state = m_BoundActions[node.DataIndex](m_pBlackBoard);
+				break;
+			case FlatBehaviorType::Behavior:
+				if (isReactive)
+					StopTracing(nodeIndex);
+				state = m_ExternalBehaviors[node.DataIndex]->Execute(m_pBlackBoard);
+				break;
+			case FlatBehaviorType::Failure:
+			default:
+				state = BehaviorState::Failure;
+				break;
+			}
+		}
+		isStateKnown = false;
+
+		//Up: hand the state to the composites on the stack until one of them goes on with its next child.
+		//The next child follows the subtree of the one that gave the state, the index stays out of the frame
+		//so finding it does not wait on a store to the stack
+		unsigned int childIndex = nodeIndex;
+		while (stackSize > 0)
+		{
+			FlatBehaviorFrame& frame = pStack[stackSize - 1];
+			const FlatBehaviorNode& composite = m_Nodes[frame.NodeIndex];
+			if (composite.Type == FlatBehaviorType::PartialSequence)
+			{
+				unsigned int& currentChild = m_PartialSequenceIndices[composite.DataIndex];
+				if (state == BehaviorState::Failure)
+					currentChild = 0;
+				else if (state == BehaviorState::Success)
+				{
+					++currentChild;
+					state = BehaviorState::Running;
+				}
+			}
+			else if (frame.ChildrenLeft > 0 && state == (composite.Type == FlatBehaviorType::Selector ? BehaviorState::Failure : BehaviorState::Success))
+			{
+				//A selector goes on while its children fail, a sequence while they succeed
+				--frame.ChildrenLeft;
+				nodeIndex = childIndex + m_Nodes[childIndex].SubtreeSize;
+				break;
+			}
+			childIndex = frame.NodeIndex;
+			--stackSize;
+		}
+		if (stackSize == 0)
+		{
+			//An update that ended on guards alone gives the same state until one of them changes
+			if (isReactive && m_IsTracing)
+			{
+				StopTracing(static_cast<unsigned int>(m_Nodes.size()));
+				m_ResumeState = state;
+			}
+			return state;
+		}
+	}
+}
+
+template BehaviorState FlatBehaviorTree::ExecuteNodes<false>();
+template BehaviorState FlatBehaviorTree::ExecuteNodes<true>();
+
+//Calls the leaves straight from the node array, without pushing a frame or going back through the switch for every child
+BehaviorState FlatBehaviorTree::ExecuteLeaves(const FlatBehaviorNode& composite) const
+{
+	//A selector goes on while its children fail, a sequence while they succeed
+	const BehaviorState continueState = composite.Type == FlatBehaviorType::Selector ? BehaviorState::Failure : BehaviorState::Success;
+	BehaviorState state = continueState;
+	const FlatBehaviorNode* pLeaf = &composite + 1;
+	for (const FlatBehaviorNode* const pEnd = pLeaf + composite.ChildCount; pLeaf != pEnd; ++pLeaf)
+	{
+		if (pLeaf->Type == FlatBehaviorType::Action)
+			state = pLeaf->pAction(m_pBlackBoard);
+		else
+			state = pLeaf->pConditional(m_pBlackBoard) != (pLeaf->Type == FlatBehaviorType::InvertedConditional) ? BehaviorState::Success : BehaviorState::Failure;
+		if (state != continueState)
+			break;
+	}
+	return state;
+}
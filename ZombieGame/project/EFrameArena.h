@@ -0,0 +1,165 @@
+/*=============================================================================*/
+// Copyright 2021-2022 Elite Engine
+/*=============================================================================*/
+// EFrameArena.h: Linear allocator for the scratch data of one frame, with std containers on top
+/*=============================================================================*/
+#ifndef ELITE_FRAME_ARENA
+#define ELITE_FRAME_ARENA
+
+//--- Includes ---
+#include <cstddef>
+#include <cstdio>
+#include <new>
+#include <vector>
+
+//-----------------------------------------------------------------
+// FRAME ARENA
+//-----------------------------------------------------------------
+//Allocating only moves a pointer forward, freeing does nothing, Reset frees everything at once.
+//Reset it at the start of every frame, nothing allocated from it may be kept past that.
+//A frame that does not fit gets extra blocks, the next Reset replaces them by one block big enough for all of it,
+//so once the biggest frame was seen the arena does not touch the heap anymore.
+class FrameArena final
+{
+public:
+	explicit FrameArena(size_t blockSize = 16 * 1024)
+	{
+		AddBlock(blockSize);
+	}
+	~FrameArena()
+	{
+		for (const Block& block : m_Blocks)
+			::operator delete(block.pData);
+	}
+
+	FrameArena(const FrameArena& other) = delete;
+	FrameArena& operator=(const FrameArena& other) = delete;
+	FrameArena(FrameArena&& other) = delete;
+	FrameArena& operator=(FrameArena&& other) = delete;
+
+	void* Allocate(size_t size, size_t alignment)
+	{
+		size_t offset = GetAlignedOffset(m_Blocks.back(), alignment);
+		if (offset + size > m_Blocks.back().Size)
+		{
+			//With room to align the start, for allocations that are bigger than a block
+			const size_t blockSize = m_Blocks.front().Size;
+			AddBlock(size + alignment > blockSize ? size + alignment : blockSize);
+			offset = GetAlignedOffset(m_Blocks.back(), alignment);
+		}
+		Block& block = m_Blocks.back();
+		block.Used = offset + size;
+		m_UsedSize += size;
+		++m_AllocationCount;
+		return block.pData + offset;
+	}
+
+	void Reset()
+	{
+		if (m_UsedSize > m_PeakSize)
+			m_PeakSize = m_UsedSize;
+		if (m_Blocks.size() > 1)
+		{
+			size_t totalSize = 0;
+			for (const Block& block : m_Blocks)
+			{
+				totalSize += block.Size;
+				::operator delete(block.pData);
+			}
+			m_Blocks.clear();
+			AddBlock(totalSize);
+		}
+		m_Blocks.back().Used = 0;
+		m_UsedSize = 0;
+		++m_FrameCount;
+	}
+
+	size_t GetUsedSize() const { return m_UsedSize; }
+	size_t GetCapacity() const
+	{
+		size_t capacity = 0;
+		for (const Block& block : m_Blocks)
+			capacity += block.Size;
+		return capacity;
+	}
+	//Blocks taken from the heap since the arena was made, stops growing once every frame fits
+	unsigned int GetBlockAllocationCount() const { return m_BlockAllocationCount; }
+
+	void PrintStats() const
+	{
+		printf("FrameArena: %u frames, %.1f allocations per frame, %zu bytes peak, %zu bytes capacity, %u blocks taken from the heap \n",
+			m_FrameCount, m_FrameCount > 0 ? double(m_AllocationCount) / m_FrameCount : 0.0, m_PeakSize, GetCapacity(), m_BlockAllocationCount);
+	}
+
+private:
+	struct Block
+	{
+		char* pData = nullptr;
+		size_t Size = 0;
+		size_t Used = 0;
+	};
+
+	std::vector<Block> m_Blocks = {};
+	size_t m_UsedSize = 0;
+	size_t m_PeakSize = 0;
+	unsigned int m_FrameCount = 0;
+	unsigned long long m_AllocationCount = 0;
+	unsigned int m_BlockAllocationCount = 0;
+
+	static size_t GetAlignedOffset(const Block& block, size_t alignment)
+	{
+		const size_t address = reinterpret_cast<size_t>(block.pData) + block.Used;
+		return block.Used + (alignment - address % alignment) % alignment;
+	}
+
+	void AddBlock(size_t size)
+	{
+		Block block{};
+		block.pData = static_cast<char*>(::operator new(size));
+		block.Size = size;
+		m_Blocks.push_back(block);
+		++m_BlockAllocationCount;
+	}
+};
+
+//-----------------------------------------------------------------
+// FRAME CONTAINERS
+//-----------------------------------------------------------------
+//Allocator for std containers that live for one frame at most, without an arena it uses the heap
+//so the same code also works where there is no frame, e.g. in tools and tests.
+template<typename T>
+class FrameAllocator
+{
+public:
+	using value_type = T;
+
+	explicit FrameAllocator(FrameArena* pArena = nullptr) : m_pArena(pArena) {}
+	template<typename U> FrameAllocator(const FrameAllocator<U>& other) : m_pArena(other.GetArena()) {}
+
+	T* allocate(size_t count)
+	{
+		if (m_pArena == nullptr)
+			return static_cast<T*>(::operator new(count * sizeof(T)));
+		return static_cast<T*>(m_pArena->Allocate(count * sizeof(T), alignof(T)));
+	}
+	void deallocate(T* p, size_t)
+	{
+		if (m_pArena == nullptr)
+			::operator delete(p);
+	}
+
+	FrameArena* GetArena() const { return m_pArena; }
+
+private:
+	FrameArena* m_pArena;
+};
+
+template<typename T, typename U>
+bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b) { return a.GetArena() == b.GetArena(); }
+template<typename T, typename U>
+bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b) { return a.GetArena() != b.GetArena(); }
+
+//Reserve what is needed up front, growing leaves the old buffer unused in the arena until the next Reset
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+#endif
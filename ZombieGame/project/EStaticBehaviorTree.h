@@ -0,0 +1,309 @@
+/*=============================================================================*/
+// Copyright 2021-2022 Elite Engine
+/*=============================================================================*/
+// EStaticBehaviorTree.h: Behavior tree composed at compile time out of templates
+/*=============================================================================*/
+#ifndef ELITE_STATIC_BEHAVIOR_TREE
+#define ELITE_STATIC_BEHAVIOR_TREE
+
+//--- Includes ---
+#include "EBehaviorTree.h"
+
+//-----------------------------------------------------------------
+// STATIC BEHAVIOR TREE NODES
+//-----------------------------------------------------------------
+//The whole tree is one type, e.g.
+//	Selector<Sequence<Cond<IsInPurgeZone>, Act<GetReadyToEscapePurgeZone>, Act<Flee>>, Act<ExploreWorld>>
+//Nodes are stored by value inside their parent, so a tree does not allocate and every call can be inlined.
+//Every node can also create the equivalent runtime IBehavior tree in a node pool with CreateBehavior().
+//The runtime nodes are created one level at a time: a node, then its child list, then all of its children,
+//then the children of each child, so siblings are next to each other in the pool.
+//GetPoolSize() and GetNodeCount() are known at compile time, the pool of CreateBehaviorTree() is one block.
+namespace BT_Static
+{
+	//--- CHILDREN ---
+	template<typename... Children>
+	class ChildList;
+
+	template<>
+	class ChildList<>
+	{
+	public:
+		BehaviorState Select(Blackboard*) { return BehaviorState::Failure; }
+		BehaviorState Sequence(Blackboard*) { return BehaviorState::Success; }
+		BehaviorState ExecuteAt(unsigned int, Blackboard*) { return BehaviorState::Failure; }
+		static void CreateNodes(IBehavior**, BehaviorNodePool&) {}
+		static void CreateChildren(IBehavior* const*, BehaviorNodePool&) {}
+		static constexpr size_t GetPoolSize() { return 0; }
+		static constexpr unsigned int GetNodeCount() { return 0; }
+	};
+
+	template<typename First, typename... Rest>
+	class ChildList<First, Rest...>
+	{
+	public:
+		//Returns the state of the first child that does not fail
+		BehaviorState Select(Blackboard* pBlackBoard)
+		{
+			const BehaviorState state = m_First.Execute(pBlackBoard);
+			if (state != BehaviorState::Failure)
+				return state;
+			return m_Rest.Select(pBlackBoard);
+		}
+		//Returns the state of the first child that does not succeed
+		BehaviorState Sequence(Blackboard* pBlackBoard)
+		{
+			const BehaviorState state = m_First.Execute(pBlackBoard);
+			if (state != BehaviorState::Success)
+				return state;
+			return m_Rest.Sequence(pBlackBoard);
+		}
+		BehaviorState ExecuteAt(unsigned int index, Blackboard* pBlackBoard)
+		{
+			if (index == 0)
+				return m_First.Execute(pBlackBoard);
+			return m_Rest.ExecuteAt(index - 1, pBlackBoard);
+		}
+		static void CreateNodes(IBehavior** pBehaviors, BehaviorNodePool& nodePool)
+		{
+			*pBehaviors = First::CreateNode(nodePool);
+			ChildList<Rest...>::CreateNodes(pBehaviors + 1, nodePool);
+		}
+		static void CreateChildren(IBehavior* const* pBehaviors, BehaviorNodePool& nodePool)
+		{
+			First::CreateChildren(*pBehaviors, nodePool);
+			ChildList<Rest...>::CreateChildren(pBehaviors + 1, nodePool);
+		}
+		static constexpr size_t GetPoolSize() { return First::GetPoolSize() + ChildList<Rest...>::GetPoolSize(); }
+		static constexpr unsigned int GetNodeCount() { return First::GetNodeCount() + ChildList<Rest...>::GetNodeCount(); }
+
+	private:
+		First m_First;
+		ChildList<Rest...> m_Rest;
+	};
+
+	//--- COMPOSITE HELPERS ---
+	template<typename... Children>
+	void CreateCompositeChildren(IBehavior* pBehavior, BehaviorNodePool& nodePool)
+	{
+		constexpr unsigned int childCount = sizeof...(Children);
+		IBehavior** pChildBehaviors = nodePool.CreateArray<IBehavior*>(childCount);
+		ChildList<Children...>::CreateNodes(pChildBehaviors, nodePool);
+		static_cast<BehaviorComposite*>(pBehavior)->SetChildBehaviors(BehaviorChildren{ pChildBehaviors, childCount });
+		ChildList<Children...>::CreateChildren(pChildBehaviors, nodePool);
+	}
+
+	template<typename Composite, typename... Children>
+	IBehavior* CreateComposite(BehaviorNodePool& nodePool)
+	{
+		IBehavior* pBehavior = nodePool.Create<Composite>();
+		CreateCompositeChildren<Children...>(pBehavior, nodePool);
+		return pBehavior;
+	}
+
+	template<typename Composite, typename... Children>
+	constexpr size_t GetCompositePoolSize()
+	{
+		return BehaviorNodePool::GetAllocationSize(sizeof(Composite))
+			+ BehaviorNodePool::GetAllocationSize(sizeof...(Children) * sizeof(IBehavior*))
+			+ ChildList<Children...>::GetPoolSize();
+	}
+
+	//--- COMPOSITES ---
+	template<typename... Children>
+	class Selector
+	{
+	public:
+		BehaviorState Execute(Blackboard* pBlackBoard) { return m_Children.Select(pBlackBoard); }
+		static IBehavior* CreateBehavior(BehaviorNodePool& nodePool) { return CreateComposite<BehaviorSelector, Children...>(nodePool); }
+		static IBehavior* CreateNode(BehaviorNodePool& nodePool) { return nodePool.Create<BehaviorSelector>(); }
+		static void CreateChildren(IBehavior* pBehavior, BehaviorNodePool& nodePool) { CreateCompositeChildren<Children...>(pBehavior, nodePool); }
+		static constexpr size_t GetPoolSize() { return GetCompositePoolSize<BehaviorSelector, Children...>(); }
+		static constexpr unsigned int GetNodeCount() { return 1 + ChildList<Children...>::GetNodeCount(); }
+
+	private:
+		ChildList<Children...> m_Children;
+	};
+
+	template<typename... Children>
+	class Sequence
+	{
+	public:
+		BehaviorState Execute(Blackboard* pBlackBoard) { return m_Children.Sequence(pBlackBoard); }
+		static IBehavior* CreateBehavior(BehaviorNodePool& nodePool) { return CreateComposite<BehaviorSequence, Children...>(nodePool); }
+		static IBehavior* CreateNode(BehaviorNodePool& nodePool) { return nodePool.Create<BehaviorSequence>(); }
+		static void CreateChildren(IBehavior* pBehavior, BehaviorNodePool& nodePool) { CreateCompositeChildren<Children...>(pBehavior, nodePool); }
+		static constexpr size_t GetPoolSize() { return GetCompositePoolSize<BehaviorSequence, Children...>(); }
+		static constexpr unsigned int GetNodeCount() { return 1 + ChildList<Children...>::GetNodeCount(); }
+
+	private:
+		ChildList<Children...> m_Children;
+	};
+
+	template<typename... Children>
+	class PartialSequence
+	{
+	public:
+		//Executes one child per update, starting from where the previous update stopped
+		BehaviorState Execute(Blackboard* pBlackBoard)
+		{
+			if (m_CurrentBehaviorIndex < sizeof...(Children))
+			{
+				switch (m_Children.ExecuteAt(m_CurrentBehaviorIndex, pBlackBoard))
+				{
+				case BehaviorState::Failure:
+					m_CurrentBehaviorIndex = 0;
+					return BehaviorState::Failure;
+				case BehaviorState::Success:
+					++m_CurrentBehaviorIndex;
+					return BehaviorState::Running;
+				case BehaviorState::Running:
+					return BehaviorState::Running;
+				}
+			}
+
+			m_CurrentBehaviorIndex = 0;
+			return BehaviorState::Success;
+		}
+		static IBehavior* CreateBehavior(BehaviorNodePool& nodePool) { return CreateComposite<BehaviorPartialSequence, Children...>(nodePool); }
+		static IBehavior* CreateNode(BehaviorNodePool& nodePool) { return nodePool.Create<BehaviorPartialSequence>(); }
+		static void CreateChildren(IBehavior* pBehavior, BehaviorNodePool& nodePool) { CreateCompositeChildren<Children...>(pBehavior, nodePool); }
+		static constexpr size_t GetPoolSize() { return GetCompositePoolSize<BehaviorPartialSequence, Children...>(); }
+		static constexpr unsigned int GetNodeCount() { return 1 + ChildList<Children...>::GetNodeCount(); }
+
+	private:
+		ChildList<Children...> m_Children;
+		unsigned int m_CurrentBehaviorIndex = 0;
+	};
+
+	//--- LEAVES ---
+	template<bool(*fpConditional)(Blackboard*)>
+	class Cond
+	{
+	public:
+		BehaviorState Execute(Blackboard* pBlackBoard)
+		{
+			return fpConditional(pBlackBoard) ? BehaviorState::Success : BehaviorState::Failure;
+		}
+		static IBehavior* CreateBehavior(BehaviorNodePool& nodePool) { return CreateNode(nodePool); }
+		static IBehavior* CreateNode(BehaviorNodePool& nodePool) { return CreateConditional(nodePool, ConditionalFunction<fpConditional>{}); }
+		static void CreateChildren(IBehavior*, BehaviorNodePool&) {}
+		static constexpr size_t GetPoolSize()
+		{
+			return BehaviorNodePool::GetAllocationSize(sizeof(CallableBehaviorConditional<ConditionalFunction<fpConditional>>));
+		}
+		static constexpr unsigned int GetNodeCount() { return 1; }
+	};
+
+	template<bool(*fpConditional)(Blackboard*)>
+	class InvCond
+	{
+	public:
+		BehaviorState Execute(Blackboard* pBlackBoard)
+		{
+			return fpConditional(pBlackBoard) ? BehaviorState::Failure : BehaviorState::Success;
+		}
+		static IBehavior* CreateBehavior(BehaviorNodePool& nodePool) { return CreateNode(nodePool); }
+		static IBehavior* CreateNode(BehaviorNodePool& nodePool) { return CreateInvertedConditional(nodePool, ConditionalFunction<fpConditional>{}); }
+		static void CreateChildren(IBehavior*, BehaviorNodePool&) {}
+		static constexpr size_t GetPoolSize()
+		{
+			return BehaviorNodePool::GetAllocationSize(sizeof(CallableInvertedBehaviorConditional<ConditionalFunction<fpConditional>>));
+		}
+		static constexpr unsigned int GetNodeCount() { return 1; }
+	};
+
+	template<BehaviorState(*fpAction)(Blackboard*)>
+	class Act
+	{
+	public:
+		BehaviorState Execute(Blackboard* pBlackBoard) { return fpAction(pBlackBoard); }
+		static IBehavior* CreateBehavior(BehaviorNodePool& nodePool) { return CreateNode(nodePool); }
+		static IBehavior* CreateNode(BehaviorNodePool& nodePool) { return CreateAction(nodePool, ActionFunction<fpAction>{}); }
+		static void CreateChildren(IBehavior*, BehaviorNodePool&) {}
+		static constexpr size_t GetPoolSize()
+		{
+			return BehaviorNodePool::GetAllocationSize(sizeof(CallableBehaviorAction<ActionFunction<fpAction>>));
+		}
+		static constexpr unsigned int GetNodeCount() { return 1; }
+	};
+
+	//Runtime IBehavior inside a static tree, created by the factory when the static tree is constructed
+	//The factory creates its whole subtree in the pool it is given, its size is not known up front
+	template<IBehavior*(*fpFactory)(BehaviorNodePool&)>
+	class Runtime
+	{
+	public:
+		Runtime() : m_pBehavior(fpFactory(m_NodePool)) {}
+
+		Runtime(const Runtime& other) = delete;
+		Runtime& operator=(const Runtime& other) = delete;
+
+		BehaviorState Execute(Blackboard* pBlackBoard) { return m_pBehavior->Execute(pBlackBoard); }
+		static IBehavior* CreateBehavior(BehaviorNodePool& nodePool) { return fpFactory(nodePool); }
+		static IBehavior* CreateNode(BehaviorNodePool& nodePool) { return fpFactory(nodePool); }
+		static void CreateChildren(IBehavior*, BehaviorNodePool&) {}
+		static constexpr size_t GetPoolSize() { return 0; }
+		static constexpr unsigned int GetNodeCount() { return 1; }
+
+	private:
+		BehaviorNodePool m_NodePool{};
+		IBehavior* m_pBehavior = nullptr;
+	};
+
+	//Runtime tree with the same nodes as the static tree, all of them in one node pool that is owned by the tree
+	//Takes ownership of the blackboard, like every BehaviorTree
+	template<typename Root>
+	BehaviorTree* CreateBehaviorTree(Blackboard* pBlackBoard)
+	{
+		BehaviorNodePool* pNodePool = new BehaviorNodePool(Root::GetPoolSize(), Root::GetNodeCount());
+		IBehavior* pRootBehavior = Root::CreateBehavior(*pNodePool);
+		return new BehaviorTree(pBlackBoard, pRootBehavior, pNodePool);
+	}
+}
+
+//-----------------------------------------------------------------
+// STATIC BEHAVIOR (IBehavior)
+//-----------------------------------------------------------------
+//Static tree inside a runtime tree
+//Static partial sequences keep their state in the node, so a tree with this behavior can not be shared between agents
+template<typename Node>
+class StaticBehavior final : public IBehavior
+{
+public:
+	StaticBehavior() = default;
+	virtual BehaviorState Execute(Blackboard* pBlackBoard) override
+	{
+		return m_Node.Execute(pBlackBoard);
+	}
+
+private:
+	Node m_Node;
+};
+
+//-----------------------------------------------------------------
+// STATIC BEHAVIOR TREE
+//-----------------------------------------------------------------
+//Does not take ownership of the blackboard
+template<typename Root>
+class StaticBehaviorTree final : public IDecisionMaking
+{
+public:
+	explicit StaticBehaviorTree(Blackboard* pBlackBoard)
+		: m_pBlackBoard(pBlackBoard) {}
+
+	virtual void Update(float deltaTime) override
+	{
+		m_pBlackBoard->BeginTick();
+		m_CurrentState = m_Root.Execute(m_pBlackBoard);
+	}
+	Blackboard* GetBlackboard() const { return m_pBlackBoard; }
+	BehaviorState GetCurrentState() const { return m_CurrentState; }
+
+private:
+	BehaviorState m_CurrentState = BehaviorState::Failure;
+	Blackboard* m_pBlackBoard = nullptr;
+	Root m_Root;
+};
+
+#endif
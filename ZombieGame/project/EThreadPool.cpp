@@ -0,0 +1,93 @@
+//=== General Includes ===
+#include "stdafx.h"
+#include "EThreadPool.h"
+
+//-----------------------------------------------------------------
+// THREAD POOL
+//-----------------------------------------------------------------
+ThreadPool::ThreadPool(unsigned int threadCount)
+	: m_Ranges(threadCount > 0 ? threadCount : (std::max)(std::thread::hardware_concurrency(), 1U))
+{
+	//The calling thread is the first thread, it does not need a worker
+	for (unsigned int threadIndex = 1; threadIndex < m_Ranges.size(); ++threadIndex)
+		m_Workers.push_back(std::thread(&ThreadPool::RunWorker, this, threadIndex));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_IsStopping = true;
+	}
+	m_WorkCondition.notify_all();
+	for (std::thread& worker : m_Workers)
+		worker.join();
+	m_Workers.clear();
+}
+
+void ThreadPool::ParallelFor(unsigned int count, const std::function<void(unsigned int)>& function)
+{
+	if (count == 0)
+		return;
+	if (m_Workers.empty() || count == 1)
+	{
+		for (unsigned int index = 0; index < count; ++index)
+			function(index);
+		return;
+	}
+
+	//Split the loop in one contiguous range per thread
+	const unsigned int threadCount = GetThreadCount();
+	for (unsigned int threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+	{
+		m_Ranges[threadIndex].Next.store(static_cast<unsigned int>(static_cast<unsigned long long>(count) * threadIndex / threadCount));
+		m_Ranges[threadIndex].End = static_cast<unsigned int>(static_cast<unsigned long long>(count) * (threadIndex + 1) / threadCount);
+	}
+	m_pFunction = &function;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_PendingWorkers = static_cast<unsigned int>(m_Workers.size());
+		++m_Generation;
+	}
+	m_WorkCondition.notify_all();
+
+	Work(0);
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_DoneCondition.wait(lock, [this]() { return m_PendingWorkers == 0; });
+	m_pFunction = nullptr;
+}
+
+void ThreadPool::RunWorker(unsigned int threadIndex)
+{
+	unsigned int generation = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkCondition.wait(lock, [this, generation]() { return m_IsStopping || m_Generation != generation; });
+			if (m_IsStopping)
+				return;
+			generation = m_Generation;
+		}
+
+		Work(threadIndex);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (--m_PendingWorkers == 0)
+			m_DoneCondition.notify_one();
+	}
+}
+
+void ThreadPool::Work(unsigned int threadIndex)
+{
+	//Start with the own range, then steal from the next ones
+	const unsigned int threadCount = GetThreadCount();
+	for (unsigned int offset = 0; offset < threadCount; ++offset)
+	{
+		WorkRange& range = m_Ranges[(threadIndex + offset) % threadCount];
+		for (unsigned int index = range.Next.fetch_add(1); index < range.End; index = range.Next.fetch_add(1))
+			(*m_pFunction)(index);
+	}
+}
@@ -0,0 +1,65 @@
+/*=============================================================================*/
+// Copyright 2021-2022 Elite Engine
+/*=============================================================================*/
+// EThreadPool.h: Fixed set of worker threads that split loops between them
+/*=============================================================================*/
+#ifndef ELITE_THREAD_POOL
+#define ELITE_THREAD_POOL
+
+//--- Includes ---
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------
+// THREAD POOL
+//-----------------------------------------------------------------
+//Every thread (the workers and the thread calling ParallelFor) starts on its own contiguous range of the loop.
+//A thread that finishes its range steals the remaining indices of the other ranges, one index at a time,
+//so uneven work per index is balanced without a shared queue.
+class ThreadPool final
+{
+public:
+	explicit ThreadPool(unsigned int threadCount = 0); //0 uses one thread per hardware thread
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool& other) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+	ThreadPool(ThreadPool&& other) = delete;
+	ThreadPool& operator=(ThreadPool&& other) = delete;
+
+	//Calls function(index) for every index in [0, count) and returns once all of them are done.
+	//Not reentrant, only one ParallelFor can run at a time.
+	void ParallelFor(unsigned int count, const std::function<void(unsigned int)>& function);
+
+	//Including the thread calling ParallelFor
+	unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_Workers.size()) + 1; }
+
+private:
+	//One per thread, padded so every thread works on its own cache line
+	struct WorkRange
+	{
+		std::atomic<unsigned int> Next{ 0 };
+		unsigned int End = 0;
+		char Padding[64 - sizeof(std::atomic<unsigned int>) - sizeof(unsigned int)];
+	};
+
+	std::vector<std::thread> m_Workers = {};
+	std::vector<WorkRange> m_Ranges;
+	const std::function<void(unsigned int)>* m_pFunction = nullptr;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkCondition;
+	std::condition_variable m_DoneCondition;
+	unsigned int m_Generation = 0; //Incremented for every ParallelFor, wakes up the workers
+	unsigned int m_PendingWorkers = 0;
+	bool m_IsStopping = false;
+
+	void RunWorker(unsigned int threadIndex);
+	void Work(unsigned int threadIndex);
+};
+
+#endif
@@ -0,0 +1,153 @@
+/*=============================================================================*/
+// Copyright 2021-2022 Elite Engine
+/*=============================================================================*/
+// EFastTrig.h: Polynomial atan2, and sincos for batches of angles, for orientation math that runs every tick
+/*=============================================================================*/
+#ifndef ELITE_MATH_FAST_TRIG
+#define ELITE_MATH_FAST_TRIG
+
+//--- Includes ---
+#include <cmath>
+#include <cfloat>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ELITE_FAST_TRIG_SSE2
+#endif
+
+namespace Elite
+{
+	namespace FastTrig
+	{
+		const float Pi = 3.14159265358979323846f;
+		const float HalfPi = 1.57079632679489661923f;
+		const float TwoOverPi = 0.636619772367581343076f;
+		//pi / 2 split in two floats, so the argument reduction keeps its precision
+		const float HalfPiHigh = 1.57079637050628662109375f;
+		const float HalfPiLow = -4.37113900018624283e-8f;
+
+		//Minimax polynomial of atan(z) for z in [0, 1], max error about 2e-6 radians
+		const float Atan1 = 0.99997726f;
+		const float Atan3 = -0.33262347f;
+		const float Atan5 = 0.19354346f;
+		const float Atan7 = -0.11643287f;
+		const float Atan9 = 0.05265332f;
+		const float Atan11 = -0.01172120f;
+
+		//Taylor polynomials of sin and cos for r in [-pi / 4, pi / 4], below float precision
+		const float Sin3 = -1.66666667e-1f;
+		const float Sin5 = 8.33333333e-3f;
+		const float Sin7 = -1.98412698e-4f;
+		const float Sin9 = 2.75573192e-6f;
+		const float Cos2 = -0.5f;
+		const float Cos4 = 4.16666667e-2f;
+		const float Cos6 = -1.38888889e-3f;
+		const float Cos8 = 2.48015873e-5f;
+		const float Cos10 = -2.75573192e-7f;
+	}
+
+	/*! atan2 with a max error of about 2e-6 radians, in [-pi, pi]. Returns 0 for (0, 0). */
+	inline float FastAtan2(float y, float x)
+	{
+		using namespace FastTrig;
+		//atan of the smallest over the largest component is in [0, pi / 4], the octant is added after
+		const float absX = fabsf(x);
+		const float absY = fabsf(y);
+		const bool isSteep = absY > absX;
+		const float z = (isSteep ? absX : absY) / (isSteep ? (absY > FLT_MIN ? absY : FLT_MIN) : (absX > FLT_MIN ? absX : FLT_MIN));
+		const float z2 = z * z;
+		float angle = z * (Atan1 + z2 * (Atan3 + z2 * (Atan5 + z2 * (Atan7 + z2 * (Atan9 + z2 * Atan11)))));
+		if (isSteep)
+			angle = HalfPi - angle;
+		if (x < 0.f)
+			angle = Pi - angle;
+		return y < 0.f ? -angle : angle;
+	}
+
+	/*! FastAtan2 for count pairs, 4 at a time with SSE2. The results can differ from FastAtan2 in the last bit. */
+	inline void FastAtan2(const float* pY, const float* pX, float* pAngles, unsigned int count)
+	{
+		unsigned int index = 0;
+#if defined(ELITE_FAST_TRIG_SSE2)
+		using namespace FastTrig;
+		const __m128 signMask = _mm_set1_ps(-0.f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 minValue = _mm_set1_ps(FLT_MIN);
+		const __m128 halfPi = _mm_set1_ps(HalfPi);
+		const __m128 pi = _mm_set1_ps(Pi);
+		for (; index + 4 <= count; index += 4)
+		{
+			const __m128 y = _mm_loadu_ps(pY + index);
+			const __m128 x = _mm_loadu_ps(pX + index);
+			const __m128 absX = _mm_andnot_ps(signMask, x);
+			const __m128 absY = _mm_andnot_ps(signMask, y);
+			const __m128 isSteep = _mm_cmpgt_ps(absY, absX);
+			const __m128 z = _mm_div_ps(_mm_min_ps(absX, absY), _mm_max_ps(_mm_max_ps(absX, absY), minValue));
+			const __m128 z2 = _mm_mul_ps(z, z);
+
+			__m128 polynomial = _mm_add_ps(_mm_set1_ps(Atan9), _mm_mul_ps(z2, _mm_set1_ps(Atan11)));
+			polynomial = _mm_add_ps(_mm_set1_ps(Atan7), _mm_mul_ps(z2, polynomial));
+			polynomial = _mm_add_ps(_mm_set1_ps(Atan5), _mm_mul_ps(z2, polynomial));
+			polynomial = _mm_add_ps(_mm_set1_ps(Atan3), _mm_mul_ps(z2, polynomial));
+			polynomial = _mm_add_ps(_mm_set1_ps(Atan1), _mm_mul_ps(z2, polynomial));
+			__m128 angle = _mm_mul_ps(z, polynomial);
+
+			//No blend in SSE2, select with the comparison masks
+			angle = _mm_or_ps(_mm_and_ps(isSteep, _mm_sub_ps(halfPi, angle)), _mm_andnot_ps(isSteep, angle));
+			const __m128 isLeft = _mm_cmplt_ps(x, zero);
+			angle = _mm_or_ps(_mm_and_ps(isLeft, _mm_sub_ps(pi, angle)), _mm_andnot_ps(isLeft, angle));
+			const __m128 isDown = _mm_cmplt_ps(y, zero);
+			angle = _mm_xor_ps(angle, _mm_and_ps(isDown, signMask));
+			_mm_storeu_ps(pAngles + index, angle);
+		}
+#endif
+		for (; index < count; ++index)
+			pAngles[index] = FastAtan2(pY[index], pX[index]);
+	}
+
+	/*! sin and cos of count angles, 4 at a time with SSE2, accurate to a few float ulps for angles up to a few thousand radians.
+	There is no scalar version: for one angle the polynomial is not faster than sinf and cosf, the rest is done with those. */
+	inline void FastSinCos(const float* pAngles, float* pSines, float* pCosines, unsigned int count)
+	{
+		unsigned int index = 0;
+#if defined(ELITE_FAST_TRIG_SSE2)
+		using namespace FastTrig;
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+		for (; index + 4 <= count; index += 4)
+		{
+			const __m128 angle = _mm_loadu_ps(pAngles + index);
+			//Rounds to the nearest quadrant
+			const __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(TwoOverPi)));
+			const __m128 quadrantFloat = _mm_cvtepi32_ps(quadrant);
+			const __m128 r = _mm_sub_ps(_mm_sub_ps(angle, _mm_mul_ps(quadrantFloat, _mm_set1_ps(HalfPiHigh))), _mm_mul_ps(quadrantFloat, _mm_set1_ps(HalfPiLow)));
+			const __m128 r2 = _mm_mul_ps(r, r);
+
+			__m128 s = _mm_add_ps(_mm_set1_ps(Sin7), _mm_mul_ps(r2, _mm_set1_ps(Sin9)));
+			s = _mm_add_ps(_mm_set1_ps(Sin5), _mm_mul_ps(r2, s));
+			s = _mm_add_ps(_mm_set1_ps(Sin3), _mm_mul_ps(r2, s));
+			s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+			__m128 c = _mm_add_ps(_mm_set1_ps(Cos8), _mm_mul_ps(r2, _mm_set1_ps(Cos10)));
+			c = _mm_add_ps(_mm_set1_ps(Cos6), _mm_mul_ps(r2, c));
+			c = _mm_add_ps(_mm_set1_ps(Cos4), _mm_mul_ps(r2, c));
+			c = _mm_add_ps(_mm_set1_ps(Cos2), _mm_mul_ps(r2, c));
+			c = _mm_add_ps(_mm_set1_ps(1.f), _mm_mul_ps(r2, c));
+
+			//Odd quadrants swap sin and cos, quadrants 2 and 3 negate the sine, 1 and 2 the cosine
+			const __m128 isSwapped = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+			const __m128 sine = _mm_or_ps(_mm_and_ps(isSwapped, c), _mm_andnot_ps(isSwapped, s));
+			const __m128 cosine = _mm_or_ps(_mm_and_ps(isSwapped, s), _mm_andnot_ps(isSwapped, c));
+			const __m128 sineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+			const __m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+			_mm_storeu_ps(pSines + index, _mm_xor_ps(sine, sineSign));
+			_mm_storeu_ps(pCosines + index, _mm_xor_ps(cosine, cosineSign));
+		}
+#endif
+		for (; index < count; ++index)
+		{
+			pSines[index] = sinf(pAngles[index]);
+			pCosines[index] = cosf(pAngles[index]);
+		}
+	}
+}
+
+#endif
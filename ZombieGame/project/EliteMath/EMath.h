@@ -11,11 +11,13 @@
 #include <math.h>
 /* --- UTILITIES --- */
 #include "EMathUtilities.h"
+#include "EFastTrig.h"
 /* --- TYPES --- */
 #include "EVector2.h"
 #include "EVector3.h"
 #include "EMat22.h"
 #include "FMatrix.h"
+#include "EVector2Batch.h"
 
 /* --- TYPE DEFINES --- */
 #endif
@@ -216,20 +216,26 @@ namespace Elite
 	/*  Creates a normalized vector from an angle in radians.  */
 	inline Vector2 OrientationToVector(float orientation)
 	{
-		return Vector2(cos(orientation), sin(orientation));
+		return Vector2(cosf(orientation), sinf(orientation));
 	}
 
-	/*Calculates the orientation angle from a vector*/
+	/*Calculates the orientation angle from a vector, between -pi and pi*/
 	inline float VectorToOrientation(const Vector2& vector)
 	{
-		return atan2f(vector.y, vector.x);
+		return FastAtan2(vector.y, vector.x);
 	}
 
-	/*! Get Angle Between 2 vectors*/
+	/*! Get Angle Between 2 vectors, between -pi and pi*/
 	inline float AngleBetween(const Elite::Vector2& v1, const Elite::Vector2& v2) {
 		float x = v1.Dot(v2);
 		float y = v1.Cross(v2);
-		return atan2(y, x);
+		return FastAtan2(y, x);
+	}
+
+	/*! Signed angle to turn from one orientation to another, the short way round (between -pi and pi)*/
+	inline float DeltaOrientation(float from, float to)
+	{
+		return ClampedAngle(to - from);
 	}
 
 #pragma endregion //ExtraFunctions
@@ -0,0 +1,325 @@
+/*=============================================================================*/
+// Copyright 2021-2022 Elite Engine
+/*=============================================================================*/
+// EVector2Batch.h: Many Vector2 in structure of arrays layout, with vectorized functions
+/*=============================================================================*/
+#ifndef ELITE_MATH_VECTOR2_BATCH
+#define ELITE_MATH_VECTOR2_BATCH
+
+//--- Includes ---
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ELITE_VECTOR2_BATCH_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ELITE_VECTOR2_BATCH_SSE2
+#endif
+
+namespace Elite
+{
+	//The x and y lanes are separate arrays, aligned and padded to a multiple of the widest vector,
+	//so every function works on whole vectors without a scalar tail on the inputs.
+	//The functions are chosen at compile time: AVX2, SSE2 or scalar, and give the same results as the Vector2 functions.
+	class Vector2Batch final
+	{
+	public:
+		static const unsigned int Width = 8; //Padding, in floats
+		static const unsigned int InvalidIndex = 0xFFFFFFFFU;
+
+		Vector2Batch() { Reserve(Width); }
+		explicit Vector2Batch(unsigned int capacity) { Reserve(capacity); }
+		~Vector2Batch() = default;
+
+		Vector2Batch(const Vector2Batch& other) = delete;
+		Vector2Batch& operator=(const Vector2Batch& other) = delete;
+		Vector2Batch(Vector2Batch&& other) = delete;
+		Vector2Batch& operator=(Vector2Batch&& other) = delete;
+
+		//--- Lanes ---
+		//Only grows the storage, so a batch refilled every frame does not allocate
+		void Reserve(unsigned int capacity)
+		{
+			const unsigned int paddedCapacity = GetPaddedSize(capacity);
+			if (paddedCapacity <= m_Capacity)
+				return;
+
+			//One buffer for both lanes, with room to align the start to 32 bytes
+			std::vector<float> storage(paddedCapacity * 2 + Width);
+			float* pX = Align(storage.data());
+			float* pY = pX + paddedCapacity;
+			for (unsigned int index = 0; index < m_Size; ++index)
+			{
+				pX[index] = m_pX[index];
+				pY[index] = m_pY[index];
+			}
+			m_Storage.swap(storage);
+			m_pX = pX;
+			m_pY = pY;
+			m_Capacity = paddedCapacity;
+		}
+		void Clear() { Resize(0); }
+		void Resize(unsigned int size)
+		{
+			Reserve(size);
+			//The padding is kept at zero
+			for (unsigned int index = size; index < GetPaddedSize(m_Size); ++index)
+				m_pX[index] = m_pY[index] = 0.f;
+			for (unsigned int index = m_Size; index < size; ++index)
+				m_pX[index] = m_pY[index] = 0.f;
+			m_Size = size;
+		}
+		void PushBack(const Vector2& v)
+		{
+			Resize(m_Size + 1);
+			Set(m_Size - 1, v);
+		}
+		void Assign(const std::vector<Vector2>& points)
+		{
+			Resize(static_cast<unsigned int>(points.size()));
+			for (unsigned int index = 0; index < m_Size; ++index)
+				Set(index, points[index]);
+		}
+
+		void Set(unsigned int index, const Vector2& v) { m_pX[index] = v.x; m_pY[index] = v.y; }
+		Vector2 Get(unsigned int index) const { return Vector2(m_pX[index], m_pY[index]); }
+		unsigned int Size() const { return m_Size; }
+		const float* GetX() const { return m_pX; }
+		const float* GetY() const { return m_pY; }
+
+		//--- Functions ---
+		//Every output array has at least Size() elements
+		void DistanceSquared(const Vector2& point, float* pDistancesSquared) const
+		{
+#if defined(ELITE_VECTOR2_BATCH_AVX2)
+			const __m256 pointX = _mm256_set1_ps(point.x);
+			const __m256 pointY = _mm256_set1_ps(point.y);
+			unsigned int index = 0;
+			for (; index + 8 <= m_Size; index += 8)
+				_mm256_storeu_ps(pDistancesSquared + index, DistanceSquared8(index, pointX, pointY));
+#elif defined(ELITE_VECTOR2_BATCH_SSE2)
+			const __m128 pointX = _mm_set1_ps(point.x);
+			const __m128 pointY = _mm_set1_ps(point.y);
+			unsigned int index = 0;
+			for (; index + 4 <= m_Size; index += 4)
+				_mm_storeu_ps(pDistancesSquared + index, DistanceSquared4(index, pointX, pointY));
+#else
+			unsigned int index = 0;
+#endif
+			for (; index < m_Size; ++index)
+				pDistancesSquared[index] = Square(point.x - m_pX[index]) + Square(point.y - m_pY[index]);
+		}
+
+		void Dot(const Vector2& v, float* pDots) const
+		{
+#if defined(ELITE_VECTOR2_BATCH_AVX2)
+			const __m256 vX = _mm256_set1_ps(v.x);
+			const __m256 vY = _mm256_set1_ps(v.y);
+			unsigned int index = 0;
+			for (; index + 8 <= m_Size; index += 8)
+				_mm256_storeu_ps(pDots + index, _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(m_pX + index), vX), _mm256_mul_ps(_mm256_load_ps(m_pY + index), vY)));
+#elif defined(ELITE_VECTOR2_BATCH_SSE2)
+			const __m128 vX = _mm_set1_ps(v.x);
+			const __m128 vY = _mm_set1_ps(v.y);
+			unsigned int index = 0;
+			for (; index + 4 <= m_Size; index += 4)
+				_mm_storeu_ps(pDots + index, _mm_add_ps(_mm_mul_ps(_mm_load_ps(m_pX + index), vX), _mm_mul_ps(_mm_load_ps(m_pY + index), vY)));
+#else
+			unsigned int index = 0;
+#endif
+			for (; index < m_Size; ++index)
+				pDots[index] = m_pX[index] * v.x + m_pY[index] * v.y;
+		}
+
+		//Like Vector2::Normalize, a vector with a magnitude of (almost) zero becomes zero
+		void Normalize()
+		{
+			//The padding is zero and stays zero, so it is normalized with the rest
+#if defined(ELITE_VECTOR2_BATCH_AVX2)
+			const __m256 epsilon = _mm256_set1_ps(FLT_EPSILON);
+			const __m256 one = _mm256_set1_ps(1.f);
+			for (unsigned int index = 0; index < m_Size; index += 8)
+			{
+				const __m256 x = _mm256_load_ps(m_pX + index);
+				const __m256 y = _mm256_load_ps(m_pY + index);
+				const __m256 magnitude = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)));
+				const __m256 isValid = _mm256_cmp_ps(magnitude, epsilon, _CMP_GT_OQ);
+				const __m256 invMagnitude = _mm256_and_ps(_mm256_div_ps(one, magnitude), isValid);
+				_mm256_store_ps(m_pX + index, _mm256_mul_ps(x, invMagnitude));
+				_mm256_store_ps(m_pY + index, _mm256_mul_ps(y, invMagnitude));
+			}
+#elif defined(ELITE_VECTOR2_BATCH_SSE2)
+			const __m128 epsilon = _mm_set1_ps(FLT_EPSILON);
+			const __m128 one = _mm_set1_ps(1.f);
+			for (unsigned int index = 0; index < m_Size; index += 4)
+			{
+				const __m128 x = _mm_load_ps(m_pX + index);
+				const __m128 y = _mm_load_ps(m_pY + index);
+				const __m128 magnitude = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+				const __m128 isValid = _mm_cmpgt_ps(magnitude, epsilon);
+				const __m128 invMagnitude = _mm_and_ps(_mm_div_ps(one, magnitude), isValid);
+				_mm_store_ps(m_pX + index, _mm_mul_ps(x, invMagnitude));
+				_mm_store_ps(m_pY + index, _mm_mul_ps(y, invMagnitude));
+			}
+#else
+			for (unsigned int index = 0; index < m_Size; ++index)
+			{
+				const float magnitude = sqrtf(m_pX[index] * m_pX[index] + m_pY[index] * m_pY[index]);
+				const float invMagnitude = magnitude > FLT_EPSILON ? 1.f / magnitude : 0.f;
+				m_pX[index] *= invMagnitude;
+				m_pY[index] *= invMagnitude;
+			}
+#endif
+		}
+
+		//Index of the closest vector to the point, the first one if several are equally close, InvalidIndex when empty
+		unsigned int ArgMinDistance(const Vector2& point, float* pDistanceSquared = nullptr) const
+		{
+			if (m_Size == 0)
+				return InvalidIndex;
+
+			unsigned int closestIndex = 0;
+			float closestDistanceSquared = FLT_MAX;
+			unsigned int index = 0;
+#if defined(ELITE_VECTOR2_BATCH_SSE2) || defined(ELITE_VECTOR2_BATCH_AVX2)
+			//Every lane keeps its own closest distance and index, the lanes are merged at the end
+			const __m128 pointX = _mm_set1_ps(point.x);
+			const __m128 pointY = _mm_set1_ps(point.y);
+			__m128 bestDistances = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndices = _mm_setzero_si128();
+			__m128i indices = _mm_set_epi32(3, 2, 1, 0);
+			const __m128i step = _mm_set1_epi32(4);
+			for (; index + 4 <= m_Size; index += 4)
+			{
+				const __m128 distances = DistanceSquared4(index, pointX, pointY);
+				const __m128 isCloser = _mm_cmplt_ps(distances, bestDistances);
+				bestDistances = _mm_or_ps(_mm_and_ps(isCloser, distances), _mm_andnot_ps(isCloser, bestDistances));
+				const __m128i isCloserInt = _mm_castps_si128(isCloser);
+				bestIndices = _mm_or_si128(_mm_and_si128(isCloserInt, indices), _mm_andnot_si128(isCloserInt, bestIndices));
+				indices = _mm_add_epi32(indices, step);
+			}
+
+			float laneDistances[4];
+			unsigned int laneIndices[4];
+			_mm_storeu_ps(laneDistances, bestDistances);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(laneIndices), bestIndices);
+			for (unsigned int lane = 0; lane < 4; ++lane)
+			{
+				if (laneDistances[lane] < closestDistanceSquared || (laneDistances[lane] == closestDistanceSquared && laneIndices[lane] < closestIndex))
+				{
+					closestDistanceSquared = laneDistances[lane];
+					closestIndex = laneIndices[lane];
+				}
+			}
+#endif
+			for (; index < m_Size; ++index)
+			{
+				const float distanceSquared = Square(point.x - m_pX[index]) + Square(point.y - m_pY[index]);
+				if (distanceSquared < closestDistanceSquared)
+				{
+					closestDistanceSquared = distanceSquared;
+					closestIndex = index;
+				}
+			}
+
+			if (pDistanceSquared != nullptr)
+				*pDistanceSquared = closestDistanceSquared;
+			return closestIndex;
+		}
+
+		//Sets bit (index % 32) of pMask[index / 32] for every vector within the radius (inclusive) of the point,
+		//pMask needs (Size() + 31) / 32 elements. Returns the amount of vectors within the radius.
+		unsigned int WithinRadius(const Vector2& point, float radius, unsigned int* pMask) const
+		{
+			const float radiusSquared = radius * radius;
+			const unsigned int wordCount = (m_Size + 31) / 32;
+			for (unsigned int word = 0; word < wordCount; ++word)
+				pMask[word] = 0;
+
+			unsigned int count = 0;
+			unsigned int index = 0;
+#if defined(ELITE_VECTOR2_BATCH_AVX2)
+			const __m256 pointX = _mm256_set1_ps(point.x);
+			const __m256 pointY = _mm256_set1_ps(point.y);
+			const __m256 radiusSquaredLanes = _mm256_set1_ps(radiusSquared);
+			for (; index + 8 <= m_Size; index += 8)
+			{
+				const unsigned int bits = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_cmp_ps(DistanceSquared8(index, pointX, pointY), radiusSquaredLanes, _CMP_LE_OQ)));
+				pMask[index / 32] |= bits << (index % 32);
+				count += CountBits(bits);
+			}
+#elif defined(ELITE_VECTOR2_BATCH_SSE2)
+			const __m128 pointX = _mm_set1_ps(point.x);
+			const __m128 pointY = _mm_set1_ps(point.y);
+			const __m128 radiusSquaredLanes = _mm_set1_ps(radiusSquared);
+			for (; index + 4 <= m_Size; index += 4)
+			{
+				const unsigned int bits = static_cast<unsigned int>(_mm_movemask_ps(_mm_cmple_ps(DistanceSquared4(index, pointX, pointY), radiusSquaredLanes)));
+				pMask[index / 32] |= bits << (index % 32);
+				count += CountBits(bits);
+			}
+#endif
+			for (; index < m_Size; ++index)
+			{
+				if (Square(point.x - m_pX[index]) + Square(point.y - m_pY[index]) <= radiusSquared)
+				{
+					pMask[index / 32] |= 1U << (index % 32);
+					++count;
+				}
+			}
+			return count;
+		}
+
+		static const char* GetInstructionSet()
+		{
+#if defined(ELITE_VECTOR2_BATCH_AVX2)
+			return "AVX2";
+#elif defined(ELITE_VECTOR2_BATCH_SSE2)
+			return "SSE2";
+#else
+			return "scalar";
+#endif
+		}
+
+	private:
+		std::vector<float> m_Storage = {};
+		float* m_pX = nullptr;
+		float* m_pY = nullptr;
+		unsigned int m_Size = 0;
+		unsigned int m_Capacity = 0;
+
+		static unsigned int GetPaddedSize(unsigned int size) { return (size + Width - 1) / Width * Width; }
+		static float* Align(float* pData)
+		{
+			const size_t alignment = Width * sizeof(float);
+			const size_t address = reinterpret_cast<size_t>(pData);
+			return reinterpret_cast<float*>((address + alignment - 1) / alignment * alignment);
+		}
+		static unsigned int CountBits(unsigned int bits)
+		{
+			unsigned int count = 0;
+			for (; bits != 0; bits &= bits - 1)
+				++count;
+			return count;
+		}
+
+#if defined(ELITE_VECTOR2_BATCH_AVX2)
+		__m256 DistanceSquared8(unsigned int index, __m256 pointX, __m256 pointY) const
+		{
+			const __m256 dx = _mm256_sub_ps(pointX, _mm256_load_ps(m_pX + index));
+			const __m256 dy = _mm256_sub_ps(pointY, _mm256_load_ps(m_pY + index));
+			return _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		}
+#endif
+#if defined(ELITE_VECTOR2_BATCH_SSE2) || defined(ELITE_VECTOR2_BATCH_AVX2)
+		__m128 DistanceSquared4(unsigned int index, __m128 pointX, __m128 pointY) const
+		{
+			const __m128 dx = _mm_sub_ps(pointX, _mm_load_ps(m_pX + index));
+			const __m128 dy = _mm_sub_ps(pointY, _mm_load_ps(m_pY + index));
+			return _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		}
+#endif
+	};
+}
+
+#endif
@@ -0,0 +1,226 @@
+#include "stdafx.h"
+#include "EnemyThreats.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define THREATS_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define THREATS_SSE2
+#endif
+
+namespace
+{
+	//Keeps the direction of an enemy on top of the player defined
+	const float MinDistanceSquared{ 0.0001f };
+	//Slower than this the enemy is not getting closer
+	const float MinClosingSpeed{ 0.01f };
+	const float MaxTimeToContact{ 60.f };
+
+	//score = type weight + health * HealthWeight + ProximityWeight / (gap + 1) + ContactWeight / (time to contact + 1)
+	const float HealthWeight{ 0.1f };
+	const float ProximityWeight{ 20.f };
+	const float ContactWeight{ 10.f };
+}
+
+EnemyThreats::EnemyThreats(UINT capacity)
+{
+	const UINT paddedCapacity{ (capacity + m_Width - 1) / m_Width * m_Width };
+	for (std::vector<float>* pArray : { &m_X, &m_Y, &m_VelocityX, &m_VelocityY, &m_Radius, &m_Health, &m_TypeWeight,
+		&m_ClosingSpeeds, &m_TimesToContact, &m_Scores }) {
+		pArray->reserve(paddedCapacity);
+	}
+}
+
+bool EnemyThreats::Evaluate(const std::vector<EnemyInfo>& enemies, const Elite::Vector2& playerPosition, const Elite::Vector2& playerVelocity, UINT& biggestThreat)
+{
+	if (enemies.empty()) {
+		m_Size = 0;
+		return false;
+	}
+
+	Assign(enemies);
+	ScoreVector(playerPosition, playerVelocity);
+	biggestThreat = GetBiggestThreat();
+	return true;
+}
+
+bool EnemyThreats::EvaluateScalar(const std::vector<EnemyInfo>& enemies, const Elite::Vector2& playerPosition, const Elite::Vector2& playerVelocity, UINT& biggestThreat)
+{
+	if (enemies.empty()) {
+		m_Size = 0;
+		return false;
+	}
+
+	Assign(enemies);
+	ScoreScalar(playerPosition, playerVelocity);
+	biggestThreat = GetBiggestThreat();
+	return true;
+}
+
+const char* EnemyThreats::GetInstructionSet()
+{
+#if defined(THREATS_AVX2)
+	return "AVX2";
+#elif defined(THREATS_SSE2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
+
+void EnemyThreats::Assign(const std::vector<EnemyInfo>& enemies)
+{
+	m_Size = UINT(enemies.size());
+	const UINT paddedSize{ (m_Size + m_Width - 1) / m_Width * m_Width };
+
+	//Only grows, so the arrays are not reallocated every frame
+	for (std::vector<float>* pArray : { &m_X, &m_Y, &m_VelocityX, &m_VelocityY, &m_Radius, &m_Health, &m_TypeWeight,
+		&m_ClosingSpeeds, &m_TimesToContact, &m_Scores }) {
+		pArray->resize(paddedSize);
+	}
+
+	for (UINT index{}; index < m_Size; ++index) {
+		const EnemyInfo& enemy = enemies[index];
+		m_X[index] = enemy.Location.x;
+		m_Y[index] = enemy.Location.y;
+		m_VelocityX[index] = enemy.LinearVelocity.x;
+		m_VelocityY[index] = enemy.LinearVelocity.y;
+		m_Radius[index] = enemy.Size / 2.f;
+		m_Health[index] = enemy.Health;
+		m_TypeWeight[index] = GetTypeWeight(enemy.Type);
+	}
+	//The padding is scored too, but never picked
+	for (UINT index{ m_Size }; index < paddedSize; ++index) {
+		m_X[index] = m_Y[index] = m_VelocityX[index] = m_VelocityY[index] = 0.f;
+		m_Radius[index] = m_Health[index] = m_TypeWeight[index] = 0.f;
+	}
+}
+
+void EnemyThreats::ScoreScalar(const Elite::Vector2& playerPosition, const Elite::Vector2& playerVelocity)
+{
+	for (UINT index{}; index < m_Size; ++index) {
+		//Relative to the player
+		const float dx{ m_X[index] - playerPosition.x };
+		const float dy{ m_Y[index] - playerPosition.y };
+		const float vx{ m_VelocityX[index] - playerVelocity.x };
+		const float vy{ m_VelocityY[index] - playerVelocity.y };
+
+		const float distance{ sqrtf((std::max)(dx * dx + dy * dy, MinDistanceSquared)) };
+		const float gap{ (std::max)(distance - m_Radius[index], 0.f) };
+		const float closingSpeed{ (0.f - (dx * vx + dy * vy)) / distance };
+
+		//Enemies that are not getting closer never make contact
+		const float contactTime{ (std::min)(gap / (std::max)(closingSpeed, MinClosingSpeed), MaxTimeToContact) };
+		const float timeToContact{ closingSpeed > MinClosingSpeed ? contactTime : MaxTimeToContact };
+
+		m_ClosingSpeeds[index] = closingSpeed;
+		m_TimesToContact[index] = timeToContact;
+		m_Scores[index] = m_TypeWeight[index] + m_Health[index] * HealthWeight + ProximityWeight / (gap + 1.f) + ContactWeight / (timeToContact + 1.f);
+	}
+}
+
+#if defined(THREATS_AVX2)
+void EnemyThreats::ScoreVector(const Elite::Vector2& playerPosition, const Elite::Vector2& playerVelocity)
+{
+	const __m256 playerX{ _mm256_set1_ps(playerPosition.x) };
+	const __m256 playerY{ _mm256_set1_ps(playerPosition.y) };
+	const __m256 playerVelocityX{ _mm256_set1_ps(playerVelocity.x) };
+	const __m256 playerVelocityY{ _mm256_set1_ps(playerVelocity.y) };
+	const __m256 zero{ _mm256_setzero_ps() };
+	const __m256 one{ _mm256_set1_ps(1.f) };
+	const __m256 minDistanceSquared{ _mm256_set1_ps(MinDistanceSquared) };
+	const __m256 minClosingSpeed{ _mm256_set1_ps(MinClosingSpeed) };
+	const __m256 maxTimeToContact{ _mm256_set1_ps(MaxTimeToContact) };
+	const __m256 healthWeight{ _mm256_set1_ps(HealthWeight) };
+	const __m256 proximityWeight{ _mm256_set1_ps(ProximityWeight) };
+	const __m256 contactWeight{ _mm256_set1_ps(ContactWeight) };
+
+	for (UINT index{}; index < m_Size; index += 8) {
+		const __m256 dx{ _mm256_sub_ps(_mm256_loadu_ps(&m_X[index]), playerX) };
+		const __m256 dy{ _mm256_sub_ps(_mm256_loadu_ps(&m_Y[index]), playerY) };
+		const __m256 vx{ _mm256_sub_ps(_mm256_loadu_ps(&m_VelocityX[index]), playerVelocityX) };
+		const __m256 vy{ _mm256_sub_ps(_mm256_loadu_ps(&m_VelocityY[index]), playerVelocityY) };
+
+		const __m256 distance{ _mm256_sqrt_ps(_mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), minDistanceSquared)) };
+		const __m256 gap{ _mm256_max_ps(_mm256_sub_ps(distance, _mm256_loadu_ps(&m_Radius[index])), zero) };
+		const __m256 closingSpeed{ _mm256_div_ps(_mm256_sub_ps(zero, _mm256_add_ps(_mm256_mul_ps(dx, vx), _mm256_mul_ps(dy, vy))), distance) };
+
+		const __m256 contactTime{ _mm256_min_ps(_mm256_div_ps(gap, _mm256_max_ps(closingSpeed, minClosingSpeed)), maxTimeToContact) };
+		const __m256 isClosing{ _mm256_cmp_ps(closingSpeed, minClosingSpeed, _CMP_GT_OQ) };
+		const __m256 timeToContact{ _mm256_blendv_ps(maxTimeToContact, contactTime, isClosing) };
+
+		__m256 score{ _mm256_add_ps(_mm256_loadu_ps(&m_TypeWeight[index]), _mm256_mul_ps(_mm256_loadu_ps(&m_Health[index]), healthWeight)) };
+		score = _mm256_add_ps(score, _mm256_div_ps(proximityWeight, _mm256_add_ps(gap, one)));
+		score = _mm256_add_ps(score, _mm256_div_ps(contactWeight, _mm256_add_ps(timeToContact, one)));
+
+		_mm256_storeu_ps(&m_ClosingSpeeds[index], closingSpeed);
+		_mm256_storeu_ps(&m_TimesToContact[index], timeToContact);
+		_mm256_storeu_ps(&m_Scores[index], score);
+	}
+}
+#elif defined(THREATS_SSE2)
+void EnemyThreats::ScoreVector(const Elite::Vector2& playerPosition, const Elite::Vector2& playerVelocity)
+{
+	const __m128 playerX{ _mm_set1_ps(playerPosition.x) };
+	const __m128 playerY{ _mm_set1_ps(playerPosition.y) };
+	const __m128 playerVelocityX{ _mm_set1_ps(playerVelocity.x) };
+	const __m128 playerVelocityY{ _mm_set1_ps(playerVelocity.y) };
+	const __m128 zero{ _mm_setzero_ps() };
+	const __m128 one{ _mm_set1_ps(1.f) };
+	const __m128 minDistanceSquared{ _mm_set1_ps(MinDistanceSquared) };
+	const __m128 minClosingSpeed{ _mm_set1_ps(MinClosingSpeed) };
+	const __m128 maxTimeToContact{ _mm_set1_ps(MaxTimeToContact) };
+	const __m128 healthWeight{ _mm_set1_ps(HealthWeight) };
+	const __m128 proximityWeight{ _mm_set1_ps(ProximityWeight) };
+	const __m128 contactWeight{ _mm_set1_ps(ContactWeight) };
+
+	for (UINT index{}; index < m_Size; index += 4) {
+		const __m128 dx{ _mm_sub_ps(_mm_loadu_ps(&m_X[index]), playerX) };
+		const __m128 dy{ _mm_sub_ps(_mm_loadu_ps(&m_Y[index]), playerY) };
+		const __m128 vx{ _mm_sub_ps(_mm_loadu_ps(&m_VelocityX[index]), playerVelocityX) };
+		const __m128 vy{ _mm_sub_ps(_mm_loadu_ps(&m_VelocityY[index]), playerVelocityY) };
+
+		const __m128 distance{ _mm_sqrt_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), minDistanceSquared)) };
+		const __m128 gap{ _mm_max_ps(_mm_sub_ps(distance, _mm_loadu_ps(&m_Radius[index])), zero) };
+		const __m128 closingSpeed{ _mm_div_ps(_mm_sub_ps(zero, _mm_add_ps(_mm_mul_ps(dx, vx), _mm_mul_ps(dy, vy))), distance) };
+
+		//No blend in SSE2, select with the comparison mask
+		const __m128 contactTime{ _mm_min_ps(_mm_div_ps(gap, _mm_max_ps(closingSpeed, minClosingSpeed)), maxTimeToContact) };
+		const __m128 isClosing{ _mm_cmpgt_ps(closingSpeed, minClosingSpeed) };
+		const __m128 timeToContact{ _mm_or_ps(_mm_and_ps(isClosing, contactTime), _mm_andnot_ps(isClosing, maxTimeToContact)) };
+
+		__m128 score{ _mm_add_ps(_mm_loadu_ps(&m_TypeWeight[index]), _mm_mul_ps(_mm_loadu_ps(&m_Health[index]), healthWeight)) };
+		score = _mm_add_ps(score, _mm_div_ps(proximityWeight, _mm_add_ps(gap, one)));
+		score = _mm_add_ps(score, _mm_div_ps(contactWeight, _mm_add_ps(timeToContact, one)));
+
+		_mm_storeu_ps(&m_ClosingSpeeds[index], closingSpeed);
+		_mm_storeu_ps(&m_TimesToContact[index], timeToContact);
+		_mm_storeu_ps(&m_Scores[index], score);
+	}
+}
+#else
+void EnemyThreats::ScoreVector(const Elite::Vector2& playerPosition, const Elite::Vector2& playerVelocity)
+{
+	ScoreScalar(playerPosition, playerVelocity);
+}
+#endif
+
+UINT EnemyThreats::GetBiggestThreat() const
+{
+	UINT biggestThreat{};
+	for (UINT index{ 1 }; index < m_Size; ++index) {
+		if (m_Scores[index] > m_Scores[biggestThreat]) {
+			biggestThreat = index;
+		}
+	}
+	return biggestThreat;
+}
+
+float EnemyThreats::GetTypeWeight(eEnemyType type)
+{
+	//A table instead of a switch, the types of the enemies in view are in no particular order
+	static const float typeWeights[]{ 1.f, 1.f, 1.5f, 2.f, 1.f }; //DEFAULT, ZOMBIE_NORMAL, ZOMBIE_RUNNER, ZOMBIE_HEAVY, RANDOM_ENEMY
+	const UINT typeIndex{ UINT(type) };
+	return typeIndex < sizeof(typeWeights) / sizeof(typeWeights[0]) ? typeWeights[typeIndex] : 1.f;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Exam_HelperStructs.h"
+
+//Threat of every enemy in the FOV, scored all at once on a structure of arrays copy of the enemies
+//Uses AVX2 or SSE2 when the compiler targets them, the scalar loop does the same operations in the same order
+class EnemyThreats final {
+public:
+	//Room for this many enemies is made up front, more enemies in the FOV grow the arrays
+	explicit EnemyThreats(UINT capacity = 32);
+	~EnemyThreats() = default;
+
+	//Delete copy and move constructors and operators
+	EnemyThreats(const EnemyThreats& enemyThreats) = delete;
+	EnemyThreats(EnemyThreats&& enemyThreats) = delete;
+	EnemyThreats& operator=(const EnemyThreats& enemyThreats) = delete;
+	EnemyThreats& operator=(EnemyThreats&& enemyThreats) = delete;
+
+	//Copies and scores the enemies, returns false if there are none
+	//The biggest threat is the index of the highest score, the first one if they are equal
+	bool Evaluate(const std::vector<EnemyInfo>& enemies, const Elite::Vector2& playerPosition, const Elite::Vector2& playerVelocity, UINT& biggestThreat);
+	//Same as Evaluate, but always with the scalar loop
+	bool EvaluateScalar(const std::vector<EnemyInfo>& enemies, const Elite::Vector2& playerPosition, const Elite::Vector2& playerVelocity, UINT& biggestThreat);
+
+	UINT Size() const { return m_Size; }
+	//Speed at which the enemy gets closer, negative when it moves away
+	float GetClosingSpeed(UINT index) const { return m_ClosingSpeeds[index]; }
+	//Seconds until the enemy touches the player, capped for enemies that do not get closer
+	float GetTimeToContact(UINT index) const { return m_TimesToContact[index]; }
+	float GetScore(UINT index) const { return m_Scores[index]; }
+
+	static const char* GetInstructionSet();
+
+private:
+	//Every array is padded to a multiple of the widest vector
+	static const UINT m_Width{ 8 };
+
+	UINT m_Size{};
+	std::vector<float> m_X{};
+	std::vector<float> m_Y{};
+	std::vector<float> m_VelocityX{};
+	std::vector<float> m_VelocityY{};
+	std::vector<float> m_Radius{};
+	std::vector<float> m_Health{};
+	std::vector<float> m_TypeWeight{}; //The type, as the weight it adds to the score
+
+	std::vector<float> m_ClosingSpeeds{};
+	std::vector<float> m_TimesToContact{};
+	std::vector<float> m_Scores{};
+
+	void Assign(const std::vector<EnemyInfo>& enemies);
+	void ScoreScalar(const Elite::Vector2& playerPosition, const Elite::Vector2& playerVelocity);
+	void ScoreVector(const Elite::Vector2& playerPosition, const Elite::Vector2& playerVelocity);
+	UINT GetBiggestThreat() const;
+	static float GetTypeWeight(eEnemyType type);
+};
@@ -1,11 +1,15 @@
 #include "stdafx.h"
 #include "Inventory.h"
-#include <map>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+const UINT Inventory::m_MaxSize;
 
 Inventory::Inventory(IExamInterface* pInterface, int maxGunAmount, int maxMedkitAmount, int maxFoodAmount, 
 	int minGunAmmoAmount, int minMedkitChargeAmount, int minFoodEnergyAmount)
 	:m_pInterface{ pInterface },
-	m_Size{ pInterface->Inventory_GetCapacity() },
+	m_Size{ (std::min)(pInterface->Inventory_GetCapacity(), m_MaxSize) },
 	m_MaxGunAmount{maxGunAmount},
 	m_MaxMedkitAmount{maxMedkitAmount},
 	m_MaxFoodAmount{maxFoodAmount},
@@ -13,32 +17,119 @@ Inventory::Inventory(IExamInterface* pInterface, int maxGunAmount, int maxMedkit
 	m_MinMedkitChargeAmount{minMedkitChargeAmount},
 	m_MinFoodEnergyAmount{minFoodEnergyAmount}
 {
+	if (pInterface->Inventory_GetCapacity() > m_MaxSize) {
+		printf("WARNING: inventory capacity %u is more than %u, only the first %u slots are used\n", pInterface->Inventory_GetCapacity(), m_MaxSize, m_MaxSize);
+	}
+
 	m_Items.resize(m_Size);
 	//fill it up with Random drops, this is only internally used and will be seen as Empty
+	for (UINT index{ 0 }; index < m_Size; ++index) {
+		ClearSlot(index);
+	}
+}
+
+void Inventory::SetSlot(UINT index, const ItemInfo& item)
+{
+	//Move the slot from the mask of the old type to the new one
+	const UINT slotBit{ 1U << index };
+	const int oldType{ int(m_Items[index].Type) };
+	if (m_SlotMasks[oldType] & slotBit) {
+		m_SlotMasks[oldType] &= ~slotBit;
+		--m_TypeAmounts[oldType];
+	}
+
+	m_Items[index] = item;
+	m_SlotMasks[int(item.Type)] |= slotBit;
+	++m_TypeAmounts[int(item.Type)];
+	m_SlotValues[index] = 0;
+	m_SlotUses[index] = 0;
+	++m_SlotVersion;
+}
+
+void Inventory::ClearSlot(UINT index)
+{
 	ItemInfo emptyItem{};
 	emptyItem.Type = eItemType::RANDOM_DROP;
-	std::fill(m_Items.begin(), m_Items.end(), emptyItem);
+	SetSlot(index, emptyItem);
 }
 
-UINT Inventory::GetFreeSlot() const
+UINT Inventory::GetSlotMask(eItemType itemType) const
 {
-	for (UINT inventoryIndex{ 0 }; inventoryIndex < m_Size; ++inventoryIndex) {
-		//Random drop is seen as empty
-		if (m_Items.at(inventoryIndex).Type == eItemType::RANDOM_DROP) {
-			return inventoryIndex;
-		}
+	const int typeIndex{ int(itemType) };
+	if (typeIndex < 0 || typeIndex >= m_TypeCount) {
+		return 0;
 	}
-	return invalid_index;
+	return m_SlotMasks[typeIndex];
 }
 
-int Inventory::GetAmountOfType(eItemType itemType) const
+UINT Inventory::GetLowestSlot(UINT slotMask)
 {
-	//Use count if to count the amount of items of a certain type
-	const int itemAmount = std::count_if(m_Items.begin(), m_Items.end(), [itemType](ItemInfo item) {
-		return (item.Type == itemType);
-		});
+	if (slotMask == 0) {
+		return invalid_index;
+	}
+#if defined(_MSC_VER)
+	unsigned long index{};
+	_BitScanForward(&index, slotMask);
+	return UINT(index);
+#else
+	return UINT(__builtin_ctz(slotMask));
+#endif
+}
 
-	return itemAmount;
+int Inventory::GetHostValue(ItemInfo& item)
+{
+	switch (item.Type)
+	{
+	case eItemType::PISTOL:
+	case eItemType::SHOTGUN:
+		++m_HostValueCalls;
+		return m_pInterface->Weapon_GetAmmo(item);
+	case eItemType::MEDKIT:
+		++m_HostValueCalls;
+		return m_pInterface->Medkit_GetHealth(item);
+	case eItemType::FOOD:
+		++m_HostValueCalls;
+		return m_pInterface->Food_GetEnergy(item);
+	default:
+		return 0;
+	}
+}
+
+void Inventory::ReconcileSlot(UINT index)
+{
+	//The item info of a slot does not change, so only the value has to be asked
+	m_SlotValues[index] = GetHostValue(m_Items[index]);
+	m_SlotUses[index] = 0;
+}
+
+int Inventory::GetItemValue(UINT index) const
+{
+	if (index >= m_Size) {
+		return 0;
+	}
+	//Instead of Inventory_GetItem and the value of that item
+	m_AvoidedHostCalls += 2;
+	return m_SlotValues[index];
+}
+
+void Inventory::PrintHostCallStats() const
+{
+	printf("Inventory: %llu item value calls to the host, %llu host calls avoided \n", m_HostValueCalls, m_AvoidedHostCalls);
+}
+
+UINT Inventory::GetFreeSlot() const
+{
+	//Random drop is seen as empty
+	return GetLowestSlot(GetSlotMask(eItemType::RANDOM_DROP));
+}
+
+int Inventory::GetAmountOfType(eItemType itemType) const
+{
+	const int typeIndex{ int(itemType) };
+	if (typeIndex < 0 || typeIndex >= m_TypeCount) {
+		return 0;
+	}
+	return m_TypeAmounts[typeIndex];
 }
 
 bool Inventory::HasTooManyOfType(eItemType itemType) const
@@ -68,74 +159,52 @@ bool Inventory::HasTooManyOfType(eItemType itemType) const
 	return false;
 }
 
-UINT Inventory::GetAlmostEmptyItemOfType(eItemType itemType)
+bool Inventory::IsAlmostEmpty(UINT index) const
 {
-	//If there are no items of this type, return invalid index
-	if (!ContainsItemOfType(itemType)) {
-		return invalid_index;
+	switch (m_Items[index].Type)
+	{
+	case eItemType::PISTOL:
+	case eItemType::SHOTGUN:
+		return m_SlotValues[index] < m_MinGunAmmoAmount;
+	case eItemType::MEDKIT:
+		return m_SlotValues[index] < m_MinMedkitChargeAmount;
+	case eItemType::FOOD:
+		return m_SlotValues[index] < m_MinFoodEnergyAmount;
+	default:
+		return false;
 	}
-	
-	//Make a map of items to check since there can be multiple of a type
-	std::map<UINT, ItemInfo> itemsToCheck{};
-	for (UINT index{ 0 }; index < m_Size; ++index) {
-		ItemInfo item = m_Items.at(index);
-		if (item.Type == itemType) {
-			itemsToCheck.insert(std::pair<UINT, ItemInfo>(index, item));
+}
+
+bool Inventory::RemoveAlmostEmptyItemOfType(eItemType itemType)
+{
+	//Check all the items of this type, from the first slot on, and drop the first one that is almost empty
+	for (UINT slotMask{ GetSlotMask(itemType) }; slotMask != 0; slotMask &= slotMask - 1) {
+		const UINT index{ GetLowestSlot(slotMask) };
+		++m_AvoidedHostCalls;
+		if (!IsAlmostEmpty(index)) {
+			continue;
 		}
-	}
 
-	//Check all the items and if any of them are almost empty, return the inventory index
-	for (auto indexItemPair : itemsToCheck) {
-		switch (itemType)
-		{
-		case eItemType::PISTOL:
-		case eItemType::SHOTGUN:
-			if (m_pInterface->Weapon_GetAmmo(indexItemPair.second) < m_MinGunAmmoAmount) {
-				return indexItemPair.first;
-			}
-			break;
-		case eItemType::MEDKIT:
-			if (m_pInterface->Medkit_GetHealth(indexItemPair.second) < m_MinMedkitChargeAmount) {
-				return indexItemPair.first;
-			}
-			break;
-		case eItemType::FOOD:
-			if (m_pInterface->Food_GetEnergy(indexItemPair.second) < m_MinFoodEnergyAmount) {
-				return indexItemPair.first;
-			}
-			break;
+		//A drop can not be undone, so the host is asked before trusting the cache
+		ReconcileSlot(index);
+		if (IsAlmostEmpty(index)) {
+			m_pInterface->Inventory_RemoveItem(index);
+			ClearSlot(index);
+			return true;
 		}
 	}
-	return invalid_index;
+	return false;
 }
 
-UINT Inventory::GetIndexOfItemOfType(eItemType itemType)
+UINT Inventory::GetIndexOfItemOfType(eItemType itemType) const
 {
-	if (!(ContainsItemOfType(itemType))) {
-		return invalid_index;
-	}
-	//Iterator for item
-	auto itemIterator = std::find_if(m_Items.begin(), m_Items.end(), [itemType](ItemInfo item) {
-		return item.Type == itemType;
-		});
-
-	return std::distance(m_Items.begin(), itemIterator);
+	//First slot with an item of this type
+	return GetLowestSlot(GetSlotMask(itemType));
 }
 
 bool Inventory::ContainsItemOfType(eItemType itemType) const
 {
-	//Iterator for item
-	auto itemIterator = std::find_if(m_Items.begin(), m_Items.end(), [itemType](ItemInfo item) {
-		return item.Type == itemType;
-		});
-
-	//If the iterator is end, no item of this type was found in the inventory
-	if (itemIterator == m_Items.end()) {
-		return false;
-	}
-
-	return true;
-	//Alternative implementation with GetAmountOfType == 0
+	return GetSlotMask(itemType) != 0;
 }
 
 bool Inventory::IsFull() const
@@ -159,39 +228,16 @@ bool Inventory::ShouldPickupItem(EntityInfo item) {
 
 		//Check if you dont already have too many items of this type
 		if (HasTooManyOfType(itemInfo.Type)) {
-			//Check if any of them are almost empty
-			UINT almostEmptyItemIndex = GetAlmostEmptyItemOfType(itemInfo.Type);
-			if (almostEmptyItemIndex != invalid_index) {
-				//Get rid of the item at that current index
-				ItemInfo emptyItem{};
-				emptyItem.Type = eItemType::RANDOM_DROP;
-				m_pInterface->Inventory_RemoveItem(almostEmptyItemIndex);
-				m_Items[almostEmptyItemIndex] = emptyItem;
-				return true;
-			}
-			else {
-				return false;
-			}
+			//Get rid of one of them if it is almost empty
+			return RemoveAlmostEmptyItemOfType(itemInfo.Type);
 		}
 
 		return true;
 	}
 	//decide if this item is worth being picked up, over an item already in there
 	else {
-		UINT almostEmptyItemIndex = GetAlmostEmptyItemOfType(itemInfo.Type);
-		if (almostEmptyItemIndex != invalid_index) {
-			//Get rid of the item at that current index
-			ItemInfo emptyItem{};
-			emptyItem.Type = eItemType::RANDOM_DROP;
-			m_pInterface->Inventory_RemoveItem(almostEmptyItemIndex);
-			m_Items[almostEmptyItemIndex] = emptyItem;
-			//Pick up the new item and add it to both inventories
-			//See if you can grab the item
-			return true;
-		}
-		else {
-			return false;
-		}
+		//Get rid of an almost empty item of this type, then the new item can be picked up
+		return RemoveAlmostEmptyItemOfType(itemInfo.Type);
 	}
 
 	return false;
@@ -221,72 +267,63 @@ bool Inventory::PickupItem(EntityInfo item)
 	//Get the first free slot and add the item to both inventories
 	UINT slotIndex = GetFreeSlot();
 	bool hasAddedItem = m_pInterface->Inventory_AddItem(slotIndex, itemInfo);
-	m_Items[slotIndex] = itemInfo;
+	SetSlot(slotIndex, itemInfo);
+	if (hasAddedItem) {
+		m_SlotValues[slotIndex] = GetHostValue(itemInfo);
+	}
 
 	return hasAddedItem;
 }
 
 bool Inventory::UseItemOfType(eItemType itemType)
 {
-	if (!ContainsItemOfType(itemType)) {
+	UINT index = GetIndexOfItemOfType(itemType);
+	if (index == invalid_index) {
 		return false;
 	}
 
-	auto itemIterator = std::find_if(m_Items.begin(), m_Items.end(), [itemType](ItemInfo item) {
-		return item.Type == itemType;
-		});
-
-	UINT index = std::distance(m_Items.begin(), itemIterator);
-	ItemInfo itemInfo{};
-
 	bool itemUsed = m_pInterface->Inventory_UseItem(index);
 
 	if (!itemUsed) {
+		//The cache said it could be used, so ask the host what is left
+		ReconcileSlot(index);
+		if (m_SlotValues[index] <= 0) {
+			m_pInterface->Inventory_RemoveItem(index);
+			ClearSlot(index);
+		}
 		return false;
 	}
 
-	//Check if you fully used the item and drop it if it is empty
-	m_pInterface->Inventory_GetItem(index, itemInfo);
-
-	switch (itemInfo.Type)
+	//A weapon uses one bullet, medkits and food are used up at once
+	switch (itemType)
 	{
 	case eItemType::PISTOL:
-		//If you used your last ammo from weapon, drop it
-		if (m_pInterface->Weapon_GetAmmo(itemInfo) <= 0) {
-			m_pInterface->Inventory_RemoveItem(index);
-			ItemInfo emptyItem{};
-			emptyItem.Type = eItemType::RANDOM_DROP;
-			m_Items.at(index) = emptyItem;
-		}
-		break;
 	case eItemType::SHOTGUN:
-		//If you used your last ammo from weapon, drop it
-		if (m_pInterface->Weapon_GetAmmo(itemInfo) <= 0) {
-			m_pInterface->Inventory_RemoveItem(index);
-			ItemInfo emptyItem{};
-			emptyItem.Type = eItemType::RANDOM_DROP;
-			m_Items.at(index) = emptyItem;
-		}
+		--m_SlotValues[index];
 		break;
 	case eItemType::MEDKIT:
-		//If you used your medkit fully, drop it
-		if (m_pInterface->Medkit_GetHealth(itemInfo) <= 0) {
-			m_pInterface->Inventory_RemoveItem(index);
-			ItemInfo emptyItem{};
-			emptyItem.Type = eItemType::RANDOM_DROP;
-			m_Items.at(index) = emptyItem;
-		}
-		break;
 	case eItemType::FOOD:
-		//If you used all the energy from the food, delete it from your inventories
-		if (m_pInterface->Food_GetEnergy(itemInfo) <= 0) {
-			m_pInterface->Inventory_RemoveItem(index);
-			ItemInfo emptyItem{};
-			emptyItem.Type = eItemType::RANDOM_DROP;
-			m_Items.at(index) = emptyItem;
-		}
+		m_SlotValues[index] = 0;
+		break;
+	default:
 		break;
 	}
+	++m_SlotUses[index];
+
+	//Check with the host every few uses, and before dropping the item because it looks empty
+	if (m_SlotValues[index] <= 0 || m_SlotUses[index] >= m_ReconcileInterval) {
+		ReconcileSlot(index);
+		m_AvoidedHostCalls += 1;
+	}
+	else {
+		m_AvoidedHostCalls += 2;
+	}
+
+	//If you fully used the item, drop it
+	if (m_SlotValues[index] <= 0) {
+		m_pInterface->Inventory_RemoveItem(index);
+		ClearSlot(index);
+	}
 	return true;
 }
 
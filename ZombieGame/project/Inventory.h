@@ -28,9 +28,23 @@ public:
 
 	void DebugRender();
 
-	UINT GetIndexOfItemOfType(eItemType itemType);
+	UINT GetIndexOfItemOfType(eItemType itemType) const;
+	//Ammo, health or energy left in the item in the slot, from the local cache instead of the host
+	int GetItemValue(UINT index) const;
+
+	//Goes up every time the item in a slot changes, values used up in an item do not count
+	unsigned int GetSlotVersion() const { return m_SlotVersion; }
+
+	unsigned long long GetAvoidedHostCalls() const { return m_AvoidedHostCalls; }
+	void PrintHostCallStats() const;
 
 private:
+	static const int m_TypeCount{ int(eItemType::RANDOM_DROP_WITH_CHANCE) + 1 };
+	//One bit per slot in the slot masks
+	static const UINT m_MaxSize{ 32 };
+	//Uses of an item before its cached value is checked with the host again
+	static const int m_ReconcileInterval{ 8 };
+
 	//Size could be a non constant in case you can pick up extra backpacks with storage space etc
 	const UINT m_Size{};
 	const int m_MaxGunAmount;
@@ -43,9 +57,27 @@ private:
 
 	IExamInterface* m_pInterface{ nullptr };
 	std::vector<ItemInfo> m_Items;
+	//Slots and amount of every item type, kept up to date with m_Items by SetSlot (empty slots are random drops)
+	UINT m_SlotMasks[m_TypeCount]{};
+	int m_TypeAmounts[m_TypeCount]{};
+	//Ammo, health or energy of every slot, filled at pickup and updated locally on every use
+	int m_SlotValues[m_MaxSize]{};
+	int m_SlotUses[m_MaxSize]{};
+	unsigned int m_SlotVersion{};
+	mutable unsigned long long m_AvoidedHostCalls{};
+	unsigned long long m_HostValueCalls{};
+
+	void SetSlot(UINT index, const ItemInfo& item);
+	void ClearSlot(UINT index);
+	UINT GetSlotMask(eItemType itemType) const;
+	static UINT GetLowestSlot(UINT slotMask);
+	int GetHostValue(ItemInfo& item);
+	void ReconcileSlot(UINT index);
 
 	int GetAmountOfType(eItemType itemType) const;
 	bool IsFull() const;
 	bool HasTooManyOfType(eItemType itemType) const;
-	UINT GetAlmostEmptyItemOfType(eItemType itemType);
+	bool IsAlmostEmpty(UINT index) const;
+	//Checks the cached value with the host before the item is dropped
+	bool RemoveAlmostEmptyItemOfType(eItemType itemType);
 };
\ No newline at end of file
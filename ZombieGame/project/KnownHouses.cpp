@@ -0,0 +1,78 @@
+#include "stdafx.h"
+#include "KnownHouses.h"
+
+KnownHouses::KnownHouses(float cellSize)
+	:m_CellSize{ cellSize }
+{
+}
+
+bool KnownHouses::AddHouse(const HouseInfo& house)
+{
+	//If the centers are very close together, it means it is the same house
+	if (FindHouseNear(house.Center, HouseSearch{}.acceptanceRadius) != nullptr) {
+		return false;
+	}
+
+	const UINT index{ UINT(m_Houses.size()) };
+	m_Houses.push_back(HouseSearch(house));
+
+	//Add the house to every cell its bounds overlap
+	const Elite::Vector2 halfSize{ house.Size / 2.f };
+	const int minX{ GetCellCoordinate(house.Center.x - halfSize.x) };
+	const int maxX{ GetCellCoordinate(house.Center.x + halfSize.x) };
+	const int minY{ GetCellCoordinate(house.Center.y - halfSize.y) };
+	const int maxY{ GetCellCoordinate(house.Center.y + halfSize.y) };
+	for (int y{ minY }; y <= maxY; ++y) {
+		for (int x{ minX }; x <= maxX; ++x) {
+			m_Cells[GetGridCellKey(x, y)].push_back(index);
+		}
+	}
+	return true;
+}
+
+HouseSearch* KnownHouses::FindHouseContaining(const Elite::Vector2& point)
+{
+	auto cellIt = m_Cells.find(GetGridCellKey(GetCellCoordinate(point.x), GetCellCoordinate(point.y)));
+	if (cellIt == m_Cells.end()) {
+		return nullptr;
+	}
+
+	//The indices are sorted, so the first match is the first house that was added
+	for (UINT index : cellIt->second) {
+		if (m_Houses[index].IsPointInsideHouse(point)) {
+			return &m_Houses[index];
+		}
+	}
+	return nullptr;
+}
+
+HouseSearch* KnownHouses::FindHouseNear(const Elite::Vector2& center, float radius)
+{
+	//A house is in the cell of its own center, so only the cells within the radius have to be checked
+	const int minX{ GetCellCoordinate(center.x - radius) };
+	const int maxX{ GetCellCoordinate(center.x + radius) };
+	const int minY{ GetCellCoordinate(center.y - radius) };
+	const int maxY{ GetCellCoordinate(center.y + radius) };
+
+	UINT firstIndex{ UINT(m_Houses.size()) };
+	for (int y{ minY }; y <= maxY; ++y) {
+		for (int x{ minX }; x <= maxX; ++x) {
+			auto cellIt = m_Cells.find(GetGridCellKey(x, y));
+			if (cellIt == m_Cells.end()) {
+				continue;
+			}
+			for (UINT index : cellIt->second) {
+				if (index < firstIndex && Elite::DistanceSquared(m_Houses[index].Center, center) < radius * radius) {
+					firstIndex = index;
+					break;
+				}
+			}
+		}
+	}
+	return firstIndex < m_Houses.size() ? &m_Houses[firstIndex] : nullptr;
+}
+
+int KnownHouses::GetCellCoordinate(float position) const
+{
+	return int(floorf(position / m_CellSize));
+}
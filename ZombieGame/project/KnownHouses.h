@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Structs.h"
+#include <deque>
+#include <unordered_map>
+
+//All houses the agent has seen, with a uniform grid over their bounds so lookups by position only check nearby houses
+//The houses are kept in a deque, so pointers to them (e.g. in the blackboard) stay valid when houses are added
+class KnownHouses final {
+public:
+	explicit KnownHouses(float cellSize = 32.f);
+	~KnownHouses() = default;
+
+	//Delete copy and move constructors and operators
+	KnownHouses(const KnownHouses& knownHouses) = delete;
+	KnownHouses(KnownHouses&& knownHouses) = delete;
+	KnownHouses& operator=(const KnownHouses& knownHouses) = delete;
+	KnownHouses& operator=(KnownHouses&& knownHouses) = delete;
+
+	//Adds the house, unless it is already known (a known house has its center within the acceptance radius)
+	bool AddHouse(const HouseInfo& house);
+	//First known house, in the order they were added, that contains the point
+	HouseSearch* FindHouseContaining(const Elite::Vector2& point);
+	//First known house, in the order they were added, with its center within the radius
+	HouseSearch* FindHouseNear(const Elite::Vector2& center, float radius);
+
+	size_t Size() const { return m_Houses.size(); }
+	HouseSearch& operator[](size_t index) { return m_Houses[index]; }
+	std::deque<HouseSearch>::iterator begin() { return m_Houses.begin(); }
+	std::deque<HouseSearch>::iterator end() { return m_Houses.end(); }
+	std::deque<HouseSearch>::const_iterator begin() const { return m_Houses.begin(); }
+	std::deque<HouseSearch>::const_iterator end() const { return m_Houses.end(); }
+
+private:
+	const float m_CellSize;
+	std::deque<HouseSearch> m_Houses{};
+	//Indices of the houses overlapping every cell, in the order they were added
+	std::unordered_map<unsigned long long, std::vector<UINT>> m_Cells{};
+
+	int GetCellCoordinate(float position) const;
+};
@@ -0,0 +1,190 @@
+#include "stdafx.h"
+#include "KnownItems.h"
+
+KnownItems::KnownItems(float cellSize, float mergeDistance)
+	:m_CellSize{ cellSize },
+	m_MergeDistance{ mergeDistance }
+{
+}
+
+bool KnownItems::AddItem(const ItemInfo& item)
+{
+	const int typeIndex{ int(item.Type) };
+	if (typeIndex < 0 || typeIndex >= m_TypeCount) {
+		return false;
+	}
+
+	//Check to see if it is already in there, by location
+	for (ItemGrid& grid : m_Grids) {
+		if (FindItemNear(grid, item.Location) != nullptr) {
+			return false;
+		}
+	}
+
+	ItemGrid& grid{ m_Grids[typeIndex] };
+	const int x{ GetCellCoordinate(item.Location.x) };
+	const int y{ GetCellCoordinate(item.Location.y) };
+	if (grid.Size == 0 && grid.Cells.empty()) {
+		grid.MinX = grid.MaxX = x;
+		grid.MinY = grid.MaxY = y;
+	}
+	grid.MinX = (std::min)(grid.MinX, x);
+	grid.MaxX = (std::max)(grid.MaxX, x);
+	grid.MinY = (std::min)(grid.MinY, y);
+	grid.MaxY = (std::max)(grid.MaxY, y);
+
+	KnownItem knownItem{};
+	knownItem.Info = item;
+	knownItem.Order = m_NextOrder++;
+	grid.Cells[GetGridCellKey(x, y)].push_back(knownItem);
+	++grid.Size;
+	++m_Size;
+	return true;
+}
+
+bool KnownItems::RemoveItemAt(const Elite::Vector2& location)
+{
+	for (ItemGrid& grid : m_Grids) {
+		std::vector<KnownItem>* pCell{};
+		const KnownItem* pItem = FindItemNear(grid, location, &pCell);
+		if (pItem == nullptr) {
+			continue;
+		}
+
+		pCell->erase(pCell->begin() + (pItem - pCell->data()));
+		--grid.Size;
+		--m_Size;
+		return true;
+	}
+	return false;
+}
+
+bool KnownItems::FindClosestItem(const std::vector<eItemType>& types, const Elite::Vector2& position, float maxRange, ItemInfo& item) const
+{
+	float closestDistanceSquared{ FLT_MAX };
+	bool isFound{ false };
+	FrameVector<Candidate> candidates{ FrameAllocator<Candidate>{ m_pFrameArena } };
+	for (eItemType type : types) {
+		const int typeIndex{ int(type) };
+		if (typeIndex < 0 || typeIndex >= m_TypeCount) {
+			continue;
+		}
+
+		FindClosestCandidates(m_Grids[typeIndex], position, maxRange, 1, candidates);
+		if (!candidates.empty() && candidates[0].DistanceSquared < closestDistanceSquared) {
+			closestDistanceSquared = candidates[0].DistanceSquared;
+			item = candidates[0].pItem->Info;
+			isFound = true;
+		}
+	}
+	return isFound;
+}
+
+void KnownItems::FindClosestItems(eItemType type, const Elite::Vector2& position, float maxRange, UINT count, std::vector<ItemInfo>& items) const
+{
+	items.clear();
+	const int typeIndex{ int(type) };
+	if (typeIndex < 0 || typeIndex >= m_TypeCount) {
+		return;
+	}
+
+	FrameVector<Candidate> candidates{ FrameAllocator<Candidate>{ m_pFrameArena } };
+	FindClosestCandidates(m_Grids[typeIndex], position, maxRange, count, candidates);
+	for (const Candidate& candidate : candidates) {
+		items.push_back(candidate.pItem->Info);
+	}
+}
+
+const KnownItems::KnownItem* KnownItems::FindItemNear(ItemGrid& grid, const Elite::Vector2& location, std::vector<KnownItem>** ppCell) const
+{
+	if (grid.Size == 0) {
+		return nullptr;
+	}
+
+	//Only the cells within the merge distance can have the same item
+	const int minX{ GetCellCoordinate(location.x - m_MergeDistance) };
+	const int maxX{ GetCellCoordinate(location.x + m_MergeDistance) };
+	const int minY{ GetCellCoordinate(location.y - m_MergeDistance) };
+	const int maxY{ GetCellCoordinate(location.y + m_MergeDistance) };
+	for (int y{ minY }; y <= maxY; ++y) {
+		for (int x{ minX }; x <= maxX; ++x) {
+			auto cellIt = grid.Cells.find(GetGridCellKey(x, y));
+			if (cellIt == grid.Cells.end()) {
+				continue;
+			}
+
+			for (const KnownItem& knownItem : cellIt->second) {
+				if (knownItem.Info.Location.Distance(location) < m_MergeDistance) {
+					if (ppCell != nullptr) {
+						*ppCell = &cellIt->second;
+					}
+					return &knownItem;
+				}
+			}
+		}
+	}
+	return nullptr;
+}
+
+void KnownItems::FindClosestCandidates(const ItemGrid& grid, const Elite::Vector2& position, float maxRange, UINT count, FrameVector<Candidate>& candidates) const
+{
+	candidates.clear();
+	if (grid.Size == 0 || count == 0) {
+		return;
+	}
+	//One more than asked for while inserting, so it never grows in the arena
+	candidates.reserve(count + 1);
+
+	//Search the cells in rings around the position, the cells in ring r + 1 are at least r cells away
+	const int centerX{ GetCellCoordinate(position.x) };
+	const int centerY{ GetCellCoordinate(position.y) };
+	const float maxRangeSquared{ maxRange * maxRange };
+	const int boundsRing{ (std::max)((std::max)(abs(centerX - grid.MinX), abs(centerX - grid.MaxX)), (std::max)(abs(centerY - grid.MinY), abs(centerY - grid.MaxY))) };
+	const float rangeRing{ ceilf(maxRange / m_CellSize) };
+	const int maxRing{ rangeRing < float(boundsRing) ? int(rangeRing) : boundsRing };
+
+	for (int ring{}; ring <= maxRing; ++ring) {
+		for (int y{ (std::max)(centerY - ring, grid.MinY) }; y <= (std::min)(centerY + ring, grid.MaxY); ++y) {
+			//Only the first and last row of the ring are full, the others only have their two ends
+			const bool isFullRow{ y == centerY - ring || y == centerY + ring };
+			const int step{ isFullRow || ring == 0 ? 1 : 2 * ring };
+			for (int x{ centerX - ring }; x <= centerX + ring; x += step) {
+				if (x < grid.MinX || x > grid.MaxX) {
+					continue;
+				}
+				auto cellIt = grid.Cells.find(GetGridCellKey(x, y));
+				if (cellIt == grid.Cells.end()) {
+					continue;
+				}
+
+				for (const KnownItem& knownItem : cellIt->second) {
+					Candidate candidate{ Elite::DistanceSquared(position, knownItem.Info.Location), &knownItem };
+					if (candidate.DistanceSquared > maxRangeSquared) {
+						continue;
+					}
+					//Keep the closest ones sorted, by distance and then by the order they were added
+					auto insertIt = std::find_if(candidates.begin(), candidates.end(), [&candidate](const Candidate& other) {
+						return candidate.DistanceSquared < other.DistanceSquared ||
+							(candidate.DistanceSquared == other.DistanceSquared && candidate.pItem->Order < other.pItem->Order);
+					});
+					if (candidates.size() < count || insertIt != candidates.end()) {
+						candidates.insert(insertIt, candidate);
+						if (candidates.size() > count) {
+							candidates.pop_back();
+						}
+					}
+				}
+			}
+		}
+
+		const float ringDistance{ ring * m_CellSize };
+		if (candidates.size() == count && candidates.back().DistanceSquared < ringDistance * ringDistance) {
+			return;
+		}
+	}
+}
+
+int KnownItems::GetCellCoordinate(float position) const
+{
+	return int(floorf(position / m_CellSize));
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Structs.h"
+#include "EFrameArena.h"
+#include <unordered_map>
+
+//Items the agent has seen but did not pick up, with a uniform grid per item type
+//Items closer together than the merge distance are the same item, like the linear checks in the behaviors did
+class KnownItems final {
+public:
+	explicit KnownItems(float cellSize = 32.f, float mergeDistance = 0.1f);
+	~KnownItems() = default;
+
+	//Delete copy and move constructors and operators
+	KnownItems(const KnownItems& knownItems) = delete;
+	KnownItems(KnownItems&& knownItems) = delete;
+	KnownItems& operator=(const KnownItems& knownItems) = delete;
+	KnownItems& operator=(KnownItems&& knownItems) = delete;
+
+	//Adds the item, unless a known item of any type is within the merge distance
+	bool AddItem(const ItemInfo& item);
+	//Removes a known item of any type within the merge distance, e.g. when it was picked up
+	bool RemoveItemAt(const Elite::Vector2& location);
+
+	//Closest item of one of the types within the range (inclusive), ties go to the type that comes first and then the item added first
+	bool FindClosestItem(const std::vector<eItemType>& types, const Elite::Vector2& position, float maxRange, ItemInfo& item) const;
+	//Up to count items of the type within the range, closest first
+	void FindClosestItems(eItemType type, const Elite::Vector2& position, float maxRange, UINT count, std::vector<ItemInfo>& items) const;
+
+	UINT Size() const { return m_Size; }
+	//Scratch memory of the searches comes from the arena, the heap is used without one
+	void SetFrameArena(FrameArena* pFrameArena) { m_pFrameArena = pFrameArena; }
+
+private:
+	static const int m_TypeCount{ int(eItemType::RANDOM_DROP_WITH_CHANCE) + 1 };
+
+	struct KnownItem {
+		ItemInfo Info{};
+		UINT Order{}; //Items are returned in the order they were added when they are equally close
+	};
+	struct ItemGrid {
+		std::unordered_map<unsigned long long, std::vector<KnownItem>> Cells{};
+		UINT Size{};
+		//Bounds of the cells that were ever used, searches never go further
+		int MinX{}, MinY{}, MaxX{}, MaxY{};
+	};
+	struct Candidate {
+		float DistanceSquared{};
+		const KnownItem* pItem{ nullptr };
+	};
+
+	const float m_CellSize;
+	const float m_MergeDistance;
+	ItemGrid m_Grids[m_TypeCount]{};
+	UINT m_Size{};
+	UINT m_NextOrder{};
+	FrameArena* m_pFrameArena{ nullptr };
+
+	const KnownItem* FindItemNear(ItemGrid& grid, const Elite::Vector2& location, std::vector<KnownItem>** ppCell = nullptr) const;
+	void FindClosestCandidates(const ItemGrid& grid, const Elite::Vector2& position, float maxRange, UINT count, FrameVector<Candidate>& candidates) const;
+	int GetCellCoordinate(float position) const;
+};
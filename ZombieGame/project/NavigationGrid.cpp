@@ -0,0 +1,472 @@
+#include "stdafx.h"
+#include "NavigationGrid.h"
+#include "Structs.h"
+#include <algorithm>
+
+namespace {
+	const int DirectionCount{ 8 };
+	const int DirectionX[DirectionCount]{ 1, -1, 0, 0, 1, 1, -1, -1 };
+	const int DirectionY[DirectionCount]{ 0, 0, 1, -1, 1, -1, 1, -1 };
+	//Costs of a straight and a diagonal step in fixed point
+	const UINT StraightCost{ 1 << 16 };
+	const UINT DiagonalCost{ 92682 }; //sqrt(2) * StraightCost
+
+	int GetLowestBit(unsigned long long bits)
+	{
+#if defined(_MSC_VER)
+		unsigned long index{};
+		_BitScanForward64(&index, bits);
+		return int(index);
+#else
+		return __builtin_ctzll(bits);
+#endif
+	}
+
+	int GetHighestBit(unsigned long long bits)
+	{
+#if defined(_MSC_VER)
+		unsigned long index{};
+		_BitScanReverse64(&index, bits);
+		return int(index);
+#else
+		return 63 - __builtin_clzll(bits);
+#endif
+	}
+
+	int GetBitCount(unsigned long long bits)
+	{
+#if defined(_MSC_VER)
+		return int(__popcnt64(bits));
+#else
+		return __builtin_popcountll(bits);
+#endif
+	}
+
+	//First position from the start in the direction (1 or -1) that is blocked, is the goal, or has a side that opens up
+	//Returns -1 if it is blocked, the line and its two sides are blocked bits that end in a blocked border
+	int ScanLine(const unsigned long long* pLine, const unsigned long long* pSide1, const unsigned long long* pSide2, int start, int direction, int goal)
+	{
+		if (direction > 0) {
+			unsigned long long mask{ ~0ull << ((start + 1) & 63) };
+			for (int word{ (start + 1) >> 6 }; ; ++word, mask = ~0ull) {
+				//The sides one cell back
+				const unsigned long long back1{ (pSide1[word] << 1) | (word > 0 ? pSide1[word - 1] >> 63 : 0) };
+				const unsigned long long back2{ (pSide2[word] << 1) | (word > 0 ? pSide2[word - 1] >> 63 : 0) };
+				unsigned long long stops{ pLine[word] | (~pSide1[word] & back1) | (~pSide2[word] & back2) };
+				if (goal >> 6 == word) {
+					stops |= 1ull << (goal & 63);
+				}
+				stops &= mask;
+				if (stops != 0) {
+					const int position{ (word << 6) + GetLowestBit(stops) };
+					return (pLine[word] >> (position & 63)) & 1 ? -1 : position;
+				}
+			}
+		}
+
+		unsigned long long mask{ ~0ull >> (63 - ((start - 1) & 63)) };
+		for (int word{ (start - 1) >> 6 }; ; --word, mask = ~0ull) {
+			//The sides one cell ahead, every line has a spare word at the end
+			const unsigned long long ahead1{ (pSide1[word] >> 1) | (pSide1[word + 1] << 63) };
+			const unsigned long long ahead2{ (pSide2[word] >> 1) | (pSide2[word + 1] << 63) };
+			unsigned long long stops{ pLine[word] | (~pSide1[word] & ahead1) | (~pSide2[word] & ahead2) };
+			if (goal >= 0 && goal >> 6 == word) {
+				stops |= 1ull << (goal & 63);
+			}
+			stops &= mask;
+			if (stops != 0) {
+				const int position{ (word << 6) + GetHighestBit(stops) };
+				return (pLine[word] >> (position & 63)) & 1 ? -1 : position;
+			}
+		}
+	}
+}
+
+NavigationGrid::NavigationGrid(const Elite::Vector2& center, const Elite::Vector2& dimensions, float cellSize)
+	:m_CellSize{ cellSize }
+	, m_Origin{ center - dimensions / 2.f }
+	, m_Width{ int(ceilf(dimensions.x / cellSize)) }
+	, m_Height{ int(ceilf(dimensions.y / cellSize)) }
+{
+	const size_t cellCount{ size_t(m_Width) * m_Height };
+	m_Flags.resize(cellCount);
+	m_Costs.resize(cellCount);
+	m_Parents.resize(cellCount);
+	m_Generations.resize(cellCount);
+
+	//Positions in the lines are shifted by one for the border, the border rows and columns are fully blocked
+	m_RowWords = (m_Width + 2 + 63) / 64 + 1;
+	m_ColumnWords = (m_Height + 2 + 63) / 64 + 1;
+	m_RowBits.resize(size_t(m_Height + 2) * m_RowWords);
+	m_ColumnBits.resize(size_t(m_Width + 2) * m_ColumnWords);
+	InitializeBorder(m_RowBits, m_RowWords, m_Width, m_Height);
+	InitializeBorder(m_ColumnBits, m_ColumnWords, m_Height, m_Width);
+	//Grows to the largest open list once, later queries reuse it
+	m_Open.reserve(4 * (m_Width + m_Height));
+}
+
+void NavigationGrid::AddHouse(const HouseSearch& house)
+{
+	const Elite::Vector2 min{ house.Center - house.Size / 2.f };
+	const Elite::Vector2 max{ house.Center + house.Size / 2.f };
+	const float thickness{ house.wallThickness };
+
+	AddObstacle(min, Elite::Vector2{ max.x, min.y + thickness });
+	AddObstacle(Elite::Vector2{ min.x, max.y - thickness }, max);
+	AddObstacle(min, Elite::Vector2{ min.x + thickness, max.y });
+	AddObstacle(Elite::Vector2{ max.x - thickness, min.y }, max);
+}
+
+void NavigationGrid::AddObstacle(const Elite::Vector2& min, const Elite::Vector2& max)
+{
+	const int minX{ (std::max)(0, int(floorf((min.x - m_Origin.x) / m_CellSize))) };
+	const int minY{ (std::max)(0, int(floorf((min.y - m_Origin.y) / m_CellSize))) };
+	const int maxX{ (std::min)(m_Width - 1, int(ceilf((max.x - m_Origin.x) / m_CellSize)) - 1) };
+	const int maxY{ (std::min)(m_Height - 1, int(ceilf((max.y - m_Origin.y) / m_CellSize)) - 1) };
+	for (int y{ minY }; y <= maxY; ++y) {
+		for (int x{ minX }; x <= maxX; ++x) {
+			m_Flags[y * m_Width + x] |= Blocked;
+			UpdateBits(x, y);
+		}
+	}
+	++m_Version;
+}
+
+void NavigationGrid::MarkWalkable(const Elite::Vector2& position, float radius)
+{
+	const int minX{ (std::max)(0, int(floorf((position.x - radius - m_Origin.x) / m_CellSize))) };
+	const int minY{ (std::max)(0, int(floorf((position.y - radius - m_Origin.y) / m_CellSize))) };
+	const int maxX{ (std::min)(m_Width - 1, int(floorf((position.x + radius - m_Origin.x) / m_CellSize))) };
+	const int maxY{ (std::min)(m_Height - 1, int(floorf((position.y + radius - m_Origin.y) / m_CellSize))) };
+	for (int y{ minY }; y <= maxY; ++y) {
+		for (int x{ minX }; x <= maxX; ++x) {
+			const int index{ y * m_Width + x };
+			if (IsBlocked(index)) {
+				++m_Version;
+			}
+			m_Flags[index] |= Walked;
+			UpdateBits(x, y);
+		}
+	}
+}
+
+bool NavigationGrid::FindPath(const Elite::Vector2& start, const Elite::Vector2& goal, std::vector<Elite::Vector2>& path)
+{
+	path.clear();
+	int startX{}, startY{}, goalX{}, goalY{};
+	if (!GetCell(start, startX, startY) || !GetCell(goal, goalX, goalY)) {
+		return false;
+	}
+	const int goalIndex{ goalY * m_Width + goalX };
+	if (Search(startY * m_Width + startX, goalIndex) == FLT_MAX) {
+		return false;
+	}
+
+	m_JumpPath.clear();
+	for (int index{ goalIndex }; index != -1; index = m_Parents[index]) {
+		m_JumpPath.push_back(index);
+	}
+	std::reverse(m_JumpPath.begin(), m_JumpPath.end());
+
+	//The path only turns at jump points, skip every one that the previous waypoint can see past
+	Elite::Vector2 waypoint{ start };
+	Elite::Vector2 lastVisible{ start };
+	for (size_t pathIndex{ 1 }; pathIndex < m_JumpPath.size(); ++pathIndex) {
+		const int index{ m_JumpPath[pathIndex] };
+		const Elite::Vector2 corner{ index == goalIndex ? goal : GetCellCenter(index % m_Width, index / m_Width) };
+		if (!IsLineWalkable(waypoint, corner) && lastVisible != waypoint) {
+			path.push_back(lastVisible);
+			waypoint = lastVisible;
+		}
+		lastVisible = corner;
+	}
+	path.push_back(goal);
+	return true;
+}
+
+float NavigationGrid::GetPathCost(const Elite::Vector2& start, const Elite::Vector2& goal)
+{
+	int startX{}, startY{}, goalX{}, goalY{};
+	if (!GetCell(start, startX, startY) || !GetCell(goal, goalX, goalY)) {
+		return FLT_MAX;
+	}
+	return Search(startY * m_Width + startX, goalY * m_Width + goalX);
+}
+
+bool NavigationGrid::IsLineWalkable(const Elite::Vector2& start, const Elite::Vector2& end) const
+{
+	int x{}, y{}, endX{}, endY{};
+	if (!GetCell(start, x, y) || !GetCell(end, endX, endY)) {
+		return false;
+	}
+
+	//Walk over every cell the line crosses, the distances are in line lengths
+	const Elite::Vector2 direction{ end - start };
+	const int stepX{ direction.x > 0.f ? 1 : -1 };
+	const int stepY{ direction.y > 0.f ? 1 : -1 };
+	const float deltaX{ direction.x != 0.f ? fabsf(m_CellSize / direction.x) : FLT_MAX };
+	const float deltaY{ direction.y != 0.f ? fabsf(m_CellSize / direction.y) : FLT_MAX };
+	float nextX{ direction.x != 0.f ? ((x + (stepX > 0 ? 1 : 0)) * m_CellSize + m_Origin.x - start.x) / direction.x : FLT_MAX };
+	float nextY{ direction.y != 0.f ? ((y + (stepY > 0 ? 1 : 0)) * m_CellSize + m_Origin.y - start.y) / direction.y : FLT_MAX };
+
+	const int maxSteps{ abs(endX - x) + abs(endY - y) };
+	for (int step{}; step <= maxSteps; ++step) {
+		if (IsBlocked(y * m_Width + x)) {
+			return false;
+		}
+		if (x == endX && y == endY) {
+			return true;
+		}
+		if (nextX == nextY) {
+			//Through a corner, both cells next to it have to be free
+			if (IsBlocked(y * m_Width + x + stepX) || IsBlocked((y + stepY) * m_Width + x)) {
+				return false;
+			}
+			x += stepX;
+			y += stepY;
+			nextX += deltaX;
+			nextY += deltaY;
+			++step;
+		}
+		else if (nextX < nextY) {
+			x += stepX;
+			nextX += deltaX;
+		}
+		else {
+			y += stepY;
+			nextY += deltaY;
+		}
+	}
+	//Rounding took the walk past the end cell
+	return false;
+}
+
+bool NavigationGrid::IsBlocked(int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= m_Width || y >= m_Height) {
+		return true;
+	}
+	return IsBlocked(y * m_Width + x);
+}
+
+float NavigationGrid::GetBlockedFraction(const Elite::Vector2& min, const Elite::Vector2& max) const
+{
+	const int minX{ int(ceilf((min.x - m_Origin.x) / m_CellSize - 0.5f)) };
+	const int minY{ int(ceilf((min.y - m_Origin.y) / m_CellSize - 0.5f)) };
+	const int maxX{ int(ceilf((max.x - m_Origin.x) / m_CellSize - 0.5f)) - 1 };
+	const int maxY{ int(ceilf((max.y - m_Origin.y) / m_CellSize - 0.5f)) - 1 };
+	if (maxX < minX || maxY < minY) {
+		return 0.f;
+	}
+	if (maxX < 0 || minX >= m_Width) {
+		return 1.f;
+	}
+
+	//Counted on the row bits, the border bits on both ends of a row are blocked already
+	const int firstBit{ (std::max)(minX, -1) + 1 };
+	const int lastBit{ (std::min)(maxX, m_Width) + 1 };
+	const int outsideCount{ (maxX - minX + 1) - (lastBit - firstBit + 1) };
+	int blockedCount{};
+	for (int y{ minY }; y <= maxY; ++y) {
+		if (y < 0 || y >= m_Height) {
+			blockedCount += maxX - minX + 1;
+			continue;
+		}
+		const unsigned long long* pRow{ &m_RowBits[size_t(y + 1) * m_RowWords] };
+		for (int word{ firstBit >> 6 }; word <= lastBit >> 6; ++word) {
+			unsigned long long bits{ pRow[word] };
+			if (word == firstBit >> 6) {
+				bits &= ~0ull << (firstBit & 63);
+			}
+			if (word == lastBit >> 6) {
+				bits &= ~0ull >> (63 - (lastBit & 63));
+			}
+			blockedCount += GetBitCount(bits);
+		}
+		blockedCount += outsideCount;
+	}
+	return float(blockedCount) / ((maxX - minX + 1) * (maxY - minY + 1));
+}
+
+Elite::Vector2 NavigationGrid::GetCellCenter(int x, int y) const
+{
+	return Elite::Vector2{ m_Origin.x + (x + 0.5f) * m_CellSize, m_Origin.y + (y + 0.5f) * m_CellSize };
+}
+
+bool NavigationGrid::GetCell(const Elite::Vector2& position, int& x, int& y) const
+{
+	x = int(floorf((position.x - m_Origin.x) / m_CellSize));
+	y = int(floorf((position.y - m_Origin.y) / m_CellSize));
+	return x >= 0 && y >= 0 && x < m_Width && y < m_Height;
+}
+
+float NavigationGrid::Search(int startIndex, int goalIndex)
+{
+	m_ExpandedJumpPoints = 0;
+	if (IsBlocked(startIndex) || IsBlocked(goalIndex)) {
+		return FLT_MAX;
+	}
+
+	//A new generation invalidates the costs of the previous query without touching them
+	if (++m_Generation == 0) {
+		std::fill(m_Generations.begin(), m_Generations.end(), 0);
+		m_Generation = 1;
+	}
+	m_Open.clear();
+	m_Costs[startIndex] = 0;
+	m_Parents[startIndex] = -1;
+	m_Generations[startIndex] = m_Generation;
+	m_Open.push_back(OpenNode{ GetHeuristic(startIndex, goalIndex), 0, startIndex });
+
+	while (!m_Open.empty()) {
+		std::pop_heap(m_Open.begin(), m_Open.end());
+		const OpenNode node{ m_Open.back() };
+		m_Open.pop_back();
+		if (node.index == goalIndex) {
+			return float(m_Costs[goalIndex]) / StraightCost * m_CellSize;
+		}
+		//The cell was reached cheaper after this node was added
+		const UINT cost{ m_Costs[node.index] };
+		if (node.cost > cost) {
+			continue;
+		}
+		++m_ExpandedJumpPoints;
+
+		const int x{ node.index % m_Width };
+		const int y{ node.index / m_Width };
+		const int parent{ m_Parents[node.index] };
+		int directionsX[DirectionCount]{};
+		int directionsY[DirectionCount]{};
+		int directionCount{};
+		if (parent == -1) {
+			std::copy(DirectionX, DirectionX + DirectionCount, directionsX);
+			std::copy(DirectionY, DirectionY + DirectionCount, directionsY);
+			directionCount = DirectionCount;
+		}
+		else {
+			//Only the directions the parent could not have reached as well from its own cell
+			const int directionX{ Elite::Clamp(x - parent % m_Width, -1, 1) };
+			const int directionY{ Elite::Clamp(y - parent / m_Width, -1, 1) };
+			if (directionX != 0 && directionY != 0) {
+				const int pruned[3][2]{ { directionX, directionY }, { directionX, 0 }, { 0, directionY } };
+				for (const auto& direction : pruned) {
+					directionsX[directionCount] = direction[0];
+					directionsY[directionCount++] = direction[1];
+				}
+			}
+			else {
+				//Without cutting corners, the sides of a straight line can only be reached from the line
+				const int sideX{ directionY }, sideY{ directionX };
+				const int pruned[5][2]{ { directionX, directionY }, { directionX + sideX, directionY + sideY }, { directionX - sideX, directionY - sideY }, { sideX, sideY }, { -sideX, -sideY } };
+				for (const auto& direction : pruned) {
+					directionsX[directionCount] = direction[0];
+					directionsY[directionCount++] = direction[1];
+				}
+			}
+		}
+
+		for (int direction{}; direction < directionCount; ++direction) {
+			const int jumpPoint{ Jump(x, y, directionsX[direction], directionsY[direction], goalIndex) };
+			if (jumpPoint == -1) {
+				continue;
+			}
+			//Between jump points the path is a straight or diagonal line, the octile distance is its exact cost
+			const UINT jumpCost{ cost + GetHeuristic(node.index, jumpPoint) };
+			if (m_Generations[jumpPoint] == m_Generation && m_Costs[jumpPoint] <= jumpCost) {
+				continue;
+			}
+			m_Generations[jumpPoint] = m_Generation;
+			m_Costs[jumpPoint] = jumpCost;
+			m_Parents[jumpPoint] = node.index;
+			m_Open.push_back(OpenNode{ jumpCost + GetHeuristic(jumpPoint, goalIndex), jumpCost, jumpPoint });
+			std::push_heap(m_Open.begin(), m_Open.end());
+		}
+	}
+	return FLT_MAX;
+}
+
+int NavigationGrid::Jump(int x, int y, int directionX, int directionY, int goalIndex) const
+{
+	if (directionX == 0 || directionY == 0) {
+		return JumpStraight(x, y, directionX, directionY, goalIndex);
+	}
+
+	//Steps on until the goal, or until one of the straight parts of the diagonal finds a jump point
+	for (;;) {
+		if (!CanStep(x, y, directionX, directionY)) {
+			return -1;
+		}
+		x += directionX;
+		y += directionY;
+		const int index{ y * m_Width + x };
+		if (index == goalIndex || JumpStraight(x, y, directionX, 0, goalIndex) != -1 || JumpStraight(x, y, 0, directionY, goalIndex) != -1) {
+			return index;
+		}
+	}
+}
+
+int NavigationGrid::JumpStraight(int x, int y, int directionX, int directionY, int goalIndex) const
+{
+	//Stops at the goal, or where a wall next to the line ends, the cell past it can be reached from there
+	const int goalX{ goalIndex % m_Width };
+	const int goalY{ goalIndex / m_Width };
+	if (directionY == 0) {
+		const unsigned long long* pRow{ &m_RowBits[size_t(y + 1) * m_RowWords] };
+		const int position{ ScanLine(pRow, pRow - m_RowWords, pRow + m_RowWords, x + 1, directionX, goalY == y ? goalX + 1 : -1) };
+		return position == -1 ? -1 : y * m_Width + position - 1;
+	}
+	const unsigned long long* pColumn{ &m_ColumnBits[size_t(x + 1) * m_ColumnWords] };
+	const int position{ ScanLine(pColumn, pColumn - m_ColumnWords, pColumn + m_ColumnWords, y + 1, directionY, goalX == x ? goalY + 1 : -1) };
+	return position == -1 ? -1 : (position - 1) * m_Width + x;
+}
+
+bool NavigationGrid::CanStep(int x, int y, int directionX, int directionY) const
+{
+	if (IsBlocked(x + directionX, y + directionY)) {
+		return false;
+	}
+	//Diagonals can not cut the corner of a blocked cell
+	return directionX == 0 || directionY == 0 || (!IsBlocked(x + directionX, y) && !IsBlocked(x, y + directionY));
+}
+
+void NavigationGrid::UpdateBits(int x, int y)
+{
+	const unsigned long long rowBit{ 1ull << ((x + 1) & 63) };
+	const unsigned long long columnBit{ 1ull << ((y + 1) & 63) };
+	unsigned long long& rowWord{ m_RowBits[size_t(y + 1) * m_RowWords + ((x + 1) >> 6)] };
+	unsigned long long& columnWord{ m_ColumnBits[size_t(x + 1) * m_ColumnWords + ((y + 1) >> 6)] };
+	if (IsBlocked(y * m_Width + x)) {
+		rowWord |= rowBit;
+		columnWord |= columnBit;
+	}
+	else {
+		rowWord &= ~rowBit;
+		columnWord &= ~columnBit;
+	}
+}
+
+void NavigationGrid::InitializeBorder(std::vector<unsigned long long>& bits, int words, int length, int lineCount)
+{
+	std::fill(bits.begin(), bits.begin() + words, ~0ull);
+	std::fill(bits.end() - words, bits.end(), ~0ull);
+	for (int line{ 1 }; line <= lineCount; ++line) {
+		unsigned long long* pLine{ &bits[size_t(line) * words] };
+		pLine[0] |= 1;
+		//Everything from the end of the line on
+		const int end{ length + 1 };
+		pLine[end >> 6] |= ~0ull << (end & 63);
+		for (int word{ (end >> 6) + 1 }; word < words; ++word) {
+			pLine[word] = ~0ull;
+		}
+	}
+}
+
+UINT NavigationGrid::GetHeuristic(int index, int goalIndex) const
+{
+	//Octile distance, the exact cost without any blocked cells
+	const int distanceX{ abs(index % m_Width - goalIndex % m_Width) };
+	const int distanceY{ abs(index / m_Width - goalIndex / m_Width) };
+	const int diagonal{ (std::min)(distanceX, distanceY) };
+	const int straight{ (std::max)(distanceX, distanceY) - diagonal };
+	return straight * StraightCost + diagonal * DiagonalCost;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Exam_HelperStructs.h"
+
+struct HouseSearch;
+
+//Occupancy grid of the world as far as the agent knows it, with a jump point search on top
+//(A* that skips over the cells of straight lines and only expands the cells where the path can turn)
+//Houses block their walls, the doors are not known, they are found by walking: a cell the agent stood on is always free
+//All memory of the pathfinder is allocated once, a query only resets the cells it touches
+class NavigationGrid final {
+public:
+	NavigationGrid(const Elite::Vector2& center, const Elite::Vector2& dimensions, float cellSize = 1.f);
+	~NavigationGrid() = default;
+
+	//Delete copy and move constructors and operators
+	NavigationGrid(const NavigationGrid& navigationGrid) = delete;
+	NavigationGrid(NavigationGrid&& navigationGrid) = delete;
+	NavigationGrid& operator=(const NavigationGrid& navigationGrid) = delete;
+	NavigationGrid& operator=(NavigationGrid&& navigationGrid) = delete;
+
+	//Blocks the walls of the house, a band of wallThickness along its bounds
+	void AddHouse(const HouseSearch& house);
+	//Blocks every cell overlapping the rectangle, except the ones that were walked on
+	void AddObstacle(const Elite::Vector2& min, const Elite::Vector2& max);
+	//The agent stood here, so nothing in the circle blocks
+	void MarkWalkable(const Elite::Vector2& position, float radius);
+
+	//Shortest path over the grid, without cutting corners, shortened to the waypoints that can see each other
+	//The path starts with the first waypoint after the start and ends with the goal, returns false if there is none
+	bool FindPath(const Elite::Vector2& start, const Elite::Vector2& goal, std::vector<Elite::Vector2>& path);
+	//Length of the shortest grid path, FLT_MAX if there is none
+	float GetPathCost(const Elite::Vector2& start, const Elite::Vector2& goal);
+	//True if no blocked cell is crossed by the line
+	bool IsLineWalkable(const Elite::Vector2& start, const Elite::Vector2& end) const;
+
+	int GetWidth() const { return m_Width; }
+	int GetHeight() const { return m_Height; }
+	float GetCellSize() const { return m_CellSize; }
+	bool IsBlocked(int x, int y) const;
+	//Part of the cells with their center in the rectangle that is blocked, cells outside the grid count as blocked
+	float GetBlockedFraction(const Elite::Vector2& min, const Elite::Vector2& max) const;
+	Elite::Vector2 GetCellCenter(int x, int y) const;
+	//Changes whenever a cell gets blocked or free
+	UINT GetVersion() const { return m_Version; }
+	//Jump points expanded by the last query
+	UINT GetExpandedJumpPoints() const { return m_ExpandedJumpPoints; }
+
+private:
+	struct OpenNode {
+		UINT estimate{}; //Cost so far plus the heuristic
+		UINT cost{};
+		int index{};
+		//Min heap on the estimate, most of the cells between the start and the goal have the same one on an open grid
+		//so the equal ones that got furthest go first
+		bool operator<(const OpenNode& node) const { return estimate > node.estimate || (estimate == node.estimate && cost < node.cost); }
+	};
+
+	enum CellFlags : unsigned char {
+		Blocked = 1,
+		Walked = 2
+	};
+
+	const float m_CellSize;
+	Elite::Vector2 m_Origin{}; //Bottom left corner
+	int m_Width{};
+	int m_Height{};
+	std::vector<unsigned char> m_Flags{};
+	UINT m_Version{};
+	//The same blocked cells as bits, by row and by column, so the jumps along a line check 64 cells at once
+	int m_RowWords{};
+	int m_ColumnWords{};
+	std::vector<unsigned long long> m_RowBits{};
+	std::vector<unsigned long long> m_ColumnBits{};
+
+	//Pathfinder state, a cell is only valid for the query whose generation it has
+	std::vector<UINT> m_Costs{}; //In fixed point, so equal estimates are exactly equal
+	std::vector<int> m_Parents{};
+	std::vector<UINT> m_Generations{};
+	std::vector<OpenNode> m_Open{};
+	std::vector<int> m_JumpPath{};
+	UINT m_Generation{};
+	UINT m_ExpandedJumpPoints{};
+
+	bool GetCell(const Elite::Vector2& position, int& x, int& y) const;
+	bool IsBlocked(int index) const { return (m_Flags[index] & Blocked) != 0 && (m_Flags[index] & Walked) == 0; }
+	//Jump point search from the start to the goal cell, returns the cost, the parents lead back from the goal
+	float Search(int startIndex, int goalIndex);
+	//Next jump point from the cell in the direction, -1 if there is none
+	int Jump(int x, int y, int directionX, int directionY, int goalIndex) const;
+	int JumpStraight(int x, int y, int directionX, int directionY, int goalIndex) const;
+	bool CanStep(int x, int y, int directionX, int directionY) const;
+	void UpdateBits(int x, int y);
+	static void InitializeBorder(std::vector<unsigned long long>& bits, int words, int length, int lineCount);
+	UINT GetHeuristic(int index, int goalIndex) const;
+};
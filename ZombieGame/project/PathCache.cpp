@@ -0,0 +1,91 @@
+#include "stdafx.h"
+#include "PathCache.h"
+#include "IExamInterface.h"
+
+PathCache::PathCache(float startCellSize, float goalTolerance, float corridorWidth, float arrivalRadius)
+	:m_StartCellSize{ startCellSize }
+	, m_GoalTolerance{ goalTolerance }
+	, m_CorridorWidth{ corridorWidth }
+	, m_ArrivalRadius{ arrivalRadius }
+{
+}
+
+Elite::Vector2 PathCache::GetClosestPathPoint(IExamInterface* pInterface, const Elite::Vector2& position, const Elite::Vector2& goal)
+{
+	//The path point only changes when the agent gets a view past it, the start cell bounds how long that can go unnoticed
+	const int startCellX{ int(floorf(position.x / m_StartCellSize)) };
+	const int startCellY{ int(floorf(position.y / m_StartCellSize)) };
+	const int goalCellX{ int(floorf(goal.x / m_GoalTolerance)) };
+	const int goalCellY{ int(floorf(goal.y / m_GoalTolerance)) };
+	const unsigned long long use{ m_Hits + m_Misses };
+
+	for (Entry& entry : m_Entries) {
+		if (!IsKey(entry, startCellX, startCellY, goalCellX, goalCellY)) {
+			continue;
+		}
+		if (Elite::DistanceSquared(entry.goal, goal) > m_GoalTolerance * m_GoalTolerance || !IsInCorridor(entry, position)) {
+			continue;
+		}
+
+		++m_Hits;
+		entry.lastUse = use;
+		//Without anything in between, the goal that moved a bit is still the way to go
+		return entry.isGoal ? goal : entry.pathPoint;
+	}
+
+	++m_Misses;
+	const Elite::Vector2 pathPoint{ pInterface->NavMesh_GetClosestPathPoint(goal) };
+
+	//Replace the entry with the same key, or else the least recently used one
+	Entry* pEntry{ &m_Entries[0] };
+	for (Entry& entry : m_Entries) {
+		if (IsKey(entry, startCellX, startCellY, goalCellX, goalCellY)) {
+			pEntry = &entry;
+			break;
+		}
+		if (!entry.isValid || entry.lastUse < pEntry->lastUse) {
+			pEntry = &entry;
+		}
+	}
+	pEntry->isValid = true;
+	pEntry->startCellX = startCellX;
+	pEntry->startCellY = startCellY;
+	pEntry->goalCellX = goalCellX;
+	pEntry->goalCellY = goalCellY;
+	pEntry->goal = goal;
+	pEntry->start = position;
+	pEntry->pathPoint = pathPoint;
+	pEntry->isGoal = pathPoint == goal;
+	pEntry->lastUse = use;
+	return pathPoint;
+}
+
+void PathCache::PrintStats() const
+{
+	const unsigned long long calls{ m_Hits + m_Misses };
+	printf("PathCache: %llu hits, %llu misses (%.1f%% hit rate)\n", m_Hits, m_Misses, calls > 0 ? 100.0 * m_Hits / calls : 0.0);
+}
+
+bool PathCache::IsInCorridor(const Entry& entry, const Elite::Vector2& position) const
+{
+	//Close to an intermediate path point, the host would already give the next one
+	if (!entry.isGoal && Elite::DistanceSquared(position, entry.pathPoint) < m_ArrivalRadius * m_ArrivalRadius) {
+		return false;
+	}
+
+	//Distance to the segment from the start to the path point
+	const Elite::Vector2 segment{ entry.pathPoint - entry.start };
+	const float lengthSquared{ segment.MagnitudeSquared() };
+	float t{};
+	if (lengthSquared > 0.f) {
+		t = Elite::Clamp(Elite::Dot(position - entry.start, segment) / lengthSquared, 0.f, 1.f);
+	}
+	const Elite::Vector2 closestPoint{ entry.start + segment * t };
+	return Elite::DistanceSquared(position, closestPoint) <= m_CorridorWidth * m_CorridorWidth;
+}
+
+bool PathCache::IsKey(const Entry& entry, int startCellX, int startCellY, int goalCellX, int goalCellY) const
+{
+	return entry.isValid && entry.startCellX == startCellX && entry.startCellY == startCellY
+		&& entry.goalCellX == goalCellX && entry.goalCellY == goalCellY;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Exam_HelperStructs.h"
+
+class IExamInterface;
+
+//Path points returned by NavMesh_GetClosestPathPoint, which runs a pathfind on the host for every call
+//An entry is keyed by the cells of the agent and the goal when the host was asked, and reused while the goal
+//stays within the tolerance and the agent stays in the corridor between where it asked and the path point
+class PathCache final {
+public:
+	explicit PathCache(float startCellSize = 2.f, float goalTolerance = 1.f, float corridorWidth = 1.f, float arrivalRadius = 1.f);
+	~PathCache() = default;
+
+	//Delete copy and move constructors and operators
+	PathCache(const PathCache& pathCache) = delete;
+	PathCache(PathCache&& pathCache) = delete;
+	PathCache& operator=(const PathCache& pathCache) = delete;
+	PathCache& operator=(PathCache&& pathCache) = delete;
+
+	//Path point from the agent position towards the goal, only asks the host on a miss
+	Elite::Vector2 GetClosestPathPoint(IExamInterface* pInterface, const Elite::Vector2& position, const Elite::Vector2& goal);
+
+	unsigned long long GetHits() const { return m_Hits; }
+	unsigned long long GetMisses() const { return m_Misses; }
+	void PrintStats() const;
+
+private:
+	struct Entry {
+		bool isValid{};
+		int startCellX{};
+		int startCellY{};
+		int goalCellX{};
+		int goalCellY{};
+		Elite::Vector2 goal{};
+		Elite::Vector2 start{}; //Agent position when the host was asked
+		Elite::Vector2 pathPoint{};
+		bool isGoal{}; //Nothing in between, the path point is the goal itself
+		unsigned long long lastUse{};
+	};
+
+	static const UINT m_EntryCount{ 4 };
+
+	const float m_StartCellSize;
+	const float m_GoalTolerance;
+	const float m_CorridorWidth;
+	const float m_ArrivalRadius;
+	Entry m_Entries[m_EntryCount]{};
+
+	unsigned long long m_Hits{};
+	unsigned long long m_Misses{};
+
+	bool IsInCorridor(const Entry& entry, const Elite::Vector2& position) const;
+	bool IsKey(const Entry& entry, int startCellX, int startCellY, int goalCellX, int goalCellY) const;
+};
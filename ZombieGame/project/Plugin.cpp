@@ -3,11 +3,266 @@
 #include "IExamInterface.h"
 #include "EBlackboard.h"
 #include "EBehaviorTree.h"
+#include "EFlatBehaviorTree.h"
+#include "EStaticBehaviorTree.h"
 #include "Behaviors.h"
 #include "Inventory.h"
+#include "NavigationGrid.h"
+#include "BlackboardKeys.h"
 
 using namespace std;
 
+//ENTRY
+//This is the first function that is called by the host program
+//The plugin returned by this function is also the plugin used by the host program
+IPluginBase* Register()
+{
+	return new Plugin();
+}
+
+//Behavior tree of the agent, the whole tree is one type
+namespace
+{
+	using namespace BT_Static;
+	using namespace BT_Actions;
+	using namespace BT_Conditions;
+
+	using PluginBehavior =
+		//Root
+		Selector<
+			//Run from purge zone
+			Sequence<
+				Cond<IsInPurgeZone>,
+				Act<GetReadyToEscapePurgeZone>,
+				Act<Flee>
+			>,
+			//Use items needed to survive
+			Selector<
+				//Use medkit
+				Sequence<
+					Cond<IsHurt>,
+					Cond<ShouldHeal>,
+					Act<UseMedkit>
+				>,
+				//Eat food
+				Sequence<
+					Cond<IsHungry>,
+					Cond<ShouldEat>,
+					Act<EatFood>
+				>
+			>,
+			//Enemy spotted
+			Sequence<
+				Cond<IsEnemyInFOV>,
+				Act<SetBiggestThreatAsTarget>,
+				Selector<
+					//If you are facing an enemy, shoot it
+					Sequence<
+						Cond<HasGun>,
+						Cond<IsFacingTarget>,
+						Act<ShootTarget>
+					>,
+					//If you see an enemy and have a gun, face it while walking back
+					Sequence<
+						Cond<HasGun>,
+						Act<Flee>,
+						Act<FaceBehind>
+					>,
+					//If you see an enemy in a house and you have no gun, mark house as unsafe and run
+					Sequence<
+						InvCond<HasGun>,
+						Cond<IsInsideHouse>,
+						Act<MarkHouseAsUnsafe>,
+						Act<GetReadyToFlee>,
+						Act<Flee>
+					>,
+					//If there are safe houses nearby hide there
+					Sequence<
+						InvCond<HasGun>,
+						Cond<ShouldSearchKnownHouse>,
+						Act<GetReadyToFlee>,
+						Act<SearchHouse>
+					>,
+					//If you see an enemy and have no gun, get ready to flee
+					Sequence<
+						InvCond<HasGun>,
+						Act<GetReadyToFlee>,
+						Act<Flee>
+					>
+				>
+			>,
+			//Bitten by enemy
+			Selector<
+				//If you just got bitten and no enemy is in the FOV, set the target behind you
+				Sequence<
+					Cond<IsBitten>,
+					InvCond<IsEnemyInFOV>,
+					Act<SetTargetBehindPlayer>
+				>,
+				//If you were bitten and have a gun, turn around while walking away
+				Sequence<
+					Cond<WasBitten>,
+					Cond<HasGun>,
+					Act<Flee>,
+					Act<FaceBehind>
+				>,
+				//If you were bitten and have no gun
+				Sequence<
+					Cond<WasBitten>,
+					InvCond<HasGun>,
+					Selector<
+						//If you are inside a house mark it as unsafe and flee
+						Sequence<
+							Cond<IsInsideHouse>,
+							Act<MarkHouseAsUnsafe>,
+							Act<GetReadyToFlee>,
+							Act<Flee>
+						>,
+						//If there are safe houses nearby hide there
+						Sequence<
+							Cond<ShouldSearchKnownHouse>,
+							Act<GetReadyToFlee>,
+							Act<SearchHouse>
+						>,
+						//If not, flee
+						Sequence<
+							Act<GetReadyToFlee>,
+							Act<Flee>
+						>
+					>
+				>
+			>,
+			//Look behind you if you were fleeing
+			Selector<
+				//If still within flee radius, continue fleeing
+				Sequence<
+					Cond<IsFleeing>,
+					Act<Flee>
+				>,
+				//When you are done fleeing, turn around to see if you are still being followed
+				Sequence<
+					Cond<WasFleeing>,
+					Act<FaceBehind>
+				>
+			>,
+			//Pickup items
+			Sequence<
+				Cond<IsItemInFOV>,
+				Selector<
+					//If an item is within pickup range try to pick it up
+					Sequence<
+						Cond<IsItemInPickupRange>,
+						Act<SetClosestItemAsTarget>,
+						Cond<ShouldPickUpClosestItem>,
+						Act<PickUpClosestItem>
+					>,
+					//If an item is not within pickup range move to it
+					Sequence<
+						Act<SetClosestItemAsTarget>,
+						Cond<ShouldPickUpClosestItem>,
+						Act<Seek>
+					>,
+					//If you should not pick up the item, save it as a known item
+					Sequence<
+						Act<SetClosestItemAsTarget>,
+						InvCond<ShouldPickUpClosestItem>,
+						Act<RememberItem>
+					>
+				>
+			>,
+			//Go to known items you need 
+			Sequence<
+				Cond<IsInNeedOfItem>,
+				Cond<ShouldPickupKnownItem>,
+				Act<Seek>
+			>,
+			//Explore houses
+			Selector<
+				//If you are currently inside of a house, and should explore it, search all locations
+				Sequence<
+					Cond<IsInsideHouse>,
+					Cond<ShouldSearchHouse>,
+					Act<SearchHouse>
+				>,
+				//If any of the houses you already know should be looted, loot that
+				Sequence<
+					Cond<ShouldSearchKnownHouse>,
+					Act<SearchHouse>
+				>
+			>,
+			//Explore world
+			Act<ExploreWorld>
+			//Any fallback behavior (go to current target)
+		>;
+
+#ifdef ELITE_BEHAVIOR_PROFILER
+	//Names of the leaves in the behavior profile
+	void RegisterBehaviorNames()
+	{
+#define REGISTER_BEHAVIOR_NAME(function) BehaviorProfiler::SetFunctionName(reinterpret_cast<const void*>(&function), #function)
+		REGISTER_BEHAVIOR_NAME(Seek);
+		REGISTER_BEHAVIOR_NAME(Flee);
+		REGISTER_BEHAVIOR_NAME(Face);
+		REGISTER_BEHAVIOR_NAME(FaceBehind);
+		REGISTER_BEHAVIOR_NAME(GetReadyToEscapePurgeZone);
+		REGISTER_BEHAVIOR_NAME(GetReadyToFlee);
+		REGISTER_BEHAVIOR_NAME(SetBiggestThreatAsTarget);
+		REGISTER_BEHAVIOR_NAME(ShootTarget);
+		REGISTER_BEHAVIOR_NAME(UseMedkit);
+		REGISTER_BEHAVIOR_NAME(EatFood);
+		REGISTER_BEHAVIOR_NAME(SetTargetBehindPlayer);
+		REGISTER_BEHAVIOR_NAME(SetClosestItemAsTarget);
+		REGISTER_BEHAVIOR_NAME(PickUpClosestItem);
+		REGISTER_BEHAVIOR_NAME(SearchHouse);
+		REGISTER_BEHAVIOR_NAME(ExploreWorld);
+		REGISTER_BEHAVIOR_NAME(RememberItem);
+		REGISTER_BEHAVIOR_NAME(MarkHouseAsUnsafe);
+		REGISTER_BEHAVIOR_NAME(IsInPurgeZone);
+		REGISTER_BEHAVIOR_NAME(IsEnemyInFOV);
+		REGISTER_BEHAVIOR_NAME(HasGun);
+		REGISTER_BEHAVIOR_NAME(WasFleeing);
+		REGISTER_BEHAVIOR_NAME(IsFleeing);
+		REGISTER_BEHAVIOR_NAME(IsHurt);
+		REGISTER_BEHAVIOR_NAME(ShouldHeal);
+		REGISTER_BEHAVIOR_NAME(IsHungry);
+		REGISTER_BEHAVIOR_NAME(ShouldEat);
+		REGISTER_BEHAVIOR_NAME(WasBitten);
+		REGISTER_BEHAVIOR_NAME(IsItemInFOV);
+		REGISTER_BEHAVIOR_NAME(IsBitten);
+		REGISTER_BEHAVIOR_NAME(IsItemInPickupRange);
+		REGISTER_BEHAVIOR_NAME(IsFacingTarget);
+		REGISTER_BEHAVIOR_NAME(IsInsideHouse);
+		REGISTER_BEHAVIOR_NAME(ShouldSearchHouse);
+		REGISTER_BEHAVIOR_NAME(ShouldSearchKnownHouse);
+		REGISTER_BEHAVIOR_NAME(ShouldPickUpClosestItem);
+		REGISTER_BEHAVIOR_NAME(IsInNeedOfItem);
+		REGISTER_BEHAVIOR_NAME(ShouldPickupKnownItem);
+#undef REGISTER_BEHAVIOR_NAME
+	}
+#endif
+
+	//Keys read by the guards the reactive tree only checks again when one of them was written, every other conditional is always executed.
+	//The impure ones write something when they return true, so they are executed every update they do
+	void RegisterConditionalInputs()
+	{
+		//Fails as long as no purge zone is in view, only reads the position when one is
+		FlatBehaviorTree::SetConditionalInputs(&IsInPurgeZone, { BB_Keys::PurgeZonesInFOV.GetSlot() }, false);
+		FlatBehaviorTree::SetConditionalInputs(&IsHurt, BB_Memos::IsHurt.GetInputSlots());
+		FlatBehaviorTree::SetConditionalInputs(&IsHungry, BB_Memos::IsHungry.GetInputSlots());
+		//Medkits and food are used up at once, so their value only changes together with their slot
+		FlatBehaviorTree::SetConditionalInputs(&ShouldHeal, { BB_Keys::PlayerHealth.GetSlot(), BB_Keys::MaxPlayerHealth.GetSlot(), BB_Keys::Inventory.GetSlot() });
+		FlatBehaviorTree::SetConditionalInputs(&ShouldEat, { BB_Keys::PlayerEnergy.GetSlot(), BB_Keys::MaxPlayerEnergy.GetSlot(), BB_Keys::Inventory.GetSlot() });
+		FlatBehaviorTree::SetConditionalInputs(&IsEnemyInFOV, BB_Memos::IsEnemyInFOV.GetInputSlots());
+		FlatBehaviorTree::SetConditionalInputs(&HasGun, BB_Memos::HasGun.GetInputSlots());
+		FlatBehaviorTree::SetConditionalInputs(&IsBitten, { BB_Keys::PlayerBitten.GetSlot() }, false);
+		FlatBehaviorTree::SetConditionalInputs(&WasBitten, { BB_Keys::PlayerWasBitten.GetSlot(), BB_Keys::IsInDanger.GetSlot() }, false);
+		FlatBehaviorTree::SetConditionalInputs(&IsFleeing, { BB_Keys::IsFleeing.GetSlot() });
+		FlatBehaviorTree::SetConditionalInputs(&WasFleeing, { BB_Keys::WasFleeing.GetSlot() });
+		FlatBehaviorTree::SetConditionalInputs(&IsItemInFOV, { BB_Keys::ItemsInFOV.GetSlot() });
+		FlatBehaviorTree::SetConditionalInputs(&IsInsideHouse, { BB_Keys::KnownHouses.GetSlot(), BB_Keys::PlayerPosition.GetSlot() }, false);
+	}
+}
+
 //Called only once, during initialization
 void Plugin::Initialize(IBaseInterface* pInterface, PluginInfo& info)
 {
@@ -29,218 +284,80 @@ void Plugin::Initialize(IBaseInterface* pInterface, PluginInfo& info)
 	m_pBlackboard = new Blackboard();
 	//Make the worldSearch
 	m_pWorldSearch = new WorldSearch(m_pInterface->World_GetInfo());
+	//Make the navigation grid, it gets the walls of every house that is found
+	m_pNavigationGrid = new NavigationGrid(m_pWorldSearch->Center, m_pWorldSearch->Dimensions);
+	//Searches of the known items take their scratch memory from the frame arena
+	m_KnownItems.SetFrameArena(&m_FrameArena);
 
 	//Add blackboard data
-	m_pBlackboard->AddData("Interface", m_pInterface);
-	m_pBlackboard->AddData("PlayerInfo", m_pInterface->Agent_GetInfo());
-	m_pBlackboard->AddData("WorldInfo", m_pInterface->World_GetInfo());
-	m_pBlackboard->AddData("SteeringOutput", SteeringPlugin_Output{});
-	m_pBlackboard->AddData("Inventory", m_pInventory);
-	m_pBlackboard->AddData("FleeRadius", 60.f);
-	m_pBlackboard->AddData("EnemiesInFOV", &m_EnemiesInFOV);
+	//	Data used every tick comes first, so it is packed together in the blackboard arena
+	const AgentInfo agentInfo{ m_pInterface->Agent_GetInfo() };
+	m_pBlackboard->AddData(BB_Keys::PlayerInfo, agentInfo);
+	m_pBlackboard->AddData(BB_Keys::PlayerHealth, agentInfo.Health);
+	m_pBlackboard->AddData(BB_Keys::PlayerEnergy, agentInfo.Energy);
+	m_pBlackboard->AddData(BB_Keys::PlayerPosition, agentInfo.Position);
+	m_pBlackboard->AddData(BB_Keys::PlayerBitten, agentInfo.Bitten);
+	m_pBlackboard->AddData(BB_Keys::PlayerWasBitten, agentInfo.WasBitten);
+	m_pBlackboard->AddData(BB_Keys::SteeringOutput, SteeringPlugin_Output{});
+	m_pBlackboard->AddData(BB_Keys::Target, Elite::Vector2{0, 0});
+	m_pBlackboard->AddData(BB_Keys::FleeTarget, Elite::Vector2{ 0, 0 });
+	m_pBlackboard->AddData(BB_Keys::PathCache, &m_PathCache);
+	m_pBlackboard->AddData(BB_Keys::DangerField, &m_DangerField);
+	m_pBlackboard->AddData(BB_Keys::Interface, m_pInterface);
+	m_pBlackboard->AddData(BB_Keys::Inventory, m_pInventory);
+	m_pBlackboard->AddData(BB_Keys::EnemiesInFOV, &m_EnemiesInFOV);
+	m_pBlackboard->AddData(BB_Keys::EnemyThreats, &m_EnemyThreats);
+	m_pBlackboard->AddData(BB_Keys::ItemsInFOV, &m_ItemsInFOV);
+	m_pBlackboard->AddData(BB_Keys::PurgeZonesInFOV, &m_PurgeZonesInFOV);
+	m_pBlackboard->AddData(BB_Keys::KnownHouses, &m_KnownHouses);
+	m_pBlackboard->AddData(BB_Keys::FleeRadius, 60.f);
+	m_pBlackboard->AddData(BB_Keys::CanRun, m_CanRun);
+	m_pBlackboard->AddData(BB_Keys::WasFleeing, false);
+	m_pBlackboard->AddData(BB_Keys::IsFleeing, false);
+	m_pBlackboard->AddData(BB_Keys::IsInDanger, false);
+
+	//General
+	m_pBlackboard->AddData(BB_Keys::WorldInfo, m_pInterface->World_GetInfo());
 
 	//Items
-	m_pBlackboard->AddData("ItemsInFOV", &m_ItemsInFOV);
-	m_pBlackboard->AddData("KnownItems", &m_KnownItems);
-	m_pBlackboard->AddData("ClosestItem", EntityInfo{});
-	m_pBlackboard->AddData("NeededItemTypes", std::vector<eItemType>());
-	m_pBlackboard->AddData("MaxItemWalkRange", 100.f);
+	m_pBlackboard->AddData(BB_Keys::KnownItems, &m_KnownItems);
+	m_pBlackboard->AddData(BB_Keys::ClosestItem, EntityInfo{});
+	m_pBlackboard->AddData(BB_Keys::NeededItemTypes, &m_NeededItemTypes);
+	m_pBlackboard->AddData(BB_Keys::MaxItemWalkRange, 100.f);
 
 	//Purge zone
-	m_pBlackboard->AddData("PurgeZonesInFOV", &m_PurgeZonesInFOV);
-	m_pBlackboard->AddData("CurrentPurgeZone", PurgeZoneInfo{});
-
-	m_pBlackboard->AddData("CanRun", m_CanRun);
-	m_pBlackboard->AddData("WasFleeing", false);
-	m_pBlackboard->AddData("IsFleeing", false);
-	m_pBlackboard->AddData("Target", Elite::Vector2{0, 0});
-	m_pBlackboard->AddData("FleeTarget", Elite::Vector2{ 0, 0 });
+	m_pBlackboard->AddData(BB_Keys::CurrentPurgeZone, PurgeZoneInfo{});
 
 	//Health
-	m_pBlackboard->AddData("MaxPlayerHealth", 10.0f);
-	m_pBlackboard->AddData("IsInDanger", false);
+	m_pBlackboard->AddData(BB_Keys::MaxPlayerHealth, 10.0f);
 
 	//Food
-	m_pBlackboard->AddData("MaxPlayerEnergy", 10.0f);
+	m_pBlackboard->AddData(BB_Keys::MaxPlayerEnergy, 10.0f);
 
 	//Houses
-	m_pBlackboard->AddData("HousesInFOV", m_HousesInFOV);
-	m_pBlackboard->AddData("KnownHouses", &m_KnownHouses);
-	m_pBlackboard->AddData("CurrentHouse", &HouseSearch{});
-	m_pBlackboard->AddData("ClosestHouse", HouseInfo{});
+	m_pBlackboard->AddData(BB_Keys::HousesInFOV, &m_HousesInFOV);
+	m_pBlackboard->AddData(BB_Keys::CurrentHouse, nullptr);
+	m_pBlackboard->AddData(BB_Keys::ClosestHouse, HouseInfo{});
 	
 	//World
-	m_pBlackboard->AddData("WorldSearch", m_pWorldSearch);
+	m_pBlackboard->AddData(BB_Keys::WorldSearch, m_pWorldSearch);
+	m_pBlackboard->AddData(BB_Keys::NavigationGrid, m_pNavigationGrid);
 
 	//Create behaviorTree
-	m_pBehaviorTree = new BehaviorTree(m_pBlackboard,
-		//Root
-		new BehaviorSelector({
-			//Run from purge zone
-			new BehaviorSequence({
-				new BehaviorConditional(BT_Conditions::IsInPurgeZone),
-				new BehaviorAction(BT_Actions::GetReadyToEscapePurgeZone),
-				new BehaviorAction(BT_Actions::Flee)
-			}),
-			//Use items needed to survive
-			new BehaviorSelector({
-				//Use medkit
-				new BehaviorSequence({
-					new BehaviorConditional(BT_Conditions::IsHurt),
-					new BehaviorConditional(BT_Conditions::ShouldHeal),
-					new BehaviorAction(BT_Actions::UseMedkit)
-				}),
-				//Eat food
-				new BehaviorSequence({
-					new BehaviorConditional(BT_Conditions::IsHungry),
-					new BehaviorConditional(BT_Conditions::ShouldEat),
-					new BehaviorAction(BT_Actions::EatFood)
-				})
-			}),
-			//Enemy spotted
-			new BehaviorSequence({
-				new BehaviorConditional(BT_Conditions::IsEnemyInFOV),
-				new BehaviorAction(BT_Actions::SetClosestEnemyAsTarget),
-				new BehaviorSelector({
-					//If you are facing an enemy, shoot it
-					new BehaviorSequence({	
-						new BehaviorConditional(BT_Conditions::HasGun),
-						new BehaviorConditional(BT_Conditions::IsFacingTarget),
-						new BehaviorAction(BT_Actions::ShootTarget)
-					}),
-					//If you see an enemy and have a gun, face it while walking back
-					new BehaviorSequence({
-						new BehaviorConditional(BT_Conditions::HasGun),
-						new BehaviorAction(BT_Actions::Flee),
-						new BehaviorAction(BT_Actions::FaceBehind)
-					}),
-					//If you see an enemy in a house and you have no gun, mark house as unsafe and run
-					new BehaviorSequence({
-						new InvertedBehaviorConditional(BT_Conditions::HasGun),
-						new BehaviorConditional(BT_Conditions::IsInsideHouse),
-						new BehaviorAction(BT_Actions::MarkHouseAsUnsafe),
-						new BehaviorAction(BT_Actions::GetReadyToFlee),
-						new BehaviorAction(BT_Actions::Flee)
-					}),
-					//If there are safe houses nearby hide there
-					new BehaviorSequence({
-						new InvertedBehaviorConditional(BT_Conditions::HasGun),
-						new BehaviorConditional(BT_Conditions::ShouldSearchKnownHouse),
-						new BehaviorAction(BT_Actions::GetReadyToFlee),
-						new BehaviorAction(BT_Actions::SearchHouse)
-					}),
-					//If you see an enemy and have no gun, get ready to flee
-					new BehaviorSequence({
-						new InvertedBehaviorConditional(BT_Conditions::HasGun),
-						new BehaviorAction(BT_Actions::GetReadyToFlee),
-						new BehaviorAction(BT_Actions::Flee)
-					}),
-				}),
-			}),
-			//Bitten by enemy
-			new BehaviorSelector({
-				//If you just got bitten and no enemy is in the FOV, set the target behind you
-				new BehaviorSequence({
-					new BehaviorConditional(BT_Conditions::IsBitten),
-					new InvertedBehaviorConditional(BT_Conditions::IsEnemyInFOV),
-					new BehaviorAction(BT_Actions::SetTargetBehindPlayer)
-					}),
-				//If you were bitten and have a gun, turn around while walking away
-				new BehaviorSequence({
-					new BehaviorConditional(BT_Conditions::WasBitten),
-					new BehaviorConditional(BT_Conditions::HasGun),
-					new BehaviorAction(BT_Actions::Flee),
-					new BehaviorAction(BT_Actions::FaceBehind)
-				}),
-				//If you were bitten and have no gun
-				new BehaviorSequence({
-					new BehaviorConditional(BT_Conditions::WasBitten),
-					new InvertedBehaviorConditional(BT_Conditions::HasGun),
-					new BehaviorSelector({
-						//If you are inside a house mark it as unsafe and flee
-						new BehaviorSequence({
-							new BehaviorConditional(BT_Conditions::IsInsideHouse),
-							new BehaviorAction(BT_Actions::MarkHouseAsUnsafe),
-							new BehaviorAction(BT_Actions::GetReadyToFlee),
-							new BehaviorAction(BT_Actions::Flee)
-						}),
-						//If there are safe houses nearby hide there
-						new BehaviorSequence({
-							new BehaviorConditional(BT_Conditions::ShouldSearchKnownHouse),
-							new BehaviorAction(BT_Actions::GetReadyToFlee),
-							new BehaviorAction(BT_Actions::SearchHouse)
-						}),
-						//If not, flee
-						new BehaviorSequence({
-							new BehaviorAction(BT_Actions::GetReadyToFlee),
-							new BehaviorAction(BT_Actions::Flee)
-						})
-					})
-				}),
-			}),
-			//Look behind you if you were fleeing
-			new BehaviorSelector({
-				//If still within flee radius, continue fleeing
-				new BehaviorSequence({
-					new BehaviorConditional(BT_Conditions::IsFleeing),
-					new BehaviorAction(BT_Actions::Flee)
-					}),
-				//When you are done fleeing, turn around to see if you are still being followed
-				new BehaviorSequence({
-					new BehaviorConditional(BT_Conditions::WasFleeing),
-					new BehaviorAction(BT_Actions::FaceBehind)
-					})
-			}),
-			//Pickup items
-			new BehaviorSequence({
-				new BehaviorConditional(BT_Conditions::IsItemInFOV),
-				new BehaviorSelector({
-					//If an item is within pickup range try to pick it up
-					new BehaviorSequence({
-						new BehaviorConditional(BT_Conditions::IsItemInPickupRange),
-						new BehaviorAction(BT_Actions::SetClosestItemAsTarget),
-						new BehaviorConditional(BT_Conditions::ShouldPickUpClosestItem),
-						new BehaviorAction(BT_Actions::PickUpClosestItem)
-					}),
-					//If an item is not within pickup range move to it
-					new BehaviorSequence({
-						new BehaviorAction(BT_Actions::SetClosestItemAsTarget),
-						new BehaviorConditional(BT_Conditions::ShouldPickUpClosestItem),
-						new BehaviorAction(BT_Actions::Seek)
-					}),
-					//If you should not pick up the item, save it as a known item
-					new BehaviorSequence({
-						new BehaviorAction(BT_Actions::SetClosestItemAsTarget),
-						new InvertedBehaviorConditional(BT_Conditions::ShouldPickUpClosestItem),
-						new BehaviorAction(BT_Actions::RememberItem)
-					})
-				}),
-			}),
-			//Go to known items you need 
-			new BehaviorSequence({
-				new BehaviorConditional(BT_Conditions::IsInNeedOfItem),
-				new BehaviorConditional(BT_Conditions::ShouldPickupKnownItem),
-				new BehaviorAction(BT_Actions::Seek)
-			}),
-			//Explore houses
-			new BehaviorSelector({
-				//If you are currently inside of a house, and should explore it, search all locations
-				new BehaviorSequence({
-					new BehaviorConditional(BT_Conditions::IsInsideHouse),
-					new BehaviorConditional(BT_Conditions::ShouldSearchHouse),
-					new BehaviorAction(BT_Actions::SearchHouse)
-				}),
-				//If any of the houses you already know should be looted, loot that
-				new BehaviorSequence({
-					new BehaviorConditional(BT_Conditions::ShouldSearchKnownHouse),
-					new BehaviorAction(BT_Actions::SearchHouse)
-				})
-			}),
-			//Explore world
-			new BehaviorAction(BT_Actions::ExploreWorld),
-			//Any fallback behavior (go to current target)
-		})
-	);
+#ifdef ELITE_BEHAVIOR_PROFILER
+	//Only the runtime tree is instrumented
+	RegisterBehaviorNames();
+	m_BehaviorTreeEngine = BehaviorTreeEngine::Runtime;
+#endif
+	//	The runtime tree is generated from the same definition, in one node pool, it owns the blackboard
+	m_pBehaviorTree = BT_Static::CreateBehaviorTree<PluginBehavior>(m_pBlackboard);
+	//	The flat tree is compiled from the runtime tree
+	m_pFlatBehaviorTree = new FlatBehaviorTree(m_pBlackboard, m_pBehaviorTree->GetRootBehavior());
+	//	The reactive tree is the flat tree that only re-checks the branches whose inputs changed
+	RegisterConditionalInputs();
+	m_pReactiveBehaviorTree = new FlatBehaviorTree(m_pBlackboard, m_pBehaviorTree->GetRootBehavior(), true);
+	//	The static tree is the one that gets updated every frame by default
+	m_pStaticBehaviorTree = new StaticBehaviorTree<PluginBehavior>(m_pBlackboard);
 
 }
 
@@ -254,6 +371,10 @@ void Plugin::DllInit()
 void Plugin::DllShutdown()
 {
 	SAFE_DELETE(m_pInventory);
+	SAFE_DELETE(m_pNavigationGrid);
+	SAFE_DELETE(m_pStaticBehaviorTree);
+	SAFE_DELETE(m_pReactiveBehaviorTree);
+	SAFE_DELETE(m_pFlatBehaviorTree);
 	SAFE_DELETE(m_pBehaviorTree);
 	//BehaviorTree takes ownership of passed blackboard, so no need to delete here
 }
@@ -278,6 +399,22 @@ void Plugin::InitGameDebugParams(GameDebugParams& params)
 	params.Seed = 36;
 }
 
+IDecisionMaking* Plugin::GetBehaviorTree(BehaviorTreeEngine engine) const
+{
+	switch (engine)
+	{
+	case BehaviorTreeEngine::Runtime:
+		return m_pBehaviorTree;
+	case BehaviorTreeEngine::Flat:
+		return m_pFlatBehaviorTree;
+	case BehaviorTreeEngine::Reactive:
+		return m_pReactiveBehaviorTree;
+	case BehaviorTreeEngine::Static:
+	default:
+		return m_pStaticBehaviorTree;
+	}
+}
+
 //Only Active in DEBUG Mode
 //(=Use only for Debug Purposes)
 void Plugin::Update(float dt)
@@ -333,6 +470,23 @@ void Plugin::Update(float dt)
 		if (m_InventorySlot < 4)
 			++m_InventorySlot;
 	}
+	else if (m_pInterface->Input_IsKeyboardKeyDown(Elite::eScancode_B))
+	{
+		//Print the layout of the blackboard arena
+		m_pBlackboard->DebugPrint();
+	}
+#ifdef ELITE_BEHAVIOR_PROFILER
+	else if (m_pInterface->Input_IsKeyboardKeyDown(Elite::eScancode_P))
+	{
+		//Dump the profile of the runtime tree and start a new one
+		BehaviorProfiler& profiler = m_pBehaviorTree->GetProfiler();
+		profiler.PrintBreakdown();
+		profiler.WriteCSV("BehaviorProfile.csv");
+		profiler.WriteJSON("BehaviorProfile.json");
+		profiler.WriteFoldedStacks("BehaviorProfile.folded");
+		profiler.Reset();
+	}
+#endif
 	else if (m_pInterface->Input_IsKeyboardKeyDown(Elite::eScancode_Q))
 	{
 		ItemInfo info = {};
@@ -345,6 +499,19 @@ void Plugin::Update(float dt)
 //This function calculates the new SteeringOutput, called once per frame
 SteeringPlugin_Output Plugin::UpdateSteering(float dt)
 {
+	UpdateBlackboard(dt);
+
+	//Update the behaviorTree (with the new data)
+	GetBehaviorTree(m_BehaviorTreeEngine)->Update(dt);
+
+	return GetSteeringOutput();
+}
+
+//Fills the blackboard with the data of this frame
+void Plugin::UpdateBlackboard(float dt)
+{
+	//Everything allocated from the frame arena last tick is gone
+	m_FrameArena.Reset();
 	//Clear all the data
 	ClearData();
 	//Reset State
@@ -355,10 +522,15 @@ SteeringPlugin_Output Plugin::UpdateSteering(float dt)
 	//Fill in the new data
 	//	Fill in the agent info and update blackboard
 	AgentInfo agentInfo = m_pInterface->Agent_GetInfo();
-	m_pBlackboard->ChangeData("PlayerInfo", agentInfo);
+	m_pBlackboard->ChangeData(BB_Keys::PlayerInfo, agentInfo);
+	UpdatePlayerKeys(agentInfo);
 	//	Fill in all the entities in the FOV in their respective categories and update blackboard
 	UpdateEntitiesFOV();
 	UpdateHousesFOV();
+	//	Wherever the agent is can be walked on, this is how the doors are found
+	m_pNavigationGrid->MarkWalkable(agentInfo.Position, agentInfo.AgentSize / 2.f);
+	//	Danger of everything in view, for fleeing
+	m_DangerField.Update(agentInfo.Position, m_EnemiesInFOV, m_PurgeZonesInFOV, m_pNavigationGrid);
 	//Update the timer on known houses so you will loot them again after some time
 	UpdateKnownHouses(dt);
 	//Update the fleeing timer
@@ -368,13 +540,13 @@ SteeringPlugin_Output Plugin::UpdateSteering(float dt)
 	UpdateIsRunningTimer(dt);
 	//Update danger timer
 	UpdateIsInDangerTimer(dt);
+}
 
-	//Update the behaviorTree (with the new data)
-	m_pBehaviorTree->Update(dt);
-
+SteeringPlugin_Output Plugin::GetSteeringOutput() const
+{
 	//Get the steering
 	SteeringPlugin_Output steering{};
-	bool steeringFound = m_pBlackboard->GetData("SteeringOutput", steering);
+	bool steeringFound = m_pBlackboard->GetData(BB_Keys::SteeringOutput, steering);
 	if (!steeringFound) {
 		std::cout << "Steering was not found in the blackboard" << std::endl;
 	}
@@ -389,103 +561,106 @@ void Plugin::Render(float dt) const
 	m_pInterface->Draw_SolidCircle(m_Target, .7f, { 0,0 }, { 1, 0, 0 });
 
 	Elite::Vector2 target{};
-	m_pBlackboard->GetData("Target", target);
+	m_pBlackboard->GetData(BB_Keys::Target, target);
 
 	m_pInterface->Draw_Point(target, 5.0f, Elite::Vector3{ 0, 1, 0 });
 }
 
-vector<HouseInfo> Plugin::GetHousesInFOV() const
-{
-	vector<HouseInfo> vHousesInFOV = {};
-
-	HouseInfo hi = {};
-	for (int i = 0;; ++i)
-	{
-		if (m_pInterface->Fov_GetHouseByIndex(i, hi))
-		{
-			vHousesInFOV.push_back(hi);
-			continue;
-		}
-
-		break;
-	}
-
-	return vHousesInFOV;
-}
-
-vector<EntityInfo> Plugin::GetEntitiesInFOV() const
-{
-	vector<EntityInfo> vEntitiesInFOV = {};
-
-	EntityInfo ei = {};
-	for (int i = 0;; ++i)
-	{
-		if (m_pInterface->Fov_GetEntityByIndex(i, ei))
-		{
-			vEntitiesInFOV.push_back(ei);
-			continue;
-		}
-
-		break;
-	}
-
-	return vEntitiesInFOV;
-}
-
 void Plugin::ClearData()
 {
+	//The lists are stored as pointers in the blackboard, they are only marked as changed when they were not empty
+	if (!m_ItemsInFOV.empty())
+		m_pBlackboard->MarkChanged(BB_Keys::ItemsInFOV);
+	if (!m_EnemiesInFOV.empty())
+		m_pBlackboard->MarkChanged(BB_Keys::EnemiesInFOV);
+	if (!m_PurgeZonesInFOV.empty())
+		m_pBlackboard->MarkChanged(BB_Keys::PurgeZonesInFOV);
+	if (!m_HousesInFOV.empty())
+		m_pBlackboard->MarkChanged(BB_Keys::HousesInFOV);
+
+	//Clearing keeps the capacity, so filling them again does not allocate once they are big enough
 	m_HousesInFOV.clear();
 	m_ItemsInFOV.clear();
 	m_EnemiesInFOV.clear();
 	m_PurgeZonesInFOV.clear();
 	//Now done with timers
-	//m_pBlackboard->ChangeData("CanRun", false);
-	//m_pBlackboard->ChangeData("WasFleeing", false);
+	//m_pBlackboard->ChangeData(BB_Keys::CanRun, false);
+	//m_pBlackboard->ChangeData(BB_Keys::WasFleeing, false);
+}
+
+//The keys are only written when their value changed, so their version tells the reactive tree whether to check them again
+void Plugin::UpdatePlayerKeys(const AgentInfo& agentInfo)
+{
+	float health{};
+	if (m_pBlackboard->GetData(BB_Keys::PlayerHealth, health) && health != agentInfo.Health) {
+		m_pBlackboard->ChangeData(BB_Keys::PlayerHealth, agentInfo.Health);
+	}
+	float energy{};
+	if (m_pBlackboard->GetData(BB_Keys::PlayerEnergy, energy) && energy != agentInfo.Energy) {
+		m_pBlackboard->ChangeData(BB_Keys::PlayerEnergy, agentInfo.Energy);
+	}
+	//Compared exactly, the == of Vector2 allows a small difference
+	Elite::Vector2 position{};
+	if (m_pBlackboard->GetData(BB_Keys::PlayerPosition, position) && (position.x != agentInfo.Position.x || position.y != agentInfo.Position.y)) {
+		m_pBlackboard->ChangeData(BB_Keys::PlayerPosition, agentInfo.Position);
+	}
+	bool isBitten{};
+	if (m_pBlackboard->GetData(BB_Keys::PlayerBitten, isBitten) && isBitten != agentInfo.Bitten) {
+		m_pBlackboard->ChangeData(BB_Keys::PlayerBitten, agentInfo.Bitten);
+	}
+	bool wasBitten{};
+	if (m_pBlackboard->GetData(BB_Keys::PlayerWasBitten, wasBitten) && wasBitten != agentInfo.WasBitten) {
+		m_pBlackboard->ChangeData(BB_Keys::PlayerWasBitten, agentInfo.WasBitten);
+	}
 }
 
 void Plugin::UpdateEntitiesFOV()
 {
-	std::vector<EntityInfo> entitiesInFOV = GetEntitiesInFOV();
-	
-	//Update the member variables then update the value in the blackboard
-	for (const EntityInfo& entity : entitiesInFOV) {
-		if (entity.Type == eEntityType::ITEM) {
+	//Sort the entities straight into their lists, which keep their capacity between frames
+	EntityInfo entity{};
+	for (UINT index = 0; m_pInterface->Fov_GetEntityByIndex(index, entity); ++index) {
+		switch (entity.Type) {
+		case eEntityType::ITEM:
 			//Keep the items as entities so it is easier to destroy them
 			m_ItemsInFOV.push_back(entity);
-		}
-		if (entity.Type == eEntityType::ENEMY) {
-			EnemyInfo enemyInfo{};
-			m_pInterface->Enemy_GetInfo(entity, enemyInfo);
-			m_EnemiesInFOV.push_back(enemyInfo);
-		}
-		if (entity.Type == eEntityType::PURGEZONE) {
-			PurgeZoneInfo purgeZoneInfo{};
-			m_pInterface->PurgeZone_GetInfo(entity, purgeZoneInfo);
-			m_PurgeZonesInFOV.push_back(purgeZoneInfo);
+			break;
+		case eEntityType::ENEMY:
+			m_EnemiesInFOV.emplace_back();
+			m_pInterface->Enemy_GetInfo(entity, m_EnemiesInFOV.back());
+			break;
+		case eEntityType::PURGEZONE:
+			m_PurgeZonesInFOV.emplace_back();
+			m_pInterface->PurgeZone_GetInfo(entity, m_PurgeZonesInFOV.back());
+			break;
+		default:
+			break;
 		}
 	}
+
+	if (!m_ItemsInFOV.empty())
+		m_pBlackboard->MarkChanged(BB_Keys::ItemsInFOV);
+	if (!m_EnemiesInFOV.empty())
+		m_pBlackboard->MarkChanged(BB_Keys::EnemiesInFOV);
+	if (!m_PurgeZonesInFOV.empty())
+		m_pBlackboard->MarkChanged(BB_Keys::PurgeZonesInFOV);
 }
 
 void Plugin::UpdateHousesFOV()
 {
-	std::vector<HouseInfo> housesInFOV = GetHousesInFOV();
-	//Update the member variable and update the blackboard
-	m_HousesInFOV = housesInFOV;
-	m_pBlackboard->ChangeData("HousesInFOV", m_HousesInFOV);
-
-	bool isNewHouse{ true };
-	//If it is a new house add it to the known houses
-	for (const HouseInfo& house : housesInFOV) {
-		for (const HouseSearch& houseSearch : m_KnownHouses) {
-			//If the centers are very close together, it means it is the same house
-			if (Elite::DistanceSquared(house.Center, houseSearch.Center) < houseSearch.acceptanceRadius * houseSearch.acceptanceRadius) {
-				isNewHouse = false;
-			}
-		}
-		//If you checked all the known houses and it is still true, it is a new house
-		if (isNewHouse) {
-			m_KnownHouses.push_back(HouseSearch(house));
-			//Data in Blackboard is automatically changed since it is a pointer
+	//Fill the member variable in place, the blackboard points to it
+	HouseInfo houseInfo{};
+	for (UINT index = 0; m_pInterface->Fov_GetHouseByIndex(index, houseInfo); ++index) {
+		m_HousesInFOV.push_back(houseInfo);
+	}
+	if (!m_HousesInFOV.empty())
+		m_pBlackboard->MarkChanged(BB_Keys::HousesInFOV);
+
+	//If it is a new house add it to the known houses, and its walls to the navigation grid
+	for (const HouseInfo& house : m_HousesInFOV) {
+		//Data in Blackboard is automatically changed since it is a pointer, it is marked changed for IsInsideHouse
+		if (m_KnownHouses.AddHouse(house)) {
+			m_pNavigationGrid->AddHouse(m_KnownHouses[m_KnownHouses.Size() - 1]);
+			m_pBlackboard->MarkChanged(BB_Keys::KnownHouses);
 		}
 	}
 }
@@ -500,12 +675,12 @@ void Plugin::UpdateKnownHouses(float dt)
 void Plugin::UpdateWasFleeingTimer(float dt)
 {
 	bool wasFleeing{};
-	m_pBlackboard->GetData("WasFleeing", wasFleeing);
+	m_pBlackboard->GetData(BB_Keys::WasFleeing, wasFleeing);
 
 	if (wasFleeing) {
 		m_WasFleeingTimer -= dt;
 		if (m_WasFleeingTimer <= 0) {
-			m_pBlackboard->ChangeData("WasFleeing", false);
+			m_pBlackboard->ChangeData(BB_Keys::WasFleeing, false);
 			m_WasFleeingTimer = m_MaxWasFleeingTime;
 		}
 	}
@@ -514,12 +689,12 @@ void Plugin::UpdateWasFleeingTimer(float dt)
 void Plugin::UpdateIsFleeingTimer(float dt)
 {
 	bool isFleeing{};
-	m_pBlackboard->GetData("IsFleeing", isFleeing);
+	m_pBlackboard->GetData(BB_Keys::IsFleeing, isFleeing);
 
 	if (isFleeing) {
 		m_IsFleeingTimer -= dt;
 		if (m_IsFleeingTimer <= 0) {
-			m_pBlackboard->ChangeData("IsFleeing", false);
+			m_pBlackboard->ChangeData(BB_Keys::IsFleeing, false);
 			m_IsFleeingTimer = m_MaxIsFleeingTime;
 		}
 	}
@@ -528,12 +703,12 @@ void Plugin::UpdateIsFleeingTimer(float dt)
 void Plugin::UpdateIsRunningTimer(float dt)
 {
 	bool canRun{};
-	m_pBlackboard->GetData("CanRun", canRun);
+	m_pBlackboard->GetData(BB_Keys::CanRun, canRun);
 
 	if (canRun) {
 		m_IsRunningTimer -= dt;
 		if (m_IsRunningTimer <= 0) {
-			m_pBlackboard->ChangeData("CanRun", false);
+			m_pBlackboard->ChangeData(BB_Keys::CanRun, false);
 			m_IsRunningTimer = m_MaxRunningTime;
 		}
 	}
@@ -542,12 +717,12 @@ void Plugin::UpdateIsRunningTimer(float dt)
 void Plugin::UpdateIsInDangerTimer(float dt)
 {
 	bool isInDanger{};
-	m_pBlackboard->GetData("IsInDanger", isInDanger);
+	m_pBlackboard->GetData(BB_Keys::IsInDanger, isInDanger);
 
 	if (isInDanger) {
 		m_IsInDangerTimer -= dt;
 		if (m_IsInDangerTimer <= 0) {
-			m_pBlackboard->ChangeData("IsInDanger", false);
+			m_pBlackboard->ChangeData(BB_Keys::IsInDanger, false);
 			m_IsInDangerTimer = m_MaxDangerTime;
 		}
 	}
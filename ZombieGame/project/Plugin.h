@@ -2,12 +2,29 @@
 #include "IExamPlugin.h"
 #include "Exam_HelperStructs.h"
 #include "Structs.h"
+#include "KnownHouses.h"
+#include "KnownItems.h"
+#include "EnemyThreats.h"
+#include "PathCache.h"
+#include "DangerField.h"
+#include "EFrameArena.h"
 
 class IBaseInterface;
 class IExamInterface;
 class Blackboard;
 class BehaviorTree;
+class IDecisionMaking;
 class Inventory;
+class NavigationGrid;
+
+//Engine used to update the behavior tree, all of them run the same tree
+enum class BehaviorTreeEngine
+{
+	Runtime,
+	Flat,
+	Reactive, //Flat tree that skips subtrees whose inputs did not change
+	Static
+};
 
 class Plugin :public IExamPlugin
 {
@@ -25,11 +42,22 @@ public:
 	SteeringPlugin_Output UpdateSteering(float dt) override;
 	void Render(float dt) const override;
 
+	//Used by offline tools like the headless simulator
+	void SetBehaviorTreeEngine(BehaviorTreeEngine engine) { m_BehaviorTreeEngine = engine; }
+	IDecisionMaking* GetBehaviorTree(BehaviorTreeEngine engine) const;
+	Blackboard* GetBlackboard() const { return m_pBlackboard; }
+	const Inventory* GetInventory() const { return m_pInventory; }
+	const PathCache* GetPathCache() const { return &m_PathCache; }
+	const DangerField* GetDangerField() const { return &m_DangerField; }
+	const FrameArena* GetFrameArena() const { return &m_FrameArena; }
+	NavigationGrid* GetNavigationGrid() const { return m_pNavigationGrid; }
+	//The steps of UpdateSteering around the behavior tree update, for a tree that is updated by the caller
+	void UpdateBlackboard(float dt);
+	SteeringPlugin_Output GetSteeringOutput() const;
+
 private:
 	//Interface, used to request data from/perform actions with the AI Framework
 	IExamInterface* m_pInterface = nullptr;
-	std::vector<HouseInfo> GetHousesInFOV() const;
-	std::vector<EntityInfo> GetEntitiesInFOV() const;
 
 	Elite::Vector2 m_Target = {};
 	bool m_CanRun = false; //Demo purpose
@@ -55,18 +83,30 @@ private:
 
 	Blackboard* m_pBlackboard{ nullptr };
 	BehaviorTree* m_pBehaviorTree{nullptr};
+	IDecisionMaking* m_pFlatBehaviorTree{ nullptr };
+	IDecisionMaking* m_pReactiveBehaviorTree{ nullptr };
+	IDecisionMaking* m_pStaticBehaviorTree{ nullptr };
+	BehaviorTreeEngine m_BehaviorTreeEngine{ BehaviorTreeEngine::Static };
 	Inventory* m_pInventory{ nullptr };
 
 	std::vector<EntityInfo> m_ItemsInFOV{};
 	std::vector<EnemyInfo> m_EnemiesInFOV{};
+	EnemyThreats m_EnemyThreats{};
 	std::vector<PurgeZoneInfo> m_PurgeZonesInFOV{};
 	std::vector<HouseInfo> m_HousesInFOV{};
-
-	std::vector<HouseSearch> m_KnownHouses{};
-	std::vector<ItemInfo> m_KnownItems{};
+	std::vector<eItemType> m_NeededItemTypes{};
+	//Scratch data of one tick, reset at the start of every tick
+	FrameArena m_FrameArena{};
+
+	KnownHouses m_KnownHouses{};
+	KnownItems m_KnownItems{};
+	PathCache m_PathCache{};
+	DangerField m_DangerField{};
 	WorldSearch* m_pWorldSearch{};
+	NavigationGrid* m_pNavigationGrid{};
 
 	void ClearData();
+	void UpdatePlayerKeys(const AgentInfo& agentInfo);
 	void UpdateEntitiesFOV();
 	void UpdateHousesFOV();
 	void UpdateKnownHouses(float dt);
@@ -81,8 +121,5 @@ private:
 //The plugin returned by this function is also the plugin used by the host program
 extern "C"
 {
-	__declspec (dllexport) IPluginBase* Register()
-	{
-		return new Plugin();
-	}
+	__declspec (dllexport) IPluginBase* Register();
 }
\ No newline at end of file
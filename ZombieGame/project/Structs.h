@@ -1,7 +1,14 @@
 #pragma once
 
 #include "stdafx.h"
-#include "Plugin.h"
+#include "Exam_HelperStructs.h"
+
+//Key of a cell of a uniform grid, x in the high 32 bits and y in the low 32 bits
+//Built from the unsigned bit patterns, shifting a negative signed value is undefined
+inline unsigned long long GetGridCellKey(int x, int y)
+{
+	return (static_cast<unsigned long long>(static_cast<unsigned int>(x)) << 32) | static_cast<unsigned int>(y);
+}
 
 struct HouseSearch : public HouseInfo {
 
@@ -52,6 +59,7 @@ struct HouseSearch : public HouseInfo {
 	}
 
 	void GenerateSearchLocations() {
+		searchLocations.reserve(5);
 		Elite::Vector2 bottomLeftCenter{Center.x - Size.x/3.f + wallThickness, Center.y - Size.y/3.f + wallThickness};
 		Elite::Vector2 bottomRightCenter{ Center.x + Size.x / 3.f - wallThickness, Center.y - Size.y / 3.f + wallThickness };
 		Elite::Vector2 topLeftCenter{ Center.x - Size.x / 3.f + wallThickness, Center.y + Size.y / 3.f - wallThickness };
@@ -0,0 +1,972 @@
+#include "stdafx.h"
+#include "HeadlessWorld.h"
+
+namespace
+{
+	//World
+	const float WorldSize{ 400.f };
+	const float HouseGridSize{ 60.f };
+	const float HouseChance{ 0.6f };
+	const float WallThickness{ 1.f };
+	const float DoorWidth{ 5.f };
+	const float NavigationMargin{ 2.f };
+	const float ItemInHouseChance{ 0.7f };
+
+	//Agent
+	const float AgentMaxHealth{ 10.f };
+	const float AgentMaxEnergy{ 10.f };
+	const float AgentMaxStamina{ 10.f };
+	const float AgentWalkSpeed{ 5.f };
+	const float AgentRunMultiplier{ 2.f };
+	const float EnergyDrainPerSecond{ 0.05f };
+	const float StarvationDamagePerSecond{ 0.2f };
+	const float StaminaDrainPerSecond{ 1.f };
+	const float StaminaRegenPerSecond{ 0.5f };
+	const float WasBittenTime{ 0.5f };
+	const UINT InventoryCapacity{ 5 };
+
+	//Enemies
+	const float EnemyDetectionRange{ 20.f };
+	const float EnemyBiteCooldown{ 1.f };
+
+	//Purge zones
+	const float PurgeZoneMinInterval{ 40.f };
+	const float PurgeZoneMaxInterval{ 90.f };
+	const float PurgeZoneDelay{ 5.f };
+	const float PurgeZoneLingerTime{ 1.f };
+
+	//The host uses the exact trig functions, the plugin gets the fast ones from EliteMath
+	Elite::Vector2 GetDirection(float orientation)
+	{
+		return Elite::Vector2(cos(orientation), sin(orientation));
+	}
+
+	float GetOrientation(const Elite::Vector2& direction)
+	{
+		return atan2f(direction.y, direction.x);
+	}
+}
+
+//-----------------------------------------------------------------
+// PLUGIN BASE
+//-----------------------------------------------------------------
+//Normally provided by GPP_PluginBase.lib, which only exists for Windows
+IBaseInterface::IBaseInterface() {}
+IBaseInterface::~IBaseInterface() {}
+void IBaseInterface::Draw_Polygon(const Elite::Vector2* points, int count, const Elite::Vector3& color) { Draw_Polygon(points, count, color, NextDepthSlice()); }
+void IBaseInterface::Draw_SolidPolygon(const Elite::Vector2* points, int count, const Elite::Vector3& color) { Draw_SolidPolygon(points, count, color, NextDepthSlice(), false); }
+void IBaseInterface::Draw_Circle(const Elite::Vector2& center, float radius, const Elite::Vector3& color) { Draw_Circle(center, radius, color, NextDepthSlice()); }
+void IBaseInterface::Draw_SolidCircle(const Elite::Vector2& center, float32 radius, const Elite::Vector2& axis, const Elite::Vector3& color) { Draw_SolidCircle(center, radius, axis, color, NextDepthSlice()); }
+void IBaseInterface::Draw_Segment(const Elite::Vector2& p1, const Elite::Vector2& p2, const Elite::Vector3& color) { Draw_Segment(p1, p2, color, NextDepthSlice()); }
+void IBaseInterface::Draw_Transform(const b2Transform& xf) { Draw_Transform(xf, NextDepthSlice()); }
+void IBaseInterface::Draw_Point(const Elite::Vector2& p, float size, const Elite::Vector3& color) { Draw_Point(p, size, color, NextDepthSlice()); }
+
+IExamInterface::IExamInterface() {}
+IExamInterface::~IExamInterface() {}
+
+//-----------------------------------------------------------------
+// HEADLESS WORLD
+//-----------------------------------------------------------------
+HeadlessWorld::HeadlessWorld(const GameDebugParams& params)
+	: m_Params{ params },
+	m_Rng{ params.Seed >= 0 ? unsigned(params.Seed) : std::random_device{}() }
+{
+	m_WorldInfo.Center = Elite::Vector2{ 0.f, 0.f };
+	m_WorldInfo.Dimensions = Elite::Vector2{ WorldSize, WorldSize };
+
+	m_Stats = StatisticsInfo{};
+	m_Stats.Difficulty = float(params.StartingDifficultyStage);
+
+	m_Agent = AgentInfo{};
+	m_Agent.Stamina = AgentMaxStamina;
+	m_Agent.Health = AgentMaxHealth;
+	m_Agent.Energy = AgentMaxEnergy;
+	m_Agent.FOV_Angle = float(E_PI_2);
+	m_Agent.FOV_Range = 25.f;
+	m_Agent.Position = m_WorldInfo.Center;
+	m_Agent.MaxLinearSpeed = AgentWalkSpeed;
+	m_Agent.MaxAngularSpeed = float(E_PI);
+	m_Agent.GrabRange = 3.f;
+	m_Agent.AgentSize = 1.f;
+
+	m_Inventory.resize(InventoryCapacity);
+	m_PurgeZoneSpawnTimer = RandomFloat(PurgeZoneMinInterval, PurgeZoneMaxInterval);
+
+	GenerateHouses();
+	GenerateNavigationGraph();
+	for (int index{}; index < params.ItemCount; ++index)
+		SpawnItem();
+	if (params.SpawnEnemies)
+	{
+		for (int index{}; index < params.EnemyCount; ++index)
+			SpawnEnemy();
+	}
+
+	//Debug weapons are dropped right next to the agent
+	const eItemType debugWeapons[]{ eItemType::PISTOL, eItemType::SHOTGUN };
+	const bool spawnDebugWeapons[]{ params.SpawnDebugPistol, params.SpawnDebugShotgun };
+	for (int index{}; index < 2; ++index)
+	{
+		if (!spawnDebugWeapons[index])
+			continue;
+		WorldItem item{};
+		item.Info.Type = debugWeapons[index];
+		item.Info.Location = m_Agent.Position + Elite::Vector2{ 1.f + index, 1.f };
+		item.Info.ItemHash = m_NextHash++;
+		item.Value = 1000;
+		m_Items.push_back(item);
+	}
+
+	UpdatePerception();
+}
+
+#pragma region Generation
+void HeadlessWorld::GenerateHouses()
+{
+	const float halfWorld{ WorldSize / 2.f };
+	for (float x{ -halfWorld + HouseGridSize / 2.f }; x < halfWorld; x += HouseGridSize)
+	{
+		for (float y{ -halfWorld + HouseGridSize / 2.f }; y < halfWorld; y += HouseGridSize)
+		{
+			//Keep the spawn of the agent free
+			if (abs(x) < HouseGridSize && abs(y) < HouseGridSize)
+				continue;
+			if (RandomFloat(0.f, 1.f) > HouseChance)
+				continue;
+
+			HouseInfo house{};
+			house.Size = Elite::Vector2{ RandomFloat(20.f, 40.f), RandomFloat(20.f, 40.f) };
+			const float jitterX{ (HouseGridSize - house.Size.x) / 2.f - 2.f };
+			const float jitterY{ (HouseGridSize - house.Size.y) / 2.f - 2.f };
+			house.Center = Elite::Vector2{ x + RandomFloat(-jitterX, jitterX), y + RandomFloat(-jitterY, jitterY) };
+			m_Houses.push_back(house);
+		}
+	}
+}
+
+void HeadlessWorld::GenerateNavigationGraph()
+{
+	//Walk around houses with some distance to the walls, corners that end up in another house are skipped
+	for (const HouseInfo& house : m_Houses)
+	{
+		const Elite::Vector2 halfSize{ house.Size / 2.f + Elite::Vector2{ NavigationMargin, NavigationMargin } };
+		const Elite::Vector2 corners[]{
+			house.Center + Elite::Vector2{ -halfSize.x, -halfSize.y },
+			house.Center + Elite::Vector2{ halfSize.x, -halfSize.y },
+			house.Center + Elite::Vector2{ halfSize.x, halfSize.y },
+			house.Center + Elite::Vector2{ -halfSize.x, halfSize.y } };
+		for (const Elite::Vector2& corner : corners)
+		{
+			if (!IsBlockedByHouse(corner, corner))
+				m_NavigationNodes.push_back(corner);
+		}
+	}
+
+	m_NavigationEdges.resize(m_NavigationNodes.size());
+	for (unsigned int from{}; from < m_NavigationNodes.size(); ++from)
+	{
+		for (unsigned int to{ from + 1 }; to < m_NavigationNodes.size(); ++to)
+		{
+			if (IsBlockedByHouse(m_NavigationNodes[from], m_NavigationNodes[to]))
+				continue;
+			m_NavigationEdges[from].push_back(to);
+			m_NavigationEdges[to].push_back(from);
+		}
+	}
+}
+
+void HeadlessWorld::SpawnItem()
+{
+	WorldItem item{};
+	item.Info.ItemHash = m_NextHash++;
+
+	const float roll{ RandomFloat(0.f, 1.f) };
+	if (roll < 0.2f)
+	{
+		item.Info.Type = eItemType::PISTOL;
+		item.Value = RandomInt(8, 20);
+	}
+	else if (roll < 0.3f)
+	{
+		item.Info.Type = eItemType::SHOTGUN;
+		item.Value = RandomInt(4, 10);
+	}
+	else if (roll < 0.5f)
+	{
+		item.Info.Type = eItemType::MEDKIT;
+		item.Value = RandomInt(2, 6);
+	}
+	else if (roll < 0.8f)
+	{
+		item.Info.Type = eItemType::FOOD;
+		item.Value = RandomInt(3, 8);
+	}
+	else
+	{
+		item.Info.Type = eItemType::GARBAGE;
+	}
+
+	if (!m_Houses.empty() && RandomFloat(0.f, 1.f) < ItemInHouseChance)
+	{
+		const HouseInfo& house = m_Houses[RandomInt(0, int(m_Houses.size()) - 1)];
+		const Elite::Vector2 halfInside{ house.Size / 2.f - Elite::Vector2{ WallThickness + 1.f, WallThickness + 1.f } };
+		item.Info.Location = house.Center + Elite::Vector2{ RandomFloat(-halfInside.x, halfInside.x), RandomFloat(-halfInside.y, halfInside.y) };
+	}
+	else
+	{
+		item.Info.Location = GetRandomFreePosition(0.f);
+	}
+
+	m_Items.push_back(item);
+}
+
+void HeadlessWorld::SpawnEnemy()
+{
+	WorldEnemy enemy{};
+	enemy.Info.EnemyHash = m_NextHash++;
+	enemy.Info.Location = GetRandomFreePosition(40.f);
+
+	const float roll{ RandomFloat(0.f, 1.f) };
+	if (roll < 0.6f)
+	{
+		enemy.Info.Type = eEnemyType::ZOMBIE_NORMAL;
+		enemy.Info.Size = 1.5f;
+		enemy.Info.Health = 2.f;
+	}
+	else if (roll < 0.85f)
+	{
+		enemy.Info.Type = eEnemyType::ZOMBIE_RUNNER;
+		enemy.Info.Size = 1.f;
+		enemy.Info.Health = 1.f;
+	}
+	else
+	{
+		enemy.Info.Type = eEnemyType::ZOMBIE_HEAVY;
+		enemy.Info.Size = 2.5f;
+		enemy.Info.Health = 5.f;
+	}
+
+	m_Enemies.push_back(enemy);
+}
+
+void HeadlessWorld::SpawnPurgeZone()
+{
+	WorldPurgeZone zone{};
+	zone.Info.ZoneHash = m_NextHash++;
+	zone.Info.Radius = RandomFloat(10.f, 25.f);
+	//Spawn close to the agent, otherwise it never has to deal with it
+	zone.Info.Center = m_Agent.Position + Elite::Vector2{ RandomFloat(-40.f, 40.f), RandomFloat(-40.f, 40.f) };
+	zone.TimeUntilPurge = PurgeZoneDelay;
+	zone.TimeToLive = PurgeZoneDelay + PurgeZoneLingerTime;
+	m_PurgeZones.push_back(zone);
+}
+
+Elite::Vector2 HeadlessWorld::GetRandomFreePosition(float minDistanceToAgent)
+{
+	const float halfWorld{ WorldSize / 2.f };
+	Elite::Vector2 position{};
+	for (int attempt{}; attempt < 100; ++attempt)
+	{
+		position = Elite::Vector2{ RandomFloat(-halfWorld, halfWorld), RandomFloat(-halfWorld, halfWorld) };
+		if (GetHouseContaining(position) == nullptr && Elite::DistanceSquared(position, m_Agent.Position) >= minDistanceToAgent * minDistanceToAgent)
+			break;
+	}
+	return position;
+}
+
+//mt19937 gives the same numbers everywhere, the std distributions do not,
+//so the numbers are mapped to a range here to get the same world from a seed with every standard library
+float HeadlessWorld::RandomFloat(float min, float max)
+{
+	//The 24 high bits fill the mantissa exactly, a value in [0, 1)
+	const float unit{ float(uint32_t(m_Rng()) >> 8) * (1.f / 16777216.f) };
+	return min + unit * (max - min);
+}
+
+int HeadlessWorld::RandomInt(int min, int max)
+{
+	//Multiply and shift instead of a modulo, in [min, max]
+	const uint64_t range{ uint64_t(int64_t(max) - int64_t(min) + 1) };
+	return int(int64_t(min) + int64_t((uint64_t(uint32_t(m_Rng())) * range) >> 32));
+}
+#pragma endregion
+
+#pragma region Simulation
+void HeadlessWorld::UpdatePerception()
+{
+	m_EntitiesInFOV.clear();
+	m_HousesInFOV.clear();
+
+	for (const WorldItem& item : m_Items)
+	{
+		if (IsInFOV(item.Info.Location))
+			m_EntitiesInFOV.push_back(EntityInfo{ eEntityType::ITEM, item.Info.Location, item.Info.ItemHash });
+	}
+	for (const WorldEnemy& enemy : m_Enemies)
+	{
+		if (IsInFOV(enemy.Info.Location))
+			m_EntitiesInFOV.push_back(EntityInfo{ eEntityType::ENEMY, enemy.Info.Location, enemy.Info.EnemyHash });
+	}
+	for (const WorldPurgeZone& zone : m_PurgeZones)
+	{
+		//Purge zones are big, they are seen as soon as their edge is within range
+		if (Elite::Distance(zone.Info.Center, m_Agent.Position) - zone.Info.Radius <= m_Agent.FOV_Range)
+			m_EntitiesInFOV.push_back(EntityInfo{ eEntityType::PURGEZONE, zone.Info.Center, zone.Info.ZoneHash });
+	}
+
+	const HouseInfo* pCurrentHouse = GetHouseContaining(m_Agent.Position);
+	for (const HouseInfo& house : m_Houses)
+	{
+		const Elite::Vector2 halfSize{ house.Size / 2.f };
+		const bool isVisible = &house == pCurrentHouse || IsInFOV(house.Center) ||
+			IsInFOV(house.Center + Elite::Vector2{ -halfSize.x, -halfSize.y }) || IsInFOV(house.Center + Elite::Vector2{ halfSize.x, -halfSize.y }) ||
+			IsInFOV(house.Center + Elite::Vector2{ -halfSize.x, halfSize.y }) || IsInFOV(house.Center + Elite::Vector2{ halfSize.x, halfSize.y });
+		if (isVisible)
+			m_HousesInFOV.push_back(house);
+	}
+}
+
+void HeadlessWorld::Step(const SteeringPlugin_Output& steering, float dt)
+{
+	if (m_Agent.Death)
+		return;
+
+	m_Agent.Bitten = false;
+	MoveAgent(steering, dt);
+	UpdateEnemies(dt);
+	UpdatePurgeZones(dt);
+	UpdateAgentStats(dt);
+
+	m_Stats.TimeSurvived += dt;
+	m_Stats.Difficulty = float(m_Params.StartingDifficultyStage) + m_Stats.TimeSurvived / 300.f;
+	m_Stats.Score = int(m_Stats.TimeSurvived) + 10 * m_Stats.NumEnemiesKilled;
+}
+
+void HeadlessWorld::MoveAgent(const SteeringPlugin_Output& steering, float dt)
+{
+	const bool canRun{ steering.RunMode && (m_Params.InfiniteStamina || m_Agent.Stamina > 0.f) };
+	m_Agent.RunMode = canRun;
+
+	const float maxSpeed{ m_Agent.MaxLinearSpeed * (canRun ? AgentRunMultiplier : 1.f) };
+	Elite::Vector2 velocity{ steering.LinearVelocity };
+	if (velocity.MagnitudeSquared() > maxSpeed * maxSpeed)
+		velocity = velocity.GetNormalized() * maxSpeed;
+
+	const float halfWorld{ WorldSize / 2.f };
+	Elite::Vector2 target{ m_Agent.Position + velocity * dt };
+	target.x = Elite::Clamp(target.x, -halfWorld, halfWorld);
+	target.y = Elite::Clamp(target.y, -halfWorld, halfWorld);
+
+	const Elite::Vector2 previousPosition{ m_Agent.Position };
+	m_Agent.Position = ResolveWallCollision(m_Agent.Position, target, m_Agent.AgentSize / 2.f);
+	m_Agent.LinearVelocity = (m_Agent.Position - previousPosition) / dt;
+	m_Agent.CurrentLinearSpeed = m_Agent.LinearVelocity.Magnitude();
+
+	if (steering.AutoOrient)
+	{
+		m_Agent.AngularVelocity = 0.f;
+		if (m_Agent.CurrentLinearSpeed > 0.01f)
+			m_Agent.Orientation = GetOrientation(m_Agent.LinearVelocity);
+	}
+	else
+	{
+		m_Agent.AngularVelocity = Elite::Clamp(steering.AngularVelocity, -m_Agent.MaxAngularSpeed, m_Agent.MaxAngularSpeed);
+		m_Agent.Orientation = Elite::ClampedAngle(m_Agent.Orientation + m_Agent.AngularVelocity * dt);
+	}
+
+	m_Agent.IsInHouse = GetHouseContaining(m_Agent.Position) != nullptr;
+}
+
+void HeadlessWorld::UpdateEnemies(float dt)
+{
+	for (WorldEnemy& enemy : m_Enemies)
+	{
+		float speed{};
+		float damage{};
+		switch (enemy.Info.Type)
+		{
+		case eEnemyType::ZOMBIE_RUNNER:
+			speed = 6.f;
+			damage = 1.f;
+			break;
+		case eEnemyType::ZOMBIE_HEAVY:
+			speed = 2.5f;
+			damage = 2.f;
+			break;
+		default:
+			speed = 3.5f;
+			damage = 1.f;
+			break;
+		}
+
+		const Elite::Vector2 toAgent{ m_Agent.Position - enemy.Info.Location };
+		if (toAgent.MagnitudeSquared() < EnemyDetectionRange * EnemyDetectionRange)
+		{
+			//Chase the agent
+			enemy.Info.LinearVelocity = toAgent.GetNormalized() * speed;
+		}
+		else if (enemy.Info.LinearVelocity.MagnitudeSquared() < 0.01f || RandomFloat(0.f, 1.f) < dt * 0.5f)
+		{
+			//Wander, every now and then pick a new direction
+			const float angle{ RandomFloat(-float(E_PI), float(E_PI)) };
+			enemy.Info.LinearVelocity = GetDirection(angle) * speed * 0.5f;
+		}
+
+		const Elite::Vector2 target{ enemy.Info.Location + enemy.Info.LinearVelocity * dt };
+		enemy.Info.Location = ResolveWallCollision(enemy.Info.Location, target, enemy.Info.Size / 2.f);
+
+		//Bite the agent when close enough
+		enemy.BiteCooldown -= dt;
+		const float biteRange{ enemy.Info.Size / 2.f + m_Agent.AgentSize / 2.f + 0.3f };
+		if (enemy.BiteCooldown <= 0.f && Elite::DistanceSquared(enemy.Info.Location, m_Agent.Position) < biteRange * biteRange)
+		{
+			enemy.BiteCooldown = EnemyBiteCooldown;
+			m_Agent.Bitten = true;
+			m_Agent.WasBitten = true;
+			m_WasBittenTimer = WasBittenTime;
+			DamageAgent(damage);
+		}
+	}
+}
+
+void HeadlessWorld::UpdatePurgeZones(float dt)
+{
+	m_PurgeZoneSpawnTimer -= dt;
+	if (m_PurgeZoneSpawnTimer <= 0.f)
+	{
+		SpawnPurgeZone();
+		m_PurgeZoneSpawnTimer = RandomFloat(PurgeZoneMinInterval, PurgeZoneMaxInterval);
+	}
+
+	for (WorldPurgeZone& zone : m_PurgeZones)
+	{
+		const bool wasArmed{ zone.TimeUntilPurge > 0.f };
+		zone.TimeUntilPurge -= dt;
+		zone.TimeToLive -= dt;
+		if (!wasArmed || zone.TimeUntilPurge > 0.f)
+			continue;
+
+		//Purge everything that is inside
+		const float radiusSquared{ zone.Info.Radius * zone.Info.Radius };
+		if (Elite::DistanceSquared(zone.Info.Center, m_Agent.Position) < radiusSquared)
+			DamageAgent(1000.f);
+
+		const size_t enemyCount{ m_Enemies.size() };
+		m_Enemies.erase(std::remove_if(m_Enemies.begin(), m_Enemies.end(), [&zone, radiusSquared](const WorldEnemy& enemy) {
+			return Elite::DistanceSquared(zone.Info.Center, enemy.Info.Location) < radiusSquared;
+			}), m_Enemies.end());
+		for (size_t index{ m_Enemies.size() }; index < enemyCount; ++index)
+			SpawnEnemy();
+	}
+
+	m_PurgeZones.erase(std::remove_if(m_PurgeZones.begin(), m_PurgeZones.end(), [](const WorldPurgeZone& zone) {
+		return zone.TimeToLive <= 0.f;
+		}), m_PurgeZones.end());
+}
+
+void HeadlessWorld::UpdateAgentStats(float dt)
+{
+	m_WasBittenTimer -= dt;
+	if (m_WasBittenTimer <= 0.f)
+		m_Agent.WasBitten = false;
+
+	if (!m_Params.InfiniteStamina)
+	{
+		if (m_Agent.RunMode && m_Agent.CurrentLinearSpeed > 0.f)
+			m_Agent.Stamina = std::max(0.f, m_Agent.Stamina - StaminaDrainPerSecond * dt);
+		else
+			m_Agent.Stamina = std::min(AgentMaxStamina, m_Agent.Stamina + StaminaRegenPerSecond * dt);
+	}
+
+	if (!m_Params.IgnoreEnergy)
+	{
+		m_Agent.Energy = std::max(0.f, m_Agent.Energy - EnergyDrainPerSecond * dt);
+		if (m_Agent.Energy <= 0.f)
+			DamageAgent(StarvationDamagePerSecond * dt);
+	}
+}
+
+void HeadlessWorld::DamageAgent(float damage)
+{
+	if (m_Params.GodMode)
+		return;
+
+	m_Agent.Health -= damage;
+	if (m_Agent.Health <= 0.f)
+	{
+		m_Agent.Health = 0.f;
+		m_Agent.Death = true;
+	}
+}
+
+void HeadlessWorld::Shoot(float range, float spread, float damage)
+{
+	const Elite::Vector2 forward{ GetDirection(m_Agent.Orientation) };
+	int closestIndex{ -1 };
+	float closestDistance{ FLT_MAX };
+	std::vector<int>& hitIndices{ m_HitIndices };
+	hitIndices.clear();
+
+	for (int index{}; index < int(m_Enemies.size()); ++index)
+	{
+		const EnemyInfo& enemy = m_Enemies[index].Info;
+		const Elite::Vector2 toEnemy{ enemy.Location - m_Agent.Position };
+		const float alongRay{ toEnemy.Dot(forward) };
+		if (alongRay <= 0.f || alongRay > range)
+			continue;
+
+		//Hit when the enemy touches the ray, or when it is inside the spread of the weapon
+		const float fromRay{ abs(toEnemy.Cross(forward)) };
+		if (fromRay > enemy.Size / 2.f && fromRay > alongRay * tanf(spread))
+			continue;
+
+		hitIndices.push_back(index);
+		if (alongRay < closestDistance)
+		{
+			closestDistance = alongRay;
+			closestIndex = index;
+		}
+	}
+
+	if (closestIndex < 0)
+	{
+		++m_Stats.NumMissedShots;
+		return;
+	}
+
+	//Without spread the bullet stops at the first enemy
+	if (spread <= 0.f)
+		hitIndices.assign(1, closestIndex);
+
+	for (int index : hitIndices)
+	{
+		m_Enemies[index].Info.Health -= damage;
+		++m_Stats.NumEnemiesHit;
+	}
+
+	const size_t enemyCount{ m_Enemies.size() };
+	m_Enemies.erase(std::remove_if(m_Enemies.begin(), m_Enemies.end(), [](const WorldEnemy& enemy) {
+		return enemy.Info.Health <= 0.f;
+		}), m_Enemies.end());
+	for (size_t index{ m_Enemies.size() }; index < enemyCount; ++index)
+	{
+		++m_Stats.NumEnemiesKilled;
+		SpawnEnemy();
+	}
+}
+
+Elite::Vector2 HeadlessWorld::ResolveWallCollision(const Elite::Vector2& from, const Elite::Vector2& to, float radius) const
+{
+	auto isInWall = [this, radius](const Elite::Vector2& point) {
+		for (const HouseInfo& house : m_Houses)
+		{
+			const Elite::Vector2 local{ point - house.Center };
+			const Elite::Vector2 halfOuter{ house.Size / 2.f + Elite::Vector2{ radius, radius } };
+			const Elite::Vector2 halfInner{ house.Size / 2.f - Elite::Vector2{ WallThickness + radius, WallThickness + radius } };
+			if (abs(local.x) >= halfOuter.x || abs(local.y) >= halfOuter.y)
+				continue;
+			if (abs(local.x) < halfInner.x && abs(local.y) < halfInner.y)
+				continue;
+			//The door is in the middle of the bottom wall
+			if (local.y < 0.f && abs(local.x) < DoorWidth / 2.f - radius)
+				continue;
+			return true;
+		}
+		return false;
+	};
+
+	if (!isInWall(to))
+		return to;
+	//Slide along the wall
+	if (!isInWall(Elite::Vector2{ to.x, from.y }))
+		return Elite::Vector2{ to.x, from.y };
+	if (!isInWall(Elite::Vector2{ from.x, to.y }))
+		return Elite::Vector2{ from.x, to.y };
+	return from;
+}
+#pragma endregion
+
+#pragma region Queries
+bool HeadlessWorld::IsInFOV(const Elite::Vector2& position) const
+{
+	const Elite::Vector2 toPosition{ position - m_Agent.Position };
+	if (toPosition.MagnitudeSquared() > m_Agent.FOV_Range * m_Agent.FOV_Range)
+		return false;
+
+	const float angle{ Elite::ClampedAngle(GetOrientation(toPosition) - m_Agent.Orientation) };
+	return abs(angle) <= m_Agent.FOV_Angle / 2.f;
+}
+
+const HouseInfo* HeadlessWorld::GetHouseContaining(const Elite::Vector2& position, float margin) const
+{
+	for (const HouseInfo& house : m_Houses)
+	{
+		const Elite::Vector2 local{ position - house.Center };
+		if (abs(local.x) < house.Size.x / 2.f + margin && abs(local.y) < house.Size.y / 2.f + margin)
+			return &house;
+	}
+	return nullptr;
+}
+
+bool HeadlessWorld::IsBlockedByHouse(const Elite::Vector2& from, const Elite::Vector2& to) const
+{
+	const Elite::Vector2 direction{ to - from };
+	for (const HouseInfo& house : m_Houses)
+	{
+		//Slab test of the segment against the bounds of the house, a bit smaller than the agent radius
+		//so an agent touching a wall can still move away from it
+		const Elite::Vector2 halfSize{ house.Size / 2.f + Elite::Vector2{ 0.4f, 0.4f } };
+		float entry{ 0.f };
+		float exit{ 1.f };
+		bool isMissed{ false };
+		for (unsigned int axis{}; axis < 2 && !isMissed; ++axis)
+		{
+			const float minBound{ house.Center[axis] - halfSize[axis] };
+			const float maxBound{ house.Center[axis] + halfSize[axis] };
+			if (abs(direction[axis]) < FLT_EPSILON)
+			{
+				isMissed = from[axis] < minBound || from[axis] > maxBound;
+				continue;
+			}
+			float t0{ (minBound - from[axis]) / direction[axis] };
+			float t1{ (maxBound - from[axis]) / direction[axis] };
+			if (t0 > t1)
+				std::swap(t0, t1);
+			entry = std::max(entry, t0);
+			exit = std::min(exit, t1);
+			isMissed = entry > exit;
+		}
+
+		if (!isMissed)
+			return true;
+	}
+	return false;
+}
+
+Elite::Vector2 HeadlessWorld::GetDoor(const HouseInfo& house, bool isInside) const
+{
+	const float bottom{ house.Center.y - house.Size.y / 2.f };
+	const float offset{ WallThickness + 1.5f };
+	return Elite::Vector2{ house.Center.x, isInside ? bottom + offset : bottom - offset };
+}
+
+HeadlessWorld::WorldItem* HeadlessWorld::FindItem(int itemHash)
+{
+	for (WorldItem& item : m_Items)
+	{
+		if (item.Info.ItemHash == itemHash)
+			return &item;
+	}
+	return nullptr;
+}
+
+HeadlessWorld::WorldItem* HeadlessWorld::FindInventoryItem(const ItemInfo& item)
+{
+	for (WorldItem& inventoryItem : m_Inventory)
+	{
+		if (inventoryItem.Info.ItemHash != 0 && inventoryItem.Info.ItemHash == item.ItemHash)
+			return &inventoryItem;
+	}
+	auto it = m_GrabbedItems.find(item.ItemHash);
+	if (it != m_GrabbedItems.end())
+		return &it->second;
+	return FindItem(item.ItemHash);
+}
+#pragma endregion
+
+#pragma region IExamInterface
+WorldInfo HeadlessWorld::World_GetInfo() const
+{
+	return m_WorldInfo;
+}
+
+StatisticsInfo HeadlessWorld::World_GetStats() const
+{
+	return m_Stats;
+}
+
+bool HeadlessWorld::Fov_GetHouseByIndex(UINT index, HouseInfo& houseInfo) const
+{
+	if (index >= m_HousesInFOV.size())
+		return false;
+	houseInfo = m_HousesInFOV[index];
+	return true;
+}
+
+bool HeadlessWorld::Fov_GetEntityByIndex(UINT index, EntityInfo& entityInfo) const
+{
+	if (index >= m_EntitiesInFOV.size())
+		return false;
+	entityInfo = m_EntitiesInFOV[index];
+	return true;
+}
+
+AgentInfo HeadlessWorld::Agent_GetInfo() const
+{
+	return m_Agent;
+}
+
+bool HeadlessWorld::Enemy_GetInfo(EntityInfo entity, EnemyInfo& enemy)
+{
+	for (const WorldEnemy& worldEnemy : m_Enemies)
+	{
+		if (worldEnemy.Info.EnemyHash == entity.EntityHash)
+		{
+			enemy = worldEnemy.Info;
+			return true;
+		}
+	}
+	return false;
+}
+
+Elite::Vector2 HeadlessWorld::NavMesh_GetClosestPathPoint(Elite::Vector2 goal) const
+{
+	const float switchDistanceSquared{ 1.f };
+	const Elite::Vector2 start{ m_Agent.Position };
+	const HouseInfo* pStartHouse = GetHouseContaining(start);
+	const HouseInfo* pGoalHouse = GetHouseContaining(goal);
+
+	if (pStartHouse != nullptr && pStartHouse == pGoalHouse)
+		return goal;
+
+	//Leave the current house through the door
+	if (pStartHouse != nullptr)
+	{
+		const Elite::Vector2 insideDoor{ GetDoor(*pStartHouse, true) };
+		const bool isInDoorway{ start.y < insideDoor.y && abs(start.x - insideDoor.x) < DoorWidth / 2.f };
+		if (isInDoorway || Elite::DistanceSquared(start, insideDoor) < switchDistanceSquared)
+			return GetDoor(*pStartHouse, false);
+		return insideDoor;
+	}
+
+	//Right outside a door the walls next to it block every path, step away from the door first
+	const HouseInfo* pDoorHouse = GetHouseContaining(start, m_Agent.AgentSize / 2.f);
+	if (pDoorHouse != nullptr && pDoorHouse != pGoalHouse)
+		return GetDoor(*pDoorHouse, false);
+
+	//Enter the goal house through the door
+	Elite::Vector2 target{ goal };
+	if (pGoalHouse != nullptr)
+	{
+		const Elite::Vector2 outsideDoor{ GetDoor(*pGoalHouse, false) };
+		const bool isInDoorway{ start.y > outsideDoor.y - 1.f && abs(start.x - outsideDoor.x) < DoorWidth / 2.f };
+		if (isInDoorway)
+			return GetDoor(*pGoalHouse, true);
+		target = outsideDoor;
+	}
+
+	if (!IsBlockedByHouse(start, target))
+		return target;
+
+	//Dijkstra over the navigation graph, the start and target connect to every node they can see
+	//Only the first node of the shortest path is needed, it is carried along with every node
+	const unsigned int nodeCount{ unsigned(m_NavigationNodes.size()) };
+	std::vector<float>& distances{ m_NavigationDistances };
+	std::vector<unsigned int>& firstNodes{ m_NavigationFirstNodes };
+	std::vector<bool>& isVisited{ m_NavigationVisited };
+	distances.assign(nodeCount, FLT_MAX);
+	firstNodes.assign(nodeCount, 0);
+	isVisited.assign(nodeCount, false);
+	for (unsigned int node{}; node < nodeCount; ++node)
+	{
+		if (IsBlockedByHouse(start, m_NavigationNodes[node]))
+			continue;
+		distances[node] = Elite::Distance(start, m_NavigationNodes[node]);
+		firstNodes[node] = node;
+	}
+
+	float bestDistance{ FLT_MAX };
+	Elite::Vector2 bestPathPoint{ target };
+	for (;;)
+	{
+		unsigned int current{ nodeCount };
+		for (unsigned int node{}; node < nodeCount; ++node)
+		{
+			if (!isVisited[node] && distances[node] < FLT_MAX && (current == nodeCount || distances[node] < distances[current]))
+				current = node;
+		}
+		if (current == nodeCount || distances[current] >= bestDistance)
+			break;
+		isVisited[current] = true;
+
+		const Elite::Vector2& position = m_NavigationNodes[current];
+		if (!IsBlockedByHouse(position, target))
+		{
+			const float distance{ distances[current] + Elite::Distance(position, target) };
+			if (distance < bestDistance)
+			{
+				bestDistance = distance;
+				bestPathPoint = m_NavigationNodes[firstNodes[current]];
+			}
+		}
+
+		for (unsigned int neighbor : m_NavigationEdges[current])
+		{
+			const float distance{ distances[current] + Elite::Distance(position, m_NavigationNodes[neighbor]) };
+			if (distance < distances[neighbor])
+			{
+				distances[neighbor] = distance;
+				firstNodes[neighbor] = firstNodes[current];
+			}
+		}
+	}
+	return bestPathPoint;
+}
+
+bool HeadlessWorld::Inventory_AddItem(UINT slotId, ItemInfo item)
+{
+	if (slotId >= m_Inventory.size() || m_Inventory[slotId].Info.ItemHash != 0)
+		return false;
+
+	auto it = m_GrabbedItems.find(item.ItemHash);
+	if (it == m_GrabbedItems.end())
+		return false;
+
+	m_Inventory[slotId] = it->second;
+	m_GrabbedItems.erase(it);
+	return true;
+}
+
+bool HeadlessWorld::Inventory_UseItem(UINT slotId)
+{
+	if (slotId >= m_Inventory.size() || m_Inventory[slotId].Info.ItemHash == 0)
+		return false;
+
+	WorldItem& item = m_Inventory[slotId];
+	switch (item.Info.Type)
+	{
+	case eItemType::PISTOL:
+		if (item.Value <= 0)
+			return false;
+		--item.Value;
+		Shoot(m_Agent.FOV_Range * 2.f, 0.f, 1.f);
+		return true;
+	case eItemType::SHOTGUN:
+		if (item.Value <= 0)
+			return false;
+		--item.Value;
+		Shoot(m_Agent.FOV_Range, 0.35f, 2.f);
+		return true;
+	case eItemType::MEDKIT:
+		if (item.Value <= 0)
+			return false;
+		m_Agent.Health = std::min(AgentMaxHealth, m_Agent.Health + float(item.Value));
+		item.Value = 0;
+		return true;
+	case eItemType::FOOD:
+		if (item.Value <= 0)
+			return false;
+		m_Agent.Energy = std::min(AgentMaxEnergy, m_Agent.Energy + float(item.Value));
+		item.Value = 0;
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool HeadlessWorld::Inventory_RemoveItem(UINT slotId)
+{
+	if (slotId >= m_Inventory.size() || m_Inventory[slotId].Info.ItemHash == 0)
+		return false;
+	m_Inventory[slotId] = WorldItem{};
+	return true;
+}
+
+bool HeadlessWorld::Inventory_GetItem(UINT slotId, ItemInfo& item)
+{
+	if (slotId >= m_Inventory.size() || m_Inventory[slotId].Info.ItemHash == 0)
+		return false;
+	item = m_Inventory[slotId].Info;
+	return true;
+}
+
+UINT HeadlessWorld::Inventory_GetCapacity() const
+{
+	return InventoryCapacity;
+}
+
+bool HeadlessWorld::Item_GetInfo(EntityInfo entity, ItemInfo& item)
+{
+	const WorldItem* pItem = FindItem(entity.EntityHash);
+	if (pItem == nullptr)
+		return false;
+	item = pItem->Info;
+	return true;
+}
+
+bool HeadlessWorld::Item_Grab(EntityInfo entity, ItemInfo& item)
+{
+	//Find the item to grab, with AutoGrabClosestItem the entity is ignored
+	const float grabRangeSquared{ m_Agent.GrabRange * m_Agent.GrabRange };
+	int grabIndex{ -1 };
+	float closestDistance{ FLT_MAX };
+	for (int index{}; index < int(m_Items.size()); ++index)
+	{
+		const ItemInfo& info = m_Items[index].Info;
+		if (!m_Params.AutoGrabClosestItem && info.ItemHash != entity.EntityHash)
+			continue;
+		const float distanceSquared{ Elite::DistanceSquared(info.Location, m_Agent.Position) };
+		if (distanceSquared <= grabRangeSquared && distanceSquared < closestDistance)
+		{
+			closestDistance = distanceSquared;
+			grabIndex = index;
+		}
+	}
+
+	if (grabIndex < 0)
+		return false;
+
+	item = m_Items[grabIndex].Info;
+	m_GrabbedItems[item.ItemHash] = m_Items[grabIndex];
+	m_Items.erase(m_Items.begin() + grabIndex);
+	++m_Stats.NumItemsPickUp;
+	SpawnItem();
+	return true;
+}
+
+bool HeadlessWorld::Item_Destroy(EntityInfo entity)
+{
+	for (auto it = m_Items.begin(); it != m_Items.end(); ++it)
+	{
+		if (it->Info.ItemHash != entity.EntityHash)
+			continue;
+		if (Elite::DistanceSquared(it->Info.Location, m_Agent.Position) > m_Agent.GrabRange * m_Agent.GrabRange)
+			return false;
+		m_Items.erase(it);
+		SpawnItem();
+		return true;
+	}
+	return false;
+}
+
+int HeadlessWorld::Weapon_GetAmmo(ItemInfo& item)
+{
+	const WorldItem* pItem = FindInventoryItem(item);
+	return pItem != nullptr && (item.Type == eItemType::PISTOL || item.Type == eItemType::SHOTGUN) ? pItem->Value : 0;
+}
+
+int HeadlessWorld::Medkit_GetHealth(ItemInfo& item)
+{
+	const WorldItem* pItem = FindInventoryItem(item);
+	return pItem != nullptr && item.Type == eItemType::MEDKIT ? pItem->Value : 0;
+}
+
+int HeadlessWorld::Food_GetEnergy(ItemInfo& item)
+{
+	const WorldItem* pItem = FindInventoryItem(item);
+	return pItem != nullptr && item.Type == eItemType::FOOD ? pItem->Value : 0;
+}
+
+bool HeadlessWorld::PurgeZone_GetInfo(EntityInfo entity, PurgeZoneInfo& zone)
+{
+	for (const WorldPurgeZone& worldZone : m_PurgeZones)
+	{
+		if (worldZone.Info.ZoneHash == entity.EntityHash)
+		{
+			zone = worldZone.Info;
+			return true;
+		}
+	}
+	return false;
+}
+#pragma endregion
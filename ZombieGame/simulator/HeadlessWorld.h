@@ -0,0 +1,159 @@
+#pragma once
+#include "Exam_HelperStructs.h"
+#include "IExamInterface.h"
+#include <random>
+#include <unordered_map>
+
+//Headless version of the exam host, without rendering or input
+//Implements every IExamInterface call on top of a small deterministic world simulation
+class HeadlessWorld final : public IExamInterface
+{
+public:
+	explicit HeadlessWorld(const GameDebugParams& params);
+	~HeadlessWorld() = default;
+
+	HeadlessWorld(const HeadlessWorld& other) = delete;
+	HeadlessWorld(HeadlessWorld&& other) = delete;
+	HeadlessWorld& operator=(const HeadlessWorld& other) = delete;
+	HeadlessWorld& operator=(HeadlessWorld&& other) = delete;
+
+	//Simulation
+	void UpdatePerception();
+	void Step(const SteeringPlugin_Output& steering, float dt);
+	bool IsAgentDead() const { return m_Agent.Death; }
+	bool IsShutdownRequested() const { return m_IsShutdownRequested; }
+
+	//WORLD & ENTITIES
+	WorldInfo World_GetInfo() const override;
+	StatisticsInfo World_GetStats() const override;
+
+	bool Fov_GetHouseByIndex(UINT index, HouseInfo& houseInfo) const override;
+	bool Fov_GetEntityByIndex(UINT index, EntityInfo& entityInfo) const override;
+
+	AgentInfo Agent_GetInfo() const override;
+	bool Enemy_GetInfo(EntityInfo entity, EnemyInfo& enemy) override;
+
+	//NAVMESH
+	Elite::Vector2 NavMesh_GetClosestPathPoint(Elite::Vector2 goal) const override;
+
+	//INVENTORY
+	bool Inventory_AddItem(UINT slotId, ItemInfo item) override;
+	bool Inventory_UseItem(UINT slotId) override;
+	bool Inventory_RemoveItem(UINT slotId) override;
+	bool Inventory_GetItem(UINT slotId, ItemInfo& item) override;
+	UINT Inventory_GetCapacity() const override;
+
+	bool Item_GetInfo(EntityInfo entity, ItemInfo& item) override;
+	bool Item_Grab(EntityInfo entity, ItemInfo& item) override;
+	bool Item_Destroy(EntityInfo entity) override;
+
+	int Weapon_GetAmmo(ItemInfo& item) override;
+	int Medkit_GetHealth(ItemInfo& item) override;
+	int Food_GetEnergy(ItemInfo& item) override;
+
+	//PURGEZONE
+	bool PurgeZone_GetInfo(EntityInfo entity, PurgeZoneInfo& zone) override;
+
+	//DEBUG
+	Elite::Vector2 Debug_ConvertScreenToWorld(Elite::Vector2 screenPos) const override { return screenPos; }
+	Elite::Vector2 Debug_ConvertWorldToScreen(Elite::Vector2 worldPos) const override { return worldPos; }
+
+	//INPUT (there is no input in a headless run)
+	bool Input_IsKeyboardKeyDown(Elite::InputScancode key) const override { return false; }
+	bool Input_IsKeyboardKeyUp(Elite::InputScancode key) const override { return false; }
+	bool Input_IsMouseButtonDown(Elite::InputMouseButton button) const override { return false; }
+	bool Input_IsMouseButtonUp(Elite::InputMouseButton button) const override { return false; }
+	Elite::MouseData Input_GetMouseData(Elite::InputType type, Elite::InputMouseButton button) const override { return Elite::MouseData{}; }
+
+	//EVENT
+	void RequestShutdown() const override { m_IsShutdownRequested = true; }
+
+	//RENDERER (nothing is rendered in a headless run)
+	void Draw_Polygon(const Elite::Vector2* points, int count, const Elite::Vector3& color, float depth) override {}
+	void Draw_SolidPolygon(const Elite::Vector2* points, int count, const Elite::Vector3& color, float depth, bool triangulate) override {}
+	void Draw_Circle(const Elite::Vector2& center, float radius, const Elite::Vector3& color, float depth) override {}
+	void Draw_SolidCircle(const Elite::Vector2& center, float radius, const Elite::Vector2& axis, const Elite::Vector3& color, float depth) override {}
+	void Draw_Segment(const Elite::Vector2& p1, const Elite::Vector2& p2, const Elite::Vector3& color, float depth) override {}
+	void Draw_Direction(const Elite::Vector2& p, Elite::Vector2 dir, float length, const Elite::Vector3& color, float depth) override {}
+	void Draw_Transform(const b2Transform& xf, float depth) override {}
+	void Draw_Point(const Elite::Vector2& p, float size, const Elite::Vector3& color, float depth) override {}
+	float NextDepthSlice() override { return 0.f; }
+
+private:
+	struct WorldItem
+	{
+		ItemInfo Info{};
+		int Value{}; //Ammo, medkit health or food energy
+	};
+	struct WorldEnemy
+	{
+		EnemyInfo Info{};
+		float BiteCooldown{};
+	};
+	struct WorldPurgeZone
+	{
+		PurgeZoneInfo Info{};
+		float TimeUntilPurge{};
+		float TimeToLive{};
+	};
+
+	const GameDebugParams m_Params;
+	std::mt19937 m_Rng;
+
+	WorldInfo m_WorldInfo{};
+	StatisticsInfo m_Stats{};
+	AgentInfo m_Agent{};
+	float m_WasBittenTimer{};
+	float m_PurgeZoneSpawnTimer{};
+	int m_NextHash{ 1 };
+	mutable bool m_IsShutdownRequested{ false };
+
+	std::vector<HouseInfo> m_Houses{};
+	std::vector<WorldItem> m_Items{};
+	std::vector<WorldEnemy> m_Enemies{};
+	std::vector<WorldPurgeZone> m_PurgeZones{};
+
+	//Items that were grabbed but not yet added to the inventory, by hash
+	std::unordered_map<int, WorldItem> m_GrabbedItems{};
+	std::vector<WorldItem> m_Inventory{};
+
+	//Navigation graph around the houses, corners of every house and the visible connections between them
+	std::vector<Elite::Vector2> m_NavigationNodes{};
+	std::vector<std::vector<unsigned int>> m_NavigationEdges{};
+	//Scratch of the path queries and shots, kept so they do not allocate
+	mutable std::vector<float> m_NavigationDistances{};
+	mutable std::vector<unsigned int> m_NavigationFirstNodes{};
+	mutable std::vector<bool> m_NavigationVisited{};
+	std::vector<int> m_HitIndices{};
+
+	//Perception of the current frame
+	std::vector<EntityInfo> m_EntitiesInFOV{};
+	std::vector<HouseInfo> m_HousesInFOV{};
+
+	//Generation
+	void GenerateHouses();
+	void GenerateNavigationGraph();
+	void SpawnItem();
+	void SpawnEnemy();
+	void SpawnPurgeZone();
+	Elite::Vector2 GetRandomFreePosition(float minDistanceToAgent);
+	float RandomFloat(float min, float max);
+	int RandomInt(int min, int max);
+
+	//Simulation
+	void MoveAgent(const SteeringPlugin_Output& steering, float dt);
+	void UpdateEnemies(float dt);
+	void UpdatePurgeZones(float dt);
+	void UpdateAgentStats(float dt);
+	void DamageAgent(float damage);
+	void Shoot(float range, float spread, float damage);
+	Elite::Vector2 ResolveWallCollision(const Elite::Vector2& from, const Elite::Vector2& to, float radius) const;
+
+	//Queries
+	bool IsInFOV(const Elite::Vector2& position) const;
+	const HouseInfo* GetHouseContaining(const Elite::Vector2& position, float margin = 0.f) const;
+	bool IsBlockedByHouse(const Elite::Vector2& from, const Elite::Vector2& to) const;
+	Elite::Vector2 GetDoor(const HouseInfo& house, bool isInside) const;
+	WorldItem* FindItem(int itemHash);
+	WorldItem* FindInventoryItem(const ItemInfo& item);
+};
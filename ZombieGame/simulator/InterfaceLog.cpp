@@ -0,0 +1,1083 @@
+#include "stdafx.h"
+#include "InterfaceLog.h"
+#include <cstring>
+#include <type_traits>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const uint32_t LogMagic{ 0x52505047 }; //"GPPR"
+	const uint32_t LogVersion{ 2 };
+	const uint32_t LogCompressedFlag{ 1 };
+	static_assert(sizeof(LogHeader) == 32 && sizeof(LogChunk) == 24, "The layout of the file must not depend on the compiler");
+
+	//Both streams go through the same Transfer functions, so what is written is always what is read
+	struct LogWriter
+	{
+		std::vector<char>& Data;
+
+		template<typename T>
+		void Value(const T& value)
+		{
+			const size_t offset{ Data.size() };
+			Data.resize(offset + sizeof(T));
+			memcpy(Data.data() + offset, &value, sizeof(T));
+		}
+	};
+
+	struct LogReader
+	{
+		const char* pData;
+		size_t Size;
+		size_t& Offset;
+		bool& IsOverrun;
+
+		template<typename T>
+		void Value(T& value)
+		{
+			if (IsOverrun || Offset + sizeof(T) > Size)
+			{
+				IsOverrun = true;
+				value = T{};
+				return;
+			}
+			memcpy(&value, pData + Offset, sizeof(T));
+			Offset += sizeof(T);
+		}
+	};
+
+	//Counts the bytes a value takes in the log
+	struct LogSizer
+	{
+		size_t Size;
+
+		template<typename T>
+		void Value(const T&)
+		{
+			Size += sizeof(T);
+		}
+	};
+
+	template<typename Stream, typename T>
+	typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>::type Transfer(Stream& stream, T& value)
+	{
+		stream.Value(value);
+	}
+	template<typename Stream, typename T>
+	typename std::enable_if<std::is_enum<T>::value>::type Transfer(Stream& stream, T& value)
+	{
+		int32_t number{ static_cast<int32_t>(value) };
+		stream.Value(number);
+		value = static_cast<T>(number);
+	}
+	template<typename Stream>
+	void Transfer(Stream& stream, bool& value)
+	{
+		uint8_t byte{ uint8_t(value ? 1 : 0) };
+		stream.Value(byte);
+		value = byte != 0;
+	}
+	template<typename Stream>
+	void Transfer(Stream& stream, Elite::Vector2& value)
+	{
+		Transfer(stream, value.x);
+		Transfer(stream, value.y);
+	}
+
+	template<typename Stream>
+	void Transfer(Stream& stream, WorldInfo& value)
+	{
+		Transfer(stream, value.Center);
+		Transfer(stream, value.Dimensions);
+	}
+	template<typename Stream>
+	void Transfer(Stream& stream, StatisticsInfo& value)
+	{
+		Transfer(stream, value.Score);
+		Transfer(stream, value.Difficulty);
+		Transfer(stream, value.TimeSurvived);
+		Transfer(stream, value.KillCountdown);
+		Transfer(stream, value.NumEnemiesKilled);
+		Transfer(stream, value.NumEnemiesHit);
+		Transfer(stream, value.NumItemsPickUp);
+		Transfer(stream, value.NumMissedShots);
+		Transfer(stream, value.NumChkpntsReached);
+	}
+	template<typename Stream>
+	void Transfer(Stream& stream, HouseInfo& value)
+	{
+		Transfer(stream, value.Center);
+		Transfer(stream, value.Size);
+	}
+	template<typename Stream>
+	void Transfer(Stream& stream, EntityInfo& value)
+	{
+		Transfer(stream, value.Type);
+		Transfer(stream, value.Location);
+		Transfer(stream, value.EntityHash);
+	}
+	template<typename Stream>
+	void Transfer(Stream& stream, EnemyInfo& value)
+	{
+		Transfer(stream, value.Type);
+		Transfer(stream, value.Location);
+		Transfer(stream, value.LinearVelocity);
+		Transfer(stream, value.EnemyHash);
+		Transfer(stream, value.Size);
+		Transfer(stream, value.Health);
+	}
+	template<typename Stream>
+	void Transfer(Stream& stream, ItemInfo& value)
+	{
+		Transfer(stream, value.Type);
+		Transfer(stream, value.Location);
+		Transfer(stream, value.ItemHash);
+	}
+	template<typename Stream>
+	void Transfer(Stream& stream, PurgeZoneInfo& value)
+	{
+		Transfer(stream, value.Center);
+		Transfer(stream, value.Radius);
+		Transfer(stream, value.ZoneHash);
+	}
+	template<typename Stream>
+	void Transfer(Stream& stream, AgentInfo& value)
+	{
+		Transfer(stream, value.Stamina);
+		Transfer(stream, value.Health);
+		Transfer(stream, value.Energy);
+		Transfer(stream, value.RunMode);
+		Transfer(stream, value.IsInHouse);
+		Transfer(stream, value.Bitten);
+		Transfer(stream, value.WasBitten);
+		Transfer(stream, value.Death);
+		Transfer(stream, value.FOV_Angle);
+		Transfer(stream, value.FOV_Range);
+		Transfer(stream, value.LinearVelocity);
+		Transfer(stream, value.AngularVelocity);
+		Transfer(stream, value.CurrentLinearSpeed);
+		Transfer(stream, value.Position);
+		Transfer(stream, value.Orientation);
+		Transfer(stream, value.MaxLinearSpeed);
+		Transfer(stream, value.MaxAngularSpeed);
+		Transfer(stream, value.GrabRange);
+		Transfer(stream, value.AgentSize);
+	}
+	template<typename Stream>
+	void Transfer(Stream& stream, Elite::MouseData& value)
+	{
+		Transfer(stream, value.TimeStamp);
+		Transfer(stream, value.Button);
+		Transfer(stream, value.X);
+		Transfer(stream, value.Y);
+		Transfer(stream, value.XRel);
+		Transfer(stream, value.YRel);
+	}
+	template<typename Stream>
+	void Transfer(Stream& stream, SteeringPlugin_Output& value)
+	{
+		Transfer(stream, value.LinearVelocity);
+		Transfer(stream, value.AngularVelocity);
+		Transfer(stream, value.AutoOrient);
+		Transfer(stream, value.RunMode);
+	}
+
+	bool IsSameBits(float a, float b)
+	{
+		return memcmp(&a, &b, sizeof(float)) == 0;
+	}
+
+	template<typename T>
+	size_t GetLogSize()
+	{
+		LogSizer sizer{ 0 };
+		T value{};
+		Transfer(sizer, value);
+		return sizer.Size;
+	}
+
+	//Size of the record of a call without its id, out parameters come after the returned value
+	size_t GetRecordSize(InterfaceCall call)
+	{
+		switch (call)
+		{
+		case InterfaceCall::Frame:
+		case InterfaceCall::NextDepthSlice:
+			return GetLogSize<float>();
+		case InterfaceCall::Steering:
+			return GetLogSize<SteeringPlugin_Output>();
+		case InterfaceCall::World_GetInfo:
+			return GetLogSize<WorldInfo>();
+		case InterfaceCall::World_GetStats:
+			return GetLogSize<StatisticsInfo>();
+		case InterfaceCall::Fov_GetHouseByIndex:
+			return GetLogSize<bool>() + GetLogSize<HouseInfo>();
+		case InterfaceCall::Fov_GetEntityByIndex:
+			return GetLogSize<bool>() + GetLogSize<EntityInfo>();
+		case InterfaceCall::Agent_GetInfo:
+			return GetLogSize<AgentInfo>();
+		case InterfaceCall::Enemy_GetInfo:
+			return GetLogSize<bool>() + GetLogSize<EnemyInfo>();
+		case InterfaceCall::NavMesh_GetClosestPathPoint:
+		case InterfaceCall::Debug_ConvertScreenToWorld:
+		case InterfaceCall::Debug_ConvertWorldToScreen:
+			return GetLogSize<Elite::Vector2>();
+		case InterfaceCall::Inventory_AddItem:
+		case InterfaceCall::Inventory_UseItem:
+		case InterfaceCall::Inventory_RemoveItem:
+		case InterfaceCall::Item_Destroy:
+		case InterfaceCall::Input_IsKeyboardKeyDown:
+		case InterfaceCall::Input_IsKeyboardKeyUp:
+		case InterfaceCall::Input_IsMouseButtonDown:
+		case InterfaceCall::Input_IsMouseButtonUp:
+			return GetLogSize<bool>();
+		case InterfaceCall::Inventory_GetItem:
+		case InterfaceCall::Item_GetInfo:
+		case InterfaceCall::Item_Grab:
+			return GetLogSize<bool>() + GetLogSize<ItemInfo>();
+		case InterfaceCall::Inventory_GetCapacity:
+			return GetLogSize<UINT>();
+		case InterfaceCall::Weapon_GetAmmo:
+		case InterfaceCall::Medkit_GetHealth:
+		case InterfaceCall::Food_GetEnergy:
+			return GetLogSize<int>() + GetLogSize<ItemInfo>();
+		case InterfaceCall::PurgeZone_GetInfo:
+			return GetLogSize<bool>() + GetLogSize<PurgeZoneInfo>();
+		case InterfaceCall::Input_GetMouseData:
+			return GetLogSize<Elite::MouseData>();
+		case InterfaceCall::RequestShutdown:
+			return 0;
+		}
+		return 0;
+	}
+
+	const char* const CallNames[]{ "Frame", "Steering", "World_GetInfo", "World_GetStats", "Fov_GetHouseByIndex", "Fov_GetEntityByIndex",
+		"Agent_GetInfo", "Enemy_GetInfo", "NavMesh_GetClosestPathPoint", "Inventory_AddItem", "Inventory_UseItem", "Inventory_RemoveItem",
+		"Inventory_GetItem", "Inventory_GetCapacity", "Item_GetInfo", "Item_Grab", "Item_Destroy", "Weapon_GetAmmo", "Medkit_GetHealth",
+		"Food_GetEnergy", "PurgeZone_GetInfo", "Debug_ConvertScreenToWorld", "Debug_ConvertWorldToScreen", "Input_IsKeyboardKeyDown",
+		"Input_IsKeyboardKeyUp", "Input_IsMouseButtonDown", "Input_IsMouseButtonUp", "Input_GetMouseData", "RequestShutdown", "NextDepthSlice" };
+	const unsigned int CallCount{ sizeof(CallNames) / sizeof(CallNames[0]) };
+
+	//--- BLOCK COMPRESSION ---
+	//Same layout as an LZ4 block: sequences of a token, literals and a match that copies earlier output.
+	//The token holds the literal length and the match length - MinMatch, 15 means more length bytes follow.
+	//The last sequence only has literals.
+	const size_t MinMatch{ 4 };
+	const size_t MaxMatchOffset{ 0xFFFF };
+	const unsigned int MatchHashBits{ 12 };
+
+	void WriteLength(std::vector<char>& destination, size_t length)
+	{
+		for (; length >= 255; length -= 255)
+			destination.push_back(char(255));
+		destination.push_back(char(length));
+	}
+
+	void WriteSequence(std::vector<char>& destination, const char* pLiterals, size_t literalLength, size_t matchOffset, size_t matchLength)
+	{
+		const size_t matchCode{ matchLength >= MinMatch ? matchLength - MinMatch : 0 };
+		destination.push_back(char(((literalLength < 15 ? literalLength : 15) << 4) | (matchCode < 15 ? matchCode : 15)));
+		if (literalLength >= 15)
+			WriteLength(destination, literalLength - 15);
+		destination.insert(destination.end(), pLiterals, pLiterals + literalLength);
+		if (matchLength == 0)
+			return;
+		destination.push_back(char(matchOffset & 0xFF));
+		destination.push_back(char(matchOffset >> 8));
+		if (matchCode >= 15)
+			WriteLength(destination, matchCode - 15);
+	}
+
+	void CompressBlock(const char* pSource, size_t size, std::vector<char>& destination)
+	{
+		destination.clear();
+		//Last position of every hashed 4 byte sequence, + 1 so 0 is empty
+		std::vector<uint32_t> positions(size_t(1) << MatchHashBits, 0);
+		size_t literalStart{};
+		size_t position{};
+		while (position + MinMatch <= size)
+		{
+			uint32_t sequence;
+			memcpy(&sequence, pSource + position, sizeof(sequence));
+			const uint32_t hash{ (sequence * 2654435761U) >> (32 - MatchHashBits) };
+			const size_t candidate{ positions[hash] };
+			positions[hash] = uint32_t(position + 1);
+			if (candidate == 0 || position + 1 - candidate > MaxMatchOffset || memcmp(pSource + candidate - 1, pSource + position, MinMatch) != 0)
+			{
+				++position;
+				continue;
+			}
+
+			const size_t matchStart{ candidate - 1 };
+			size_t matchLength{ MinMatch };
+			while (position + matchLength < size && pSource[matchStart + matchLength] == pSource[position + matchLength])
+				++matchLength;
+			WriteSequence(destination, pSource + literalStart, position - literalStart, position - matchStart, matchLength);
+			position += matchLength;
+			literalStart = position;
+		}
+		WriteSequence(destination, pSource + literalStart, size - literalStart, 0, 0);
+	}
+
+	bool ReadLength(const char* pSource, size_t size, size_t& offset, size_t& length)
+	{
+		unsigned char byte{ 255 };
+		while (byte == 255)
+		{
+			if (offset >= size)
+				return false;
+			byte = static_cast<unsigned char>(pSource[offset++]);
+			length += byte;
+		}
+		return true;
+	}
+
+	//False when the block is damaged, every read and write is checked
+	bool DecompressBlock(const char* pSource, size_t size, char* pDestination, size_t rawSize)
+	{
+		size_t input{}, output{};
+		while (input < size)
+		{
+			const unsigned char token{ static_cast<unsigned char>(pSource[input++]) };
+			size_t literalLength{ size_t(token >> 4) };
+			if (literalLength == 15 && !ReadLength(pSource, size, input, literalLength))
+				return false;
+			if (literalLength > size - input || literalLength > rawSize - output)
+				return false;
+			memcpy(pDestination + output, pSource + input, literalLength);
+			input += literalLength;
+			output += literalLength;
+			if (input == size)
+				break;
+
+			if (size - input < 2)
+				return false;
+			const size_t matchOffset{ size_t(static_cast<unsigned char>(pSource[input])) | size_t(static_cast<unsigned char>(pSource[input + 1])) << 8 };
+			input += 2;
+			size_t matchLength{ size_t(token & 15) };
+			if (matchLength == 15 && !ReadLength(pSource, size, input, matchLength))
+				return false;
+			matchLength += MinMatch;
+			if (matchOffset == 0 || matchOffset > output || matchLength > rawSize - output)
+				return false;
+			//One byte at a time, a match can overlap what it writes
+			for (size_t index{}; index < matchLength; ++index, ++output)
+				pDestination[output] = pDestination[output - matchOffset];
+		}
+		return output == rawSize;
+	}
+}
+
+//-----------------------------------------------------------------
+// MAPPED FILE
+//-----------------------------------------------------------------
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+#ifdef _WIN32
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		return false;
+	m_Buffer.resize(size_t(file.tellg()));
+	file.seekg(0);
+	file.read(m_Buffer.data(), std::streamsize(m_Buffer.size()));
+	if (!file)
+		return false;
+	m_pData = m_Buffer.data();
+	m_Size = m_Buffer.size();
+	return true;
+#else
+	const int fileDescriptor{ open(path.c_str(), O_RDONLY) };
+	if (fileDescriptor < 0)
+		return false;
+	struct stat fileStatus{};
+	void* pMapping{ MAP_FAILED };
+	if (fstat(fileDescriptor, &fileStatus) == 0 && fileStatus.st_size > 0)
+		pMapping = mmap(nullptr, size_t(fileStatus.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	//The mapping stays valid without the file descriptor
+	close(fileDescriptor);
+	if (pMapping == MAP_FAILED)
+		return false;
+	m_pData = static_cast<const char*>(pMapping);
+	m_Size = size_t(fileStatus.st_size);
+	return true;
+#endif
+}
+
+void MappedFile::Close()
+{
+#ifndef _WIN32
+	if (m_pData != nullptr)
+		munmap(const_cast<char*>(m_pData), m_Size);
+#endif
+	m_Buffer.clear();
+	m_pData = nullptr;
+	m_Size = 0;
+}
+
+//-----------------------------------------------------------------
+// RECORDING
+//-----------------------------------------------------------------
+RecordingInterface::RecordingInterface(IExamInterface* pHost, int seed)
+	: m_pHost(pHost)
+	, m_Seed(seed)
+{
+}
+
+bool RecordingInterface::Open(const std::string& path, bool isCompressed)
+{
+	m_File.open(path, std::ios::binary | std::ios::trunc);
+	if (!m_File)
+		return false;
+	m_IsCompressed = isCompressed;
+
+	//Filled in by Close
+	const LogHeader header{};
+	m_File.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	m_FileOffset = sizeof(header);
+	return bool(m_File);
+}
+
+bool RecordingInterface::Close()
+{
+	if (!m_File.is_open())
+		return false;
+	WriteChunk();
+
+	//The index is read in place, align it for the LogChunk array
+	const char padding[alignof(LogChunk)]{};
+	const size_t paddingSize{ size_t((alignof(LogChunk) - m_FileOffset % alignof(LogChunk)) % alignof(LogChunk)) };
+	m_File.write(padding, std::streamsize(paddingSize));
+	m_FileOffset += paddingSize;
+
+	LogHeader header{};
+	header.Magic = LogMagic;
+	header.Version = LogVersion;
+	header.Seed = m_Seed;
+	header.FrameCount = uint32_t(m_FrameOffsets.size());
+	header.ChunkCount = uint32_t(m_Chunks.size());
+	header.Flags = m_IsCompressed ? LogCompressedFlag : 0;
+	header.IndexOffset = m_FileOffset;
+	m_File.write(reinterpret_cast<const char*>(m_Chunks.data()), std::streamsize(m_Chunks.size() * sizeof(LogChunk)));
+	m_File.write(reinterpret_cast<const char*>(m_FrameOffsets.data()), std::streamsize(m_FrameOffsets.size() * sizeof(uint32_t)));
+	m_FileOffset += m_Chunks.size() * sizeof(LogChunk) + m_FrameOffsets.size() * sizeof(uint32_t);
+	m_File.seekp(0);
+	m_File.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	const bool isWritten{ bool(m_File) };
+	m_File.close();
+	return isWritten;
+}
+
+void RecordingInterface::WriteChunk()
+{
+	//The calls of Initialize are in the first chunk, before its first frame
+	const uint32_t firstFrame{ m_Chunks.empty() ? 0 : m_Chunks.back().FirstFrame + m_Chunks.back().FrameCount };
+	if (m_Chunk.empty() && !m_Chunks.empty())
+		return;
+
+	LogChunk chunk{};
+	chunk.FileOffset = m_FileOffset;
+	chunk.RawSize = uint32_t(m_Chunk.size());
+	chunk.FirstFrame = firstFrame;
+	chunk.FrameCount = uint32_t(m_FrameOffsets.size()) - firstFrame;
+
+	const char* pStored{ m_Chunk.data() };
+	chunk.StoredSize = chunk.RawSize;
+	if (m_IsCompressed)
+	{
+		CompressBlock(m_Chunk.data(), m_Chunk.size(), m_CompressedChunk);
+		if (m_CompressedChunk.size() < m_Chunk.size())
+		{
+			pStored = m_CompressedChunk.data();
+			chunk.StoredSize = uint32_t(m_CompressedChunk.size());
+		}
+	}
+	m_File.write(pStored, chunk.StoredSize);
+	m_FileOffset += chunk.StoredSize;
+	m_RawSize += chunk.RawSize;
+	m_Chunks.push_back(chunk);
+	m_Chunk.clear();
+}
+
+void RecordingInterface::BeginFrame(float dt)
+{
+	m_FrameOffsets.push_back(uint32_t(m_Chunk.size()));
+	Write(InterfaceCall::Frame, dt);
+}
+
+void RecordingInterface::EndFrame(const SteeringPlugin_Output& steering)
+{
+	Write(InterfaceCall::Steering, steering);
+
+	//Chunks only end between frames
+	const uint32_t firstFrame{ m_Chunks.empty() ? 0 : m_Chunks.back().FirstFrame + m_Chunks.back().FrameCount };
+	if (m_File.is_open() && m_FrameOffsets.size() - firstFrame >= FramesPerChunk)
+		WriteChunk();
+}
+
+void RecordingInterface::WriteCall(InterfaceCall call) const
+{
+	m_Chunk.push_back(char(call));
+}
+
+template<typename T>
+void RecordingInterface::Write(InterfaceCall call, const T& value) const
+{
+	WriteCall(call);
+	LogWriter writer{ m_Chunk };
+	T copy{ value };
+	Transfer(writer, copy);
+}
+
+template<typename T, typename U>
+void RecordingInterface::Write(InterfaceCall call, const T& value, const U& outValue) const
+{
+	Write(call, value);
+	LogWriter writer{ m_Chunk };
+	U copy{ outValue };
+	Transfer(writer, copy);
+}
+
+WorldInfo RecordingInterface::World_GetInfo() const
+{
+	const WorldInfo result{ m_pHost->World_GetInfo() };
+	Write(InterfaceCall::World_GetInfo, result);
+	return result;
+}
+
+StatisticsInfo RecordingInterface::World_GetStats() const
+{
+	const StatisticsInfo result{ m_pHost->World_GetStats() };
+	Write(InterfaceCall::World_GetStats, result);
+	return result;
+}
+
+bool RecordingInterface::Fov_GetHouseByIndex(UINT index, HouseInfo& houseInfo) const
+{
+	const bool result{ m_pHost->Fov_GetHouseByIndex(index, houseInfo) };
+	Write(InterfaceCall::Fov_GetHouseByIndex, result, houseInfo);
+	return result;
+}
+
+bool RecordingInterface::Fov_GetEntityByIndex(UINT index, EntityInfo& entityInfo) const
+{
+	const bool result{ m_pHost->Fov_GetEntityByIndex(index, entityInfo) };
+	Write(InterfaceCall::Fov_GetEntityByIndex, result, entityInfo);
+	return result;
+}
+
+AgentInfo RecordingInterface::Agent_GetInfo() const
+{
+	const AgentInfo result{ m_pHost->Agent_GetInfo() };
+	Write(InterfaceCall::Agent_GetInfo, result);
+	return result;
+}
+
+bool RecordingInterface::Enemy_GetInfo(EntityInfo entity, EnemyInfo& enemy)
+{
+	const bool result{ m_pHost->Enemy_GetInfo(entity, enemy) };
+	Write(InterfaceCall::Enemy_GetInfo, result, enemy);
+	return result;
+}
+
+Elite::Vector2 RecordingInterface::NavMesh_GetClosestPathPoint(Elite::Vector2 goal) const
+{
+	const Elite::Vector2 result{ m_pHost->NavMesh_GetClosestPathPoint(goal) };
+	Write(InterfaceCall::NavMesh_GetClosestPathPoint, result);
+	return result;
+}
+
+bool RecordingInterface::Inventory_AddItem(UINT slotId, ItemInfo item)
+{
+	const bool result{ m_pHost->Inventory_AddItem(slotId, item) };
+	Write(InterfaceCall::Inventory_AddItem, result);
+	return result;
+}
+
+bool RecordingInterface::Inventory_UseItem(UINT slotId)
+{
+	const bool result{ m_pHost->Inventory_UseItem(slotId) };
+	Write(InterfaceCall::Inventory_UseItem, result);
+	return result;
+}
+
+bool RecordingInterface::Inventory_RemoveItem(UINT slotId)
+{
+	const bool result{ m_pHost->Inventory_RemoveItem(slotId) };
+	Write(InterfaceCall::Inventory_RemoveItem, result);
+	return result;
+}
+
+bool RecordingInterface::Inventory_GetItem(UINT slotId, ItemInfo& item)
+{
+	const bool result{ m_pHost->Inventory_GetItem(slotId, item) };
+	Write(InterfaceCall::Inventory_GetItem, result, item);
+	return result;
+}
+
+UINT RecordingInterface::Inventory_GetCapacity() const
+{
+	const UINT result{ m_pHost->Inventory_GetCapacity() };
+	Write(InterfaceCall::Inventory_GetCapacity, result);
+	return result;
+}
+
+bool RecordingInterface::Item_GetInfo(EntityInfo entity, ItemInfo& item)
+{
+	const bool result{ m_pHost->Item_GetInfo(entity, item) };
+	Write(InterfaceCall::Item_GetInfo, result, item);
+	return result;
+}
+
+bool RecordingInterface::Item_Grab(EntityInfo entity, ItemInfo& item)
+{
+	const bool result{ m_pHost->Item_Grab(entity, item) };
+	Write(InterfaceCall::Item_Grab, result, item);
+	return result;
+}
+
+bool RecordingInterface::Item_Destroy(EntityInfo entity)
+{
+	const bool result{ m_pHost->Item_Destroy(entity) };
+	Write(InterfaceCall::Item_Destroy, result);
+	return result;
+}
+
+int RecordingInterface::Weapon_GetAmmo(ItemInfo& item)
+{
+	const int result{ m_pHost->Weapon_GetAmmo(item) };
+	Write(InterfaceCall::Weapon_GetAmmo, result, item);
+	return result;
+}
+
+int RecordingInterface::Medkit_GetHealth(ItemInfo& item)
+{
+	const int result{ m_pHost->Medkit_GetHealth(item) };
+	Write(InterfaceCall::Medkit_GetHealth, result, item);
+	return result;
+}
+
+int RecordingInterface::Food_GetEnergy(ItemInfo& item)
+{
+	const int result{ m_pHost->Food_GetEnergy(item) };
+	Write(InterfaceCall::Food_GetEnergy, result, item);
+	return result;
+}
+
+bool RecordingInterface::PurgeZone_GetInfo(EntityInfo entity, PurgeZoneInfo& zone)
+{
+	const bool result{ m_pHost->PurgeZone_GetInfo(entity, zone) };
+	Write(InterfaceCall::PurgeZone_GetInfo, result, zone);
+	return result;
+}
+
+Elite::Vector2 RecordingInterface::Debug_ConvertScreenToWorld(Elite::Vector2 screenPos) const
+{
+	const Elite::Vector2 result{ m_pHost->Debug_ConvertScreenToWorld(screenPos) };
+	Write(InterfaceCall::Debug_ConvertScreenToWorld, result);
+	return result;
+}
+
+Elite::Vector2 RecordingInterface::Debug_ConvertWorldToScreen(Elite::Vector2 worldPos) const
+{
+	const Elite::Vector2 result{ m_pHost->Debug_ConvertWorldToScreen(worldPos) };
+	Write(InterfaceCall::Debug_ConvertWorldToScreen, result);
+	return result;
+}
+
+bool RecordingInterface::Input_IsKeyboardKeyDown(Elite::InputScancode key) const
+{
+	const bool result{ m_pHost->Input_IsKeyboardKeyDown(key) };
+	Write(InterfaceCall::Input_IsKeyboardKeyDown, result);
+	return result;
+}
+
+bool RecordingInterface::Input_IsKeyboardKeyUp(Elite::InputScancode key) const
+{
+	const bool result{ m_pHost->Input_IsKeyboardKeyUp(key) };
+	Write(InterfaceCall::Input_IsKeyboardKeyUp, result);
+	return result;
+}
+
+bool RecordingInterface::Input_IsMouseButtonDown(Elite::InputMouseButton button) const
+{
+	const bool result{ m_pHost->Input_IsMouseButtonDown(button) };
+	Write(InterfaceCall::Input_IsMouseButtonDown, result);
+	return result;
+}
+
+bool RecordingInterface::Input_IsMouseButtonUp(Elite::InputMouseButton button) const
+{
+	const bool result{ m_pHost->Input_IsMouseButtonUp(button) };
+	Write(InterfaceCall::Input_IsMouseButtonUp, result);
+	return result;
+}
+
+Elite::MouseData RecordingInterface::Input_GetMouseData(Elite::InputType type, Elite::InputMouseButton button) const
+{
+	const Elite::MouseData result{ m_pHost->Input_GetMouseData(type, button) };
+	Write(InterfaceCall::Input_GetMouseData, result);
+	return result;
+}
+
+void RecordingInterface::RequestShutdown() const
+{
+	m_pHost->RequestShutdown();
+	WriteCall(InterfaceCall::RequestShutdown);
+}
+
+float RecordingInterface::NextDepthSlice()
+{
+	const float result{ m_pHost->NextDepthSlice() };
+	Write(InterfaceCall::NextDepthSlice, result);
+	return result;
+}
+
+//-----------------------------------------------------------------
+// REPLAY
+//-----------------------------------------------------------------
+bool ReplayInterface::Load(const std::string& path)
+{
+	m_pHeader = nullptr;
+	if (!m_File.Open(path) || m_File.GetSize() < sizeof(LogHeader))
+		return false;
+
+	//Check the whole index before anything is read through it
+	const char* pData{ m_File.GetData() };
+	const size_t fileSize{ m_File.GetSize() };
+	const LogHeader* pHeader{ reinterpret_cast<const LogHeader*>(pData) };
+	if (pHeader->Magic != LogMagic || pHeader->Version != LogVersion || pHeader->ChunkCount == 0
+		|| pHeader->IndexOffset % alignof(LogChunk) != 0 || pHeader->IndexOffset > fileSize
+		|| (fileSize - pHeader->IndexOffset) / sizeof(LogChunk) < pHeader->ChunkCount)
+		return false;
+	const LogChunk* pChunks{ reinterpret_cast<const LogChunk*>(pData + pHeader->IndexOffset) };
+	const size_t frameOffsetsStart{ size_t(pHeader->IndexOffset) + pHeader->ChunkCount * sizeof(LogChunk) };
+	if ((fileSize - frameOffsetsStart) / sizeof(uint32_t) < pHeader->FrameCount)
+		return false;
+
+	uint32_t nextFrame{};
+	for (unsigned int index{}; index < pHeader->ChunkCount; ++index)
+	{
+		const LogChunk& chunk{ pChunks[index] };
+		if (chunk.FileOffset > pHeader->IndexOffset || chunk.StoredSize > pHeader->IndexOffset - chunk.FileOffset
+			|| chunk.StoredSize > chunk.RawSize || chunk.FirstFrame != nextFrame)
+			return false;
+		nextFrame += chunk.FrameCount;
+	}
+	if (nextFrame != pHeader->FrameCount)
+		return false;
+
+	m_pHeader = pHeader;
+	m_pChunks = pChunks;
+	m_pFrameOffsets = reinterpret_cast<const uint32_t*>(pData + frameOffsetsStart);
+	Rewind();
+	return true;
+}
+
+void ReplayInterface::Rewind()
+{
+	m_FrameCount = 0;
+	m_SteeringMismatchCount = 0;
+	m_IsOutOfSync = !LoadChunk(0);
+	m_Offset = 0;
+}
+
+bool ReplayInterface::Seek(unsigned int frame)
+{
+	if (frame >= m_pHeader->FrameCount)
+		return false;
+
+	//Chunks are in frame order
+	unsigned int first{}, last{ m_pHeader->ChunkCount - 1 };
+	while (first < last)
+	{
+		const unsigned int middle{ (first + last + 1) / 2 };
+		if (m_pChunks[middle].FirstFrame <= frame)
+			first = middle;
+		else
+			last = middle - 1;
+	}
+	m_IsOutOfSync = !LoadChunk(first);
+	m_Offset = m_pFrameOffsets[frame];
+	m_FrameCount = 0;
+	m_SteeringMismatchCount = 0;
+	return !m_IsOutOfSync;
+}
+
+bool ReplayInterface::LoadChunk(unsigned int chunkIndex)
+{
+	if (chunkIndex >= m_pHeader->ChunkCount)
+		return false;
+	const LogChunk& chunk{ m_pChunks[chunkIndex] };
+	const char* pStored{ m_File.GetData() + chunk.FileOffset };
+	m_ChunkIndex = chunkIndex;
+	if (chunk.StoredSize == chunk.RawSize)
+	{
+		m_pChunk = pStored;
+		m_ChunkSize = chunk.RawSize;
+		return true;
+	}
+
+	m_ChunkBuffer.resize(chunk.RawSize);
+	m_pChunk = m_ChunkBuffer.data();
+	m_ChunkSize = chunk.RawSize;
+	return DecompressBlock(pStored, chunk.StoredSize, m_ChunkBuffer.data(), chunk.RawSize);
+}
+
+bool ReplayInterface::BeginFrame(float& dt)
+{
+	if (m_IsOutOfSync)
+		return false;
+	if (m_Offset >= m_ChunkSize)
+	{
+		if (m_ChunkIndex + 1 >= m_pHeader->ChunkCount)
+			return false;
+		if (!LoadChunk(m_ChunkIndex + 1))
+		{
+			m_IsOutOfSync = true;
+			return false;
+		}
+		m_Offset = 0;
+	}
+	dt = Read<float>(InterfaceCall::Frame);
+	if (m_IsOutOfSync)
+		return false;
+	++m_FrameCount;
+	return true;
+}
+
+void ReplayInterface::EndFrame(const SteeringPlugin_Output& steering)
+{
+	const SteeringPlugin_Output logged{ Read<SteeringPlugin_Output>(InterfaceCall::Steering) };
+	if (m_IsOutOfSync)
+		return;
+	if (!IsSameBits(steering.LinearVelocity.x, logged.LinearVelocity.x) || !IsSameBits(steering.LinearVelocity.y, logged.LinearVelocity.y)
+		|| !IsSameBits(steering.AngularVelocity, logged.AngularVelocity)
+		|| steering.AutoOrient != logged.AutoOrient || steering.RunMode != logged.RunMode)
+		++m_SteeringMismatchCount;
+}
+
+void ReplayInterface::PrintFrame(unsigned int frame)
+{
+	if (!Seek(frame))
+	{
+		printf("frame %u is not in the log (%u frames)\n", frame, m_pHeader->FrameCount);
+		return;
+	}
+
+	//Every record has the size of its call, so the frame can be walked without a plugin
+	unsigned int callCounts[CallCount]{};
+	AgentInfo agent{};
+	SteeringPlugin_Output steering{};
+	float dt{};
+	bool isDamaged{ false };
+	while (m_Offset < m_ChunkSize)
+	{
+		const unsigned int call{ static_cast<unsigned char>(m_pChunk[m_Offset]) };
+		if (call >= CallCount || (call == unsigned(InterfaceCall::Frame) && callCounts[call] > 0))
+		{
+			isDamaged = call >= CallCount;
+			break;
+		}
+		++callCounts[call];
+
+		size_t valueOffset{ m_Offset + 1 };
+		LogReader reader{ m_pChunk, m_ChunkSize, valueOffset, isDamaged };
+		if (call == unsigned(InterfaceCall::Frame))
+			Transfer(reader, dt);
+		else if (call == unsigned(InterfaceCall::Agent_GetInfo))
+			Transfer(reader, agent);
+		else if (call == unsigned(InterfaceCall::Steering))
+			Transfer(reader, steering);
+		m_Offset += 1 + GetRecordSize(InterfaceCall(call));
+	}
+
+	printf("frame %u of seed %d (chunk %u, dt %.4f)%s\n", frame, m_pHeader->Seed, m_ChunkIndex, dt, isDamaged ? ", DAMAGED" : "");
+	for (unsigned int call{}; call < CallCount; ++call)
+	{
+		if (callCounts[call] > 0)
+			printf("  %-28s %u\n", CallNames[call], callCounts[call]);
+	}
+	printf("agent at (%.2f, %.2f), health %.2f, energy %.2f, steering (%.2f, %.2f) angular %.2f%s\n", agent.Position.x, agent.Position.y,
+		agent.Health, agent.Energy, steering.LinearVelocity.x, steering.LinearVelocity.y, steering.AngularVelocity, steering.RunMode ? ", running" : "");
+	Rewind();
+}
+
+bool ReplayInterface::ReadCall(InterfaceCall call) const
+{
+	if (m_IsOutOfSync || m_Offset >= m_ChunkSize || m_pChunk[m_Offset] != char(call))
+	{
+		m_IsOutOfSync = true;
+		return false;
+	}
+	++m_Offset;
+	return true;
+}
+
+template<typename T>
+T ReplayInterface::Read(InterfaceCall call) const
+{
+	T value{};
+	if (!ReadCall(call))
+		return value;
+	LogReader reader{ m_pChunk, m_ChunkSize, m_Offset, m_IsOutOfSync };
+	Transfer(reader, value);
+	return value;
+}
+
+template<typename T, typename U>
+T ReplayInterface::Read(InterfaceCall call, U& outValue) const
+{
+	const T value{ Read<T>(call) };
+	if (m_IsOutOfSync)
+		return value;
+	LogReader reader{ m_pChunk, m_ChunkSize, m_Offset, m_IsOutOfSync };
+	Transfer(reader, outValue);
+	return value;
+}
+
+WorldInfo ReplayInterface::World_GetInfo() const
+{
+	return Read<WorldInfo>(InterfaceCall::World_GetInfo);
+}
+
+StatisticsInfo ReplayInterface::World_GetStats() const
+{
+	return Read<StatisticsInfo>(InterfaceCall::World_GetStats);
+}
+
+bool ReplayInterface::Fov_GetHouseByIndex(UINT index, HouseInfo& houseInfo) const
+{
+	return Read<bool>(InterfaceCall::Fov_GetHouseByIndex, houseInfo);
+}
+
+bool ReplayInterface::Fov_GetEntityByIndex(UINT index, EntityInfo& entityInfo) const
+{
+	return Read<bool>(InterfaceCall::Fov_GetEntityByIndex, entityInfo);
+}
+
+AgentInfo ReplayInterface::Agent_GetInfo() const
+{
+	return Read<AgentInfo>(InterfaceCall::Agent_GetInfo);
+}
+
+bool ReplayInterface::Enemy_GetInfo(EntityInfo entity, EnemyInfo& enemy)
+{
+	return Read<bool>(InterfaceCall::Enemy_GetInfo, enemy);
+}
+
+Elite::Vector2 ReplayInterface::NavMesh_GetClosestPathPoint(Elite::Vector2 goal) const
+{
+	return Read<Elite::Vector2>(InterfaceCall::NavMesh_GetClosestPathPoint);
+}
+
+bool ReplayInterface::Inventory_AddItem(UINT slotId, ItemInfo item)
+{
+	return Read<bool>(InterfaceCall::Inventory_AddItem);
+}
+
+bool ReplayInterface::Inventory_UseItem(UINT slotId)
+{
+	return Read<bool>(InterfaceCall::Inventory_UseItem);
+}
+
+bool ReplayInterface::Inventory_RemoveItem(UINT slotId)
+{
+	return Read<bool>(InterfaceCall::Inventory_RemoveItem);
+}
+
+bool ReplayInterface::Inventory_GetItem(UINT slotId, ItemInfo& item)
+{
+	return Read<bool>(InterfaceCall::Inventory_GetItem, item);
+}
+
+UINT ReplayInterface::Inventory_GetCapacity() const
+{
+	return Read<UINT>(InterfaceCall::Inventory_GetCapacity);
+}
+
+bool ReplayInterface::Item_GetInfo(EntityInfo entity, ItemInfo& item)
+{
+	return Read<bool>(InterfaceCall::Item_GetInfo, item);
+}
+
+bool ReplayInterface::Item_Grab(EntityInfo entity, ItemInfo& item)
+{
+	return Read<bool>(InterfaceCall::Item_Grab, item);
+}
+
+bool ReplayInterface::Item_Destroy(EntityInfo entity)
+{
+	return Read<bool>(InterfaceCall::Item_Destroy);
+}
+
+int ReplayInterface::Weapon_GetAmmo(ItemInfo& item)
+{
+	return Read<int>(InterfaceCall::Weapon_GetAmmo, item);
+}
+
+int ReplayInterface::Medkit_GetHealth(ItemInfo& item)
+{
+	return Read<int>(InterfaceCall::Medkit_GetHealth, item);
+}
+
+int ReplayInterface::Food_GetEnergy(ItemInfo& item)
+{
+	return Read<int>(InterfaceCall::Food_GetEnergy, item);
+}
+
+bool ReplayInterface::PurgeZone_GetInfo(EntityInfo entity, PurgeZoneInfo& zone)
+{
+	return Read<bool>(InterfaceCall::PurgeZone_GetInfo, zone);
+}
+
+Elite::Vector2 ReplayInterface::Debug_ConvertScreenToWorld(Elite::Vector2 screenPos) const
+{
+	return Read<Elite::Vector2>(InterfaceCall::Debug_ConvertScreenToWorld);
+}
+
+Elite::Vector2 ReplayInterface::Debug_ConvertWorldToScreen(Elite::Vector2 worldPos) const
+{
+	return Read<Elite::Vector2>(InterfaceCall::Debug_ConvertWorldToScreen);
+}
+
+bool ReplayInterface::Input_IsKeyboardKeyDown(Elite::InputScancode key) const
+{
+	return Read<bool>(InterfaceCall::Input_IsKeyboardKeyDown);
+}
+
+bool ReplayInterface::Input_IsKeyboardKeyUp(Elite::InputScancode key) const
+{
+	return Read<bool>(InterfaceCall::Input_IsKeyboardKeyUp);
+}
+
+bool ReplayInterface::Input_IsMouseButtonDown(Elite::InputMouseButton button) const
+{
+	return Read<bool>(InterfaceCall::Input_IsMouseButtonDown);
+}
+
+bool ReplayInterface::Input_IsMouseButtonUp(Elite::InputMouseButton button) const
+{
+	return Read<bool>(InterfaceCall::Input_IsMouseButtonUp);
+}
+
+Elite::MouseData ReplayInterface::Input_GetMouseData(Elite::InputType type, Elite::InputMouseButton button) const
+{
+	return Read<Elite::MouseData>(InterfaceCall::Input_GetMouseData);
+}
+
+void ReplayInterface::RequestShutdown() const
+{
+	ReadCall(InterfaceCall::RequestShutdown);
+}
+
+float ReplayInterface::NextDepthSlice()
+{
+	return Read<float>(InterfaceCall::NextDepthSlice);
+}
@@ -0,0 +1,323 @@
+#pragma once
+#include "Exam_HelperStructs.h"
+#include "IExamInterface.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//Binary log of every answer the host gives the plugin, in the order the plugin asks for them.
+//The plugin only sees the world through IExamInterface, so handing it the same answers in the same order
+//repeats a run exactly, without the host. A record is the id of the call followed by what the call returned,
+//out parameters included. Values are written field by field in the byte order of the machine,
+//so a log has no padding and the same run always gives the same bytes. Every call has a record of a fixed size.
+//
+//The records are stored in chunks of whole frames, each chunk is compressed on its own or stored as it is.
+//The file ends with an index: the place and size of every chunk and where every frame starts in its chunk,
+//so a replay only maps the file and reads the index before it starts, and can go to any frame.
+//	[LogHeader][chunk 0][chunk 1]...[LogChunk for every chunk][offset of every frame in its chunk]
+enum class InterfaceCall : uint8_t
+{
+	Frame, //Delta time of the frame, before Plugin::Update
+	Steering, //Output of Plugin::UpdateSteering, only checked on replay
+	World_GetInfo,
+	World_GetStats,
+	Fov_GetHouseByIndex,
+	Fov_GetEntityByIndex,
+	Agent_GetInfo,
+	Enemy_GetInfo,
+	NavMesh_GetClosestPathPoint,
+	Inventory_AddItem,
+	Inventory_UseItem,
+	Inventory_RemoveItem,
+	Inventory_GetItem,
+	Inventory_GetCapacity,
+	Item_GetInfo,
+	Item_Grab,
+	Item_Destroy,
+	Weapon_GetAmmo,
+	Medkit_GetHealth,
+	Food_GetEnergy,
+	PurgeZone_GetInfo,
+	Debug_ConvertScreenToWorld,
+	Debug_ConvertWorldToScreen,
+	Input_IsKeyboardKeyDown,
+	Input_IsKeyboardKeyUp,
+	Input_IsMouseButtonDown,
+	Input_IsMouseButtonUp,
+	Input_GetMouseData,
+	RequestShutdown,
+	NextDepthSlice
+};
+
+//Fixed layout of the file, read in place from the mapping
+struct LogHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	int32_t Seed;
+	uint32_t FrameCount;
+	uint32_t ChunkCount;
+	uint32_t Flags;
+	uint64_t IndexOffset; //LogChunk array, followed by a uint32_t per frame
+};
+
+struct LogChunk
+{
+	uint64_t FileOffset;
+	uint32_t StoredSize; //Compressed when smaller than the raw size
+	uint32_t RawSize;
+	uint32_t FirstFrame;
+	uint32_t FrameCount;
+};
+
+//Read only view of a whole file, pages are only read from disk when they are first touched
+//Uses mmap on POSIX systems, elsewhere the file is read into memory
+class MappedFile final
+{
+public:
+	MappedFile() = default;
+	~MappedFile() { Close(); }
+
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile(MappedFile&& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+	MappedFile& operator=(MappedFile&& other) = delete;
+
+	bool Open(const std::string& path);
+	void Close();
+
+	const char* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_Size; }
+
+private:
+	const char* m_pData{ nullptr };
+	size_t m_Size{};
+	std::vector<char> m_Buffer{}; //Only without mmap
+};
+
+//Passes every call on to the host and logs its answer, every full chunk is written to the file right away
+class RecordingInterface final : public IExamInterface
+{
+public:
+	RecordingInterface(IExamInterface* pHost, int seed);
+	~RecordingInterface() = default;
+
+	RecordingInterface(const RecordingInterface& other) = delete;
+	RecordingInterface(RecordingInterface&& other) = delete;
+	RecordingInterface& operator=(const RecordingInterface& other) = delete;
+	RecordingInterface& operator=(RecordingInterface&& other) = delete;
+
+	//Around Plugin::Update and Plugin::UpdateSteering
+	void BeginFrame(float dt);
+	void EndFrame(const SteeringPlugin_Output& steering);
+
+	//Chunks are compressed with an LZ4 style block compression when isCompressed is set
+	bool Open(const std::string& path, bool isCompressed);
+	//Writes the last chunk and the index
+	bool Close();
+	unsigned int GetFrameCount() const { return unsigned(m_FrameOffsets.size()); }
+	size_t GetChunkCount() const { return m_Chunks.size(); }
+	unsigned long long GetRawSize() const { return m_RawSize; }
+	unsigned long long GetFileSize() const { return m_FileOffset; }
+
+	//WORLD & ENTITIES
+	WorldInfo World_GetInfo() const override;
+	StatisticsInfo World_GetStats() const override;
+
+	bool Fov_GetHouseByIndex(UINT index, HouseInfo& houseInfo) const override;
+	bool Fov_GetEntityByIndex(UINT index, EntityInfo& entityInfo) const override;
+
+	AgentInfo Agent_GetInfo() const override;
+	bool Enemy_GetInfo(EntityInfo entity, EnemyInfo& enemy) override;
+
+	//NAVMESH
+	Elite::Vector2 NavMesh_GetClosestPathPoint(Elite::Vector2 goal) const override;
+
+	//INVENTORY
+	bool Inventory_AddItem(UINT slotId, ItemInfo item) override;
+	bool Inventory_UseItem(UINT slotId) override;
+	bool Inventory_RemoveItem(UINT slotId) override;
+	bool Inventory_GetItem(UINT slotId, ItemInfo& item) override;
+	UINT Inventory_GetCapacity() const override;
+
+	bool Item_GetInfo(EntityInfo entity, ItemInfo& item) override;
+	bool Item_Grab(EntityInfo entity, ItemInfo& item) override;
+	bool Item_Destroy(EntityInfo entity) override;
+
+	int Weapon_GetAmmo(ItemInfo& item) override;
+	int Medkit_GetHealth(ItemInfo& item) override;
+	int Food_GetEnergy(ItemInfo& item) override;
+
+	//PURGEZONE
+	bool PurgeZone_GetInfo(EntityInfo entity, PurgeZoneInfo& zone) override;
+
+	//DEBUG
+	Elite::Vector2 Debug_ConvertScreenToWorld(Elite::Vector2 screenPos) const override;
+	Elite::Vector2 Debug_ConvertWorldToScreen(Elite::Vector2 worldPos) const override;
+
+	//INPUT
+	bool Input_IsKeyboardKeyDown(Elite::InputScancode key) const override;
+	bool Input_IsKeyboardKeyUp(Elite::InputScancode key) const override;
+	bool Input_IsMouseButtonDown(Elite::InputMouseButton button) const override;
+	bool Input_IsMouseButtonUp(Elite::InputMouseButton button) const override;
+	Elite::MouseData Input_GetMouseData(Elite::InputType type, Elite::InputMouseButton button) const override;
+
+	//EVENT
+	void RequestShutdown() const override;
+
+	//RENDERER (passed on, nothing to log)
+	void Draw_Polygon(const Elite::Vector2* points, int count, const Elite::Vector3& color, float depth) override { m_pHost->Draw_Polygon(points, count, color, depth); }
+	void Draw_SolidPolygon(const Elite::Vector2* points, int count, const Elite::Vector3& color, float depth, bool triangulate) override { m_pHost->Draw_SolidPolygon(points, count, color, depth, triangulate); }
+	void Draw_Circle(const Elite::Vector2& center, float radius, const Elite::Vector3& color, float depth) override { m_pHost->Draw_Circle(center, radius, color, depth); }
+	void Draw_SolidCircle(const Elite::Vector2& center, float radius, const Elite::Vector2& axis, const Elite::Vector3& color, float depth) override { m_pHost->Draw_SolidCircle(center, radius, axis, color, depth); }
+	void Draw_Segment(const Elite::Vector2& p1, const Elite::Vector2& p2, const Elite::Vector3& color, float depth) override { m_pHost->Draw_Segment(p1, p2, color, depth); }
+	void Draw_Direction(const Elite::Vector2& p, Elite::Vector2 dir, float length, const Elite::Vector3& color, float depth) override { m_pHost->Draw_Direction(p, dir, length, color, depth); }
+	void Draw_Transform(const b2Transform& xf, float depth) override { m_pHost->Draw_Transform(xf, depth); }
+	void Draw_Point(const Elite::Vector2& p, float size, const Elite::Vector3& color, float depth) override { m_pHost->Draw_Point(p, size, color, depth); }
+	float NextDepthSlice() override;
+
+private:
+	static const unsigned int FramesPerChunk{ 1024 };
+
+	IExamInterface* m_pHost{ nullptr };
+	int m_Seed{ -1 };
+	bool m_IsCompressed{ false };
+	std::ofstream m_File{};
+	unsigned long long m_FileOffset{};
+	unsigned long long m_RawSize{};
+
+	//Const calls of the interface are logged too
+	mutable std::vector<char> m_Chunk{};
+	std::vector<char> m_CompressedChunk{};
+	std::vector<LogChunk> m_Chunks{};
+	std::vector<uint32_t> m_FrameOffsets{};
+
+	void WriteChunk();
+
+	void WriteCall(InterfaceCall call) const;
+	template<typename T>
+	void Write(InterfaceCall call, const T& value) const;
+	template<typename T, typename U>
+	void Write(InterfaceCall call, const T& value, const U& outValue) const;
+};
+
+//Answers every call from a log made by RecordingInterface, straight from the mapped file
+//Stored chunks are read in place, compressed ones are decompressed into one buffer when the replay gets to them.
+//When the plugin asks for something else than what was logged the replay is out of sync: the remaining calls
+//get default answers and BeginFrame stops the replay.
+class ReplayInterface final : public IExamInterface
+{
+public:
+	ReplayInterface() = default;
+	~ReplayInterface() = default;
+
+	ReplayInterface(const ReplayInterface& other) = delete;
+	ReplayInterface(ReplayInterface&& other) = delete;
+	ReplayInterface& operator=(const ReplayInterface& other) = delete;
+	ReplayInterface& operator=(ReplayInterface&& other) = delete;
+
+	bool Load(const std::string& path);
+	//Back to the start of the log, to replay it again with a new plugin
+	void Rewind();
+	//To the start of a frame, a new plugin that starts there is out of sync at its first call
+	bool Seek(unsigned int frame);
+	//Prints the calls of one frame, the agent and the steering
+	void PrintFrame(unsigned int frame);
+
+	//False at the end of the log or when the replay is out of sync
+	bool BeginFrame(float& dt);
+	//Compares the steering of the plugin with the logged one, bit for bit
+	void EndFrame(const SteeringPlugin_Output& steering);
+
+	int GetSeed() const { return m_pHeader->Seed; }
+	//Frames in the log, and frames replayed since the last rewind
+	unsigned int GetLogFrameCount() const { return m_pHeader->FrameCount; }
+	unsigned int GetFrameCount() const { return m_FrameCount; }
+	unsigned int GetChunkCount() const { return m_pHeader->ChunkCount; }
+	unsigned int GetSteeringMismatchCount() const { return m_SteeringMismatchCount; }
+	bool IsOutOfSync() const { return m_IsOutOfSync; }
+	size_t GetFileSize() const { return m_File.GetSize(); }
+
+	//WORLD & ENTITIES
+	WorldInfo World_GetInfo() const override;
+	StatisticsInfo World_GetStats() const override;
+
+	bool Fov_GetHouseByIndex(UINT index, HouseInfo& houseInfo) const override;
+	bool Fov_GetEntityByIndex(UINT index, EntityInfo& entityInfo) const override;
+
+	AgentInfo Agent_GetInfo() const override;
+	bool Enemy_GetInfo(EntityInfo entity, EnemyInfo& enemy) override;
+
+	//NAVMESH
+	Elite::Vector2 NavMesh_GetClosestPathPoint(Elite::Vector2 goal) const override;
+
+	//INVENTORY
+	bool Inventory_AddItem(UINT slotId, ItemInfo item) override;
+	bool Inventory_UseItem(UINT slotId) override;
+	bool Inventory_RemoveItem(UINT slotId) override;
+	bool Inventory_GetItem(UINT slotId, ItemInfo& item) override;
+	UINT Inventory_GetCapacity() const override;
+
+	bool Item_GetInfo(EntityInfo entity, ItemInfo& item) override;
+	bool Item_Grab(EntityInfo entity, ItemInfo& item) override;
+	bool Item_Destroy(EntityInfo entity) override;
+
+	int Weapon_GetAmmo(ItemInfo& item) override;
+	int Medkit_GetHealth(ItemInfo& item) override;
+	int Food_GetEnergy(ItemInfo& item) override;
+
+	//PURGEZONE
+	bool PurgeZone_GetInfo(EntityInfo entity, PurgeZoneInfo& zone) override;
+
+	//DEBUG
+	Elite::Vector2 Debug_ConvertScreenToWorld(Elite::Vector2 screenPos) const override;
+	Elite::Vector2 Debug_ConvertWorldToScreen(Elite::Vector2 worldPos) const override;
+
+	//INPUT
+	bool Input_IsKeyboardKeyDown(Elite::InputScancode key) const override;
+	bool Input_IsKeyboardKeyUp(Elite::InputScancode key) const override;
+	bool Input_IsMouseButtonDown(Elite::InputMouseButton button) const override;
+	bool Input_IsMouseButtonUp(Elite::InputMouseButton button) const override;
+	Elite::MouseData Input_GetMouseData(Elite::InputType type, Elite::InputMouseButton button) const override;
+
+	//EVENT
+	void RequestShutdown() const override;
+
+	//RENDERER (nothing is rendered in a replay)
+	void Draw_Polygon(const Elite::Vector2* points, int count, const Elite::Vector3& color, float depth) override {}
+	void Draw_SolidPolygon(const Elite::Vector2* points, int count, const Elite::Vector3& color, float depth, bool triangulate) override {}
+	void Draw_Circle(const Elite::Vector2& center, float radius, const Elite::Vector3& color, float depth) override {}
+	void Draw_SolidCircle(const Elite::Vector2& center, float radius, const Elite::Vector2& axis, const Elite::Vector3& color, float depth) override {}
+	void Draw_Segment(const Elite::Vector2& p1, const Elite::Vector2& p2, const Elite::Vector3& color, float depth) override {}
+	void Draw_Direction(const Elite::Vector2& p, Elite::Vector2 dir, float length, const Elite::Vector3& color, float depth) override {}
+	void Draw_Transform(const b2Transform& xf, float depth) override {}
+	void Draw_Point(const Elite::Vector2& p, float size, const Elite::Vector3& color, float depth) override {}
+	float NextDepthSlice() override;
+
+private:
+	MappedFile m_File{};
+	const LogHeader* m_pHeader{ nullptr };
+	const LogChunk* m_pChunks{ nullptr };
+	const uint32_t* m_pFrameOffsets{ nullptr };
+	std::vector<char> m_ChunkBuffer{}; //Decompressed chunk
+
+	//The chunk that is replayed
+	unsigned int m_ChunkIndex{};
+	const char* m_pChunk{ nullptr };
+	size_t m_ChunkSize{};
+
+	unsigned int m_FrameCount{};
+	unsigned int m_SteeringMismatchCount{};
+	//Const calls of the interface move through the log too
+	mutable size_t m_Offset{};
+	mutable bool m_IsOutOfSync{ false };
+
+	//Value initialized when the replay is out of sync
+	template<typename T>
+	T Read(InterfaceCall call) const;
+	template<typename T, typename U>
+	T Read(InterfaceCall call, U& outValue) const;
+	bool ReadCall(InterfaceCall call) const;
+	bool LoadChunk(unsigned int chunkIndex);
+};
@@ -0,0 +1,1414 @@
+#include "stdafx.h"
+#include "HeadlessWorld.h"
+#include "InterfaceLog.h"
+#include "Plugin.h"
+#include "EBehaviorTree.h"
+#include "EFlatBehaviorTree.h"
+#include "EStaticBehaviorTree.h"
+#include "EBehaviorTreeBatch.h"
+#include "Inventory.h"
+#include "EnemyThreats.h"
+#include "NavigationGrid.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+//Headless simulator, runs the plugin without the Windows host
+//	GPP_Simulator [--seed N] [--time SECONDS] [--engine runtime|flat|reactive|static] [--bench-tree UPDATES] [--profile PREFIX]
+//	              [--agents N] [--threads N] [--bench-houses N] [--bench-items N] [--bench-threats CALLS]
+//	              [--bench-vectors N] [--bench-trig N] [--bench-grid N] [--bench-danger UPDATES] [--bench-leaves CALLS]
+//	              [--check-mixed UPDATES] [--record FILE] [--record-compressed FILE] [--replay FILE] [--replay-runs N] [--replay-frame N]
+//Every allocation on the global heap is counted, so the ticks of the plugin can be checked to not allocate
+namespace
+{
+	std::atomic<unsigned long long> g_HeapAllocationCount{ 0 };
+}
+
+void* operator new(size_t size)
+{
+	++g_HeapAllocationCount;
+	void* p = malloc(size > 0 ? size : 1);
+	if (p == nullptr)
+		throw std::bad_alloc{};
+	return p;
+}
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	const float FixedDeltaTime{ 1.f / 60.f };
+	const float BenchWarmupTime{ 30.f };
+
+	struct SimulatorOptions
+	{
+		int Seed{ -2 }; //-2 keeps the seed of InitGameDebugParams
+		float MaxTime{ 600.f };
+		BehaviorTreeEngine Engine{ BehaviorTreeEngine::Static };
+		bool IsEngineSet{ false };
+		int BenchUpdates{ 0 };
+		std::string ProfilePrefix{}; //Writes PREFIX.csv, PREFIX.json and PREFIX.folded
+		int AgentCount{ 0 }; //More than 0 runs that many agents with one shared tree, agent i uses the seed + i
+		int ThreadCount{ 0 }; //0 uses one thread per hardware thread
+		int BenchHouses{ 0 };
+		int BenchItems{ 0 };
+		int BenchThreatCalls{ 0 };
+		int BenchVectors{ 0 };
+		int BenchTrig{ 0 };
+		int BenchGrid{ 0 };
+		int BenchDangerUpdates{ 0 };
+		int BenchLeafCalls{ 0 };
+		int CheckMixedUpdates{ 0 };
+		std::string RecordPath{}; //Logs every answer of the host to this file
+		bool IsRecordCompressed{ false };
+		std::string ReplayPath{}; //Runs the plugin on a log instead of the host
+		int ReplayRuns{ 1 };
+		int ReplayFrame{ -1 }; //Prints this frame of the log instead of replaying it
+	};
+
+	const char* GetEngineName(BehaviorTreeEngine engine)
+	{
+		switch (engine)
+		{
+		case BehaviorTreeEngine::Runtime:
+			return "runtime";
+		case BehaviorTreeEngine::Flat:
+			return "flat";
+		case BehaviorTreeEngine::Reactive:
+			return "reactive";
+		default:
+			return "static";
+		}
+	}
+
+	bool ParseOptions(int argc, char* argv[], SimulatorOptions& options)
+	{
+		for (int index{ 1 }; index < argc; ++index)
+		{
+			const bool hasValue{ index + 1 < argc };
+			if (strcmp(argv[index], "--seed") == 0 && hasValue)
+				options.Seed = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--time") == 0 && hasValue)
+				options.MaxTime = float(atof(argv[++index]));
+			else if (strcmp(argv[index], "--bench-tree") == 0 && hasValue)
+				options.BenchUpdates = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--profile") == 0 && hasValue)
+				options.ProfilePrefix = argv[++index];
+			else if (strcmp(argv[index], "--agents") == 0 && hasValue)
+				options.AgentCount = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--threads") == 0 && hasValue)
+				options.ThreadCount = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--bench-houses") == 0 && hasValue)
+				options.BenchHouses = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--bench-items") == 0 && hasValue)
+				options.BenchItems = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--bench-threats") == 0 && hasValue)
+				options.BenchThreatCalls = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--bench-vectors") == 0 && hasValue)
+				options.BenchVectors = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--bench-trig") == 0 && hasValue)
+				options.BenchTrig = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--bench-grid") == 0 && hasValue)
+				options.BenchGrid = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--bench-danger") == 0 && hasValue)
+				options.BenchDangerUpdates = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--bench-leaves") == 0 && hasValue)
+				options.BenchLeafCalls = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--check-mixed") == 0 && hasValue)
+				options.CheckMixedUpdates = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--record") == 0 && hasValue)
+				options.RecordPath = argv[++index];
+			else if (strcmp(argv[index], "--record-compressed") == 0 && hasValue)
+			{
+				options.RecordPath = argv[++index];
+				options.IsRecordCompressed = true;
+			}
+			else if (strcmp(argv[index], "--replay") == 0 && hasValue)
+				options.ReplayPath = argv[++index];
+			else if (strcmp(argv[index], "--replay-runs") == 0 && hasValue)
+				options.ReplayRuns = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--replay-frame") == 0 && hasValue)
+				options.ReplayFrame = atoi(argv[++index]);
+			else if (strcmp(argv[index], "--engine") == 0 && hasValue)
+			{
+				const char* engine{ argv[++index] };
+				options.IsEngineSet = true;
+				if (strcmp(engine, "runtime") == 0)
+					options.Engine = BehaviorTreeEngine::Runtime;
+				else if (strcmp(engine, "flat") == 0)
+					options.Engine = BehaviorTreeEngine::Flat;
+				else if (strcmp(engine, "reactive") == 0)
+					options.Engine = BehaviorTreeEngine::Reactive;
+				else if (strcmp(engine, "static") == 0)
+					options.Engine = BehaviorTreeEngine::Static;
+				else
+				{
+					printf("WARNING: unknown behavior tree engine %s\n", engine);
+					return false;
+				}
+			}
+			else
+			{
+				printf("WARNING: unknown option %s\n", argv[index]);
+				printf("Usage: %s [--seed N] [--time SECONDS] [--engine runtime|flat|reactive|static] [--bench-tree UPDATES] [--profile PREFIX] [--agents N] [--threads N] [--bench-houses N] [--bench-items N] [--bench-threats CALLS] [--bench-vectors N] [--bench-trig N] [--bench-grid N] [--bench-danger UPDATES] [--bench-leaves CALLS] [--check-mixed UPDATES] [--record FILE] [--record-compressed FILE] [--replay FILE] [--replay-runs N] [--replay-frame N]\n", argv[0]);
+				return false;
+			}
+		}
+
+		if (options.AgentCount > 0 && (!options.ProfilePrefix.empty() || options.IsEngineSet))
+		{
+			printf("WARNING: --agents always shares the runtime tree and can not be profiled\n");
+			return false;
+		}
+		if (!options.RecordPath.empty() && (options.AgentCount > 0 || !options.ReplayPath.empty()))
+		{
+			printf("WARNING: --record only records a single agent in the headless world\n");
+			return false;
+		}
+		if (options.ReplayRuns < 1)
+		{
+			printf("WARNING: --replay-runs needs at least one run\n");
+			return false;
+		}
+		if (options.ThreadCount < 0)
+		{
+			printf("WARNING: --threads can not be negative\n");
+			return false;
+		}
+		if (!options.ProfilePrefix.empty())
+		{
+#ifdef ELITE_BEHAVIOR_PROFILER
+			//Only the runtime tree is instrumented
+			options.Engine = BehaviorTreeEngine::Runtime;
+#else
+			printf("WARNING: --profile needs a build with GPP_BEHAVIOR_PROFILER enabled\n");
+			return false;
+#endif
+		}
+		return true;
+	}
+
+	//One plugin playing in one headless world
+	class Simulation final
+	{
+	public:
+		explicit Simulation(const SimulatorOptions& options, int seedOffset = 0)
+		{
+			m_pPlugin = static_cast<Plugin*>(Register());
+			m_pPlugin->DllInit();
+
+			GameDebugParams params{};
+			m_pPlugin->InitGameDebugParams(params);
+			if (options.Seed != -2)
+				params.Seed = options.Seed;
+			params.Seed += seedOffset;
+			m_Seed = params.Seed;
+
+			m_pWorld = new HeadlessWorld(params);
+			//The recorder sits between the plugin and the world, from the first call of Initialize on
+			if (!options.RecordPath.empty())
+			{
+				m_pRecorder = new RecordingInterface(m_pWorld, m_Seed);
+				if (!m_pRecorder->Open(options.RecordPath, options.IsRecordCompressed))
+					printf("WARNING: could not open %s\n", options.RecordPath.c_str());
+			}
+			PluginInfo info{};
+			m_pPlugin->Initialize(m_pRecorder != nullptr ? static_cast<IExamInterface*>(m_pRecorder) : m_pWorld, info);
+			m_pPlugin->SetBehaviorTreeEngine(options.Engine);
+		}
+		~Simulation()
+		{
+			m_pPlugin->DllShutdown();
+			SAFE_DELETE(m_pPlugin);
+			SAFE_DELETE(m_pRecorder);
+			SAFE_DELETE(m_pWorld);
+		}
+
+		Simulation(const Simulation& other) = delete;
+		Simulation& operator=(const Simulation& other) = delete;
+
+		bool IsRunning() const { return !m_pWorld->IsAgentDead() && !m_pWorld->IsShutdownRequested(); }
+		void Step()
+		{
+			m_pWorld->UpdatePerception();
+			if (m_pRecorder != nullptr)
+				m_pRecorder->BeginFrame(FixedDeltaTime);
+			const unsigned long long allocationCount{ g_HeapAllocationCount };
+			m_pPlugin->Update(FixedDeltaTime);
+			const SteeringPlugin_Output steering = m_pPlugin->UpdateSteering(FixedDeltaTime);
+			CountTickAllocations(allocationCount);
+			if (m_pRecorder != nullptr)
+				m_pRecorder->EndFrame(steering);
+			m_pWorld->Step(steering, FixedDeltaTime);
+		}
+		//Step in two halves, for a behavior tree that is updated by the caller in between
+		void BeginStep()
+		{
+			m_pWorld->UpdatePerception();
+			m_pPlugin->Update(FixedDeltaTime);
+			m_pPlugin->UpdateBlackboard(FixedDeltaTime);
+		}
+		void EndStep()
+		{
+			m_pWorld->Step(m_pPlugin->GetSteeringOutput(), FixedDeltaTime);
+		}
+		float Run(float maxTime)
+		{
+			float time{};
+			while (IsRunning() && time < maxTime)
+			{
+				Step();
+				time += FixedDeltaTime;
+			}
+			return time;
+		}
+
+		Plugin* GetPlugin() const { return m_pPlugin; }
+		HeadlessWorld* GetWorld() const { return m_pWorld; }
+		RecordingInterface* GetRecorder() const { return m_pRecorder; }
+		int GetSeed() const { return m_Seed; }
+
+		//Heap allocations made by the plugin (and the host calls it makes) during the ticks of Step
+		//The first ticks are left out of the steady state, that is where the plugin's lists grow to their size
+		void PrintAllocationStats() const
+		{
+			printf("heap allocations: %llu in %u ticks, %llu in the %u ticks after the first %u, %u ticks allocated after those\n",
+				m_TickAllocationCount, m_TickCount, m_SteadyAllocationCount, m_TickCount > WarmUpTicks ? m_TickCount - WarmUpTicks : 0,
+				WarmUpTicks, m_SteadyAllocatingTickCount);
+		}
+
+	private:
+		static const unsigned int WarmUpTicks{ 600 };
+
+		Plugin* m_pPlugin{ nullptr };
+		HeadlessWorld* m_pWorld{ nullptr };
+		RecordingInterface* m_pRecorder{ nullptr };
+		int m_Seed{ -1 };
+		unsigned int m_TickCount{};
+		unsigned long long m_TickAllocationCount{};
+		unsigned long long m_SteadyAllocationCount{};
+		unsigned int m_SteadyAllocatingTickCount{};
+
+		void CountTickAllocations(unsigned long long startCount)
+		{
+			const unsigned long long allocationCount{ g_HeapAllocationCount - startCount };
+			m_TickAllocationCount += allocationCount;
+			if (m_TickCount++ >= WarmUpTicks)
+			{
+				m_SteadyAllocationCount += allocationCount;
+				m_SteadyAllocatingTickCount += allocationCount > 0;
+			}
+		}
+	};
+
+	double GetSeconds(const Clock::time_point& start, const Clock::time_point& end)
+	{
+		return std::chrono::duration<double>(end - start).count();
+	}
+
+	int RunSimulation(const SimulatorOptions& options)
+	{
+		Simulation simulation{ options };
+
+		const Clock::time_point start = Clock::now();
+		const float time = simulation.Run(options.MaxTime);
+		const double wallTime = GetSeconds(start, Clock::now());
+
+		const StatisticsInfo stats = simulation.GetWorld()->World_GetStats();
+		const AgentInfo agent = simulation.GetWorld()->Agent_GetInfo();
+		printf("seed %d, engine %s\n", simulation.GetSeed(), GetEngineName(options.Engine));
+		printf("survived %.2fs (%s), score %d\n", stats.TimeSurvived, agent.Death ? "dead" : "alive", stats.Score);
+		printf("health %.2f, energy %.2f, stamina %.2f\n", agent.Health, agent.Energy, agent.Stamina);
+		printf("items picked up %d, enemies hit %d, enemies killed %d, missed shots %d\n",
+			stats.NumItemsPickUp, stats.NumEnemiesHit, stats.NumEnemiesKilled, stats.NumMissedShots);
+		printf("simulated %.2fs in %.3fs wall time (%.0f simulated seconds per second)\n",
+			time, wallTime, wallTime > 0.0 ? time / wallTime : 0.0);
+
+		//Every engine shares the blackboard of the runtime tree
+		const BehaviorTree* pRuntimeTree = static_cast<const BehaviorTree*>(simulation.GetPlugin()->GetBehaviorTree(BehaviorTreeEngine::Runtime));
+		pRuntimeTree->GetBlackboard()->PrintMemoStats();
+		simulation.GetPlugin()->GetInventory()->PrintHostCallStats();
+		simulation.GetPlugin()->GetPathCache()->PrintStats();
+		simulation.GetPlugin()->GetDangerField()->PrintStats();
+		simulation.GetPlugin()->GetFrameArena()->PrintStats();
+		simulation.PrintAllocationStats();
+		if (RecordingInterface* pRecorder = simulation.GetRecorder())
+		{
+			if (!pRecorder->Close())
+			{
+				printf("WARNING: could not write %s\n", options.RecordPath.c_str());
+				return 1;
+			}
+			printf("recorded %u frames in %zu chunks to %s, %llu bytes raw, %llu bytes in the file (%.0f bytes per frame)\n",
+				pRecorder->GetFrameCount(), pRecorder->GetChunkCount(), options.RecordPath.c_str(), pRecorder->GetRawSize(), pRecorder->GetFileSize(),
+				pRecorder->GetFrameCount() > 0 ? double(pRecorder->GetFileSize()) / pRecorder->GetFrameCount() : 0.0);
+		}
+		if (options.Engine == BehaviorTreeEngine::Reactive)
+			static_cast<const FlatBehaviorTree*>(simulation.GetPlugin()->GetBehaviorTree(options.Engine))->PrintReactiveStats();
+
+#ifdef ELITE_BEHAVIOR_PROFILER
+		if (!options.ProfilePrefix.empty())
+		{
+			BehaviorTree* pTree = static_cast<BehaviorTree*>(simulation.GetPlugin()->GetBehaviorTree(BehaviorTreeEngine::Runtime));
+			const BehaviorProfiler& profiler = pTree->GetProfiler();
+			profiler.PrintBreakdown();
+			profiler.WriteCSV(options.ProfilePrefix + ".csv");
+			profiler.WriteJSON(options.ProfilePrefix + ".json");
+			profiler.WriteFoldedStacks(options.ProfilePrefix + ".folded");
+		}
+#endif
+		return 0;
+	}
+
+	//Many agents, each in its own world, all updated with the runtime tree of the first agent
+	//Agents whose simulation stopped are no longer updated or counted
+	int RunBatch(const SimulatorOptions& options)
+	{
+		std::vector<std::unique_ptr<Simulation>> simulations{};
+		for (int agent{}; agent < options.AgentCount; ++agent)
+			simulations.push_back(std::unique_ptr<Simulation>(new Simulation(options, agent)));
+
+		BehaviorTree* pSharedTree = static_cast<BehaviorTree*>(simulations[0]->GetPlugin()->GetBehaviorTree(BehaviorTreeEngine::Runtime));
+#ifdef ELITE_BEHAVIOR_PROFILER
+		pSharedTree->GetProfiler().Detach();
+#endif
+		BehaviorTreeBatch batch{ pSharedTree->GetRootBehavior(), unsigned(options.ThreadCount) };
+		for (const std::unique_ptr<Simulation>& pSimulation : simulations)
+			batch.AddAgent(pSimulation->GetPlugin()->GetBlackboard());
+
+		const Clock::time_point start = Clock::now();
+		double treeTime{};
+		unsigned long long updates{};
+		float time{};
+		bool isAnyRunning{ true };
+		while (isAnyRunning && time < options.MaxTime)
+		{
+			for (const std::unique_ptr<Simulation>& pSimulation : simulations)
+			{
+				if (pSimulation->IsRunning())
+					pSimulation->BeginStep();
+			}
+
+			const Clock::time_point treeStart = Clock::now();
+			batch.Update(FixedDeltaTime);
+			treeTime += GetSeconds(treeStart, Clock::now());
+			updates += batch.GetActiveAgentCount();
+
+			isAnyRunning = false;
+			for (unsigned int agent{}; agent < simulations.size(); ++agent)
+			{
+				Simulation& simulation = *simulations[agent];
+				if (!simulation.IsRunning())
+					continue;
+				simulation.EndStep();
+				if (simulation.IsRunning())
+					isAnyRunning = true;
+				else
+					batch.SetAgentActive(agent, false);
+			}
+			time += FixedDeltaTime;
+		}
+		const double wallTime = GetSeconds(start, Clock::now());
+
+		int alive{};
+		long long totalScore{};
+		double totalSurvived{};
+		for (const std::unique_ptr<Simulation>& pSimulation : simulations)
+		{
+			const StatisticsInfo stats = pSimulation->GetWorld()->World_GetStats();
+			alive += pSimulation->GetWorld()->IsAgentDead() ? 0 : 1;
+			totalScore += stats.Score;
+			totalSurvived += stats.TimeSurvived;
+		}
+		printf("agents %d (seeds %d to %d), threads %u\n", options.AgentCount, simulations.front()->GetSeed(),
+			simulations.back()->GetSeed(), batch.GetThreadCount());
+		printf("alive %d, average survived %.2fs, total score %lld\n", alive, totalSurvived / options.AgentCount, totalScore);
+		printf("behavior tree: %llu agent updates in %.3fs (%.0f agent updates per second)\n",
+			updates, treeTime, treeTime > 0.0 ? updates / treeTime : 0.0);
+		printf("simulated %.2fs in %.3fs wall time\n", time, wallTime);
+		return 0;
+	}
+
+	//Compares the known houses index with the linear scans it replaced, on synthetic houses
+	int RunHouseBenchmark(const SimulatorOptions& options)
+	{
+		const int houseCount{ options.BenchHouses };
+		const int queryCount{ 20000 };
+		std::mt19937 rng{ unsigned(options.Seed != -2 ? options.Seed : 0) };
+		std::uniform_real_distribution<float> jitter{ -4.f, 4.f };
+		std::uniform_real_distribution<float> size{ 10.f, 30.f };
+
+		//Houses on a jittered grid, every house is added twice like when it stays in view
+		const int columns{ int(ceil(sqrt(float(houseCount)))) };
+		const float spacing{ 40.f };
+		std::vector<HouseInfo> houses{};
+		for (int index{}; index < houseCount; ++index)
+		{
+			HouseInfo house{};
+			house.Center = { (index % columns) * spacing + jitter(rng), (index / columns) * spacing + jitter(rng) };
+			house.Size = { size(rng), size(rng) };
+			houses.push_back(house);
+		}
+		const std::vector<HouseInfo> firstSight{ houses };
+		houses.insert(houses.end(), firstSight.begin(), firstSight.end());
+
+		std::uniform_real_distribution<float> position{ -spacing, columns * spacing };
+		std::vector<Elite::Vector2> points{};
+		for (int index{}; index < queryCount; ++index)
+			points.push_back({ position(rng), position(rng) });
+
+		//Linear, like Plugin::UpdateHousesFOV and BT_Conditions::IsInsideHouse did
+		Clock::time_point start = Clock::now();
+		std::vector<HouseSearch> linearHouses{};
+		for (const HouseInfo& house : houses)
+		{
+			bool isNewHouse{ true };
+			for (const HouseSearch& houseSearch : linearHouses)
+			{
+				if (Elite::DistanceSquared(house.Center, houseSearch.Center) < houseSearch.acceptanceRadius * houseSearch.acceptanceRadius)
+					isNewHouse = false;
+			}
+			if (isNewHouse)
+				linearHouses.push_back(HouseSearch(house));
+		}
+		const double linearAddTime = GetSeconds(start, Clock::now());
+
+		start = Clock::now();
+		std::vector<int> linearResults{};
+		for (const Elite::Vector2& point : points)
+		{
+			int result{ -1 };
+			for (size_t index{}; index < linearHouses.size(); ++index)
+			{
+				if (linearHouses[index].IsPointInsideHouse(point))
+				{
+					result = int(index);
+					break;
+				}
+			}
+			linearResults.push_back(result);
+		}
+		const double linearQueryTime = GetSeconds(start, Clock::now());
+
+		//Indexed
+		start = Clock::now();
+		KnownHouses knownHouses{};
+		for (const HouseInfo& house : houses)
+			knownHouses.AddHouse(house);
+		const double indexAddTime = GetSeconds(start, Clock::now());
+
+		start = Clock::now();
+		std::vector<const HouseSearch*> indexResults{};
+		for (const Elite::Vector2& point : points)
+			indexResults.push_back(knownHouses.FindHouseContaining(point));
+		const double indexQueryTime = GetSeconds(start, Clock::now());
+
+		//Both keep the houses in the order they were added, so the same house has the same center
+		int mismatches{ knownHouses.Size() == linearHouses.size() ? 0 : 1 };
+		for (int index{}; index < queryCount; ++index)
+		{
+			const HouseSearch* pHouse = indexResults[index];
+			const int linearResult{ linearResults[index] };
+			if ((pHouse == nullptr) != (linearResult == -1) || (pHouse != nullptr && pHouse->Center != linearHouses[linearResult].Center))
+				++mismatches;
+		}
+
+		printf("%d houses added twice, %u known, %d point queries, %d mismatches\n", houseCount, unsigned(knownHouses.Size()), queryCount, mismatches);
+		printf("linear  add %.3fs (%.1f us per house), query %.3fs (%.1f ns per query)\n", linearAddTime, linearAddTime * 1e6 / houses.size(),
+			linearQueryTime, linearQueryTime * 1e9 / queryCount);
+		printf("indexed add %.3fs (%.1f us per house), query %.3fs (%.1f ns per query)\n", indexAddTime, indexAddTime * 1e6 / houses.size(),
+			indexQueryTime, indexQueryTime * 1e9 / queryCount);
+		return mismatches == 0 ? 0 : 1;
+	}
+
+	//Compares the known items index with the linear scans it replaced, on synthetic items
+	int RunItemBenchmark(const SimulatorOptions& options)
+	{
+		const int itemCount{ options.BenchItems };
+		const int queryCount{ 20000 };
+		const float maxRange{ 100.f };
+		std::mt19937 rng{ unsigned(options.Seed != -2 ? options.Seed : 0) };
+		const float worldSize{ sqrt(float(itemCount)) * 20.f };
+		std::uniform_real_distribution<float> position{ 0.f, worldSize };
+		std::uniform_int_distribution<int> type{ int(eItemType::PISTOL), int(eItemType::GARBAGE) };
+
+		//Every item is seen twice, like when it stays in view
+		std::vector<ItemInfo> items{};
+		for (int index{}; index < itemCount; ++index)
+		{
+			ItemInfo item{};
+			item.Type = eItemType(type(rng));
+			item.Location = { position(rng), position(rng) };
+			items.push_back(item);
+		}
+		const std::vector<ItemInfo> firstSight{ items };
+		items.insert(items.end(), firstSight.begin(), firstSight.end());
+
+		const std::vector<eItemType> neededTypes{ eItemType::SHOTGUN, eItemType::PISTOL, eItemType::MEDKIT };
+		std::vector<Elite::Vector2> points{};
+		for (int index{}; index < queryCount; ++index)
+			points.push_back({ position(rng), position(rng) });
+
+		//Linear, like BT_Actions::RememberItem and BT_Conditions::ShouldPickupKnownItem did
+		Clock::time_point start = Clock::now();
+		std::vector<ItemInfo> linearItems{};
+		for (const ItemInfo& item : items)
+		{
+			bool isNewItem{ true };
+			for (const ItemInfo& knownItem : linearItems)
+			{
+				if (knownItem.Location.Distance(item.Location) < 0.1f)
+					isNewItem = false;
+			}
+			if (isNewItem)
+				linearItems.push_back(item);
+		}
+		const double linearAddTime = GetSeconds(start, Clock::now());
+
+		start = Clock::now();
+		std::vector<int> linearResults{};
+		for (const Elite::Vector2& point : points)
+		{
+			float closestDistance{ FLT_MAX };
+			int result{ -1 };
+			for (eItemType neededType : neededTypes)
+			{
+				for (size_t index{}; index < linearItems.size(); ++index)
+				{
+					const float distance{ point.Distance(linearItems[index].Location) };
+					if (linearItems[index].Type == neededType && distance < closestDistance)
+					{
+						closestDistance = distance;
+						result = int(index);
+					}
+				}
+			}
+			linearResults.push_back(closestDistance <= maxRange ? result : -1);
+		}
+		const double linearQueryTime = GetSeconds(start, Clock::now());
+
+		//Indexed
+		start = Clock::now();
+		KnownItems knownItems{};
+		for (const ItemInfo& item : items)
+			knownItems.AddItem(item);
+		const double indexAddTime = GetSeconds(start, Clock::now());
+
+		start = Clock::now();
+		std::vector<ItemInfo> indexResults(queryCount);
+		std::vector<bool> isFound(queryCount);
+		for (int index{}; index < queryCount; ++index)
+			isFound[index] = knownItems.FindClosestItem(neededTypes, points[index], maxRange, indexResults[index]);
+		const double indexQueryTime = GetSeconds(start, Clock::now());
+
+		int mismatches{ knownItems.Size() == linearItems.size() ? 0 : 1 };
+		for (int index{}; index < queryCount; ++index)
+		{
+			const int linearResult{ linearResults[index] };
+			if (isFound[index] != (linearResult != -1) || (isFound[index] && indexResults[index].Location != linearItems[linearResult].Location))
+				++mismatches;
+		}
+
+		printf("%d items added twice, %u known, %d nearest queries, %d mismatches\n", itemCount, knownItems.Size(), queryCount, mismatches);
+		printf("linear  add %.3fs (%.1f us per item), query %.3fs (%.1f ns per query)\n", linearAddTime, linearAddTime * 1e6 / items.size(),
+			linearQueryTime, linearQueryTime * 1e9 / queryCount);
+		printf("indexed add %.3fs (%.1f us per item), query %.3fs (%.1f ns per query)\n", indexAddTime, indexAddTime * 1e6 / items.size(),
+			indexQueryTime, indexQueryTime * 1e9 / queryCount);
+		return mismatches == 0 ? 0 : 1;
+	}
+
+	//Times the scalar and vector enemy threat scoring on the same enemies, for a few enemy counts
+	int RunThreatBenchmark(const SimulatorOptions& options)
+	{
+		const int callCount{ options.BenchThreatCalls };
+		const UINT enemyCounts[]{ 8, 64, 1024 };
+		const eEnemyType types[]{ eEnemyType::ZOMBIE_NORMAL, eEnemyType::ZOMBIE_RUNNER, eEnemyType::ZOMBIE_HEAVY };
+		std::mt19937 rng{ unsigned(options.Seed != -2 ? options.Seed : 0) };
+		std::uniform_real_distribution<float> position{ -30.f, 30.f };
+		std::uniform_real_distribution<float> velocity{ -6.f, 6.f };
+		std::uniform_int_distribution<int> type{ 0, 2 };
+
+		printf("vector path: %s\n", EnemyThreats::GetInstructionSet());
+		int mismatches{};
+		for (UINT enemyCount : enemyCounts)
+		{
+			std::vector<EnemyInfo> enemies(enemyCount);
+			for (EnemyInfo& enemy : enemies)
+			{
+				enemy.Type = types[type(rng)];
+				enemy.Location = { position(rng), position(rng) };
+				enemy.LinearVelocity = { velocity(rng), velocity(rng) };
+				enemy.Size = enemy.Type == eEnemyType::ZOMBIE_HEAVY ? 2.5f : 1.5f;
+				enemy.Health = enemy.Type == eEnemyType::ZOMBIE_HEAVY ? 5.f : 2.f;
+			}
+			const Elite::Vector2 playerPosition{ 1.f, -2.f };
+			const Elite::Vector2 playerVelocity{ 3.f, 1.f };
+
+			EnemyThreats scalarThreats{};
+			EnemyThreats vectorThreats{};
+			UINT scalarThreat{};
+			UINT vectorThreat{};
+			Clock::time_point start = Clock::now();
+			for (int call{}; call < callCount; ++call)
+				scalarThreats.EvaluateScalar(enemies, playerPosition, playerVelocity, scalarThreat);
+			const double scalarTime = GetSeconds(start, Clock::now());
+
+			start = Clock::now();
+			for (int call{}; call < callCount; ++call)
+				vectorThreats.Evaluate(enemies, playerPosition, playerVelocity, vectorThreat);
+			const double vectorTime = GetSeconds(start, Clock::now());
+
+			//Same operations in the same order, so the scores are expected to be exactly equal
+			int countMismatches{ scalarThreat == vectorThreat ? 0 : 1 };
+			for (UINT index{}; index < enemyCount; ++index)
+			{
+				if (scalarThreats.GetScore(index) != vectorThreats.GetScore(index) || scalarThreats.GetTimeToContact(index) != vectorThreats.GetTimeToContact(index))
+					++countMismatches;
+			}
+			mismatches += countMismatches;
+
+			printf("%4u enemies: scalar %.1f ns per call (%.2f ns per enemy), %s %.1f ns per call (%.2f ns per enemy), %.1fx, %d mismatches\n",
+				enemyCount, scalarTime * 1e9 / callCount, scalarTime * 1e9 / callCount / enemyCount,
+				EnemyThreats::GetInstructionSet(), vectorTime * 1e9 / callCount, vectorTime * 1e9 / callCount / enemyCount,
+				vectorTime > 0.0 ? scalarTime / vectorTime : 0.0, countMismatches);
+		}
+		return mismatches == 0 ? 0 : 1;
+	}
+
+	//Checks every Vector2Batch function against the Vector2 functions it replaces, and times both
+	int RunVectorBenchmark(const SimulatorOptions& options)
+	{
+		const unsigned int pointCount{ unsigned(options.BenchVectors) };
+		const int repeatCount{ (std::max)(1, int(4000000 / pointCount)) };
+		std::mt19937 rng{ unsigned(options.Seed != -2 ? options.Seed : 0) };
+		std::uniform_real_distribution<float> coordinate{ -100.f, 100.f };
+
+		//A few (almost) zero vectors for Normalize
+		std::vector<Elite::Vector2> points(pointCount);
+		for (unsigned int index{}; index < pointCount; ++index)
+			points[index] = index % 97 == 0 ? Elite::Vector2{ 0.f, 0.f } : index % 89 == 0 ? Elite::Vector2{ 1e-8f, 0.f } : Elite::Vector2{ coordinate(rng), coordinate(rng) };
+		const Elite::Vector2 point{ coordinate(rng), coordinate(rng) };
+		const Elite::Vector2 direction{ Elite::Vector2{ coordinate(rng), coordinate(rng) }.GetNormalized() };
+		const float radius{ 50.f };
+
+		Elite::Vector2Batch batch{ pointCount };
+		batch.Assign(points);
+		std::vector<float> results(pointCount);
+		std::vector<unsigned int> mask((pointCount + 31) / 32);
+
+		//Correctness, the results have to be exactly the same
+		int mismatches{};
+		batch.DistanceSquared(point, results.data());
+		for (unsigned int index{}; index < pointCount; ++index)
+			mismatches += results[index] != Elite::DistanceSquared(points[index], point);
+		batch.Dot(direction, results.data());
+		for (unsigned int index{}; index < pointCount; ++index)
+			mismatches += results[index] != Elite::Dot(points[index], direction);
+
+		unsigned int closestIndex{};
+		float closestDistanceSquared{ FLT_MAX };
+		unsigned int withinCount{};
+		for (unsigned int index{}; index < pointCount; ++index)
+		{
+			const float distanceSquared{ Elite::DistanceSquared(points[index], point) };
+			if (distanceSquared < closestDistanceSquared)
+			{
+				closestDistanceSquared = distanceSquared;
+				closestIndex = index;
+			}
+			withinCount += distanceSquared <= radius * radius;
+		}
+		mismatches += batch.ArgMinDistance(point) != closestIndex;
+		mismatches += batch.WithinRadius(point, radius, mask.data()) != withinCount;
+		for (unsigned int index{}; index < pointCount; ++index)
+			mismatches += ((mask[index / 32] >> (index % 32)) & 1U) != unsigned(Elite::DistanceSquared(points[index], point) <= radius * radius);
+
+		batch.Normalize();
+		for (unsigned int index{}; index < pointCount; ++index)
+			mismatches += batch.Get(index) != points[index].GetNormalized();
+		printf("vector path: %s, %u points, %d mismatches\n", Elite::Vector2Batch::GetInstructionSet(), pointCount, mismatches);
+
+		//Timing, each function over all the points
+		batch.Assign(points);
+		volatile float sink{}; //Keeps the results alive
+		Clock::time_point start = Clock::now();
+		for (int repeat{}; repeat < repeatCount; ++repeat)
+		{
+			for (unsigned int index{}; index < pointCount; ++index)
+				results[index] = Elite::DistanceSquared(points[index], point);
+			sink += results[repeat % pointCount];
+		}
+		const double scalarDistanceTime = GetSeconds(start, Clock::now());
+		start = Clock::now();
+		for (int repeat{}; repeat < repeatCount; ++repeat)
+		{
+			batch.DistanceSquared(point, results.data());
+			sink += results[repeat % pointCount];
+		}
+		const double batchDistanceTime = GetSeconds(start, Clock::now());
+
+		start = Clock::now();
+		for (int repeat{}; repeat < repeatCount; ++repeat)
+		{
+			unsigned int scalarClosestIndex{};
+			float scalarClosestDistanceSquared{ FLT_MAX };
+			for (unsigned int index{}; index < pointCount; ++index)
+			{
+				const float distanceSquared{ Elite::DistanceSquared(points[index], point) };
+				if (distanceSquared < scalarClosestDistanceSquared)
+				{
+					scalarClosestDistanceSquared = distanceSquared;
+					scalarClosestIndex = index;
+				}
+			}
+			sink += float(scalarClosestIndex);
+		}
+		const double scalarClosestTime = GetSeconds(start, Clock::now());
+		start = Clock::now();
+		for (int repeat{}; repeat < repeatCount; ++repeat)
+			sink += float(batch.ArgMinDistance(point));
+		const double batchClosestTime = GetSeconds(start, Clock::now());
+
+		const double callsPerPoint{ 1e9 / (double(repeatCount) * pointCount) };
+		printf("DistanceSquared: Vector2 %.2f ns per point, Vector2Batch %.2f ns per point\n", scalarDistanceTime * callsPerPoint, batchDistanceTime * callsPerPoint);
+		printf("closest point:   Vector2 %.2f ns per point, Vector2Batch %.2f ns per point\n", scalarClosestTime * callsPerPoint, batchClosestTime * callsPerPoint);
+		return mismatches == 0 ? 0 : 1;
+	}
+
+	//Measures the error of the fast trig functions against the standard library, and times both
+	int RunTrigBenchmark(const SimulatorOptions& options)
+	{
+		const unsigned int angleCount{ unsigned(options.BenchTrig) };
+		const int repeatCount{ (std::max)(1, int(4000000 / angleCount)) };
+		const float atan2Bound{ 2e-5f };
+		const float sinCosBound{ 1e-6f };
+		std::mt19937 rng{ unsigned(options.Seed != -2 ? options.Seed : 0) };
+		std::uniform_real_distribution<float> coordinate{ -100.f, 100.f };
+		//The orientations the plugin sees, a few turns either way
+		std::uniform_real_distribution<float> orientation{ -4.f * Elite::FastTrig::Pi, 4.f * Elite::FastTrig::Pi };
+
+		//Axis aligned and zero vectors for the octant edges
+		std::vector<float> ys(angleCount), xs(angleCount), angles(angleCount);
+		for (unsigned int index{}; index < angleCount; ++index)
+		{
+			ys[index] = index % 101 == 0 ? 0.f : coordinate(rng);
+			xs[index] = index % 103 == 0 ? 0.f : coordinate(rng);
+			angles[index] = orientation(rng);
+		}
+		std::vector<float> results(angleCount), sines(angleCount), cosines(angleCount);
+
+		//Accuracy, scalar and batch
+		float atan2Error{}, sinCosError{};
+		Elite::FastAtan2(ys.data(), xs.data(), results.data(), angleCount);
+		Elite::FastSinCos(angles.data(), sines.data(), cosines.data(), angleCount);
+		for (unsigned int index{}; index < angleCount; ++index)
+		{
+			const float exactAngle{ atan2f(ys[index], xs[index]) };
+			atan2Error = (std::max)(atan2Error, fabsf(Elite::FastAtan2(ys[index], xs[index]) - exactAngle));
+			atan2Error = (std::max)(atan2Error, fabsf(results[index] - exactAngle));
+
+			const float exactSine{ sinf(angles[index]) };
+			const float exactCosine{ cosf(angles[index]) };
+			sinCosError = (std::max)(sinCosError, (std::max)(fabsf(sines[index] - exactSine), fabsf(cosines[index] - exactCosine)));
+		}
+		const bool isAccurate{ atan2Error <= atan2Bound && sinCosError <= sinCosBound };
+		printf("%u angles, max error: atan2 %.2e (bound %.0e), sincos %.2e (bound %.0e)%s\n",
+			angleCount, atan2Error, atan2Bound, sinCosError, sinCosBound, isAccurate ? "" : ", OUT OF BOUNDS");
+
+		//Timing, each function over all the angles
+		volatile float sink{}; //Keeps the results alive
+		Clock::time_point start = Clock::now();
+		for (int repeat{}; repeat < repeatCount; ++repeat)
+		{
+			for (unsigned int index{}; index < angleCount; ++index)
+				results[index] = atan2f(ys[index], xs[index]);
+			sink += results[repeat % angleCount];
+		}
+		const double exactAtan2Time = GetSeconds(start, Clock::now());
+		start = Clock::now();
+		for (int repeat{}; repeat < repeatCount; ++repeat)
+		{
+			for (unsigned int index{}; index < angleCount; ++index)
+				results[index] = Elite::FastAtan2(ys[index], xs[index]);
+			sink += results[repeat % angleCount];
+		}
+		const double fastAtan2Time = GetSeconds(start, Clock::now());
+		start = Clock::now();
+		for (int repeat{}; repeat < repeatCount; ++repeat)
+		{
+			Elite::FastAtan2(ys.data(), xs.data(), results.data(), angleCount);
+			sink += results[repeat % angleCount];
+		}
+		const double batchAtan2Time = GetSeconds(start, Clock::now());
+
+		start = Clock::now();
+		for (int repeat{}; repeat < repeatCount; ++repeat)
+		{
+			for (unsigned int index{}; index < angleCount; ++index)
+			{
+				sines[index] = sinf(angles[index]);
+				cosines[index] = cosf(angles[index]);
+			}
+			sink += sines[repeat % angleCount] + cosines[repeat % angleCount];
+		}
+		const double exactSinCosTime = GetSeconds(start, Clock::now());
+		start = Clock::now();
+		for (int repeat{}; repeat < repeatCount; ++repeat)
+		{
+			Elite::FastSinCos(angles.data(), sines.data(), cosines.data(), angleCount);
+			sink += sines[repeat % angleCount] + cosines[repeat % angleCount];
+		}
+		const double batchSinCosTime = GetSeconds(start, Clock::now());
+
+		const double callsPerAngle{ 1e9 / (double(repeatCount) * angleCount) };
+		printf("atan2:  atan2f %.2f ns per call, FastAtan2 %.2f ns per call, batch %.2f ns per angle\n",
+			exactAtan2Time * callsPerAngle, fastAtan2Time * callsPerAngle, batchAtan2Time * callsPerAngle);
+		printf("sincos: sinf + cosf %.2f ns per call, batch %.2f ns per angle\n",
+			exactSinCosTime * callsPerAngle, batchSinCosTime * callsPerAngle);
+		return isAccurate ? 0 : 1;
+	}
+
+	//Shortest grid path with Dijkstra and the same moves as NavigationGrid, as a reference for its jump point search
+	float GetReferencePathCost(const NavigationGrid& grid, int startX, int startY, int goalX, int goalY)
+	{
+		const int width{ grid.GetWidth() };
+		std::vector<float> costs(size_t(width) * grid.GetHeight(), FLT_MAX);
+		typedef std::pair<float, int> QueueNode;
+		std::priority_queue<QueueNode, std::vector<QueueNode>, std::greater<QueueNode>> queue{};
+		costs[startY * width + startX] = 0.f;
+		queue.push({ 0.f, startY * width + startX });
+		while (!queue.empty())
+		{
+			const QueueNode node{ queue.top() };
+			queue.pop();
+			const int x{ node.second % width };
+			const int y{ node.second / width };
+			if (x == goalX && y == goalY)
+				return node.first;
+			if (node.first > costs[node.second])
+				continue;
+			for (int offsetY{ -1 }; offsetY <= 1; ++offsetY)
+			{
+				for (int offsetX{ -1 }; offsetX <= 1; ++offsetX)
+				{
+					const bool isDiagonal{ offsetX != 0 && offsetY != 0 };
+					if ((offsetX == 0 && offsetY == 0) || grid.IsBlocked(x + offsetX, y + offsetY)
+						|| (isDiagonal && (grid.IsBlocked(x + offsetX, y) || grid.IsBlocked(x, y + offsetY))))
+						continue;
+					const float cost{ node.first + (isDiagonal ? 1.41421356f : 1.f) * grid.GetCellSize() };
+					const int index{ (y + offsetY) * width + x + offsetX };
+					if (cost < costs[index])
+					{
+						costs[index] = cost;
+						queue.push({ cost, index });
+					}
+				}
+			}
+		}
+		return FLT_MAX;
+	}
+
+	//Times the jump point search of the navigation grid on an N by N grid with houses like the simulator world, checked against Dijkstra
+	int RunGridBenchmark(const SimulatorOptions& options)
+	{
+		const int gridSize{ options.BenchGrid };
+		const int queryCount{ 1000 };
+		const int referenceCount{ 20 };
+		std::mt19937 rng{ unsigned(options.Seed != -2 ? options.Seed : 0) };
+		std::uniform_real_distribution<float> unit{ 0.f, 1.f };
+		std::uniform_real_distribution<float> houseSize{ 20.f, 40.f };
+
+		//Houses on a grid, with the door in the middle of the bottom wall opened like the agent walked through it
+		const float spacing{ 60.f };
+		std::vector<HouseSearch> houses{};
+		for (float y{ spacing / 2.f }; y + spacing / 2.f <= gridSize; y += spacing)
+		{
+			for (float x{ spacing / 2.f }; x + spacing / 2.f <= gridSize; x += spacing)
+			{
+				if (unit(rng) > 0.6f)
+					continue;
+				HouseInfo house{};
+				house.Center = { x, y };
+				house.Size = { houseSize(rng), houseSize(rng) };
+				houses.push_back(HouseSearch(house));
+			}
+		}
+
+		const float size{ float(gridSize) };
+		NavigationGrid grid{ Elite::Vector2{ size / 2.f, size / 2.f }, Elite::Vector2{ size, size } };
+		Clock::time_point start = Clock::now();
+		for (const HouseSearch& house : houses)
+			grid.AddHouse(house);
+		const double addTime = GetSeconds(start, Clock::now());
+		for (const HouseSearch& house : houses)
+		{
+			const float bottom{ house.Center.y - house.Size.y / 2.f };
+			for (float y{ bottom - 1.f }; y <= bottom + house.wallThickness + 1.f; y += 0.5f)
+			{
+				for (float x{ house.Center.x - 2.f }; x <= house.Center.x + 2.f; x += 0.5f)
+					grid.MarkWalkable({ x, y }, 0.5f);
+			}
+		}
+
+		//Free cells, half of the goals inside a house
+		std::vector<Elite::Vector2> starts{}, goals{};
+		while (int(starts.size()) < queryCount)
+		{
+			const Elite::Vector2 startPoint{ unit(rng) * size, unit(rng) * size };
+			Elite::Vector2 goalPoint{ unit(rng) * size, unit(rng) * size };
+			if (!houses.empty() && starts.size() % 2 == 0)
+				goalPoint = houses[starts.size() % houses.size()].Center;
+			if (grid.IsBlocked(int(startPoint.x), int(startPoint.y)) || grid.IsBlocked(int(goalPoint.x), int(goalPoint.y)))
+				continue;
+			starts.push_back(startPoint);
+			goals.push_back(goalPoint);
+		}
+
+		std::vector<float> costs(queryCount);
+		unsigned long long expandedJumpPoints{};
+		start = Clock::now();
+		for (int query{}; query < queryCount; ++query)
+		{
+			costs[query] = grid.GetPathCost(starts[query], goals[query]);
+			expandedJumpPoints += grid.GetExpandedJumpPoints();
+		}
+		const double searchTime = GetSeconds(start, Clock::now());
+
+		std::vector<Elite::Vector2> path{};
+		size_t waypointCount{};
+		int unreachable{};
+		start = Clock::now();
+		for (int query{}; query < queryCount; ++query)
+		{
+			unreachable += !grid.FindPath(starts[query], goals[query], path);
+			waypointCount += path.size();
+		}
+		const double pathTime = GetSeconds(start, Clock::now());
+
+		int mismatches{};
+		for (int query{}; query < referenceCount; ++query)
+		{
+			const float reference{ GetReferencePathCost(grid, int(starts[query].x), int(starts[query].y), int(goals[query].x), int(goals[query].y)) };
+			if (reference == FLT_MAX ? costs[query] != FLT_MAX : fabsf(costs[query] - reference) > 1e-3f * reference)
+				++mismatches;
+		}
+
+		printf("%dx%d grid, %u houses added in %.2f us per house, %d queries, %d unreachable\n",
+			gridSize, gridSize, unsigned(houses.size()), houses.empty() ? 0.0 : addTime * 1e6 / houses.size(), queryCount, unreachable);
+		printf("path cost: %.2f us per query, %.0f jump points expanded per query\n", searchTime * 1e6 / queryCount, double(expandedJumpPoints) / queryCount);
+		printf("FindPath:  %.2f us per query, %.1f waypoints per path\n", pathTime * 1e6 / queryCount, double(waypointCount) / (queryCount - unreachable));
+		printf("reference: %d of %d costs differ from Dijkstra\n", mismatches, referenceCount);
+		return mismatches == 0 ? 0 : 1;
+	}
+
+	//Times the danger field with a walking agent and wandering enemies, checked against a field that is recomputed every update
+	int RunDangerBenchmark(const SimulatorOptions& options)
+	{
+		const int updateCount{ options.BenchDangerUpdates };
+		const int enemyCount{ 8 };
+		const float worldSize{ 200.f };
+		std::mt19937 rng{ unsigned(options.Seed != -2 ? options.Seed : 0) };
+		std::uniform_real_distribution<float> unit{ 0.f, 1.f };
+
+		NavigationGrid grid{ Elite::Vector2{ worldSize / 2.f, worldSize / 2.f }, Elite::Vector2{ worldSize, worldSize } };
+		for (int house{}; house < 40; ++house)
+		{
+			const Elite::Vector2 center{ 10.f + unit(rng) * (worldSize - 20.f), 10.f + unit(rng) * (worldSize - 20.f) };
+			grid.AddObstacle(center - Elite::Vector2{ 4.f, 4.f }, center + Elite::Vector2{ 4.f, 4.f });
+		}
+
+		//Same steps as the simulator: 60 updates per second, enemies a bit slower than the agent
+		Elite::Vector2 agentPosition{ worldSize / 2.f, worldSize / 2.f };
+		const Elite::Vector2 agentVelocity{ 0.06f, 0.02f };
+		std::vector<EnemyInfo> enemies(enemyCount);
+		std::vector<Elite::Vector2> enemyVelocities(enemyCount);
+		for (int enemy{}; enemy < enemyCount; ++enemy)
+		{
+			enemies[enemy].Location = agentPosition + Elite::Vector2{ unit(rng) * 40.f - 20.f, unit(rng) * 40.f - 20.f };
+			enemyVelocities[enemy] = Elite::Vector2{ unit(rng) - 0.5f, unit(rng) - 0.5f } * 0.1f;
+		}
+		std::vector<PurgeZoneInfo> purgeZones{};
+
+		//The reference does all its work in every update, the field only catches up with it when a repair is done
+		DangerField field{};
+		DangerField referenceField{ field.GetCellSize(), field.GetSize(), 0 };
+		const float cellSize{ field.GetCellSize() };
+		int mismatches{};
+		int upToDateUpdates{};
+		int fleeTargets{};
+		double referenceTime{};
+		for (int update{}; update < updateCount; ++update)
+		{
+			agentPosition += agentVelocity;
+			for (int enemy{}; enemy < enemyCount; ++enemy)
+			{
+				if (unit(rng) < 0.01f)
+					enemyVelocities[enemy] = Elite::Vector2{ unit(rng) - 0.5f, unit(rng) - 0.5f } * 0.1f;
+				enemies[enemy].Location += enemyVelocities[enemy];
+			}
+			//A purge zone now and then
+			if (update % 600 == 300)
+				purgeZones.push_back(PurgeZoneInfo{ agentPosition + Elite::Vector2{ 10.f, 0.f }, 8.f });
+			else if (update % 600 == 0)
+				purgeZones.clear();
+
+			field.Update(agentPosition, enemies, purgeZones, &grid);
+			const Clock::time_point start = Clock::now();
+			referenceField.Invalidate();
+			referenceField.Update(agentPosition, enemies, purgeZones, &grid);
+			referenceTime += GetSeconds(start, Clock::now());
+
+			//Every cell of the field has to cost the same once it caught up
+			Elite::Vector2 target{};
+			fleeTargets += field.GetFleeTarget(agentPosition, target);
+			if (!field.IsUpToDate())
+				continue;
+			++upToDateUpdates;
+			for (int y{}; y < field.GetSize(); ++y)
+			{
+				for (int x{}; x < field.GetSize(); ++x)
+				{
+					const Elite::Vector2 position{ agentPosition.x + (x - field.GetSize() / 2) * cellSize, agentPosition.y + (y - field.GetSize() / 2) * cellSize };
+					const float cost{ field.GetCost(position) };
+					const float reference{ referenceField.GetCost(position) };
+					if (fabsf(cost - reference) > 1e-3f * (std::max)(1.f, reference))
+						++mismatches;
+				}
+			}
+		}
+
+		printf("%d updates, %d enemies, flee target found in %d\n", updateCount, enemyCount, fleeTargets);
+		field.PrintStats();
+		printf("reference: %.2f us per update, %d cell costs differ in the %d updates the field was up to date\n", referenceTime * 1e6 / updateCount, mismatches, upToDateUpdates);
+		return mismatches == 0 ? 0 : 1;
+	}
+
+	//Runs the plugin on a log of the host's answers, without the host, and checks every steering output against the log
+	//Only the plugin's frames are timed, that makes a replay a benchmark of the plugin alone on a fixed input
+	int RunReplay(const SimulatorOptions& options)
+	{
+		ReplayInterface replay{};
+		const Clock::time_point loadStart = Clock::now();
+		if (!replay.Load(options.ReplayPath))
+		{
+			printf("WARNING: %s is not a log made with --record\n", options.ReplayPath.c_str());
+			return 1;
+		}
+		//Only the header and the index are touched, the chunks are read when the replay gets to them
+		printf("loaded %u frames of seed %d in %u chunks, %zu bytes, in %.3f ms\n", replay.GetLogFrameCount(), replay.GetSeed(),
+			replay.GetChunkCount(), replay.GetFileSize(), GetSeconds(loadStart, Clock::now()) * 1e3);
+		if (options.ReplayFrame >= 0)
+		{
+			replay.PrintFrame(unsigned(options.ReplayFrame));
+			return 0;
+		}
+
+		bool isDeterministic{ true };
+		for (int run{}; run < options.ReplayRuns; ++run)
+		{
+			replay.Rewind();
+			Plugin* pPlugin = static_cast<Plugin*>(Register());
+			pPlugin->DllInit();
+			PluginInfo info{};
+			pPlugin->Initialize(&replay, info);
+			pPlugin->SetBehaviorTreeEngine(options.Engine);
+
+			const Clock::time_point start = Clock::now();
+			float dt{};
+			while (replay.BeginFrame(dt))
+			{
+				pPlugin->Update(dt);
+				replay.EndFrame(pPlugin->UpdateSteering(dt));
+			}
+			const double wallTime = GetSeconds(start, Clock::now());
+
+			pPlugin->DllShutdown();
+			SAFE_DELETE(pPlugin);
+
+			printf("run %d: %u frames of seed %d in %.3fs (%.2f us per frame), %u steering mismatches%s\n", run + 1,
+				replay.GetFrameCount(), replay.GetSeed(), wallTime, replay.GetFrameCount() > 0 ? wallTime * 1e6 / replay.GetFrameCount() : 0.0,
+				replay.GetSteeringMismatchCount(), replay.IsOutOfSync() ? ", OUT OF SYNC" : "");
+			isDeterministic = isDeterministic && !replay.IsOutOfSync() && replay.GetSteeringMismatchCount() == 0;
+		}
+		return isDeterministic ? 0 : 1;
+	}
+
+	//The conditional leaf as it was before leaves were templated on their callable, to compare against
+	class FunctionBehaviorConditional final : public IBehavior
+	{
+	public:
+		explicit FunctionBehaviorConditional(std::function<bool(Blackboard*)> fp) : m_fpConditional(fp) {}
+		virtual BehaviorState Execute(Blackboard* pBlackBoard) override
+		{
+			if (m_fpConditional == nullptr)
+				return BehaviorState::Failure;
+			return m_fpConditional(pBlackBoard) ? BehaviorState::Success : BehaviorState::Failure;
+		}
+
+	private:
+		std::function<bool(Blackboard*)> m_fpConditional = nullptr;
+	};
+
+	unsigned int g_BenchLeafCalls{};
+	bool IsBenchLeafCallOdd(Blackboard*)
+	{
+		return (++g_BenchLeafCalls & 1) != 0;
+	}
+
+	//Times one conditional leaf per kind of callable, executed through IBehavior like a composite does
+	int RunLeafBenchmark(const SimulatorOptions& options)
+	{
+		const unsigned int leafCount{ 64 }; //A row of siblings
+		const int repeatCount{ (std::max)(1, options.BenchLeafCalls / int(leafCount)) };
+		const unsigned int callCount{ unsigned(repeatCount) * leafCount };
+
+		unsigned int counter{};
+		const char* names[]{ "std::function", "function pointer", "inlined function", "lambda with capture" };
+		BehaviorNodePool nodePool{};
+		std::vector<IBehavior*> leaves[4]{};
+		for (unsigned int leaf{}; leaf < leafCount; ++leaf)
+		{
+			leaves[0].push_back(nodePool.Create<FunctionBehaviorConditional>(&IsBenchLeafCallOdd));
+			leaves[1].push_back(CreateConditional(nodePool, &IsBenchLeafCallOdd));
+			leaves[2].push_back(CreateConditional(nodePool, ConditionalFunction<&IsBenchLeafCallOdd>{}));
+			leaves[3].push_back(CreateConditional(nodePool, [&counter](Blackboard*) { return (++counter & 1) != 0; }));
+		}
+
+		unsigned int mismatches{};
+		for (unsigned int kind{}; kind < 4; ++kind)
+		{
+			g_BenchLeafCalls = 0;
+			counter = 0;
+			unsigned int successCount{};
+			const Clock::time_point start = Clock::now();
+			for (int repeat{}; repeat < repeatCount; ++repeat)
+			{
+				for (IBehavior* pLeaf : leaves[kind])
+					successCount += ExecuteBehavior(pLeaf, nullptr) == BehaviorState::Success;
+			}
+			const double wallTime = GetSeconds(start, Clock::now());
+
+			//Every other call succeeds, whatever the callable
+			if (successCount != (callCount + 1) / 2)
+				++mismatches;
+			printf("%-20s %u calls in %.3fs (%.2f ns per leaf), %u succeeded\n", names[kind], callCount, wallTime,
+				wallTime * 1e9 / callCount, successCount);
+		}
+		if (mismatches > 0)
+			printf("%u kinds of leaves gave a different result\n", mismatches);
+
+		//Leaves made with a null function always fail, in the runtime tree and in the flat tree
+		IBehavior* nullLeaves[]{ CreateConditional(nodePool, BehaviorConditionalFn{ nullptr }),
+			CreateInvertedConditional(nodePool, BehaviorConditionalFn{ nullptr }), CreateAction(nodePool, BehaviorActionFn{ nullptr }) };
+		BehaviorSelector* pNullSelector = nodePool.Create<BehaviorSelector>();
+		pNullSelector->SetChildBehaviors(BehaviorChildren{ nullLeaves, 3 });
+		Blackboard blackboard{};
+		FlatBehaviorTree flatTree{ &blackboard, pNullSelector };
+		flatTree.Update(0.f);
+		bool isNullFailing{ ExecuteBehavior(pNullSelector, &blackboard) == BehaviorState::Failure && flatTree.GetCurrentState() == BehaviorState::Failure };
+		for (IBehavior* pLeaf : nullLeaves)
+			isNullFailing = isNullFailing && ExecuteBehavior(pLeaf, &blackboard) == BehaviorState::Failure;
+		for (unsigned int node{ 1 }; node < flatTree.GetNodes().size(); ++node)
+			isNullFailing = isNullFailing && flatTree.GetNodes()[node].Type == FlatBehaviorType::Failure;
+		printf("leaves without a function %s\n", isNullFailing ? "fail" : "DO NOT FAIL");
+		return mismatches == 0 && isNullFailing ? 0 : 1;
+	}
+
+	//Leaves of the mixed trees, every leaf adds its id to the trace of the update so two trees can be compared
+	const BlackboardKey<unsigned int> MixedUpdate{ "MixedUpdate" };
+	const BlackboardKey<unsigned int> MixedTrace{ "MixedTrace" };
+
+	unsigned int TraceMixedLeaf(Blackboard* pBlackboard, unsigned int leafId)
+	{
+		unsigned int update{};
+		unsigned int trace{};
+		pBlackboard->GetData(MixedUpdate, update);
+		pBlackboard->GetData(MixedTrace, trace);
+		pBlackboard->ChangeData(MixedTrace, trace * 31 + leafId);
+		return update;
+	}
+	bool IsMixedUpdateEven(Blackboard* pBlackboard) { return TraceMixedLeaf(pBlackboard, 1) % 2 == 0; }
+	bool IsMixedUpdateThird(Blackboard* pBlackboard) { return TraceMixedLeaf(pBlackboard, 2) % 3 == 0; }
+	BehaviorState SucceedMixed(Blackboard* pBlackboard)
+	{
+		TraceMixedLeaf(pBlackboard, 3);
+		return BehaviorState::Success;
+	}
+	BehaviorState RunMixedEveryFifth(Blackboard* pBlackboard)
+	{
+		return TraceMixedLeaf(pBlackboard, 4) % 5 == 0 ? BehaviorState::Running : BehaviorState::Success;
+	}
+	BehaviorState FailMixedEverySeventh(Blackboard* pBlackboard)
+	{
+		return TraceMixedLeaf(pBlackboard, 5) % 7 == 0 ? BehaviorState::Failure : BehaviorState::Success;
+	}
+
+	//One tree, as nodes of the static tree, every partial sequence keeps its place between updates
+	using MixedPartialSequence = BT_Static::PartialSequence<BT_Static::Act<SucceedMixed>, BT_Static::Act<RunMixedEveryFifth>, BT_Static::Act<FailMixedEverySeventh>>;
+	using MixedEvenBranch = BT_Static::Sequence<BT_Static::Cond<IsMixedUpdateEven>, MixedPartialSequence>;
+	using MixedThirdBranch = BT_Static::Sequence<BT_Static::Cond<IsMixedUpdateThird>, MixedPartialSequence>;
+	using MixedOddBranch = BT_Static::Sequence<BT_Static::InvCond<IsMixedUpdateEven>, BT_Static::Act<FailMixedEverySeventh>>;
+	using MixedRoot = BT_Static::Selector<MixedEvenBranch, MixedThirdBranch, MixedOddBranch, BT_Static::Act<SucceedMixed>>;
+
+	IBehavior* CreateMixedEvenBranch(BehaviorNodePool& nodePool) { return MixedEvenBranch::CreateBehavior(nodePool); }
+	IBehavior* CreateMixedOddBranch(BehaviorNodePool& nodePool) { return MixedOddBranch::CreateBehavior(nodePool); }
+	//	Static tree with runtime branches
+	using MixedStaticRoot = BT_Static::Selector<BT_Static::Runtime<&CreateMixedEvenBranch>, MixedThirdBranch,
+		BT_Static::Runtime<&CreateMixedOddBranch>, BT_Static::Act<SucceedMixed>>;
+
+	//	Runtime tree with static branches, the static partial sequences are inside them
+	BehaviorTree* CreateMixedRuntimeTree(Blackboard* pBlackboard)
+	{
+		BehaviorNodePool* pNodePool = new BehaviorNodePool();
+		IBehavior* pChildren[]{ pNodePool->Create<StaticBehavior<MixedEvenBranch>>(), MixedThirdBranch::CreateBehavior(*pNodePool),
+			pNodePool->Create<StaticBehavior<MixedOddBranch>>(), pNodePool->Create<StaticBehavior<BT_Static::Act<SucceedMixed>>>() };
+		IBehavior** pChildBehaviors = pNodePool->CreateArray<IBehavior*>(4);
+		std::copy(std::begin(pChildren), std::end(pChildren), pChildBehaviors);
+		BehaviorSelector* pRoot = pNodePool->Create<BehaviorSelector>();
+		pRoot->SetChildBehaviors(BehaviorChildren{ pChildBehaviors, 4 });
+		return new BehaviorTree(pBlackboard, pRoot, pNodePool);
+	}
+
+	Blackboard* CreateMixedBlackboard()
+	{
+		Blackboard* pBlackboard = new Blackboard();
+		pBlackboard->AddData(MixedUpdate, 0u);
+		pBlackboard->AddData(MixedTrace, 0u);
+		return pBlackboard;
+	}
+
+	//Runs a tree that mixes runtime and static nodes next to the same tree made of runtime nodes alone,
+	//both ways round, and checks every update gives the same state and executes the same leaves
+	int RunMixedTreeCheck(const SimulatorOptions& options)
+	{
+		//The runtime trees own their blackboard
+		BehaviorTree* pReferenceTree = BT_Static::CreateBehaviorTree<MixedRoot>(CreateMixedBlackboard());
+		BehaviorTree* pRuntimeTree = CreateMixedRuntimeTree(CreateMixedBlackboard());
+		Blackboard* pStaticBlackboard = CreateMixedBlackboard();
+		StaticBehaviorTree<MixedStaticRoot>* pStaticTree = new StaticBehaviorTree<MixedStaticRoot>(pStaticBlackboard);
+
+		const char* names[]{ "runtime with static branches", "static with runtime branches" };
+		unsigned int mismatches[2]{};
+		unsigned int stateCounts[3]{};
+		for (unsigned int update{}; update < unsigned(options.CheckMixedUpdates); ++update)
+		{
+			Blackboard* pBlackboards[]{ pReferenceTree->GetBlackboard(), pRuntimeTree->GetBlackboard(), pStaticBlackboard };
+			for (Blackboard* pBlackboard : pBlackboards)
+			{
+				pBlackboard->ChangeData(MixedUpdate, update);
+				pBlackboard->ChangeData(MixedTrace, 0u);
+			}
+			pReferenceTree->Update(0.f);
+			pRuntimeTree->Update(0.f);
+			pStaticTree->Update(0.f);
+
+			const BehaviorState states[]{ pRuntimeTree->GetCurrentState(), pStaticTree->GetCurrentState() };
+			unsigned int referenceTrace{};
+			pReferenceTree->GetBlackboard()->GetData(MixedTrace, referenceTrace);
+			++stateCounts[int(pReferenceTree->GetCurrentState())];
+			for (unsigned int tree{}; tree < 2; ++tree)
+			{
+				unsigned int trace{};
+				pBlackboards[tree + 1]->GetData(MixedTrace, trace);
+				if (states[tree] != pReferenceTree->GetCurrentState() || trace != referenceTrace)
+					++mismatches[tree];
+			}
+		}
+
+		printf("%d updates of the runtime tree: %u failed, %u succeeded, %u running\n", options.CheckMixedUpdates,
+			stateCounts[int(BehaviorState::Failure)], stateCounts[int(BehaviorState::Success)], stateCounts[int(BehaviorState::Running)]);
+		for (unsigned int tree{}; tree < 2; ++tree)
+			printf("%-28s %u updates with another state or other leaves\n", names[tree], mismatches[tree]);
+
+		SAFE_DELETE(pStaticTree);
+		SAFE_DELETE(pStaticBlackboard);
+		SAFE_DELETE(pRuntimeTree);
+		SAFE_DELETE(pReferenceTree);
+		return mismatches[0] == 0 && mismatches[1] == 0 ? 0 : 1;
+	}
+
+	//Times the behavior tree update alone, for every engine in the same world state
+	int RunTreeBenchmark(const SimulatorOptions& options)
+	{
+		const BehaviorTreeEngine engines[]{ BehaviorTreeEngine::Runtime, BehaviorTreeEngine::Flat, BehaviorTreeEngine::Reactive, BehaviorTreeEngine::Static };
+		for (BehaviorTreeEngine engine : engines)
+		{
+			if (options.IsEngineSet && engine != options.Engine)
+				continue;
+
+			SimulatorOptions engineOptions{ options };
+			engineOptions.Engine = engine;
+			Simulation simulation{ engineOptions };
+			simulation.Run(BenchWarmupTime);
+
+			//Also timed in batches, the fastest batch is the least disturbed by the rest of the machine
+			IDecisionMaking* pTree = simulation.GetPlugin()->GetBehaviorTree(engine);
+			const int batchSize{ 1000 };
+			double bestBatchTime{ 1e9 };
+			const FlatBehaviorTree* pReactiveTree = engine == BehaviorTreeEngine::Reactive ? static_cast<const FlatBehaviorTree*>(pTree) : nullptr;
+			const unsigned long long executedCount{ pReactiveTree != nullptr ? pReactiveTree->GetExecutedCount() : 0 };
+			const unsigned long long skippedCount{ pReactiveTree != nullptr ? pReactiveTree->GetSkippedCount() : 0 };
+			const Clock::time_point start = Clock::now();
+			for (int update{}; update < options.BenchUpdates; update += batchSize)
+			{
+				const Clock::time_point batchStart = Clock::now();
+				const int batchEnd{ (std::min)(update + batchSize, options.BenchUpdates) };
+				for (int batchUpdate{ update }; batchUpdate < batchEnd; ++batchUpdate)
+					pTree->Update(FixedDeltaTime);
+				bestBatchTime = (std::min)(bestBatchTime, GetSeconds(batchStart, Clock::now()) / (batchEnd - update));
+			}
+			const double wallTime = GetSeconds(start, Clock::now());
+
+			printf("%-8s %d updates in %.3fs (%.1f ns per update, %.1f ns in the fastest batch of %d)\n", GetEngineName(engine), options.BenchUpdates,
+				wallTime, wallTime * 1e9 / options.BenchUpdates, bestBatchTime * 1e9, batchSize);
+			if (engine == BehaviorTreeEngine::Runtime)
+				static_cast<const BehaviorTree*>(pTree)->GetNodePool()->PrintStats();
+			if (pReactiveTree != nullptr)
+				printf("Reactive behavior tree: %.1f nodes executed and %.1f guards skipped per update \n", double(pReactiveTree->GetExecutedCount() - executedCount) / options.BenchUpdates,
+					double(pReactiveTree->GetSkippedCount() - skippedCount) / options.BenchUpdates);
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	SimulatorOptions options{};
+	if (!ParseOptions(argc, argv, options))
+		return 1;
+
+	if (options.BenchHouses > 0)
+		return RunHouseBenchmark(options);
+	if (options.BenchItems > 0)
+		return RunItemBenchmark(options);
+	if (options.BenchThreatCalls > 0)
+		return RunThreatBenchmark(options);
+	if (options.BenchVectors > 0)
+		return RunVectorBenchmark(options);
+	if (options.BenchTrig > 0)
+		return RunTrigBenchmark(options);
+	if (options.BenchGrid > 0)
+		return RunGridBenchmark(options);
+	if (options.BenchDangerUpdates > 0)
+		return RunDangerBenchmark(options);
+	if (options.BenchLeafCalls > 0)
+		return RunLeafBenchmark(options);
+	if (options.CheckMixedUpdates > 0)
+		return RunMixedTreeCheck(options);
+	if (!options.ReplayPath.empty())
+		return RunReplay(options);
+	if (options.AgentCount > 0)
+		return RunBatch(options);
+	if (options.BenchUpdates > 0)
+		return RunTreeBenchmark(options);
+	return RunSimulation(options);
+}
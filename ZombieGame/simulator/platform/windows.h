@@ -0,0 +1,14 @@
+#pragma once
+//Minimal stand-in for <windows.h>, only what the plugin headers need to build on other platforms
+typedef void* HWND;
+typedef void* HDC;
+typedef void* HINSTANCE;
+typedef unsigned long WPARAM;
+typedef long LPARAM;
+typedef unsigned int UINT;
+
+#define __declspec(x)
+
+#include <algorithm>
+using std::min;
+using std::max;